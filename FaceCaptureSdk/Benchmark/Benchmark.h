@@ -0,0 +1,217 @@
+
+#ifndef _BENCHMARK_HEADER_H_
+#define _BENCHMARK_HEADER_H_
+
+#include "Metrics.h"
+
+#include <cstdio>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+* @brief benchmark entries, each one runs on synthetic data only \n
+* no gpu, face sdk or network is needed
+*/
+int BenchmarkFeatureCodec(int argc, char** argv);
+int BenchmarkNumaAffinity(int argc, char** argv);
+int BenchmarkCaptureRing(int argc, char** argv);
+int BenchmarkMatPool(int argc, char** argv);
+int BenchmarkPacketPool(int argc, char** argv);
+int BenchmarkDecodedFrameQueue(int argc, char** argv);
+int BenchmarkCaptureResultsQueue(int argc, char** argv);
+int BenchmarkBestFinder(int argc, char** argv);
+int BenchmarkRtpParse(int argc, char** argv);
+int BenchmarkClocks(int argc, char** argv);
+
+/**
+* @brief elapsed milliseconds since the start point \n
+*/
+inline double ElapsedMilliseconds(const std::chrono::steady_clock::time_point& start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+* @brief thread numbers of a scaling run: 1, 2, 4 ... up to maxThreads, which is always the last one \n
+*/
+inline std::vector<int> ThreadSteps(int maxThreads)
+{
+    std::vector<int> steps;
+    for (int threads = 1; threads < maxThreads; threads <<= 1)
+    {
+        steps.push_back(threads);
+    }
+    steps.push_back(maxThreads);
+    return steps;
+}
+
+/**
+* @brief threads of one role in a threaded run, like the producers or the consumers of a queue \n
+* operation does one op on the thread of index and returns false when there was nothing to do, like a pop
+* from an empty queue, such misses are neither counted nor timed; batch ops share a pair of clock reads,
+* for ops that are cheaper than the clock itself
+*/
+struct BenchmarkRole
+{
+    std::string name;
+    int threadNumber;
+    int batch;
+    std::function<bool(int)> operation;
+};
+
+/**
+* @brief run all roles together for milliseconds and print ops/s and latency percentiles (ns per op) of each \n
+* every thread records into a histogram of its own, so that the benchmark adds no shared cache line to the ops
+*/
+inline void RunRoles(std::vector<BenchmarkRole>& roles, int milliseconds)
+{
+    struct ThreadResult
+    {
+        long long ops;
+        MetricHistogram latency;
+    };
+
+    std::atomic<int> ready(0);
+    std::atomic<bool> started(false);
+    std::atomic<bool> running(true);
+
+    int threadNumber = 0;
+    for (size_t role = 0; role < roles.size(); ++role)
+    {
+        threadNumber += roles[role].threadNumber;
+    }
+
+    std::vector<std::shared_ptr<ThreadResult>> results;
+    std::vector<std::thread> threads;
+    for (size_t role = 0; role < roles.size(); ++role)
+    {
+        for (int index = 0; index < roles[role].threadNumber; ++index)
+        {
+            std::shared_ptr<ThreadResult> result = std::make_shared<ThreadResult>();
+            result->ops = 0;
+            results.push_back(result);
+
+            BenchmarkRole* benchmarkRole = &roles[role];
+            threads.push_back(std::thread([benchmarkRole, index, result, &ready, &started, &running]()
+            {
+                ready++;
+                while (!started)
+                {
+                    std::this_thread::yield();
+                }
+
+                int batch = (std::max)(benchmarkRole->batch, 1);
+                while (running)
+                {
+                    int done = 0;
+                    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                    for (int idx = 0; idx < batch; ++idx)
+                    {
+                        if (benchmarkRole->operation(index))
+                        {
+                            done++;
+                        }
+                    }
+                    long long costs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+                    if (done > 0)
+                    {
+                        result->ops += done;
+                        result->latency.Record(costs / done);
+                    }
+                    else
+                    {
+                        std::this_thread::yield();
+                    }
+                }
+            }));
+        }
+    }
+
+    while (ready < threadNumber)
+    {
+        std::this_thread::yield();
+    }
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    started = true;
+    std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds));
+    running = false;
+    double elapsed = ElapsedMilliseconds(start);
+    for (size_t idx = 0; idx < threads.size(); ++idx)
+    {
+        threads[idx].join();
+    }
+
+    size_t resultIndex = 0;
+    for (size_t role = 0; role < roles.size(); ++role)
+    {
+        long long ops = 0;
+        MetricHistogram latency;
+        for (int index = 0; index < roles[role].threadNumber; ++index, ++resultIndex)
+        {
+            ops += results[resultIndex]->ops;
+            latency.Merge(results[resultIndex]->latency);
+        }
+
+        printf("  %-10s threads: %2d, ops: %10lld, %12.0f ops/s, latency ns p50: %lld p99: %lld p99.9: %lld max: %lld\n",
+            roles[role].name.c_str(), roles[role].threadNumber, ops, ops * 1000.0 / elapsed,
+            latency.Percentile(0.5), latency.Percentile(0.99), latency.Percentile(0.999), latency.Max());
+    }
+}
+
+/**
+* @brief bounded hand-off between the producers and the consumers of a pool benchmark, \n
+* so that items are allocated on one thread and given back on another, like packets read by a rtsp task and freed by a muxer
+*/
+template<typename ItemType>
+class BenchmarkChannel
+{
+public:
+    explicit BenchmarkChannel(size_t capacity) : _capacity(capacity), _locker(), _items() {}
+
+    bool Push(const ItemType& item)
+    {
+        std::lock_guard<std::mutex> lg(_locker);
+        if (_items.size() >= _capacity)
+        {
+            return false;
+        }
+        _items.push_back(item);
+        return true;
+    }
+
+    bool Pop(ItemType& item)
+    {
+        std::lock_guard<std::mutex> lg(_locker);
+        if (_items.empty())
+        {
+            return false;
+        }
+        item = _items.front();
+        _items.pop_front();
+        return true;
+    }
+
+    std::deque<ItemType>& Items()
+    {
+        return _items;
+    }
+
+private:
+    size_t _capacity;
+    std::mutex _locker;
+    std::deque<ItemType> _items;
+
+private:
+    BenchmarkChannel(const BenchmarkChannel&);
+    BenchmarkChannel& operator=(const BenchmarkChannel&);
+};
+
+#endif
@@ -0,0 +1,87 @@
+#include "Benchmark.h"
+#include "Finder.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+/**
+* @brief per track state like the FaceStat kept by the key pointers \n
+*/
+struct TrackStat
+{
+    int trackId;
+    int trackedFrameNumber;
+};
+
+static void ResetTrackStat(TrackStat& trackStat)
+{
+    trackStat.trackedFrameNumber = 0;
+}
+
+/**
+* @brief BestFinder as used by the key pointers to limit captures per track, find then update or add \n
+* args: [threads] [milliseconds] [sources] [faces per source] [capture interval (ms)]
+* the checker walks every track each 10 ms with the lock held, so it shows up in the tail latency
+*/
+int BenchmarkBestFinder(int argc, char** argv)
+{
+    int maxThreads = argc > 0 ? atoi(argv[0]) : 8;
+    int milliseconds = argc > 1 ? atoi(argv[1]) : 2000;
+    int sourceNumber = argc > 2 ? atoi(argv[2]) : 16;
+    int faceNumber = argc > 3 ? atoi(argv[3]) : 50;
+    int captureInterval = argc > 4 ? atoi(argv[4]) : 3000;
+    if (maxThreads <= 0 || milliseconds <= 0 || sourceNumber <= 0 || faceNumber <= 0 || captureInterval <= 0)
+    {
+        printf("invalid arguments\n");
+        return 1;
+    }
+
+    printf("threads: 1-%d, milliseconds: %d, sources: %d, faces per source: %d, capture interval: %d ms\n",
+        maxThreads, milliseconds, sourceNumber, faceNumber, captureInterval);
+
+    std::vector<std::string> sourceIds;
+    for (int idx = 0; idx < sourceNumber; ++idx)
+    {
+        sourceIds.push_back("rtsp://127.0.0.1/benchmark/" + std::to_string(idx));
+    }
+
+    std::vector<int> steps = ThreadSteps(maxThreads);
+    for (size_t step = 0; step < steps.size(); ++step)
+    {
+        BestFinder<int, TrackStat, std::string> trackStatFinder(10, nullptr, nullptr, nullptr, ResetTrackStat);
+
+        // a generator per thread, seeded apart, picks the source and track of each face
+        std::vector<std::shared_ptr<std::minstd_rand>> generators;
+        for (int idx = 0; idx < steps[step]; ++idx)
+        {
+            generators.push_back(std::make_shared<std::minstd_rand>(idx + 1));
+        }
+
+        std::vector<BenchmarkRole> roles;
+        BenchmarkRole filter = { "find/add", steps[step], 1, [&](int index)
+        {
+            std::minstd_rand& generator = *generators[index];
+            const std::string& sourceId = sourceIds[generator() % sourceIds.size()];
+            int trackId = (int)(generator() % faceNumber);
+
+            TrackStat trackStat;
+            if (trackStatFinder.Find(trackId, trackStat, sourceId))
+            {
+                ++trackStat.trackedFrameNumber;
+                trackStatFinder.Update(trackId, trackStat, sourceId);
+            }
+            else
+            {
+                trackStat.trackId = trackId;
+                trackStat.trackedFrameNumber = 1;
+                trackStatFinder.Add(trackId, trackStat, captureInterval, sourceId, 0, captureInterval);
+            }
+            return true;
+        } };
+        roles.push_back(filter);
+        RunRoles(roles, milliseconds);
+    }
+
+    return 0;
+}
@@ -0,0 +1,210 @@
+
+#include "Benchmark.h"
+#include "CaptureRingBuffer.h"
+#include "TimeStamp.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include <memory>
+
+static const char* RING_NAME = "Local\\FaceCaptureRingBenchmark";
+
+struct ConsumerResult
+{
+    long long readNumber = 0;
+    unsigned int lostNumber = 0;
+    long long lagSum = 0;
+    unsigned int maxLag = 0;
+    long long latencySum = 0;     // microseconds
+    long long maxLatency = 0;
+    double milliseconds = 0.0;
+};
+
+/**
+* @brief publish synthetic captures of the size the pipeline publishes without scence \n
+* two 112x112 bgr images, a 2 KB feature and 5 keypoints
+*/
+static double Produce(CaptureRingBuffer& ringBuffer, int recordNumber, int rate, long long& publishedBytes)
+{
+    static const int IMAGE_SIZE = 112 * 112 * 3;
+    static const int FEATURE_SIZE = 2048;
+    static const int KEYPOINTS_NUMBER = 10;
+    std::string sourceId = "rtsp://127.0.0.1/benchmark";
+    unsigned int size = (unsigned int)(sizeof(RingRecordHeader) + sourceId.size() + KEYPOINTS_NUMBER * sizeof(float) + FEATURE_SIZE + IMAGE_SIZE * 2);
+
+    std::vector<char> pixels(IMAGE_SIZE * 2 + FEATURE_SIZE, 0x5A);
+
+    publishedBytes = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int idx = 0; idx < recordNumber; ++idx)
+    {
+        if (rate > 0)
+        {
+            // paced like a detector pushing captures
+            double due = idx * 1000.0 / rate;
+            double now = ElapsedMilliseconds(start);
+            if (due > now)
+            {
+                std::this_thread::sleep_for(std::chrono::microseconds((long long)((due - now) * 1000)));
+            }
+        }
+
+        char* record = ringBuffer.Begin(size);
+        if (!record)
+        {
+            return 0.0;
+        }
+
+        RingRecordHeader& header = *(RingRecordHeader*)record;
+        memset(&header, 0, sizeof(header));
+        header.magic = RING_RECORD_MAGIC;
+        header.size = size;
+        header.frameId = idx;
+        header.id = idx;
+        header.publishTime = TimeStamp<MICROSECONDS>::Now();
+        header.sourceIdSize = (unsigned int)sourceId.size();
+        header.keypointsNumber = KEYPOINTS_NUMBER;
+        header.featureSize = FEATURE_SIZE;
+        header.face.width = header.aligned.width = 112;
+        header.face.height = header.aligned.height = 112;
+        header.face.type = header.aligned.type = 16;
+        header.face.size = header.aligned.size = IMAGE_SIZE;
+
+        char* target = record + sizeof(RingRecordHeader);
+        memcpy(target, sourceId.data(), sourceId.size());
+        target += sourceId.size() + KEYPOINTS_NUMBER * sizeof(float);
+        memcpy(target, &pixels[0], pixels.size());
+
+        ringBuffer.Commit(size);
+        publishedBytes += size;
+    }
+    return ElapsedMilliseconds(start);
+}
+
+static void Consume(CaptureRingBuffer& ringBuffer, int recordNumber, const std::atomic<bool>& producing, ConsumerResult& result)
+{
+    std::vector<char> record;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point idleStart = start;
+    while (result.readNumber + result.lostNumber < recordNumber)
+    {
+        if (!ringBuffer.Read(record, result.lostNumber))
+        {
+            // a consumer in another process has no producing flag, it stops after 2 seconds idle
+            if (!producing && ElapsedMilliseconds(idleStart) > (result.readNumber > 0 ? 2000 : 30000))
+            {
+                break;
+            }
+            std::this_thread::yield();
+            continue;
+        }
+        idleStart = std::chrono::steady_clock::now();
+
+        RingRecordView view;
+        if (record.empty() || !view.Parse(&record[0], (unsigned int)record.size()))
+        {
+            result.lostNumber++;
+            continue;
+        }
+
+        long long latency = TimeStamp<MICROSECONDS>::Now() - view.header->publishTime;
+        unsigned int lag = ringBuffer.Lag();
+        result.readNumber++;
+        result.lagSum += lag;
+        result.maxLag = (std::max)(result.maxLag, lag);
+        result.latencySum += latency;
+        result.maxLatency = (std::max)(result.maxLatency, latency);
+    }
+    result.milliseconds = ElapsedMilliseconds(start);
+}
+
+static void PrintConsumer(int index, const ConsumerResult& result)
+{
+    long long readNumber = (std::max)(result.readNumber, 1LL);
+    printf("consumer %d: read: %lld, lost: %u, %.0f results/s, lag mean: %.1f max: %u, latency mean: %.1f us max: %lld us\n",
+        index, result.readNumber, result.lostNumber, result.readNumber * 1000.0 / (std::max)(result.milliseconds, 1.0),
+        (double)result.lagSum / readNumber, result.maxLag, (double)result.latencySum / readNumber, result.maxLatency);
+}
+
+/**
+* @brief shared memory capture ring throughput and consumer lag \n
+* args: [both|produce|consume] [records] [consumers] [rate (results/s, 0 means unlimited)] [slots]
+* produce and consume run the two sides in separate processes, start the consumers first
+*/
+int BenchmarkCaptureRing(int argc, char** argv)
+{
+    std::string mode = argc > 0 ? argv[0] : "both";
+    int recordNumber = argc > 1 ? atoi(argv[1]) : 200000;
+    int consumerNumber = argc > 2 ? atoi(argv[2]) : 2;
+    int rate = argc > 3 ? atoi(argv[3]) : 0;
+    int slotNumber = argc > 4 ? atoi(argv[4]) : 128;
+    if ((mode != "both" && mode != "produce" && mode != "consume") || recordNumber <= 0 || consumerNumber < 0 || rate < 0 || slotNumber <= 0)
+    {
+        printf("invalid arguments\n");
+        return 1;
+    }
+    if (mode == "produce")
+    {
+        consumerNumber = 0;
+    }
+
+    printf("mode: %s, records: %d, consumers: %d, rate: %d/s, slots: %d\n", mode.c_str(), recordNumber, consumerNumber, rate, slotNumber);
+
+    CaptureRingBuffer producer;
+    if (mode != "consume" && !producer.Create(RING_NAME, slotNumber, 256 << 10))
+    {
+        printf("ring can not be created, error: %u\n", (unsigned int)GetLastError());
+        return 1;
+    }
+
+    std::vector<std::shared_ptr<CaptureRingBuffer>> consumerRings;
+    for (int idx = 0; idx < consumerNumber; ++idx)
+    {
+        consumerRings.push_back(std::make_shared<CaptureRingBuffer>());
+        bool opened = consumerRings.back()->Open(RING_NAME);
+
+        // wait for the producing process
+        for (int retry = 0; !opened && mode == "consume" && retry < 300; ++retry)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            opened = consumerRings.back()->Open(RING_NAME);
+        }
+        if (!opened)
+        {
+            printf("ring can not be opened\n");
+            return 1;
+        }
+    }
+
+    std::atomic<bool> producing(mode != "consume");
+    std::vector<ConsumerResult> consumerResults(consumerNumber);
+    std::vector<std::thread> consumers;
+    for (int idx = 0; idx < consumerNumber; ++idx)
+    {
+        consumers.push_back(std::thread(Consume, std::ref(*consumerRings[idx]), recordNumber, std::cref(producing), std::ref(consumerResults[idx])));
+    }
+
+    if (mode != "consume")
+    {
+        long long publishedBytes = 0;
+        double elapsed = Produce(producer, recordNumber, rate, publishedBytes);
+        producing = false;
+        printf("producer: %d results in %.1f ms, %.0f results/s, %.1f MB/s\n",
+            recordNumber, elapsed, recordNumber * 1000.0 / (std::max)(elapsed, 1.0), publishedBytes / 1e3 / (std::max)(elapsed, 1.0));
+    }
+
+    for (int idx = 0; idx < consumerNumber; ++idx)
+    {
+        consumers[idx].join();
+        PrintConsumer(idx, consumerResults[idx]);
+    }
+
+    return 0;
+}
+
@@ -0,0 +1,135 @@
+#include "Benchmark.h"
+#include "TimeStamp.h"
+#include "TscClock.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+
+static long long SteadyNow()
+{
+    return std::chrono::steady_clock::now().time_since_epoch().count();
+}
+
+static long long SystemNow()
+{
+    return std::chrono::system_clock::now().time_since_epoch().count();
+}
+
+static long long TimeStampNow()
+{
+    return TimeStamp<MICROSECONDS>::Now();
+}
+
+static long long ClockNow()
+{
+    return (long long)clock();
+}
+
+static long long TscTicks()
+{
+    return (long long)TscClock::Ticks();
+}
+
+static long long TscNanoseconds()
+{
+    return TscClock::Nanoseconds();
+}
+
+struct ClockEntry
+{
+    const char* name;
+    long long(*now)();
+};
+
+static const ClockEntry CLOCKS[] = {
+    { "steady_clock", SteadyNow },
+    { "system_clock", SystemNow },
+    { "TimeStamp<us>", TimeStampNow },
+    { "clock()", ClockNow },
+    { "TscClock ticks", TscTicks },
+    { "TscClock ns", TscNanoseconds },
+};
+
+static const size_t CLOCK_NUMBER = sizeof(CLOCKS) / sizeof(CLOCKS[0]);
+
+/**
+* @brief cost of a read of each clock, and drift of TscClock and clock() against steady_clock \n
+* args: [threads] [milliseconds] [drift seconds] [drift sample interval (ms)]
+* the threaded runs read the clocks from 1..threads threads at once, the tsc clock shares its calibration between them
+*/
+int BenchmarkClocks(int argc, char** argv)
+{
+    int maxThreads = argc > 0 ? atoi(argv[0]) : 4;
+    int milliseconds = argc > 1 ? atoi(argv[1]) : 1000;
+    int driftSeconds = argc > 2 ? atoi(argv[2]) : 10;
+    int sampleInterval = argc > 3 ? atoi(argv[3]) : 100;
+    if (maxThreads <= 0 || milliseconds <= 0 || driftSeconds < 0 || sampleInterval <= 0)
+    {
+        printf("invalid arguments\n");
+        return 1;
+    }
+
+    TscClock::Initialize();
+    printf("threads: 1-%d, milliseconds: %d, drift: %d s sampled every %d ms\n", maxThreads, milliseconds, driftSeconds, sampleInterval);
+    printf("invariant tsc: %s, %.3f MHz\n", TscClock::Invariant() ? "yes" : "no, TscClock reads steady_clock", TscClock::TicksPerSecond() / 1e6);
+
+    // per thread sums a cache line apart keep the reads from being optimized away
+    std::vector<int> steps = ThreadSteps(maxThreads);
+    for (size_t entry = 0; entry < CLOCK_NUMBER; ++entry)
+    {
+        printf("%s\n", CLOCKS[entry].name);
+        for (size_t step = 0; step < steps.size(); ++step)
+        {
+            std::vector<long long> sums(steps[step] * 16, 0);
+            long long(*now)() = CLOCKS[entry].now;
+
+            std::vector<BenchmarkRole> roles;
+            BenchmarkRole read = { "read", steps[step], 256, [&sums, now](int index)
+            {
+                sums[index * 16] += now();
+                return true;
+            } };
+            roles.push_back(read);
+            RunRoles(roles, milliseconds);
+        }
+    }
+
+    if (driftSeconds == 0)
+    {
+        return 0;
+    }
+
+    // offsets are relative to the first sample, clock() is cpu time on linux and drifts with load or idling
+    printf("drift against steady_clock:\n");
+    long long steadyStart = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    long long tscStart = TscClock::Nanoseconds();
+    clock_t clockStart = clock();
+    long long maxTscOffset = 0;
+    long long lastTsc = tscStart;
+    long long backwards = 0;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    int sampleNumber = driftSeconds * 1000 / sampleInterval;
+    for (int sample = 1; sample <= sampleNumber; ++sample)
+    {
+        std::this_thread::sleep_until(start + std::chrono::milliseconds(sample * sampleInterval));
+
+        long long steady = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count() - steadyStart;
+        long long tsc = TscClock::Nanoseconds();
+        long long tscOffset = (tsc - tscStart) - steady;
+        double clockOffset = (clock() - clockStart) * 1000.0 / CLOCKS_PER_SEC - steady / 1e6;
+
+        backwards += tsc < lastTsc ? 1 : 0;
+        lastTsc = tsc;
+        maxTscOffset = (std::max)(maxTscOffset, tscOffset < 0 ? -tscOffset : tscOffset);
+
+        if (sample * sampleInterval % 1000 == 0)
+        {
+            printf("  %5.1f s: TscClock %+8.3f us, clock() %+10.3f ms\n", steady / 1e9, tscOffset / 1000.0, clockOffset);
+        }
+    }
+    printf("  TscClock max offset: %.3f us, went backwards: %lld times\n", maxTscOffset / 1000.0, backwards);
+
+    return 0;
+}
@@ -0,0 +1,138 @@
+
+#include "Benchmark.h"
+#include "FeatureCodec.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+typedef std::vector<std::vector<char>> Features;
+
+static void RandomFeature(std::mt19937& generator, const std::vector<float>& center, float noise, std::vector<char>& feature)
+{
+    std::normal_distribution<float> distribution(0.0f, noise);
+    feature.resize(center.size() * sizeof(float));
+    float* values = (float*)&feature[0];
+    for (size_t idx = 0; idx < center.size(); ++idx)
+    {
+        values[idx] = center[idx] + distribution(generator);
+    }
+}
+
+static size_t Top1(int encoding, const std::vector<char>& query, const Features& gallery)
+{
+    size_t best = 0;
+    float bestSimilarity = -2.0f;
+    for (size_t idx = 0; idx < gallery.size(); ++idx)
+    {
+        float similarity = FeatureCodec::Similarity(encoding, query, gallery[idx]);
+        if (similarity > bestSimilarity)
+        {
+            bestSimilarity = similarity;
+            best = idx;
+        }
+    }
+    return best;
+}
+
+/**
+* @brief top-1 recall of compressed encodings against raw float, and kernel throughput \n
+* args: [dimension] [identities] [samples per identity] [queries]
+* samples of one identity are close to each other, so quantization error can flip the nearest one
+*/
+int BenchmarkFeatureCodec(int argc, char** argv)
+{
+    size_t dimension = argc > 0 ? atoi(argv[0]) : 512;
+    size_t identities = argc > 1 ? atoi(argv[1]) : 2000;
+    size_t samples = argc > 2 ? atoi(argv[2]) : 5;
+    size_t queries = argc > 3 ? atoi(argv[3]) : 200;
+    if (dimension == 0 || identities == 0 || samples == 0 || queries == 0)
+    {
+        printf("invalid arguments\n");
+        return 1;
+    }
+
+    std::mt19937 generator(20181011);
+    std::normal_distribution<float> distribution(0.0f, 1.0f);
+
+    Features rawGallery;
+    rawGallery.reserve(identities * samples);
+    std::vector<float> center(dimension);
+    for (size_t identity = 0; identity < identities; ++identity)
+    {
+        for (size_t idx = 0; idx < dimension; ++idx)
+        {
+            center[idx] = distribution(generator);
+        }
+        for (size_t sample = 0; sample < samples; ++sample)
+        {
+            rawGallery.push_back(std::vector<char>());
+            RandomFeature(generator, center, 0.3f, rawGallery.back());
+        }
+    }
+
+    Features rawQueries(queries);
+    std::uniform_int_distribution<size_t> pick(0, rawGallery.size() - 1);
+    for (size_t idx = 0; idx < queries; ++idx)
+    {
+        const float* values = (const float*)&rawGallery[pick(generator)][0];
+        RandomFeature(generator, std::vector<float>(values, values + dimension), 0.3f, rawQueries[idx]);
+    }
+
+    printf("dimension: %u, gallery: %u, queries: %u\n", (unsigned)dimension, (unsigned)rawGallery.size(), (unsigned)queries);
+
+    std::vector<size_t> truth(queries);
+    std::vector<float> truthSimilarity(queries);
+    const int encodings[] = { FEATURE_ENCODING_RAW, FEATURE_ENCODING_FLOAT16, FEATURE_ENCODING_INT8 };
+    const char* names[] = { "raw", "float16", "int8" };
+    for (size_t e = 0; e < sizeof(encodings) / sizeof(encodings[0]); ++e)
+    {
+        int encoding = encodings[e];
+
+        Features gallery(rawGallery.size()), encodedQueries(queries);
+        for (size_t idx = 0; idx < rawGallery.size(); ++idx)
+        {
+            FeatureCodec::Encode(encoding, rawGallery[idx], gallery[idx]);
+        }
+        for (size_t idx = 0; idx < queries; ++idx)
+        {
+            FeatureCodec::Encode(encoding, rawQueries[idx], encodedQueries[idx]);
+        }
+
+        size_t matched = 0;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (size_t idx = 0; idx < queries; ++idx)
+        {
+            size_t best = Top1(encoding, encodedQueries[idx], gallery);
+            if (encoding == FEATURE_ENCODING_RAW)
+            {
+                truth[idx] = best;
+            }
+            matched += best == truth[idx] ? 1 : 0;
+        }
+        double elapsed = ElapsedMilliseconds(start);
+
+        // similarity drift of the true pair caused by the encoding
+        double similarityError = 0.0;
+        for (size_t idx = 0; idx < queries; ++idx)
+        {
+            float similarity = FeatureCodec::Similarity(encoding, encodedQueries[idx], gallery[truth[idx]]);
+            if (encoding == FEATURE_ENCODING_RAW)
+            {
+                truthSimilarity[idx] = similarity;
+            }
+            similarityError += std::fabs(similarity - truthSimilarity[idx]);
+        }
+
+        double comparisons = (double)queries * gallery.size();
+        printf("%-8s bytes/vector: %6u, recall@1: %.4f, similarity error: %.6f, %.1f ns/comparison, %.2f M comparisons/s\n",
+            names[e], (unsigned)gallery[0].size(), (double)matched / queries, similarityError / queries,
+            elapsed * 1e6 / comparisons, comparisons / elapsed / 1e3);
+    }
+
+    return 0;
+}
+
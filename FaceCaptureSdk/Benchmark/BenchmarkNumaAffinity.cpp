@@ -0,0 +1,152 @@
+
+#include "Benchmark.h"
+#include "ThreadAffinity.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <queue>
+#include <vector>
+
+struct HandOff
+{
+    std::mutex locker;
+    std::condition_variable condition;
+    std::queue<int> filled;
+    std::queue<int> emptied;
+};
+
+struct HandOffResult
+{
+    double milliseconds = 0.0;
+    long long bytes = 0;
+    long long remoteBytes = 0;
+};
+
+/**
+* @brief producer decodes into a ring of frame buffers, consumer copies them out as the pipeline does \n
+* buffers are first touched by the producer, so their pages are on the node of the producer;
+* a frame is counted remote when the consumer reads it on another node
+*/
+static HandOffResult RunHandOff(int producerNode, int consumerNode, size_t frameSize, int frameNumber, int ringSize)
+{
+    std::vector<std::vector<char>> ring(ringSize);
+    std::vector<int> bufferNodes(ringSize, -1);
+    HandOff handOff;
+    for (int idx = 0; idx < ringSize; ++idx)
+    {
+        handOff.emptied.push(idx);
+    }
+
+    HandOffResult result;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    std::thread producer([&]()
+    {
+        ThreadAffinity::BindNode(producerNode);
+        for (int frame = 0; frame < frameNumber; ++frame)
+        {
+            int index = 0;
+            {
+                std::unique_lock<std::mutex> lock(handOff.locker);
+                handOff.condition.wait(lock, [&](){ return !handOff.emptied.empty(); });
+                index = handOff.emptied.front();
+                handOff.emptied.pop();
+            }
+
+            std::vector<char>& buffer = ring[index];
+            if (buffer.empty())
+            {
+                buffer.resize(frameSize);
+                bufferNodes[index] = ThreadAffinity::CurrentNode();
+            }
+            memset(&buffer[0], frame & 0xFF, frameSize);
+
+            {
+                AUTOLOCK(handOff.locker);
+                handOff.filled.push(index);
+            }
+            WAKEUP_ALL(handOff.condition);
+        }
+    });
+
+    std::thread consumer([&]()
+    {
+        ThreadAffinity::BindNode(consumerNode);
+        std::vector<char> local(frameSize);
+        for (int frame = 0; frame < frameNumber; ++frame)
+        {
+            int index = 0;
+            {
+                std::unique_lock<std::mutex> lock(handOff.locker);
+                handOff.condition.wait(lock, [&](){ return !handOff.filled.empty(); });
+                index = handOff.filled.front();
+                handOff.filled.pop();
+            }
+
+            memcpy(&local[0], &ring[index][0], frameSize);
+            result.bytes += frameSize;
+            if (bufferNodes[index] != ThreadAffinity::CurrentNode())
+            {
+                result.remoteBytes += frameSize;
+            }
+
+            {
+                AUTOLOCK(handOff.locker);
+                handOff.emptied.push(index);
+            }
+            WAKEUP_ALL(handOff.condition);
+        }
+    });
+
+    WAIT_TO_EXIT(producer);
+    WAIT_TO_EXIT(consumer);
+
+    result.milliseconds = ElapsedMilliseconds(start);
+    return result;
+}
+
+static void PrintHandOff(const char* name, int producerNode, int consumerNode, const HandOffResult& result)
+{
+    printf("%-9s producer node: %2d, consumer node: %2d, %.2f GB/s, remote: %.1f%% (%.1f MB)\n",
+        name, producerNode, consumerNode, result.bytes / result.milliseconds / 1e6,
+        result.bytes > 0 ? result.remoteBytes * 100.0 / result.bytes : 0.0, result.remoteBytes / 1e6);
+}
+
+/**
+* @brief frame hand-off throughput with threads on the same node, on different nodes and floating \n
+* args: [width] [height] [frames] [ring size]
+* there are no memory controller counters here, cross node traffic is reported as the bytes
+* the consumer read from buffers placed on another node
+*/
+int BenchmarkNumaAffinity(int argc, char** argv)
+{
+    int width = argc > 0 ? atoi(argv[0]) : 1920;
+    int height = argc > 1 ? atoi(argv[1]) : 1080;
+    int frameNumber = argc > 2 ? atoi(argv[2]) : 2000;
+    int ringSize = argc > 3 ? atoi(argv[3]) : 8;
+    if (width <= 0 || height <= 0 || frameNumber <= 0 || ringSize <= 0)
+    {
+        printf("invalid arguments\n");
+        return 1;
+    }
+
+    size_t frameSize = (size_t)width * height * 3;
+    int nodeNumber = ThreadAffinity::NodeNumber();
+    printf("numa nodes: %d, frame: %dx%d (%.1f MB), frames: %d, ring: %d\n",
+        nodeNumber, width, height, frameSize / 1e6, frameNumber, ringSize);
+
+    PrintHandOff("local", 0, 0, RunHandOff(0, 0, frameSize, frameNumber, ringSize));
+    if (nodeNumber > 1)
+    {
+        PrintHandOff("remote", 0, 1, RunHandOff(0, 1, frameSize, frameNumber, ringSize));
+    }
+    else
+    {
+        printf("remote    skipped, single numa node\n");
+    }
+    PrintHandOff("floating", -1, -1, RunHandOff(-1, -1, frameSize, frameNumber, ringSize));
+
+    return 0;
+}
+
@@ -0,0 +1,142 @@
+#include "Benchmark.h"
+#include "XMatPool.h"
+#include "AvPacketPool.h"
+
+#pragma warning(disable:4819)
+#include "opencv2/opencv.hpp"
+#pragma warning(default:4819)
+
+#include <cstdio>
+#include <cstdlib>
+
+/**
+* @brief XMatPool of decoded frames, allocated by decoder threads and given back by detector threads \n
+* args: [threads] [milliseconds] [width] [height]
+* a miss allocates a new frame like the decoders do, misses grow once the hand-off holds more frames than the pool keeps
+*/
+int BenchmarkMatPool(int argc, char** argv)
+{
+    int maxThreads = argc > 0 ? atoi(argv[0]) : 8;
+    int milliseconds = argc > 1 ? atoi(argv[1]) : 2000;
+    int width = argc > 2 ? atoi(argv[2]) : 1920;
+    int height = argc > 3 ? atoi(argv[3]) : 1080;
+    if (maxThreads <= 0 || milliseconds <= 0 || width <= 0 || height <= 0)
+    {
+        printf("invalid arguments\n");
+        return 1;
+    }
+
+    printf("threads: 1-%d producers and consumers, milliseconds: %d, frame: %dx%d bgr\n", maxThreads, milliseconds, width, height);
+
+    cv::Mat shape(height, width, CV_8UC3);
+    std::vector<int> steps = ThreadSteps(maxThreads);
+    for (size_t step = 0; step < steps.size(); ++step)
+    {
+        BenchmarkChannel<cv::Mat> channel(16);
+        std::atomic<long long> misses(0);
+
+        std::vector<BenchmarkRole> roles;
+        BenchmarkRole alloc = { "alloc", steps[step], 1, [&](int)
+        {
+            cv::Mat mat;
+            if (!XMatPool<cv::Mat>::Alloc(shape, mat))
+            {
+                mat.create(height, width, CV_8UC3);
+                misses++;
+            }
+            if (!channel.Push(mat))
+            {
+                XMatPool<cv::Mat>::Free(mat);
+                return false;
+            }
+            return true;
+        } };
+        BenchmarkRole release = { "free", steps[step], 1, [&](int)
+        {
+            cv::Mat mat;
+            if (!channel.Pop(mat))
+            {
+                return false;
+            }
+            XMatPool<cv::Mat>::Free(mat);
+            return true;
+        } };
+        roles.push_back(alloc);
+        roles.push_back(release);
+        RunRoles(roles, milliseconds);
+        printf("  pool misses: %lld\n", misses.load());
+
+        channel.Items().clear();
+        XMatPool<cv::Mat>::Clear();
+    }
+
+    return 0;
+}
+
+/**
+* @brief AvPacketPool of the mux service, packets read by rtsp tasks and freed by the muxers after writing \n
+* args: [threads] [milliseconds] [packet size] [gop]
+* every gop-th packet is a key frame 8 times the size, like a 1080p h264 stream of about 4 Mbps
+*/
+int BenchmarkPacketPool(int argc, char** argv)
+{
+    int maxThreads = argc > 0 ? atoi(argv[0]) : 8;
+    int milliseconds = argc > 1 ? atoi(argv[1]) : 2000;
+    int packetSize = argc > 2 ? atoi(argv[2]) : 16 << 10;
+    int gop = argc > 3 ? atoi(argv[3]) : 50;
+    if (maxThreads <= 0 || milliseconds <= 0 || packetSize <= 0 || gop <= 0)
+    {
+        printf("invalid arguments\n");
+        return 1;
+    }
+
+    printf("threads: 1-%d producers and consumers, milliseconds: %d, packet: %d bytes, gop: %d\n", maxThreads, milliseconds, packetSize, gop);
+
+    AvPacketPool::Initialize();
+
+    std::vector<int> steps = ThreadSteps(maxThreads);
+    for (size_t step = 0; step < steps.size(); ++step)
+    {
+        BenchmarkChannel<AVPacket*> channel(256);
+        std::vector<long long> packetNumbers(steps[step], 0);
+
+        std::vector<BenchmarkRole> roles;
+        BenchmarkRole alloc = { "alloc", steps[step], 1, [&](int index)
+        {
+            AVPacket* packet = AvPacketPool::Alloc();
+            if (!packet)
+            {
+                return false;
+            }
+            if (av_new_packet(packet, packetNumbers[index]++ % gop == 0 ? packetSize * 8 : packetSize) < 0 || !channel.Push(packet))
+            {
+                AvPacketPool::Free(packet);
+                return false;
+            }
+            return true;
+        } };
+        BenchmarkRole release = { "free", steps[step], 1, [&](int)
+        {
+            AVPacket* packet = nullptr;
+            if (!channel.Pop(packet))
+            {
+                return false;
+            }
+            AvPacketPool::Free(packet);
+            return true;
+        } };
+        roles.push_back(alloc);
+        roles.push_back(release);
+        RunRoles(roles, milliseconds);
+
+        std::deque<AVPacket*>& packets = channel.Items();
+        for (size_t idx = 0; idx < packets.size(); ++idx)
+        {
+            AvPacketPool::Free(packets[idx]);
+        }
+        packets.clear();
+    }
+
+    AvPacketPool::Destroy();
+    return 0;
+}
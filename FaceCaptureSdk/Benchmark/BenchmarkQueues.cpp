@@ -0,0 +1,184 @@
+#include "Benchmark.h"
+#include "DecodedFrameQueue.h"
+#include "XMatPool.h"
+
+#define GLOG_NO_ABBREVIATED_SEVERITIES
+#define GOOGLE_GLOG_DLL_DECL
+#include "glog/logging.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <queue>
+
+/**
+* @brief DecodedFrameQueue of one stream, pushed by decoder threads and popped by detector threads \n
+* args: [threads] [milliseconds] [buffer size] [width] [height]
+* frames come from XMatPool and go back to it like in the decoders, overflowed frames are discarded by the queue itself
+*/
+int BenchmarkDecodedFrameQueue(int argc, char** argv)
+{
+    int maxThreads = argc > 0 ? atoi(argv[0]) : 8;
+    int milliseconds = argc > 1 ? atoi(argv[1]) : 2000;
+    int bufferSize = argc > 2 ? atoi(argv[2]) : 10;
+    int width = argc > 3 ? atoi(argv[3]) : 1920;
+    int height = argc > 4 ? atoi(argv[4]) : 1080;
+    if (maxThreads <= 0 || milliseconds <= 0 || bufferSize <= 0 || width <= 0 || height <= 0)
+    {
+        printf("invalid arguments\n");
+        return 1;
+    }
+
+    printf("threads: 1-%d producers and consumers, milliseconds: %d, buffer: %d, frame: %dx%d bgr\n", maxThreads, milliseconds, bufferSize, width, height);
+
+    // producers outrun consumers on purpose, the overflow warnings would flood the console
+    int minLogLevel = FLAGS_minloglevel;
+    FLAGS_minloglevel = google::GLOG_ERROR;
+
+    cv::Mat shape(height, width, CV_8UC3);
+    std::vector<int> steps = ThreadSteps(maxThreads);
+    for (size_t step = 0; step < steps.size(); ++step)
+    {
+        std::atomic<long long> pushed(0);
+        std::atomic<long long> popped(0);
+        {
+            DecodedFrameQueue decodedFrameQueue(0, bufferSize);
+
+            std::vector<BenchmarkRole> roles;
+            BenchmarkRole push = { "push", steps[step], 1, [&](int)
+            {
+                DecodedFrame decodedFrame;
+                decodedFrame.sourceId = "rtsp://127.0.0.1/benchmark";
+                decodedFrame.id = pushed++;
+                decodedFrame.buffered = true;
+                if (!XMatPool<cv::Mat>::Alloc(shape, decodedFrame.mat))
+                {
+                    decodedFrame.mat.create(height, width, CV_8UC3);
+                }
+                decodedFrameQueue.Push(decodedFrame);
+                return true;
+            } };
+            BenchmarkRole pop = { "pop", steps[step], 1, [&](int)
+            {
+                DecodedFrame decodedFrame;
+                if (!decodedFrameQueue.Pop(decodedFrame))
+                {
+                    return false;
+                }
+                popped++;
+                XMatPool<cv::Mat>::Free(decodedFrame.mat);
+                return true;
+            } };
+            roles.push_back(push);
+            roles.push_back(pop);
+            RunRoles(roles, milliseconds);
+        }
+        long long discarded = pushed - popped;
+        printf("  discarded: %lld frames, %.1f%%\n", discarded, discarded * 100.0 / (std::max)(pushed.load(), 1LL));
+
+        XMatPool<cv::Mat>::Clear();
+    }
+
+    FLAGS_minloglevel = minLogLevel;
+    return 0;
+}
+
+/**
+* @brief capture as large as a real one without scene: two 112x112 images and a 2 KB feature \n
+* CaptureResultsQueue holds the face sdk types, so the benchmark mirrors it with this one
+*/
+struct SyntheticCapture
+{
+    std::string sourceId;
+    unsigned long long frameId;
+    std::vector<char> feature;
+    std::vector<char> images;
+};
+
+typedef std::shared_ptr<SyntheticCapture> SyntheticCapturePtr;
+typedef std::vector<SyntheticCapturePtr> SyntheticCaptures;
+typedef std::queue<SyntheticCaptures> SyntheticCapturesQueue;
+
+/**
+* @brief result buffer of the detectors, batches of captures pushed by the analyze threads and fetched by the application \n
+* args: [threads] [milliseconds] [buffer size (faces)] [faces per batch]
+* pushing takes the same lock and trims the overflow the same way as FaceDetector::Append
+*/
+int BenchmarkCaptureResultsQueue(int argc, char** argv)
+{
+    int maxThreads = argc > 0 ? atoi(argv[0]) : 8;
+    int milliseconds = argc > 1 ? atoi(argv[1]) : 2000;
+    int bufferSize = argc > 2 ? atoi(argv[2]) : 100;
+    int batchSize = argc > 3 ? atoi(argv[3]) : 4;
+    if (maxThreads <= 0 || milliseconds <= 0 || bufferSize <= 0 || batchSize <= 0)
+    {
+        printf("invalid arguments\n");
+        return 1;
+    }
+
+    printf("threads: 1-%d producers and consumers, milliseconds: %d, buffer: %d faces, batch: %d faces\n", maxThreads, milliseconds, bufferSize, batchSize);
+
+    // captures are made once, batches only share them like a capture is shared by the archive, the sink and the buffer
+    std::vector<SyntheticCapturePtr> captures;
+    for (int idx = 0; idx < 64; ++idx)
+    {
+        SyntheticCapturePtr capture = std::make_shared<SyntheticCapture>();
+        capture->sourceId = "rtsp://127.0.0.1/benchmark";
+        capture->frameId = idx;
+        capture->feature.resize(2048, 0x5A);
+        capture->images.resize(112 * 112 * 3 * 2, 0x5A);
+        captures.push_back(capture);
+    }
+
+    std::vector<int> steps = ThreadSteps(maxThreads);
+    for (size_t step = 0; step < steps.size(); ++step)
+    {
+        std::mutex outputBufferLocker;
+        SyntheticCapturesQueue outputBuffer;
+        long long resultFaceNumber = 0;
+        long long discarded = 0;
+
+        std::vector<BenchmarkRole> roles;
+        BenchmarkRole push = { "push", steps[step], 1, [&](int index)
+        {
+            SyntheticCaptures captureResults;
+            for (int idx = 0; idx < batchSize; ++idx)
+            {
+                captureResults.push_back(captures[(index + idx) % captures.size()]);
+            }
+
+            AUTOLOCK(outputBufferLocker);
+            outputBuffer.push(captureResults);
+            resultFaceNumber += captureResults.size();
+
+            while (resultFaceNumber > bufferSize)
+            {
+                long long headSize = outputBuffer.front().size();
+                outputBuffer.pop();
+                resultFaceNumber -= headSize;
+                discarded += headSize;
+            }
+            return true;
+        } };
+        BenchmarkRole pop = { "pop", steps[step], 1, [&](int)
+        {
+            SyntheticCaptures captureResults;
+            {
+                AUTOLOCK(outputBufferLocker);
+                if (outputBuffer.empty())
+                {
+                    return false;
+                }
+                captureResults.swap(outputBuffer.front());
+                outputBuffer.pop();
+                resultFaceNumber -= captureResults.size();
+            }
+            return true;
+        } };
+        roles.push_back(push);
+        roles.push_back(pop);
+        RunRoles(roles, milliseconds);
+        printf("  discarded: %lld faces\n", discarded);
+    }
+
+    return 0;
+}
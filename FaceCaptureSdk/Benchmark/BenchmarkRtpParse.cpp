@@ -0,0 +1,102 @@
+#include "Benchmark.h"
+#include "RtpHeader.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+/**
+* @brief build a rtp packet of size bytes carrying ps, with csrcs, a header extension and padding as asked \n
+*/
+static std::vector<unsigned char> MakeRtpPacket(unsigned short sequence, size_t size, int csrcNumber, int extensionWords, int paddingLength)
+{
+    std::vector<unsigned char> packet(size, 0x5A);
+    packet[0] = (unsigned char)(0x80 | (paddingLength > 0 ? 0x20 : 0) | (extensionWords > 0 ? 0x10 : 0) | (csrcNumber & 0x0f));
+    packet[1] = (unsigned char)((sequence % 8 == 7 ? 0x80 : 0) | 96);
+    packet[2] = (unsigned char)(sequence >> 8);
+    packet[3] = (unsigned char)(sequence & 0xff);
+    unsigned int timestamp = sequence / 8 * 3600;
+    packet[4] = (unsigned char)(timestamp >> 24);
+    packet[5] = (unsigned char)(timestamp >> 16);
+    packet[6] = (unsigned char)(timestamp >> 8);
+    packet[7] = (unsigned char)timestamp;
+    memset(&packet[8], 0x11, 4);
+
+    size_t offset = 12 + 4 * csrcNumber;
+    if (extensionWords > 0)
+    {
+        packet[offset + 2] = (unsigned char)(extensionWords >> 8);
+        packet[offset + 3] = (unsigned char)(extensionWords & 0xff);
+    }
+    if (paddingLength > 0)
+    {
+        packet[size - 1] = (unsigned char)paddingLength;
+    }
+    return packet;
+}
+
+/**
+* @brief rtp header parse of the gb28181 receiver, on packets of a ps stream \n
+* args: [threads] [milliseconds] [packet size]
+* most packets have the fixed header only, some carry csrcs, an extension or padding;
+* the parse keeps no state, so threads only share the read-only packets
+*/
+int BenchmarkRtpParse(int argc, char** argv)
+{
+    int maxThreads = argc > 0 ? atoi(argv[0]) : 8;
+    int milliseconds = argc > 1 ? atoi(argv[1]) : 2000;
+    int packetSize = argc > 2 ? atoi(argv[2]) : 1400;
+    if (maxThreads <= 0 || milliseconds <= 0 || packetSize < 128)
+    {
+        printf("invalid arguments\n");
+        return 1;
+    }
+
+    printf("threads: 1-%d, milliseconds: %d, packet: %d bytes\n", maxThreads, milliseconds, packetSize);
+
+    std::vector<std::vector<unsigned char>> packets;
+    for (unsigned short sequence = 0; sequence < 256; ++sequence)
+    {
+        int csrcNumber = sequence % 8 == 3 ? 2 : 0;
+        int extensionWords = sequence % 16 == 5 ? 2 : 0;
+        int paddingLength = sequence % 32 == 9 ? 4 : 0;
+        packets.push_back(MakeRtpPacket(sequence, packetSize, csrcNumber, extensionWords, paddingLength));
+    }
+
+    std::vector<int> steps = ThreadSteps(maxThreads);
+    for (size_t step = 0; step < steps.size(); ++step)
+    {
+        // per thread cursor and payload sum, a cache line apart, the sum keeps the parse from being optimized away
+        std::vector<unsigned long long> states(steps[step] * 16, 0);
+        std::atomic<long long> invalids(0);
+
+        std::vector<BenchmarkRole> roles;
+        BenchmarkRole parse = { "parse", steps[step], 64, [&](int index)
+        {
+            unsigned long long& cursor = states[index * 16];
+            unsigned long long& payloadSize = states[index * 16 + 1];
+            std::vector<unsigned char>& packet = packets[cursor++ & 0xff];
+
+            RTPHeader header;
+            size_t payloadLength = 0;
+            if (!ParseRtpHeader(&header, &packet[0], packet.size(), payloadLength))
+            {
+                invalids++;
+                return false;
+            }
+            payloadSize += payloadLength + header.marker;
+            return true;
+        } };
+        roles.push_back(parse);
+        RunRoles(roles, milliseconds);
+
+        unsigned long long payloadSize = 0;
+        for (int idx = 0; idx < steps[step]; ++idx)
+        {
+            payloadSize += states[idx * 16 + 1];
+        }
+        printf("  payload: %llu MB, invalid packets: %lld\n", payloadSize >> 20, invalids.load());
+    }
+
+    return 0;
+}
@@ -0,0 +1,66 @@
+
+#include "Benchmark.h"
+
+#include <cstdio>
+#include <cstring>
+
+struct BenchmarkEntry
+{
+    const char* name;
+    int(*run)(int argc, char** argv);
+};
+
+// numa affinity and the capture ring are built on windows apis, the others build on linux as well:
+// g++ -std=c++11 -O2 -pthread -I../Common -I../FaceDetector -I../FaceDetector/decode -I../FaceDetector/detect
+//     -I../../shortvideo/MuxService/Server -I../../GB28181/RtpFFmpeg/RtpFFmpeg/rtp
+//     Main.cpp BenchmarkFeatureCodec.cpp BenchmarkPools.cpp BenchmarkQueues.cpp BenchmarkBestFinder.cpp BenchmarkRtpParse.cpp BenchmarkClocks.cpp
+//     ../FaceDetector/detect/FeatureCodec.cpp ../FaceDetector/decode/DecodedFrameQueue.cpp ../../shortvideo/MuxService/Server/AvPacketPool.cpp
+//     $(pkg-config --cflags --libs opencv4 libavcodec libglog) -o benchmark
+static const BenchmarkEntry g_benchmarks[] = {
+    { "feature_codec", BenchmarkFeatureCodec },
+#ifdef _WIN32
+    { "numa_affinity", BenchmarkNumaAffinity },
+    { "capture_ring", BenchmarkCaptureRing },
+#endif
+    { "mat_pool", BenchmarkMatPool },
+    { "packet_pool", BenchmarkPacketPool },
+    { "decoded_frame_queue", BenchmarkDecodedFrameQueue },
+    { "capture_results_queue", BenchmarkCaptureResultsQueue },
+    { "best_finder", BenchmarkBestFinder },
+    { "rtp_parse", BenchmarkRtpParse },
+    { "clocks", BenchmarkClocks },
+};
+
+static const size_t g_benchmarkNumber = sizeof(g_benchmarks) / sizeof(g_benchmarks[0]);
+
+int main(int argc, char** argv)
+{
+    // Benchmark.exe [name [args...]], all benchmarks run without name
+    const char* name = argc > 1 ? argv[1] : nullptr;
+
+    int result = 0;
+    bool found = false;
+    for (size_t idx = 0; idx < g_benchmarkNumber; ++idx)
+    {
+        if (name && strcmp(name, g_benchmarks[idx].name) != 0)
+        {
+            continue;
+        }
+
+        found = true;
+        printf("==== %s ====\n", g_benchmarks[idx].name);
+        result |= g_benchmarks[idx].run(name ? argc - 2 : 0, name ? argv + 2 : nullptr);
+    }
+
+    if (!found)
+    {
+        printf("unknown benchmark: %s, available:\n", name);
+        for (size_t idx = 0; idx < g_benchmarkNumber; ++idx)
+        {
+            printf("  %s\n", g_benchmarks[idx].name);
+        }
+        return 1;
+    }
+    return result;
+}
+
@@ -0,0 +1,285 @@
+
+#ifndef _ASYNCLOGGER_HEADER_H_
+#define _ASYNCLOGGER_HEADER_H_
+
+#include "Metrics.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <ctime>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define GLOG_NO_ABBREVIATED_SEVERITIES
+#define GOOGLE_GLOG_DLL_DECL
+#include "glog/logging.h"
+
+/**
+* @brief glog file logger moved off the logging threads \n
+* glog formats a line on the calling thread and hands it to the logger of each severity file with its
+* log mutex held; this logger only copies the line into a ring there, and its flusher thread writes
+* batches into the file logger it replaced, so disk stalls no longer block decoding or detecting.
+* the calls are serialized by the glog mutex, so the ring has one producer and one consumer and takes no lock.
+* lines that do not fit the ring are dropped, counted in log_dropped_lines_total and reported in the file.
+* the crash signal handler flushes the file loggers behind the rings only, so the failure writer has to
+* call DrainInstalled first, or up to a flush interval of lines is lost with the process
+*/
+class AsyncLogger : public google::base::Logger
+{
+public:
+    /**
+    * @brief put the file loggers of INFO, WARNING and ERROR behind async loggers, call it after InitGoogleLogging \n
+    * FATAL stays synchronous, and glog drains the others before it aborts;
+    * glog owns the loggers from now on, ShutdownGoogleLogging deletes them after writing out what is left
+    */
+    static void Install(unsigned int ringSize = 4 << 20, int flushInterval = 200)
+    {
+        for (int severity = google::GLOG_INFO; severity < google::GLOG_FATAL; ++severity)
+        {
+            google::base::Logger* logger = google::base::GetLogger(severity);
+            if (logger && !dynamic_cast<AsyncLogger*>(logger))
+            {
+                AsyncLogger* asyncLogger = new AsyncLogger(logger, severity, ringSize, flushInterval);
+                google::base::SetLogger(severity, asyncLogger);
+                Installed()[severity] = asyncLogger;
+            }
+        }
+    }
+
+    /**
+    * @brief write out the rings of all installed loggers, for the failure writer of a crash \n
+    * a ring whose drain is held by another thread, maybe the crashed one, is skipped after 100 ms
+    */
+    static void DrainInstalled()
+    {
+        for (int severity = google::GLOG_INFO; severity < google::GLOG_FATAL; ++severity)
+        {
+            AsyncLogger* asyncLogger = Installed()[severity];
+            if (asyncLogger)
+            {
+                asyncLogger->TryDrain();
+            }
+        }
+    }
+
+    AsyncLogger(google::base::Logger* logger, int severity, unsigned int ringSize, int flushInterval)
+        : _logger(logger), _severity(severity), _ring(), _mask(0), _head(0), _tail(0), _dropped(0)
+        , _droppedMetric(MetricsRegistry::Counter("log_dropped_lines_total", std::string("severity=\"") + google::GetLogSeverityName(severity) + "\""))
+        , _flushInterval((std::max)(flushInterval, 1)), _flushing(false), _flush(), _locker(), _condition(), _drainLocker(), _batch()
+    {
+        unsigned int size = 1 << 12;
+        while (size < ringSize && size < (1u << 30))
+        {
+            size <<= 1;
+        }
+        _ring.resize(size);
+        _mask = size - 1;
+
+        _flushing = true;
+        _flush = std::thread(&AsyncLogger::Flushing, this);
+    }
+
+    virtual ~AsyncLogger()
+    {
+        if (Installed()[_severity] == this)
+        {
+            Installed()[_severity] = nullptr;
+        }
+
+        _flushing = false;
+        _condition.notify_one();
+        if (_flush.joinable())
+        {
+            _flush.join();
+        }
+        Drain(true);
+    }
+
+    virtual void Write(bool force_flush, time_t timestamp, const char* message, int message_len)
+    {
+        // glog writes an empty forced line to every logger before it aborts on FATAL
+        if (message_len <= 0)
+        {
+            if (force_flush)
+            {
+                TryDrain();
+            }
+            return;
+        }
+
+        unsigned long long head = _head.load(std::memory_order_relaxed);
+        unsigned long long tail = _tail.load(std::memory_order_acquire);
+        unsigned long long size = sizeof(RecordHeader) + message_len;
+        if (size > _ring.size() - (head - tail))
+        {
+            _dropped.fetch_add(1, std::memory_order_relaxed);
+            _droppedMetric->Add();
+            return;
+        }
+
+        RecordHeader header;
+        header.timestamp = (long long)timestamp;
+        header.size = (unsigned int)message_len;
+        header.forceFlush = force_flush ? 1 : 0;
+        CopyIn(head, &header, sizeof(header));
+        CopyIn(head + sizeof(header), message, message_len);
+        _head.store(head + size, std::memory_order_release);
+
+        if (force_flush)
+        {
+            _condition.notify_one();
+        }
+    }
+
+    virtual void Flush()
+    {
+        Drain(true);
+    }
+
+    virtual google::uint32 LogSize()
+    {
+        return _logger->LogSize();
+    }
+
+private:
+    struct RecordHeader
+    {
+        long long timestamp;
+        unsigned int size;
+        unsigned int forceFlush;
+    };
+
+    /**
+    * @brief loggers by severity, for the crash path, which has no other way to reach them \n
+    * a zero initialized array, so it needs no thread safe static initialization
+    */
+    static AsyncLogger** Installed()
+    {
+        static AsyncLogger* loggers[google::NUM_SEVERITIES] = { nullptr };
+        return loggers;
+    }
+
+    void Flushing()
+    {
+        while (_flushing)
+        {
+            {
+                std::unique_lock<std::mutex> ul(_locker);
+                _condition.wait_for(ul, std::chrono::milliseconds(_flushInterval));
+            }
+            Drain(false);
+        }
+    }
+
+    /**
+    * @brief write everything in the ring as one batch into the file logger \n
+    * the ring space is released before the write, so producers are not held by a slow disk
+    */
+    void Drain(bool forceFlush)
+    {
+        std::lock_guard<std::mutex> lg(_drainLocker);
+        DrainLocked(forceFlush);
+    }
+
+    /**
+    * @brief Drain for the abort paths, where the drain may be held by a thread that never returns \n
+    */
+    void TryDrain()
+    {
+        std::unique_lock<std::mutex> ul(_drainLocker, std::defer_lock);
+        for (int idx = 0; idx < 100 && !ul.try_lock(); ++idx)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        if (ul.owns_lock())
+        {
+            DrainLocked(true);
+        }
+    }
+
+    void DrainLocked(bool forceFlush)
+    {
+        unsigned long long tail = _tail.load(std::memory_order_relaxed);
+        unsigned long long head = _head.load(std::memory_order_acquire);
+        time_t timestamp = time(nullptr);
+        _batch.clear();
+        while (tail < head)
+        {
+            RecordHeader header;
+            CopyOut(tail, &header, sizeof(header));
+            size_t offset = _batch.size();
+            _batch.resize(offset + header.size);
+            CopyOut(tail + sizeof(header), &_batch[offset], header.size);
+
+            tail += sizeof(header) + header.size;
+            timestamp = (time_t)header.timestamp;
+            forceFlush = forceFlush || header.forceFlush != 0;
+        }
+        _tail.store(tail, std::memory_order_release);
+
+        long long dropped = _dropped.exchange(0, std::memory_order_relaxed);
+        if (dropped > 0)
+        {
+            std::string line = std::string(google::GetLogSeverityName(_severity)) + " async logger: " + std::to_string(dropped)
+                + " lines dropped, the ring of " + std::to_string(_ring.size() >> 10) + " KB was full\n";
+            _batch.insert(_batch.end(), line.begin(), line.end());
+        }
+
+        if (!_batch.empty())
+        {
+            _logger->Write(forceFlush, timestamp, &_batch[0], (int)_batch.size());
+        }
+        if (forceFlush)
+        {
+            _logger->Flush();
+        }
+    }
+
+    inline void CopyIn(unsigned long long position, const void* data, size_t size)
+    {
+        size_t offset = (size_t)(position & _mask);
+        size_t first = (std::min)(size, _ring.size() - offset);
+        memcpy(&_ring[offset], data, first);
+        memcpy(&_ring[0], (const char*)data + first, size - first);
+    }
+
+    inline void CopyOut(unsigned long long position, void* data, size_t size) const
+    {
+        size_t offset = (size_t)(position & _mask);
+        size_t first = (std::min)(size, _ring.size() - offset);
+        memcpy(data, &_ring[offset], first);
+        memcpy((char*)data + first, &_ring[0], size - first);
+    }
+
+private:
+    google::base::Logger* _logger;  // owned by glog
+    int _severity;
+
+    std::vector<char> _ring;
+    unsigned long long _mask;
+    std::atomic<unsigned long long> _head;    // written by the producer under the glog mutex
+    std::atomic<unsigned long long> _tail;    // written by the drain
+    std::atomic<long long> _dropped;
+    MetricCounter* _droppedMetric;
+
+    int _flushInterval;
+    volatile bool _flushing;
+    std::thread _flush;
+    std::mutex _locker;
+    std::condition_variable _condition;
+
+    std::mutex _drainLocker;
+    std::vector<char> _batch;
+
+private:
+    AsyncLogger(const AsyncLogger&);
+    AsyncLogger& operator=(const AsyncLogger&);
+};
+
+#endif
+
@@ -2,6 +2,8 @@
 #ifndef _BOOSTLOGGER_HEADER_H_
 #define _BOOSTLOGGER_HEADER_H_
 
+#include "LogThrottle.h"
+
 #include <string>
 #include <fstream>
 
@@ -27,7 +29,15 @@
 
 #define LOCAL_LOG(module, lvl) BOOST_LOG_SEV(module##_sclogger, boost::log::trivial::lvl)
 
+// at most one record every ms milliseconds from this site, a statement of its own like LOG_EVERY_MS
+#define LOCAL_LOG_EVERY_MS(module, lvl, ms) \
+    static LogThrottle LOG_THROTTLE; \
+    long long LOG_SUPPRESSED = 0; \
+    if (LOG_THROTTLE.Allow(ms, LOG_SUPPRESSED)) \
+        LOCAL_LOG(module, lvl) << LogSuppressed(LOG_SUPPRESSED)
+
 // ----------------- logger initialization --------------------
+// a sink with Asynchronous=true in boost_log_setup writes from its own thread, like AsyncLogger does for glog
 #define INITIALIZE_BOOST_LOGGER() boost::log::add_common_attributes();\
     boost::log::register_simple_formatter_factory<boost::log::trivial::severity_level, char>("Severity");\
     boost::log::register_simple_filter_factory<boost::log::trivial::severity_level, char>("Severity");\
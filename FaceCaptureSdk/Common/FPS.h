@@ -1,20 +1,27 @@
 #ifndef _FPS_HEADER_H_
 #define _FPS_HEADER_H_
 
-#include <time.h>
+#include "TimeStamp.h"
+#include "Metrics.h"
+
+#include <atomic>
 #include <mutex>
 
 #define GLOG_NO_ABBREVIATED_SEVERITIES
 #define GOOGLE_GLOG_DLL_DECL
 #include "glog/logging.h"
 
+/**
+* @brief log frames per second every duration milliseconds \n
+* measured on the monotonic wall clock, clock() is cpu time of the process and
+* runs faster than the wall with several busy threads
+*/
 class FPStat
 {
 public:
-    FPStat(clock_t duration, bool multithread = false) : _count(0), _begin(clock()), _duration(duration), _multithread(multithread)
+    FPStat(long long duration, bool multithread = false) : _count(0), _begin(TimeStamp<MILLISECONDS>::Now()), _duration(duration), _multithread(multithread)
     {
         _begin += _duration;
-        _seconds = _duration / 1000.0f;
     }
 
     void Stat(size_t add, const std::string& msg = "")
@@ -25,10 +32,12 @@ public:
         }
 
         _count += add;
-        if (clock() >= _begin)
+        long long now = TimeStamp<MILLISECONDS>::Now();
+        if (now >= _begin)
         {
-            LOG(INFO) << msg << " FPS: " << _count / _seconds;
-            _begin = clock() + _duration;
+            // the real interval, a stalled thread reports late
+            LOG(INFO) << msg << " FPS: " << _count * 1000.0 / (now - _begin + _duration);
+            _begin = now + _duration;
             _count = 0;
         }
 
@@ -40,25 +49,43 @@ public:
 
 private:
     size_t _count;
-    double _seconds;
-    clock_t _begin;
-    clock_t _duration;
+    long long _begin;
+    long long _duration;
 
     bool _multithread;
     std::mutex _locker;
 };
 
+/**
+* @brief every STATISTIC_FPS site adds to its own stage_items_total counter (labeled with the function)
+* whether LOG_FPS is defined or not, LOG_FPS only adds the log line \n
+* the counter is cached in a function static atomic for the same reason as in RECORD_COSTS
+*/
+#define COUNT_ITEMS(size) do {\
+        static std::atomic<MetricCounter*> cachedCounter;\
+        MetricCounter* counter = cachedCounter.load(std::memory_order_acquire);\
+        if (!counter)\
+        {\
+            counter = MetricsRegistry::Counter("stage_items_total", "function=\"" + std::string(__FUNCTION__) + "\"");\
+            cachedCounter.store(counter, std::memory_order_release);\
+        }\
+        counter->Add(size);\
+    } while (0)
+
 #if defined(LOG_FPS)
 
 #define DECLARE_FPS(ms) FPStat fpstat(ms)
 #define DECLARE_FPS_STATIC(ms) static FPStat fpstat(ms, true)
-#define STATISTIC_FPS(size, msg) fpstat.Stat(size, msg)
+#define STATISTIC_FPS(size, msg) do {\
+        fpstat.Stat(size, msg);\
+        COUNT_ITEMS(size);\
+    } while (0)
 
 #else
 
 #define DECLARE_FPS(ms) 
 #define DECLARE_FPS_STATIC(ms)
-#define STATISTIC_FPS(size, msg) 
+#define STATISTIC_FPS(size, msg) COUNT_ITEMS(size)
 
 #endif
 
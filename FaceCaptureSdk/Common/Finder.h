@@ -3,6 +3,7 @@
 #define _FINDER_HEADER_H_
 
 #include <map>
+#include <list>
 
 #include <thread>
 #include <mutex>
@@ -22,10 +23,7 @@ public:
 private:
     static long long Now()
     {
-        typedef std::chrono::milliseconds time_precision;
-        typedef std::chrono::time_point<std::chrono::system_clock, time_precision> now_time_point;
-        now_time_point tp = std::chrono::time_point_cast<time_precision>(std::chrono::steady_clock::now());
-        return tp.time_since_epoch().count();
+        return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
     }
 
     struct StatInfo 
@@ -62,10 +60,10 @@ public:
     bool Find(const KeyType& key, ValueType& value, const GroupType& groupValue)
     {
         std::lock_guard<std::mutex> lg(_locker);
-        GroupMapType::iterator git = _group_mapper.find(groupValue);
+        typename GroupMapType::iterator git = _group_mapper.find(groupValue);
         if (git != _group_mapper.end())
         {
-            MapType::iterator it = git->second.find(key);
+            typename MapType::iterator it = git->second.find(key);
             if (it != git->second.end())
             {
                 value = it->second.value;
@@ -79,7 +77,7 @@ public:
     void Add(const KeyType& key, const ValueType& value, long long interval, const GroupType& groupValue, long long enterTimeout = 0, long long leaveTimeout = 0)
     {
         std::lock_guard<std::mutex> lg(_locker);
-        GroupMapType::iterator git = _group_mapper.find(groupValue);
+        typename GroupMapType::iterator git = _group_mapper.find(groupValue);
         if (git == _group_mapper.end())
         {
             MapType mapnode;
@@ -93,7 +91,7 @@ public:
         else
         {
             long long timeNow = Now();
-            MapType::iterator it = git->second.find(key);
+            typename MapType::iterator it = git->second.find(key);
             if (it == git->second.end())
             {
                 git->second.insert(std::make_pair(key, StatInfo{ value, enterTimeout, interval, leaveTimeout, timeNow, timeNow }));
@@ -124,10 +122,10 @@ public:
     void Update(const KeyType& key, const ValueType& value, const GroupType& groupValue, bool updateTimeStamp = false)
     {
         std::lock_guard<std::mutex> lg(_locker);
-        GroupMapType::iterator git = _group_mapper.find(groupValue);
+        typename GroupMapType::iterator git = _group_mapper.find(groupValue);
         if (git != _group_mapper.end())
         {
-            MapType::iterator it = git->second.find(key);
+            typename MapType::iterator it = git->second.find(key);
             if (it != git->second.end())
             {
                 it->second.value = value;
@@ -143,14 +141,14 @@ public:
     void Find(const std::vector<KeyType>& keys, std::vector<size_t>& founds, std::vector<size_t>& notfounds, const GroupType& groupValue)
     {
         std::lock_guard<std::mutex> lg(_locker);
-        GroupMapType::iterator git = _group_mapper.find(groupValue);
+        typename GroupMapType::iterator git = _group_mapper.find(groupValue);
         if (git != _group_mapper.end())
         {
             MapType& mapnode = git->second;
             long long timeNow = Now();
             for (size_t idx = 0; idx < keys.size(); ++idx)
             {
-                MapType::iterator it = mapnode.find(key);
+                typename MapType::iterator it = mapnode.find(keys[idx]);
                 if (it != mapnode.end())
                 {
                     it->second.accesstime = timeNow;
@@ -174,14 +172,14 @@ public:
     void FindIn(const std::vector<KeyType>& keys, std::vector<size_t>& founds, const GroupType& groupValue)
     {
         std::lock_guard<std::mutex> lg(_locker);
-        GroupMapType::iterator git = _group_mapper.find(groupValue);
+        typename GroupMapType::iterator git = _group_mapper.find(groupValue);
         if (git != _group_mapper.end())
         {
             MapType& mapnode = git->second;
             long long timeNow = Now();
             for (size_t idx = 0; idx < keys.size(); ++idx)
             {
-                MapType::iterator it = mapnode.find(key);
+                typename MapType::iterator it = mapnode.find(keys[idx]);
                 if (it != mapnode.end())
                 {
                     it->second.accesstime = timeNow;
@@ -194,13 +192,13 @@ public:
     void FindNotIn(const std::vector<KeyType>& keys, std::vector<size_t>& notfounds, const GroupType& groupValue)
     {
         std::lock_guard<std::mutex> lg(_locker);
-        GroupMapType::iterator git = _group_mapper.find(groupValue);
+        typename GroupMapType::iterator git = _group_mapper.find(groupValue);
         if (git != _group_mapper.end())
         {
             MapType& mapnode = git->second;
             for (size_t idx = 0; idx < keys.size(); ++idx)
             {
-                MapType::iterator it = mapnode.find(keys[idx]);
+                typename MapType::iterator it = mapnode.find(keys[idx]);
                 if (it == mapnode.end())
                 {
                     notfounds.push_back(idx);
@@ -219,7 +217,7 @@ public:
     void Add(const std::vector<KeyType>& keys, const std::vector<ValueType>& values, long long interval, const GroupType& groupValue, long long enterTimeout = 0, long long leaveTimeout= 0)
     {
         std::lock_guard<std::mutex> lg(_locker);
-        GroupMapType::iterator git = _group_mapper.find(groupValue);
+        typename GroupMapType::iterator git = _group_mapper.find(groupValue);
         if (git != _group_mapper.end())
         {
             MapType& mapnode = git->second;
@@ -227,10 +225,10 @@ public:
             long long timeNow = Now();
             for (size_t idx = 0; idx < keys.size(); ++idx)
             {
-                MapType::iterator it = mapnode.find(keys[idx]);
+                typename MapType::iterator it = mapnode.find(keys[idx]);
                 if (it == mapnode.end())
                 {
-                    mapnode.insert(std::make_pair(keys[idx], StatInfo{ values[idx], enterTimeout, interval, timeNow, timeNow }));
+                    mapnode.insert(std::make_pair(keys[idx], StatInfo{ values[idx], enterTimeout, interval, leaveTimeout, timeNow, timeNow }));
 #ifdef BESTFINDER_STATISTIC
                     ++_statistic;
 #endif
@@ -250,9 +248,10 @@ public:
         else
         {
             MapType mapnode;
+            long long timeNow = Now();
             for (size_t idx = 0; idx < keys.size(); ++idx)
             {
-                mapnode.insert(std::make_pair(keys[idx], StatInfo{ values[idx], enterTimeout, interval, timeNow, timeNow }));
+                mapnode.insert(std::make_pair(keys[idx], StatInfo{ values[idx], enterTimeout, interval, leaveTimeout, timeNow, timeNow }));
 #ifdef BESTFINDER_STATISTIC
                 ++_statistic;
 #endif
@@ -264,14 +263,14 @@ public:
     void Update(const std::vector<KeyType>& keys, const std::vector<ValueType>& values, const GroupType& groupValue, bool updateTimeStamp = false)
     {
         std::lock_guard<std::mutex> lg(_locker);
-        GroupMapType::iterator git = _group_mapper.find(groupValue);
+        typename GroupMapType::iterator git = _group_mapper.find(groupValue);
         if (git != _group_mapper.end())
         {
             MapType& mapnode = git->second;
             long long timeNow = Now();
             for (size_t idx = 0; idx < keys.size(); ++idx)
             {
-                MapType::iterator it = mapnode.find(keys[idx]);
+                typename MapType::iterator it = mapnode.find(keys[idx]);
                 if (it != mapnode.end())
                 {
                     it->second.value = values[idx];
@@ -285,6 +284,71 @@ public:
         }
     }
 
+    /**
+    * @brief move all keys of the group to target \n
+    * times are kept, so values are reported by target as if they were never moved
+    */
+    void Transfer(const GroupType& groupValue, BestFinder& target)
+    {
+        MapType mapnode;
+        {
+            std::lock_guard<std::mutex> lg(_locker);
+            typename GroupMapType::iterator git = _group_mapper.find(groupValue);
+            if (git == _group_mapper.end())
+            {
+                return;
+            }
+            mapnode.swap(git->second);
+            _group_mapper.erase(git);
+#ifdef BESTFINDER_STATISTIC
+            _statistic -= (int)mapnode.size();
+#endif
+        }
+
+        std::lock_guard<std::mutex> lg(target._locker);
+        MapType& targetnode = target._group_mapper[groupValue];
+        targetnode.insert(mapnode.begin(), mapnode.end());
+#ifdef BESTFINDER_STATISTIC
+        target._statistic += (int)mapnode.size();
+#endif
+    }
+
+    /**
+    * @brief report values of all keys of the group now and remove them \n
+    */
+    void Flush(const GroupType& groupValue)
+    {
+        std::list<ValueType> values;
+        {
+            std::lock_guard<std::mutex> lg(_locker);
+            typename GroupMapType::iterator git = _group_mapper.find(groupValue);
+            if (git == _group_mapper.end())
+            {
+                return;
+            }
+            for (typename MapType::iterator it = git->second.begin(); it != git->second.end(); ++it)
+            {
+                values.push_back(it->second.value);
+            }
+#ifdef BESTFINDER_STATISTIC
+            _statistic -= (int)git->second.size();
+#endif
+            _group_mapper.erase(git);
+        }
+
+        if (callback_one)
+        {
+            for (typename std::list<ValueType>::iterator it = values.begin(); it != values.end(); ++it)
+            {
+                callback_one(_context, *it);
+            }
+        }
+        if (callback_multiple && values.size() > 0)
+        {
+            callback_multiple(_context, values);
+        }
+    }
+
     ~BestFinder()
     {
         if (_checking)
@@ -306,10 +370,10 @@ private:
             size_t valuesSize = 0;
             {
                 std::lock_guard<std::mutex> lg(_locker);
-                for (GroupMapType::iterator git = _group_mapper.begin(); git != _group_mapper.end(); ++git)
+                for (typename GroupMapType::iterator git = _group_mapper.begin(); git != _group_mapper.end(); ++git)
                 {
                     MapType& mapnode = git->second;
-                    MapType::iterator it = mapnode.begin();
+                    typename MapType::iterator it = mapnode.begin();
                     long long timeNow = Now();
                     while (it != mapnode.end())
                     {
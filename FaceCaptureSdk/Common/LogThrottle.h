@@ -0,0 +1,76 @@
+
+#ifndef _LOGTHROTTLE_HEADER_H_
+#define _LOGTHROTTLE_HEADER_H_
+
+#include "TimeStamp.h"
+
+#include <atomic>
+#include <ostream>
+
+/**
+* @brief state of one rate limited log site \n
+* it is kept in a function static: the atomics start from the zero initialization of static storage
+* and constructing them does nothing, so the unguarded static initialization of vs2013 is harmless
+*/
+struct LogThrottle
+{
+    std::atomic<long long> next;        // milliseconds, the earliest time the site logs again
+    std::atomic<long long> suppressed;  // lines skipped since the site logged last
+
+    /**
+    * @brief whether the site logs now, at most once every interval milliseconds \n
+    * when it does, suppressedNumber is the number of lines skipped since the last one
+    */
+    inline bool Allow(long long interval, long long& suppressedNumber)
+    {
+        long long now = TimeStamp<MILLISECONDS>::Now();
+        long long due = next.load(std::memory_order_relaxed);
+        if (now < due || !next.compare_exchange_strong(due, now + interval, std::memory_order_relaxed))
+        {
+            suppressed.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        suppressedNumber = suppressed.exchange(0, std::memory_order_relaxed);
+        return true;
+    }
+};
+
+/**
+* @brief streamed in front of a throttled line, tells how many lines of the site were skipped \n
+*
+*/
+struct LogSuppressed
+{
+    explicit LogSuppressed(long long number) : number(number) {}
+
+    long long number;
+};
+
+inline std::ostream& operator<<(std::ostream& os, const LogSuppressed& logSuppressed)
+{
+    if (logSuppressed.number > 0)
+    {
+        os << "(" << logSuppressed.number << " similar lines suppressed) ";
+    }
+    return os;
+}
+
+#define LOG_THROTTLE_VARNAME(base, line) LOG_THROTTLE_VARNAME_CONCAT(base, line)
+#define LOG_THROTTLE_VARNAME_CONCAT(base, line) base ## line
+
+#define LOG_THROTTLE LOG_THROTTLE_VARNAME(log_throttle_, __LINE__)
+#define LOG_SUPPRESSED LOG_THROTTLE_VARNAME(log_suppressed_, __LINE__)
+
+/**
+* @brief glog LOG(severity) that writes at most once every ms milliseconds per call site,
+* for error paths that can fire on every packet or frame \n
+* like LOG_EVERY_N it declares variables, so use it as a statement of its own, not as the body of an unbraced if
+*/
+#define LOG_EVERY_MS(severity, ms) \
+    static LogThrottle LOG_THROTTLE; \
+    long long LOG_SUPPRESSED = 0; \
+    if (LOG_THROTTLE.Allow(ms, LOG_SUPPRESSED)) \
+        LOG(severity) << LogSuppressed(LOG_SUPPRESSED)
+
+#endif
+
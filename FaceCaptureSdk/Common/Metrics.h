@@ -0,0 +1,333 @@
+
+#ifndef _METRICS_HEADER_H_
+#define _METRICS_HEADER_H_
+
+#include "AutoLock.h"
+#include "TimeStamp.h"
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <string>
+
+/**
+* @brief monotonic event counter \n
+* updates are one relaxed atomic add, no lock is taken
+*/
+class MetricCounter
+{
+public:
+    MetricCounter() : _value(0) {}
+
+    inline void Add(long long value = 1)
+    {
+        _value.fetch_add(value, std::memory_order_relaxed);
+    }
+
+    inline long long Value() const
+    {
+        return _value.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<long long> _value;
+
+private:
+    MetricCounter(const MetricCounter&);
+    MetricCounter& operator=(const MetricCounter&);
+};
+
+/**
+* @brief value that goes up and down, like a queue length \n
+*
+*/
+class MetricGauge
+{
+public:
+    MetricGauge() : _value(0) {}
+
+    inline void Set(long long value)
+    {
+        _value.store(value, std::memory_order_relaxed);
+    }
+
+    inline void Add(long long value)
+    {
+        _value.fetch_add(value, std::memory_order_relaxed);
+    }
+
+    inline long long Value() const
+    {
+        return _value.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<long long> _value;
+
+private:
+    MetricGauge(const MetricGauge&);
+    MetricGauge& operator=(const MetricGauge&);
+};
+
+/**
+* @brief latency histogram with log-linear buckets, like hdr histogram \n
+* every power of 2 is split into 8 linear buckets, so a recorded value is kept
+* within 12.5% over the whole 64 bits range in a fixed 4 KB;
+* values are microseconds by convention, recording is lock free
+*/
+class MetricHistogram
+{
+public:
+    enum { SUB_BUCKET_BITS = 3, SUB_BUCKET_NUMBER = 1 << SUB_BUCKET_BITS, BUCKET_NUMBER = SUB_BUCKET_NUMBER * (64 - SUB_BUCKET_BITS + 1) };
+
+public:
+    MetricHistogram() : _count(0), _sum(0), _max(0)
+    {
+        for (int idx = 0; idx < BUCKET_NUMBER; ++idx)
+        {
+            _buckets[idx].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    inline void Record(long long value)
+    {
+        if (value < 0)
+        {
+            value = 0;
+        }
+
+        _buckets[BucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+        _count.fetch_add(1, std::memory_order_relaxed);
+        _sum.fetch_add(value, std::memory_order_relaxed);
+
+        long long max = _max.load(std::memory_order_relaxed);
+        while (value > max && !_max.compare_exchange_weak(max, value, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    /**
+    * @brief add the records of other, so that threads can record into histograms of their own and be summed up later \n
+    *
+    */
+    void Merge(const MetricHistogram& other)
+    {
+        for (int idx = 0; idx < BUCKET_NUMBER; ++idx)
+        {
+            _buckets[idx].fetch_add(other._buckets[idx].load(std::memory_order_relaxed), std::memory_order_relaxed);
+        }
+        _count.fetch_add(other.Count(), std::memory_order_relaxed);
+        _sum.fetch_add(other.Sum(), std::memory_order_relaxed);
+
+        long long value = other.Max();
+        long long max = _max.load(std::memory_order_relaxed);
+        while (value > max && !_max.compare_exchange_weak(max, value, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    inline long long Count() const { return _count.load(std::memory_order_relaxed); }
+    inline long long Sum() const { return _sum.load(std::memory_order_relaxed); }
+    inline long long Max() const { return _max.load(std::memory_order_relaxed); }
+
+    /**
+    * @brief value at quantile (0.0 - 1.0), the upper bound of the bucket it falls in \n
+    * buckets are read while they are updated, so the result is approximate under load
+    */
+    long long Percentile(double quantile) const
+    {
+        long long count = 0;
+        long long buckets[BUCKET_NUMBER];
+        for (int idx = 0; idx < BUCKET_NUMBER; ++idx)
+        {
+            buckets[idx] = _buckets[idx].load(std::memory_order_relaxed);
+            count += buckets[idx];
+        }
+        if (count == 0)
+        {
+            return 0;
+        }
+
+        long long rank = (long long)(quantile * count + 0.5);
+        rank = (std::max)(1LL, (std::min)(rank, count));
+
+        long long seen = 0;
+        for (int idx = 0; idx < BUCKET_NUMBER; ++idx)
+        {
+            seen += buckets[idx];
+            if (seen >= rank)
+            {
+                return (std::min)(BucketUpperBound(idx), Max());
+            }
+        }
+        return Max();
+    }
+
+    /**
+    * @brief index of the bucket holding value \n
+    * values below 2 * SUB_BUCKET_NUMBER have a bucket each
+    */
+    static inline int BucketIndex(long long value)
+    {
+        unsigned long long bits = (unsigned long long)value;
+        if (bits < SUB_BUCKET_NUMBER)
+        {
+            return (int)bits;
+        }
+
+        int msb = 0;
+        for (int shift = 32; shift > 0; shift >>= 1)
+        {
+            if (bits >> (msb + shift))
+            {
+                msb += shift;
+            }
+        }
+        int exponent = msb - SUB_BUCKET_BITS;
+        return SUB_BUCKET_NUMBER + exponent * SUB_BUCKET_NUMBER + (int)((bits >> exponent) & (SUB_BUCKET_NUMBER - 1));
+    }
+
+    static inline long long BucketUpperBound(int index)
+    {
+        if (index < SUB_BUCKET_NUMBER)
+        {
+            return index;
+        }
+        int exponent = (index - SUB_BUCKET_NUMBER) / SUB_BUCKET_NUMBER;
+        unsigned long long lower = (unsigned long long)(SUB_BUCKET_NUMBER + (index & (SUB_BUCKET_NUMBER - 1))) << exponent;
+        return (long long)(lower + ((1ULL << exponent) - 1));
+    }
+
+private:
+    std::atomic<long long> _buckets[BUCKET_NUMBER];
+    std::atomic<long long> _count;
+    std::atomic<long long> _sum;
+    std::atomic<long long> _max;
+
+private:
+    MetricHistogram(const MetricHistogram&);
+    MetricHistogram& operator=(const MetricHistogram&);
+};
+
+/**
+* @brief process wide registry of named metrics \n
+* a metric is identified by name and labels (prometheus style, like source="cam1"),
+* lookup takes a lock, so call sites keep the returned pointer; metrics are never removed
+* and their pointers stay valid until the process exits
+* it is a template only to keep its static members in this header, like XMatPool
+*/
+template<int Instance = 0>
+class XMetricsRegistry
+{
+public:
+    static MetricCounter* Counter(const std::string& name, const std::string& labels = "")
+    {
+        return Find(_counters, name, labels);
+    }
+
+    static MetricGauge* Gauge(const std::string& name, const std::string& labels = "")
+    {
+        return Find(_gauges, name, labels);
+    }
+
+    static MetricHistogram* Histogram(const std::string& name, const std::string& labels = "")
+    {
+        return Find(_histograms, name, labels);
+    }
+
+    /**
+    * @brief call visitor(name, labels, metric) for every metric, ordered by name \n
+    * visitor should have an overload for each metric type
+    */
+    template<typename Visitor>
+    static void Visit(Visitor& visitor)
+    {
+        AUTOLOCK(_locker);
+        for (auto iter = _counters.begin(); iter != _counters.end(); ++iter)
+        {
+            visitor(iter->first.first, iter->first.second, (const MetricCounter&)*iter->second);
+        }
+        for (auto iter = _gauges.begin(); iter != _gauges.end(); ++iter)
+        {
+            visitor(iter->first.first, iter->first.second, (const MetricGauge&)*iter->second);
+        }
+        for (auto iter = _histograms.begin(); iter != _histograms.end(); ++iter)
+        {
+            visitor(iter->first.first, iter->first.second, (const MetricHistogram&)*iter->second);
+        }
+    }
+
+private:
+    typedef std::pair<std::string, std::string> MetricKey;
+
+    template<typename Metric>
+    static Metric* Find(std::map<MetricKey, std::shared_ptr<Metric>>& metrics, const std::string& name, const std::string& labels)
+    {
+        AUTOLOCK(_locker);
+        std::shared_ptr<Metric>& metric = metrics[MetricKey(name, labels)];
+        if (!metric)
+        {
+            metric = std::make_shared<Metric>();
+        }
+        return metric.get();
+    }
+
+private:
+    static std::mutex _locker;
+    static std::map<MetricKey, std::shared_ptr<MetricCounter>> _counters;
+    static std::map<MetricKey, std::shared_ptr<MetricGauge>> _gauges;
+    static std::map<MetricKey, std::shared_ptr<MetricHistogram>> _histograms;
+
+private:
+    XMetricsRegistry();
+    XMetricsRegistry(const XMetricsRegistry&);
+    XMetricsRegistry& operator=(const XMetricsRegistry&);
+};
+
+template<int Instance>
+std::mutex XMetricsRegistry<Instance>::_locker;
+
+template<int Instance>
+std::map<typename XMetricsRegistry<Instance>::MetricKey, std::shared_ptr<MetricCounter>> XMetricsRegistry<Instance>::_counters;
+
+template<int Instance>
+std::map<typename XMetricsRegistry<Instance>::MetricKey, std::shared_ptr<MetricGauge>> XMetricsRegistry<Instance>::_gauges;
+
+template<int Instance>
+std::map<typename XMetricsRegistry<Instance>::MetricKey, std::shared_ptr<MetricHistogram>> XMetricsRegistry<Instance>::_histograms;
+
+typedef XMetricsRegistry<> MetricsRegistry;
+
+/**
+* @brief records the microseconds from construction to Stop or destruction \n
+*
+*/
+class MetricTimer
+{
+public:
+    explicit MetricTimer(MetricHistogram* histogram) : _histogram(histogram), _start(TimeStamp<MICROSECONDS>::Now()) {}
+    ~MetricTimer() { Stop(); }
+
+    inline long long Stop()
+    {
+        long long costs = TimeStamp<MICROSECONDS>::Now() - _start;
+        if (_histogram)
+        {
+            _histogram->Record(costs);
+            _histogram = nullptr;
+        }
+        return costs;
+    }
+
+private:
+    MetricHistogram* _histogram;
+    long long _start;
+
+private:
+    MetricTimer(const MetricTimer&);
+    MetricTimer& operator=(const MetricTimer&);
+};
+
+#endif
+
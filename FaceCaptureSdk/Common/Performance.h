@@ -2,6 +2,12 @@
 #ifndef _PERFORMANCE_HEADER_H_
 #define _PERFORMANCE_HEADER_H_
 
+#include "Metrics.h"
+#include "TscClock.h"
+
+#include <atomic>
+#include <string>
+
 #if defined(DEVELOPMENT)
 
 #define PRINT printf
@@ -16,26 +22,53 @@
 
 #endif
 
+/**
+* @brief stage costs are always recorded into the stage_costs_us histograms of MetricsRegistry,
+* labeled with function and module (total for function costs), LOG_PERFORMANCE prints them as well \n
+* the histogram is looked up once per call site and kept in a function static atomic, like LogThrottle:
+* vs2013 does not guard the initialization of statics, a pointer initialized by the first call could be
+* seen null by a racing thread, the atomic starts from the zero initialization of static storage instead,
+* racing threads may both look it up, and get the same pointer from the registry
+* stages are timed with TscClock, a counter read per timestamp instead of a steady_clock call
+*/
+#define START_EVALUATE(module) long long evaluate_start_##module = TscClock::Microseconds()
+#define COSTS(module) ((TscClock::Microseconds() - evaluate_start_##module) / 1000)
+
+#define RECORD_COSTS(module, costs) do {\
+        static std::atomic<MetricHistogram*> cachedHistogram;\
+        MetricHistogram* histogram = cachedHistogram.load(std::memory_order_acquire);\
+        if (!histogram)\
+        {\
+            histogram = MetricsRegistry::Histogram("stage_costs_us", "function=\"" + std::string(__FUNCTION__) + "\",module=\"" + module + "\"");\
+            cachedHistogram.store(histogram, std::memory_order_release);\
+        }\
+        histogram->Record(costs);\
+    } while (0)
+
+#define START_FUNCTION_EVALUATE() START_EVALUATE(this_function)
+
 #ifdef LOG_PERFORMANCE
 
-#define START_EVALUATE(module) clock_t clock_t_##module = clock()
-#define PRINT_COSTS(module) PRINT("%s::%s costs: %d\n", __FUNCTION__, #module, clock() - clock_t_##module)
-#define PRINT_TAG_COSTS(module, tag) PRINT("%s::%s::%s costs: %d\n", __FUNCTION__, #module, #tag, clock() - clock_t_##module)
-#define COSTS(module) (clock() - clock_t_##module)
+#define PRINT_COSTS(module) do {\
+        long long costs = TscClock::Microseconds() - evaluate_start_##module;\
+        RECORD_COSTS(#module, costs);\
+        PRINT("%s::%s costs: %.3f ms\n", __FUNCTION__, #module, costs / 1000.0);\
+    } while (0)
+#define PRINT_TAG_COSTS(module, tag) PRINT("%s::%s::%s costs: %.3f ms\n", __FUNCTION__, #module, #tag, (TscClock::Microseconds() - evaluate_start_##module) / 1000.0)
 
-#define START_FUNCTION_EVALUATE() clock_t clock_t_this_function = clock()
-#define PRINT_FUNCTION_COSTS() PRINT("%s costs: %d\n", __FUNCTION__, clock() - clock_t_this_function)
-#define PRINT_FUNCTION_TAG_COSTS(tag) PRINT("%s::%s costs: %d\n", __FUNCTION__, #tag, clock() - clock_t_this_function)
+#define PRINT_FUNCTION_COSTS() do {\
+        long long costs = TscClock::Microseconds() - evaluate_start_this_function;\
+        RECORD_COSTS("total", costs);\
+        PRINT("%s costs: %.3f ms\n", __FUNCTION__, costs / 1000.0);\
+    } while (0)
+#define PRINT_FUNCTION_TAG_COSTS(tag) PRINT_TAG_COSTS(this_function, tag)
 
 #else
 
-#define START_EVALUATE(module) 
-#define PRINT_COSTS(module) 
+#define PRINT_COSTS(module) RECORD_COSTS(#module, TscClock::Microseconds() - evaluate_start_##module)
 #define PRINT_TAG_COSTS(module, tag) 
-#define COSTS(module) 
 
-#define START_FUNCTION_EVALUATE() 
-#define PRINT_FUNCTION_COSTS() 
+#define PRINT_FUNCTION_COSTS() RECORD_COSTS("total", TscClock::Microseconds() - evaluate_start_this_function)
 #define PRINT_FUNCTION_TAG_COSTS(tag) 
 
 #endif
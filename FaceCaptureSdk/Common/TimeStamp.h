@@ -12,10 +12,7 @@ class TimeStamp
 public:
     static long long Now()
     {
-        typedef std::chrono::milliseconds time_precision;
-        typedef std::chrono::time_point<std::chrono::system_clock, time_precision> now_time_point;
-        now_time_point tp = std::chrono::time_point_cast<time_precision>(std::chrono::steady_clock::now());
-        return tp.time_since_epoch().count();
+        return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
     }
 };
 
@@ -25,10 +22,7 @@ class TimeStamp<SECONDS>
 public:
     static long long Now()
     {
-        typedef std::chrono::seconds time_precision;
-        typedef std::chrono::time_point<std::chrono::system_clock, time_precision> now_time_point;
-        now_time_point tp = std::chrono::time_point_cast<time_precision>(std::chrono::steady_clock::now());
-        return tp.time_since_epoch().count();
+        return std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
     }
 };
 
@@ -38,10 +32,7 @@ class TimeStamp<MICROSECONDS>
 public:
     static long long Now()
     {
-        typedef std::chrono::microseconds time_precision;
-        typedef std::chrono::time_point<std::chrono::system_clock, time_precision> now_time_point;
-        now_time_point tp = std::chrono::time_point_cast<time_precision>(std::chrono::steady_clock::now());
-        return tp.time_since_epoch().count();
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
     }
 };
 
@@ -0,0 +1,290 @@
+
+#ifndef _TSCCLOCK_HEADER_H_
+#define _TSCCLOCK_HEADER_H_
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__i386__) || defined(__x86_64__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define TSCCLOCK_X86
+#endif
+
+/**
+* @brief monotonic clock read from the invariant time stamp counter, for timestamps taken many times per frame \n
+* a read is one rdtsc and a multiply, against a system call or a QueryPerformanceCounter for steady_clock;
+* ticks are converted to nanoseconds on the steady_clock time base, so values can be mixed with
+* TimeStamp<MICROSECONDS> * 1000; the conversion is calibrated against steady_clock once a second
+* by whichever reader comes first, slewing instead of stepping, so the clock never goes backwards.
+* without an invariant tsc (old cpus, some hypervisors, not x86) every read falls back to steady_clock
+* it is a template only to keep its static members in this header, like XMatPool
+*/
+template<int Instance = 0>
+class XTscClock
+{
+public:
+    /**
+    * @brief calibrate now instead of on the first read, it spins for about 10 ms \n
+    * recalibrateInterval is in milliseconds, only the first call counts
+    */
+    static void Initialize(int recalibrateInterval = 1000)
+    {
+        std::call_once(_once, [recalibrateInterval]()
+        {
+            _invariant = DetectInvariant();
+            if (_invariant)
+            {
+                // a busy wait of 10 ms gets the frequency within a few ppm, the periodic calibrations refine it
+                unsigned long long ticks0 = 0;
+                long long nanoseconds0 = ReadPair(ticks0);
+                unsigned long long ticks1 = 0;
+                long long nanoseconds1 = nanoseconds0;
+                while (nanoseconds1 - nanoseconds0 < 10000000)
+                {
+                    nanoseconds1 = ReadPair(ticks1);
+                }
+
+                Calibration& calibration = _calibrations[0];
+                calibration.ticks = ticks1;
+                calibration.nanoseconds = nanoseconds1;
+                calibration.nanosecondsPerTick = (double)(nanoseconds1 - nanoseconds0) / (double)(ticks1 - ticks0);
+                _origin = calibration;
+                _recalibrateTicks = (long long)((std::max)(recalibrateInterval, 10) * 1000000.0 / calibration.nanosecondsPerTick);
+                _current.store(0, std::memory_order_release);
+            }
+            _initialized.store(true, std::memory_order_release);
+        });
+    }
+
+    /**
+    * @brief nanoseconds of the steady_clock epoch \n
+    *
+    */
+    static inline long long Nanoseconds()
+    {
+        if (!_initialized.load(std::memory_order_acquire))
+        {
+            Initialize();
+        }
+        if (!_invariant)
+        {
+            return SteadyNanoseconds();
+        }
+
+        unsigned long long ticks = ReadTicks();
+        const Calibration& calibration = _calibrations[_current.load(std::memory_order_acquire)];
+        long long elapsed = (long long)(ticks - calibration.ticks);
+        if (elapsed >= _recalibrateTicks)
+        {
+            Recalibrate();
+        }
+        return calibration.nanoseconds + (long long)(elapsed * calibration.nanosecondsPerTick);
+    }
+
+    static inline long long Microseconds()
+    {
+        return Nanoseconds() / 1000;
+    }
+
+    /**
+    * @brief raw counter for the cheapest interval measurement, convert differences with ToNanoseconds \n
+    * it is steady_clock nanoseconds without an invariant tsc
+    */
+    static inline unsigned long long Ticks()
+    {
+        if (!_initialized.load(std::memory_order_acquire))
+        {
+            Initialize();
+        }
+        return _invariant ? ReadTicks() : (unsigned long long)SteadyNanoseconds();
+    }
+
+    static inline long long ToNanoseconds(long long ticks)
+    {
+        if (!_initialized.load(std::memory_order_acquire))
+        {
+            Initialize();
+        }
+        return _invariant ? (long long)(ticks * _calibrations[_current.load(std::memory_order_acquire)].nanosecondsPerTick) : ticks;
+    }
+
+    static bool Invariant()
+    {
+        Initialize();
+        return _invariant;
+    }
+
+    /**
+    * @brief calibrated counter frequency, 1e9 for the steady_clock fallback \n
+    */
+    static double TicksPerSecond()
+    {
+        Initialize();
+        return _invariant ? 1e9 / _calibrations[_current.load(std::memory_order_acquire)].nanosecondsPerTick : 1e9;
+    }
+
+private:
+    struct Calibration
+    {
+        unsigned long long ticks;
+        long long nanoseconds;
+        double nanosecondsPerTick;
+    };
+
+    static inline long long SteadyNanoseconds()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    static inline unsigned long long ReadTicks()
+    {
+#ifdef TSCCLOCK_X86
+        return __rdtsc();
+#else
+        return 0;
+#endif
+    }
+
+    static bool DetectInvariant()
+    {
+#if defined(TSCCLOCK_X86) && defined(_MSC_VER)
+        int registers[4] = { 0 };
+        __cpuid(registers, 0x80000000);
+        if ((unsigned int)registers[0] < 0x80000007)
+        {
+            return false;
+        }
+        __cpuid(registers, 0x80000007);
+        return (registers[3] & (1 << 8)) != 0;
+#elif defined(TSCCLOCK_X86)
+        unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+        return __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) && (edx & (1 << 8)) != 0;
+#else
+        return false;
+#endif
+    }
+
+    /**
+    * @brief steady_clock and the counter read as close together as possible \n
+    * the counter is taken in the middle of the shortest of 3 bracketing pairs, so a preemption does not skew it
+    */
+    static long long ReadPair(unsigned long long& ticks)
+    {
+        long long nanoseconds = 0;
+        unsigned long long best = ~0ULL;
+        for (int idx = 0; idx < 3; ++idx)
+        {
+            unsigned long long before = ReadTicks();
+            long long steady = SteadyNanoseconds();
+            unsigned long long after = ReadTicks();
+            if (after - before < best)
+            {
+                best = after - before;
+                ticks = before + (after - before) / 2;
+                nanoseconds = steady;
+            }
+        }
+        return nanoseconds;
+    }
+
+    /**
+    * @brief measure the counter against steady_clock and publish a new conversion \n
+    * the frequency is taken over the whole time since the origin, so it gets more precise the longer the process runs;
+    * the new conversion starts where the current one is now and slews off the offset to steady_clock over the next interval,
+    * by 0.1% at most, a step larger than 1 ms (like after a suspend) restarts from steady_clock when that is ahead
+    * readers pick the conversion by index, the one they may still use is rewritten an interval later
+    */
+    static void Recalibrate()
+    {
+        std::unique_lock<std::mutex> ul(_locker, std::try_to_lock);
+        if (!ul.owns_lock())
+        {
+            return;
+        }
+
+        int current = _current.load(std::memory_order_relaxed);
+        const Calibration& calibration = _calibrations[current];
+        unsigned long long ticks = 0;
+        long long nanoseconds = ReadPair(ticks);
+        long long elapsed = (long long)(ticks - calibration.ticks);
+        if (elapsed < _recalibrateTicks)
+        {
+            return;
+        }
+
+        long long converted = calibration.nanoseconds + (long long)(elapsed * calibration.nanosecondsPerTick);
+        long long offset = nanoseconds - converted;
+
+        Calibration& next = _calibrations[1 - current];
+        next.ticks = ticks;
+        if (offset > 1000000 || offset < -1000000)
+        {
+            next.nanoseconds = (std::max)(nanoseconds, converted);
+            next.nanosecondsPerTick = calibration.nanosecondsPerTick;
+            _origin.ticks = ticks;
+            _origin.nanoseconds = nanoseconds;
+        }
+        else
+        {
+            double nanosecondsPerTick = (double)(nanoseconds - _origin.nanoseconds) / (double)(ticks - _origin.ticks);
+            double slew = (double)offset / (_recalibrateTicks * nanosecondsPerTick);
+            slew = (std::max)(-0.001, (std::min)(slew, 0.001));
+
+            next.nanoseconds = converted;
+            next.nanosecondsPerTick = nanosecondsPerTick * (1.0 + slew);
+        }
+        _current.store(1 - current, std::memory_order_release);
+    }
+
+private:
+    static std::once_flag _once;
+    static std::atomic<bool> _initialized;
+    static bool _invariant;
+    static long long _recalibrateTicks;
+
+    static std::mutex _locker;
+    static Calibration _origin;
+    static Calibration _calibrations[2];
+    static std::atomic<int> _current;
+
+private:
+    XTscClock();
+    XTscClock(const XTscClock&);
+    XTscClock& operator=(const XTscClock&);
+};
+
+template<int Instance>
+std::once_flag XTscClock<Instance>::_once;
+
+template<int Instance>
+std::atomic<bool> XTscClock<Instance>::_initialized(false);
+
+template<int Instance>
+bool XTscClock<Instance>::_invariant = false;
+
+template<int Instance>
+long long XTscClock<Instance>::_recalibrateTicks = 0;
+
+template<int Instance>
+std::mutex XTscClock<Instance>::_locker;
+
+template<int Instance>
+typename XTscClock<Instance>::Calibration XTscClock<Instance>::_origin = { 0, 0, 1.0 };
+
+template<int Instance>
+typename XTscClock<Instance>::Calibration XTscClock<Instance>::_calibrations[2] = { { 0, 0, 1.0 }, { 0, 0, 1.0 } };
+
+template<int Instance>
+std::atomic<int> XTscClock<Instance>::_current(0);
+
+typedef XTscClock<> TscClock;
+
+#endif
@@ -12,7 +12,7 @@ class XMatPool
 public:
     static bool Alloc(MatType& src, MatType& dst, int deviceIndex = 0)
     {
-        if (deviceIndex >= deviceCount)
+        if (deviceIndex < 0 || deviceIndex >= deviceCount)
         {
             return false;
         }
@@ -20,7 +20,7 @@ public:
         int resolutionType = (src.cols << 14) + src.rows;
 
         std::lock_guard<std::mutex> lg(_locker[deviceIndex]);
-        std::map<int, std::queue<MatType>>::iterator it = _pool[deviceIndex].find(resolutionType);
+        typename std::map<int, std::queue<MatType>>::iterator it = _pool[deviceIndex].find(resolutionType);
         if (it != _pool[deviceIndex].end())
         {
             std::queue<MatType>& alias = it->second;
@@ -41,7 +41,7 @@ public:
 
     static void Free(MatType& mat, int deviceIndex = 0)
     {
-        if (deviceIndex >= deviceCount)
+        if (deviceIndex < 0 || deviceIndex >= deviceCount)
         {
             return;
         }
@@ -51,7 +51,7 @@ public:
             int resolutionType = (mat.cols << 14) + mat.rows;
 
             std::lock_guard<std::mutex> lg(_locker[deviceIndex]);
-            std::map<int, std::queue<MatType>>::iterator it = _pool[deviceIndex].find(resolutionType);
+            typename std::map<int, std::queue<MatType>>::iterator it = _pool[deviceIndex].find(resolutionType);
             if (it != _pool[deviceIndex].end())
             {
                 std::queue<MatType>& que = it->second;
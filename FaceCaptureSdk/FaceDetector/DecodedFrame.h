@@ -2,6 +2,7 @@
 #ifndef _DECODEDFRAME_HEADER_H_
 #define _DECODEDFRAME_HEADER_H_
 
+#include <functional>
 #include <memory>
 
 #pragma warning(disable:4819)
@@ -12,6 +13,31 @@
 
 typedef std::shared_ptr<std::vector<char>> rawptr;
 
+/**
+* @brief acknowledgement of a frame which must not be lost, like an image of a watch folder \n
+* it is shared by the frame and the images made of it, when the last one is released done is told whether the frame
+* was processed, that is detected or skipped on purpose by the decoder; a frame dropped on the way is not processed
+*/
+struct FrameAck
+{
+    explicit FrameAck(const std::function<void(bool)>& callback) : processed(false), done(callback) {}
+    ~FrameAck()
+    {
+        if (done)
+        {
+            done(processed);
+        }
+    }
+
+    bool processed;
+    std::function<void(bool)> done;
+
+private:
+    FrameAck(const FrameAck&);
+    FrameAck& operator=(const FrameAck&);
+};
+typedef std::shared_ptr<FrameAck> FrameAckPtr;
+
 struct DecodedFrame
 {
     std::string sourceId = "";
@@ -26,6 +52,9 @@ struct DecodedFrame
 
     bool needDetect = true;
     bool buffered = false;
+    int poolIndex = 0;  // device index of the XMatPool a buffered mat is freed to, the one of its decoder
+
+    FrameAckPtr ack = nullptr;
 };
 
 #endif
@@ -25,6 +25,7 @@
 #ifndef _FACEDETECTCORE_HEADER_H_
 #define _FACEDETECTCORE_HEADER_H_
 
+#include <string>
 #include <vector>
 
 /**
@@ -137,12 +138,23 @@ struct AnalyzeParam
     bool analyze_age_gender = false;
     bool analyze_age_ethnic = false;
 
+    int cacheSize = 1000;  // maximum number of tracks whose attributes are cached
+    int cacheVotes = 3;    // consistent results needed before an attribute of a track is not analyzed any more
+
     int bufferSize = 80;
 
     int batchTimeout = 500;
     int batchSize = -1;
 };
 
+/**
+* @brief define encoding of FaceBox.feature \n
+* RAW     : float32 * dimension
+* FLOAT16 : IEEE half * dimension
+* INT8    : float32 scale, then int8 * dimension, value = int8 * scale
+*/
+enum { FEATURE_ENCODING_RAW, FEATURE_ENCODING_FLOAT16, FEATURE_ENCODING_INT8 };
+
 /**
 * @brief define face feature extract rules \n
 *
@@ -156,15 +168,105 @@ struct ExtractParam
 
     int batchTimeout = 40;
     int batchSize = 40;
+
+    float dedupThreshold = -1.0f;  // captures whose feature similarity to a recent capture of another source reaches this are suppressed (negative means disabled)
+    int dedupWindow = 5000;        // time window of recent captures compared (ms)
+    bool dedupKeepBetter = true;   // a duplicate with better keypoints confidence replaces the indexed one instead of being suppressed
+
+    int featureEncoding = FEATURE_ENCODING_RAW; // encoding of output feature
+};
+
+/**
+* @brief define capture archive rules \n
+* captures are appended to large segment files under path, empty path disables the archive
+*/
+struct ArchiveParam
+{
+    std::string path = "";      // archive directory, empty means disabled
+    int segmentSize = 256;      // segment file size (MB), a new segment is started when it is full
+    int segmentNumber = 0;      // segments to keep, the oldest ones are removed (0 means keep all)
+    int bufferSize = 1000;      // captures waiting to be archived, the oldest ones are dropped when overflow
+    int jpegQuality = 90;       // jpeg quality of archived images
+    bool archiveScence = false; // archive scence image as well as face and aligned images
+};
+
+/**
+* @brief define parameter of capture persistence sink \n
+* captures are written to path in batches by a background thread,
+* they are spilled to spillPath when path is too slow to keep up
+*/
+struct SinkParam
+{
+    std::string path = "";      // persistence directory, empty means disabled
+    int bufferSize = 1000;      // captures waiting in memory, the oldest ones are dropped when overflow
+    int batchSize = 32;         // captures written and flushed together in one commit
+    int batchTimeout = 200;     // max time waiting for a full batch (ms)
+    bool syncWrite = true;      // flush written files to disk on every commit
+    std::string spillPath = ""; // local directory for captures path can not keep up with, empty means no spilling
+    int spillSize = 1024;       // max size of spilled captures (MB)
+    int jpegQuality = 90;       // jpeg quality of persisted images
+    bool sinkScence = true;     // persist scence image as well as face and aligned images
+};
+
+/**
+* @brief define worker autoscaling rules \n
+* every interval the utilization of each stage is sampled, a stage above highUtilization
+* gets one more worker (at most maxThreadCount), a stage below lowUtilization retires one (at least one)
+*/
+struct ScaleParam
+{
+    bool autoscale = false;         // scale workers by utilization, statistics are sampled anyway
+    int interval = 5000;            // sampling interval (ms)
+    float highUtilization = 0.85f;
+    float lowUtilization = 0.30f;
+    int maxThreadCount = 4;         // most workers of one stage
+};
+
+/**
+* @brief define thread roles and their placement \n
+* AFFINITY_NONE   : the affinity of threads is left untouched, as the host process set it
+* AFFINITY_DEVICE : threads are pinned to processors of the numa node local to their gpu,
+*                   threads working on cpu are left untouched
+* a value >= 0 pins threads to processors of that numa node
+*/
+enum { THREAD_DECODER, THREAD_ASYNC, THREAD_WORKER, THREAD_CALLBACK, THREAD_SERVICE, THREAD_ROLE_NUMBER };
+enum { AFFINITY_NONE = -2, AFFINITY_DEVICE = -1 };
+
+/**
+* @brief define thread placement policy of each role \n
+* decoded frames and the buffers pooled for them stay on the node of the decoder thread which touches them first
+*/
+struct AffinityParam
+{
+    int decoder = AFFINITY_NONE;    // decoder threads
+    int async = AFFINITY_NONE;      // async context thread of each gpu
+    int worker = AFFINITY_NONE;     // pipeline workers of detector and extractor
+    int callback = AFFINITY_NONE;   // stopped stream callback thread
+    int service = AFFINITY_NONE;    // capture archive, sink and autoscaler threads
+    std::vector<int> deviceNodes;   // numa node of each gpu by device index, gpus are spread over nodes in order if not set
 };
 
 /**
 * @brief define parameter of output result \n
 *
 */
+/**
+* @brief define parameter of shared memory capture ring \n
+* captures are published to a named ring read by other processes, see CaptureRingBuffer
+*/
+struct RingParam
+{
+    std::string name = "";      // shared memory name, empty means disabled
+    int slotNumber = 128;       // captures kept in the ring, rounded up to a power of 2, the oldest ones are overwritten
+    int slotSize = 512;         // max size of one capture (KB), images are published as raw pixels
+    bool ringScence = false;    // publish scence image as well, it is left out when the capture does not fit a slot
+};
 struct ResultParam
 {
     int bufferSize = 100; // out put buffer size
+    ArchiveParam archiveParam;
+    SinkParam sinkParam;
+    RingParam ringParam;
 };
 
 #endif
@@ -1,8 +1,13 @@
 
 #include "FaceDetector.h"
 #include "FaceDetectorImpl.h"
+#include "ThreadAffinity.h"
+#include "SnapMachine.h"
 
 #include "XMatPool.h"
+#include "Metrics.h"
+#include "AsyncLogger.h"
+#include "TscClock.h"
 
 #define GLOG_NO_ABBREVIATED_SEVERITIES
 #define GOOGLE_GLOG_DLL_DECL
@@ -20,6 +25,8 @@ static bool INITIALIZED = false;
 
 static void FailureWriter(const char *data, int size)
 {
+    // the crash handler flushes only the files behind the async loggers, write out their rings first
+    AsyncLogger::DrainInstalled();
     LOG(FATAL) << std::string(data, size);
 }
 
@@ -68,6 +75,12 @@ FACEDETECTOR_API bool DetectInit()
         google::InstallFailureWriter(&FailureWriter);
         google::InstallFailureSignalHandler();
 
+        // log files are written by a flusher thread, a slow disk does not stall the pipeline
+        AsyncLogger::Install();
+
+        // calibrate the stage clock here rather than on the first timed frame
+        TscClock::Initialize();
+
         return true;
     }
     else
@@ -82,6 +95,8 @@ FACEDETECTOR_API void DetectDestroy()
 {
     if (INITIALIZED)
     {
+        SnapDecodePool::Destroy();
+
         XMatPool<cv::Mat>::Clear();
         XMatPool<cv::cuda::GpuMat>::Clear();
 
@@ -96,11 +111,30 @@ FACEDETECTOR_API const char* GetLastDetectError()
     return LAST_DECODE_ERROR;
 }
 
+FACEDETECTOR_API void SetAffinity(const AffinityParam& affinityParam)
+{
+    int gpuCount = 0;
+    if (GetGpuCount(gpuCount) != FaceSdkOk)
+    {
+        gpuCount = 0;
+    }
+    ThreadAffinity::Configure(affinityParam, gpuCount);
+
+    LOG(INFO) << "thread affinity, decoder: " << affinityParam.decoder << ", async: " << affinityParam.async
+        << ", worker: " << affinityParam.worker << ", callback: " << affinityParam.callback << ", service: " << affinityParam.service
+        << ", numa nodes: " << ThreadAffinity::NodeNumber() << ", gpus: " << gpuCount;
+}
+
+FACEDETECTOR_API int BindThread(int role, int deviceIndex)
+{
+    return ThreadAffinity::Bind(role, deviceIndex);
+}
+
 FACEDETECTOR_API FaceDetector* CreateDetector(const ModelParam& modelParam, const DetectParam& detectParam, const TrackParam& trackParam,
     const EvaluateParam& evaluateParam, const KeypointParam& keypointParam, const AlignParam& alignParam,
-    const AnalyzeParam& analyzerParam, const ResultParam& resultParam, FaceExtractor* faceExtractor)
+    const AnalyzeParam& analyzerParam, const ResultParam& resultParam, FaceExtractor* faceExtractor, const ScaleParam& scaleParam)
 {
-    FaceDetector* faceDetector = new FaceDetector(modelParam, detectParam, trackParam, evaluateParam, keypointParam, alignParam, analyzerParam, resultParam, faceExtractor);
+    FaceDetector* faceDetector = new FaceDetector(modelParam, detectParam, trackParam, evaluateParam, keypointParam, alignParam, analyzerParam, resultParam, faceExtractor, scaleParam);
     if (faceDetector)
     {
         try
@@ -134,9 +168,10 @@ FACEDETECTOR_API void DestroyDetector(FaceDetector* faceDetector)
     }
 }
 
-FACEDETECTOR_API FaceExtractor* CreateExtractor(const ModelParam& modelParam, const ExtractParam& extractParam, const ResultParam& resultParam)
+FACEDETECTOR_API FaceExtractor* CreateExtractor(const ModelParam& modelParam, const ExtractParam& extractParam, const ResultParam& resultParam,
+    const ScaleParam& scaleParam)
 {
-    FaceExtractor* faceExtractor = new FaceExtractor(modelParam, extractParam, resultParam);
+    FaceExtractor* faceExtractor = new FaceExtractor(modelParam, extractParam, resultParam, scaleParam);
     if (faceExtractor)
     {
         try
@@ -186,6 +221,59 @@ FACEDETECTOR_API void DelSource(FaceDetector* faceDetector, BaseDecoder* baseDec
     }
 }
 
+FACEDETECTOR_API bool MoveSource(FaceDetector* from, FaceDetector* to, BaseDecoder* baseDecoder, int drainTimeout)
+{
+    if (from && to && baseDecoder)
+    {
+        return from->MoveDecoder(baseDecoder, *to, drainTimeout);
+    }
+    return false;
+}
+
+FACEDETECTOR_API void GetDetectorLoad(FaceDetector* faceDetector, DetectorLoad& detectorLoad)
+{
+    if (faceDetector)
+    {
+        faceDetector->GetLoad(detectorLoad);
+    }
+}
+
+FACEDETECTOR_API bool ScaleStage(FaceDetector* faceDetector, int stage, int threadCount)
+{
+    if (faceDetector)
+    {
+        return faceDetector->ScaleStage(stage, threadCount);
+    }
+    return false;
+}
+
+FACEDETECTOR_API bool ScaleStage(FaceExtractor* faceExtractor, int stage, int threadCount)
+{
+    if (faceExtractor)
+    {
+        return faceExtractor->ScaleStage(stage, threadCount);
+    }
+    return false;
+}
+
+FACEDETECTOR_API void GetStageStatistics(FaceDetector* faceDetector, std::vector<StageStatistic>& stageStatistics)
+{
+    stageStatistics.clear();
+    if (faceDetector)
+    {
+        faceDetector->GetStageStatistics(stageStatistics);
+    }
+}
+
+FACEDETECTOR_API void GetStageStatistics(FaceExtractor* faceExtractor, std::vector<StageStatistic>& stageStatistics)
+{
+    stageStatistics.clear();
+    if (faceExtractor)
+    {
+        faceExtractor->GetStageStatistics(stageStatistics);
+    }
+}
+
 FACEDETECTOR_API bool GetCapture(FaceDetector* faceDetector, std::vector<std::shared_ptr<CaptureResult>>& captureResults)
 {
     if (faceDetector)
@@ -204,3 +292,126 @@ FACEDETECTOR_API bool GetCapture(FaceExtractor* faceExtractor, std::vector<std::
     return false;
 }
 
+
+FACEDETECTOR_API CaptureArchiveReader* OpenArchive(const char* path)
+{
+    if (path && strlen(path) > 0)
+    {
+        return new CaptureArchiveReader(path);
+    }
+    return nullptr;
+}
+
+FACEDETECTOR_API void CloseArchive(CaptureArchiveReader* captureArchiveReader)
+{
+    if (captureArchiveReader)
+    {
+        delete captureArchiveReader;
+    }
+}
+
+FACEDETECTOR_API bool QueryArchive(CaptureArchiveReader* captureArchiveReader, const char* sourceId, long long beginTime, long long endTime, std::vector<std::shared_ptr<CaptureResult>>& captureResults)
+{
+    if (captureArchiveReader)
+    {
+        return captureArchiveReader->Query(sourceId ? sourceId : "", beginTime, endTime, captureResults);
+    }
+    return false;
+}
+
+FACEDETECTOR_API CaptureRingReader* OpenRing(const char* name)
+{
+    if (name && strlen(name) > 0)
+    {
+        CaptureRingReader* captureRingReader = new CaptureRingReader();
+        if (captureRingReader->Open(name))
+        {
+            return captureRingReader;
+        }
+        delete captureRingReader;
+
+        memset(LAST_DECODE_ERROR, 0, sizeof(LAST_DECODE_ERROR));
+        strcpy(LAST_DECODE_ERROR, "capture ring can not be opened, it is not created yet or not compatible");
+    }
+    return nullptr;
+}
+
+FACEDETECTOR_API void CloseRing(CaptureRingReader* captureRingReader)
+{
+    if (captureRingReader)
+    {
+        delete captureRingReader;
+    }
+}
+
+FACEDETECTOR_API bool PollRing(CaptureRingReader* captureRingReader, std::vector<std::shared_ptr<CaptureResult>>& captureResults, int maxNumber)
+{
+    if (captureRingReader)
+    {
+        return captureRingReader->Poll(captureResults, maxNumber);
+    }
+    return false;
+}
+
+FACEDETECTOR_API void GetRingStatus(CaptureRingReader* captureRingReader, long long& lostNumber, unsigned int& lag)
+{
+    lostNumber = 0;
+    lag = 0;
+    if (captureRingReader)
+    {
+        captureRingReader->GetStatus(lostNumber, lag);
+    }
+}
+
+/**
+* @brief copy metrics of the registry into snapshots \n
+*
+*/
+struct MetricSnapshotVisitor
+{
+    std::vector<MetricSnapshot>& metricSnapshots;
+
+    explicit MetricSnapshotVisitor(std::vector<MetricSnapshot>& snapshots) : metricSnapshots(snapshots) {}
+
+    MetricSnapshot& Add(const std::string& name, const std::string& labels, int type)
+    {
+        metricSnapshots.push_back(MetricSnapshot());
+        MetricSnapshot& metricSnapshot = metricSnapshots.back();
+        metricSnapshot.name = name;
+        metricSnapshot.labels = labels;
+        metricSnapshot.type = type;
+        return metricSnapshot;
+    }
+
+    void operator()(const std::string& name, const std::string& labels, const MetricCounter& counter)
+    {
+        Add(name, labels, METRIC_COUNTER).value = counter.Value();
+    }
+
+    void operator()(const std::string& name, const std::string& labels, const MetricGauge& gauge)
+    {
+        Add(name, labels, METRIC_GAUGE).value = gauge.Value();
+    }
+
+    void operator()(const std::string& name, const std::string& labels, const MetricHistogram& histogram)
+    {
+        MetricSnapshot& metricSnapshot = Add(name, labels, METRIC_HISTOGRAM);
+        metricSnapshot.value = histogram.Count();
+        metricSnapshot.sum = histogram.Sum();
+        metricSnapshot.max = histogram.Max();
+        metricSnapshot.p50 = histogram.Percentile(0.5);
+        metricSnapshot.p90 = histogram.Percentile(0.9);
+        metricSnapshot.p99 = histogram.Percentile(0.99);
+        metricSnapshot.p999 = histogram.Percentile(0.999);
+    }
+
+private:
+    MetricSnapshotVisitor& operator=(const MetricSnapshotVisitor&);
+};
+
+FACEDETECTOR_API void GetMetrics(std::vector<MetricSnapshot>& metricSnapshots)
+{
+    metricSnapshots.clear();
+    MetricSnapshotVisitor visitor(metricSnapshots);
+    MetricsRegistry::Visit(visitor);
+}
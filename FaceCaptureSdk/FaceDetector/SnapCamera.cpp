@@ -2,6 +2,8 @@
 #include "FaceDetectorImpl.h"
 #include "SnapMachine.h"
 
+#include <algorithm>
+
 SNAPMACHINE_API SnapMachine* CreateSnapMachine(FaceDetector* faceDetector, int cameraType, const FaceParam& faceParam, const std::string& ip, unsigned short port, const std::string& username, const std::string& password)
 {
     return LoginSnapMachine::GenerateLoginSnapMachine(faceDetector, faceParam, cameraType, ip, port, username, password);
@@ -67,4 +69,8 @@ SNAPMACHINE_API bool FeedSnapMachine(SnapMachine* snapMachine, const ImageParam&
     return false;
 }
 
-
+SNAPMACHINE_API bool FeedSnapMachines(const std::vector<SnapMachine*>& snapMachines, const std::vector<ImageParam>& imageParams, std::vector<int>& results)
+{
+    SnapMachine::SnapBatch(snapMachines, imageParams, results);
+    return std::find_if(results.begin(), results.end(), [](int result){ return result != FEED_SUCCESS; }) == results.end();
+}
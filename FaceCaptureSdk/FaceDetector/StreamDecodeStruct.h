@@ -23,6 +23,8 @@
 #ifndef _STREAMDECODE_STRUCT_HEADER_H_
 #define _STREAMDECODE_STRUCT_HEADER_H_
 
+#include <string>
+
 /**
 * @brief define transfer layer type when open network stream \n
 *
@@ -53,6 +55,10 @@ struct DecoderParam
     int  width = 0;              // define decoded image width, 0 indicates original width will be kept
     int  height = 0;             // define decoded image height, 0 indicates original height will be kept
     int  buffer_size = 10;       // define buffer size that how many images can be buffered to be decoded
+
+    int  decode_threads = 0;     // define directory decoding cpu threads, 0 indicates jpeg data will be decoded by detector
+    bool ordered = true;         // define whether directory images are output in file name order when decoded by multiple threads
+    int  max_short_edge = 0;     // define directory jpeg is decoded at 1/2, 1/4 or 1/8 size while the short edge is not less than it, 0 indicates original size
 };
 
 /**
@@ -68,7 +74,29 @@ struct DecodeParam
     int failureThreshold = 5000;    // define the failure threshold how long(millisecond) the failure reaches, then the decoder will restart 
     int restartTimes = -1;          // how many times the decoder will restart
 
+    int duplicate_threshold = -1;   // define mean luma difference(0-255) of a sampled grid under which a frame is dropped as a duplicate of the last one, 0 drops exact duplicates only, -1 indicates no check
+    int frozen_duration = 10000;    // define how long(millisecond) duplicates last before the stream is reported frozen
+
     void (*ExitCallback)(const char*) = nullptr; // call back after decoder exit
+    void (*FrozenCallback)(const char*, bool) = nullptr; // call back on decoding thread when the stream is frozen(true) or recovers(false)
+};
+
+/**
+* @brief define what to do with watch folder images after they are processed \n
+*
+*/
+enum { WATCH_KEEP, WATCH_DELETE, WATCH_MOVE };
+
+/**
+* @brief define watch folder rules \n
+*
+*/
+struct WatchParam
+{
+    int processed = WATCH_KEEP;       // define what to do with processed images(WATCH_KEEP, WATCH_DELETE or WATCH_MOVE)
+    std::string processed_path = "";  // define the directory processed images are moved to when processed is WATCH_MOVE
+    std::string cursor_file = "";     // define the file recording processed images for restart, empty indicates <path>/.watch_cursor
+    int retry_times = 3;              // define how many times an image dropped before it is detected is taken again
 };
 
 #endif
@@ -65,6 +65,17 @@ STREAMDECODER_API const int GetDecoderDeviceIndex(BaseDecoder* baseDecoder)
     return -1;
 }
 
+STREAMDECODER_API bool IsDecoderFrozen(BaseDecoder* baseDecoder, long long& duplicateNumber)
+{
+    duplicateNumber = 0;
+    if (baseDecoder)
+    {
+        duplicateNumber = baseDecoder->GetDuplicateNumber();
+        return baseDecoder->IsFrozen();
+    }
+    return false;
+}
+
 STREAMDECODER_API bool DecodeFrame(BaseDecoder* baseDecoder)
 {
     if (baseDecoder)
@@ -138,6 +149,22 @@ STREAMDECODER_API BaseDecoder* OpenDirectory(const std::string& url, const Decod
     return baseDecoder;
 }
 
+STREAMDECODER_API BaseDecoder* OpenWatchFolder(const std::string& url, const DecoderParam& decoderParam, const DecodeParam& decodeParam, const WatchParam& watchParam, const std::string& id, DecoderStoppedCallback stoppedCb)
+{
+    BaseDecoder* baseDecoder = nullptr;
+    try
+    {
+        baseDecoder = DecodeManager::OpenWatchFolder(url, decoderParam, decodeParam, watchParam, id);
+        baseDecoder->SetStoppedCallback(stoppedCb);
+    }
+    catch (BaseException& ex)
+    {
+        memset(LAST_DECODE_ERROR, 0, sizeof(LAST_DECODE_ERROR));
+        memcpy(LAST_DECODE_ERROR, ex.Description().c_str(), ex.Description().size());
+    }
+    return baseDecoder;
+}
+
 STREAMDECODER_API bool CloseDecoder(BaseDecoder* baseDecoder)
 {
     if (baseDecoder)
@@ -4,6 +4,7 @@
 
 #include "TimeStamp.h"
 #include "AutoLock.h"
+#include "LogThrottle.h"
 
 #include "StreamParsor.h"
 
@@ -29,6 +30,8 @@ AsyncMatDecoder::AsyncMatDecoder(const std::string& url, const DecoderParam& dec
     _sdkDecoderParam.max_surfaces = decoderParam.buffer_size;
 
     _sdkDecoderParam.log_level = decoder::LOG_LEVEL_FATAL;
+
+    _buffered = true;
 }
 
 AsyncMatDecoder::~AsyncMatDecoder()
@@ -130,7 +133,16 @@ bool AsyncMatDecoder::ReadFrame(DecodedFrame& frame)
         frame.position = (long long)(_origFrameInterval * _nextFrameId);
         _nextFrameId++;
 
-        frame.mat = decoded_frame.mat.clone();
+        // node local pooled buffer, see MatDecoder::ReadFrame
+        if (XMatPool<cv::Mat>::Alloc(decoded_frame.mat, frame.mat, _sdkDecoderParam.device_index)
+            && frame.mat.u && frame.mat.u->refcount == 1 && frame.mat.type() == decoded_frame.mat.type())
+        {
+            decoded_frame.mat.copyTo(frame.mat);
+        }
+        else
+        {
+            frame.mat = decoded_frame.mat.clone();
+        }
         frame.id = decoded_frame.frame_index;
 
         ret = decoder::unref_frame<cv::Mat>(_decoder, decoded_frame);
@@ -138,7 +150,7 @@ bool AsyncMatDecoder::ReadFrame(DecodedFrame& frame)
         {
             char error_str[ERROR_STRING_LEN] = { '\0' };
             decoder::decoder_error_string(error_str, ERROR_STRING_LEN, ret);
-            LOG(WARNING) << __FUNCTION__ << " unref_frame<cv::Mat> failed: " << error_str;
+            LOG_EVERY_MS(WARNING, 1000) << __FUNCTION__ << " unref_frame<cv::Mat> failed: " << error_str;
         }
         return true;
     }
@@ -278,7 +290,7 @@ bool AsyncGpuMatDecoder::ReadFrame(DecodedFrame& frame)
         {
             char error_str[ERROR_STRING_LEN] = { '\0' };
             decoder::decoder_error_string(error_str, ERROR_STRING_LEN, ret);
-            LOG(WARNING) << __FUNCTION__ << " unref_frame<cv::cuda::GpuMat> failed: " << error_str;
+            LOG_EVERY_MS(WARNING, 1000) << __FUNCTION__ << " unref_frame<cv::cuda::GpuMat> failed: " << error_str;
         }
         return copyCudaSuccess;
     }
@@ -5,6 +5,9 @@
 
 #include "TimeStamp.h"
 #include "Performance.h"
+#include "ThreadAffinity.h"
+
+#include <opencv2/cudawarping.hpp>
 
 #define GLOG_NO_ABBREVIATED_SEVERITIES
 #define GOOGLE_GLOG_DLL_DECL
@@ -22,6 +25,9 @@
 #pragma comment(lib, "opencv_videoio320.lib")
 #endif
 
+// duplicate check samples a GRID x GRID luma grid of every frame
+#define DUPLICATE_GRID 32
+
 volatile bool CallbackPool::_looping = false;
 std::thread CallbackPool::_loop;
 std::mutex CallbackPool::_locker;
@@ -56,8 +62,24 @@ void CallbackPool::DestroyCallbackContext()
 
 void CallbackPool::Loop()
 {
+    // the loop is started before affinity is configured
+    int affinityGeneration = -1;
+    int affinityNode = -1;
     while (_looping)
     {
+        if (affinityGeneration != ThreadAffinity::Generation())
+        {
+            affinityGeneration = ThreadAffinity::Generation();
+            int node = ThreadAffinity::Bind(THREAD_CALLBACK, -1);
+
+            // only undo a binding of its own, the affinity may be set by the host process
+            if (node < 0 && affinityNode >= 0)
+            {
+                ThreadAffinity::Unbind();
+            }
+            affinityNode = node;
+        }
+
         WAIT_MILLISEC_TILL_COND(_condition, _locker, 500, []{ return _callbacks.size() > 0; });
         if (_callbacks.size() > 0)
         {
@@ -79,16 +101,23 @@ BaseDecoder::BaseDecoder(const std::string& url, const DecoderParam& decoderPara
     , _syncLocker(), _syncCondition(), _errorMessage()
     , _userFrameInterval(0), _origFrameInterval(0.0f)
     , _currentSkipPosition(0), _nextFrameId(0), _failureStart(0), _restartTimes(0)
-    , _buffered(false), _faceParam(), _detectFramePos(1)
+    , _buffered(false), _lumaSampled(false), _samples(), _lastSamples()
+    , _duplicateNumber(0), _duplicateStart(0), _frozen(false)
+    , _faceParam(), _detectFramePos(1)
     , _decodedFrameQueue(_decoderParam.device_index, _decoderParam.buffer_size)
     , _stoppedCallback(nullptr)
     , fpstat(5000)
+    , _framesMetric(MetricsRegistry::Counter("decoder_frames_total", "source=\"" + id + "\""))
+    , _duplicatesMetric(MetricsRegistry::Counter("decoder_duplicates_total", "source=\"" + id + "\""))
+    , _frozenMetric(MetricsRegistry::Gauge("decoder_frozen", "source=\"" + id + "\""))
+    , _readCostsMetric(MetricsRegistry::Histogram("decoder_read_us", "source=\"" + id + "\""))
 {
     _userFrameInterval = (int)(_decodeParam.fps >= 1.0f ? (1000.0f / _decodeParam.fps) : 0);
 }
 
 BaseDecoder::~BaseDecoder()
 {
+    _frozenMetric->Set(0);
 }
 
 void BaseDecoder::Create() throw(BaseException)
@@ -151,20 +180,31 @@ void BaseDecoder::Uninit()
 bool BaseDecoder::DecodeFrame()
 {
     DecodedFrame decodedFrame;
+    long long readStart = TimeStamp<MICROSECONDS>::Now();
     if (ReadFrame(decodedFrame))
     {
+        _readCostsMetric->Record(TimeStamp<MICROSECONDS>::Now() - readStart);
+
         // reset to zero, because it is not continuous
         _failureStart = 0;
 
-        if (CanFrameBeUsed(_currentSkipPosition, decodedFrame) && ReviseFrame(decodedFrame))
+        // duplicates are dropped before skipping, so skip_frame_interval counts distinct frames
+        if (!IsDuplicateFrame(decodedFrame) && CanFrameBeUsed(_currentSkipPosition, decodedFrame) && ReviseFrame(decodedFrame))
         {
             decodedFrame.buffered = _buffered;
+            decodedFrame.poolIndex = _decoderParam.device_index;
             decodedFrame.sourceId = _id;
             decodedFrame.timestamp = TimeStamp<MILLISECONDS>::Now();
             _decodedFrameQueue.Push(decodedFrame);
         }
+        else if (decodedFrame.ack)
+        {
+            // skipped on purpose, it is not to be taken again
+            decodedFrame.ack->processed = true;
+        }
 
         fpstat.Stat(1, _id);
+        _framesMetric->Add();
 
         return true;
     }
@@ -240,6 +280,8 @@ void BaseDecoder::NotifyResult()
 
 void BaseDecoder::Decode()
 {
+    ThreadAffinity::Bind(THREAD_DECODER, _decoderParam.device_index);
+
     if (Init())
     {
         // notify creating thread
@@ -356,6 +398,113 @@ bool BaseDecoder::CanFrameBeUsed(int& framePosition, DecodedFrame& decodedFrame)
     }
 }
 
+bool BaseDecoder::IsDuplicateFrame(const DecodedFrame& decodedFrame)
+{
+    if (_decodeParam.duplicate_threshold < 0 || _lumaSampled)
+    {
+        return false;
+    }
+
+    cv::Mat frame = decodedFrame.mat;
+    if (frame.empty() && !decodedFrame.gpumat.empty())
+    {
+        // only the grid is downloaded
+        cv::cuda::GpuMat grid;
+        cv::cuda::resize(decodedFrame.gpumat, grid, cv::Size(DUPLICATE_GRID, DUPLICATE_GRID), 0, 0, cv::INTER_NEAREST);
+        grid.download(frame);
+    }
+    // jpeg data of directories is decoded by detector and not checked
+    if (frame.empty() || frame.depth() != CV_8U)
+    {
+        return false;
+    }
+
+    int channels = frame.channels();
+    _samples.resize(DUPLICATE_GRID * DUPLICATE_GRID);
+    for (int row = 0; row < DUPLICATE_GRID; ++row)
+    {
+        const unsigned char* line = frame.ptr<unsigned char>((2 * row + 1) * frame.rows / (2 * DUPLICATE_GRID));
+        for (int col = 0; col < DUPLICATE_GRID; ++col)
+        {
+            const unsigned char* pixel = line + (2 * col + 1) * frame.cols / (2 * DUPLICATE_GRID) * channels;
+
+            // bt.601 luma of bgr(a) pixels
+            _samples[row * DUPLICATE_GRID + col] = channels < 3 ? pixel[0] : (unsigned char)((29 * pixel[0] + 150 * pixel[1] + 77 * pixel[2]) >> 8);
+        }
+    }
+    return IsDuplicate();
+}
+
+bool BaseDecoder::IsDuplicateLuma(const unsigned char* plane, int width, int height, int stride)
+{
+    if (_decodeParam.duplicate_threshold < 0 || !plane || width <= 0 || height <= 0)
+    {
+        return false;
+    }
+
+    _samples.resize(DUPLICATE_GRID * DUPLICATE_GRID);
+    for (int row = 0; row < DUPLICATE_GRID; ++row)
+    {
+        const unsigned char* line = plane + (long long)((2 * row + 1) * height / (2 * DUPLICATE_GRID)) * stride;
+        for (int col = 0; col < DUPLICATE_GRID; ++col)
+        {
+            _samples[row * DUPLICATE_GRID + col] = line[(2 * col + 1) * width / (2 * DUPLICATE_GRID)];
+        }
+    }
+    return IsDuplicate();
+}
+
+bool BaseDecoder::IsDuplicate()
+{
+    // compared with the last distinct frame, so slow changes add up and are not dropped
+    bool duplicate = false;
+    if (_lastSamples.size() == _samples.size())
+    {
+        int difference = 0;
+        for (size_t idx = 0; idx < _samples.size(); ++idx)
+        {
+            difference += abs((int)_samples[idx] - (int)_lastSamples[idx]);
+        }
+        duplicate = difference <= _decodeParam.duplicate_threshold * (int)_samples.size();
+    }
+
+    long long now = TimeStamp<MILLISECONDS>::Now();
+    if (!duplicate)
+    {
+        _lastSamples.swap(_samples);
+        if (_frozen)
+        {
+            _frozen = false;
+            _frozenMetric->Set(0);
+            LOG(INFO) << Name() << "(" << _id << ") stream recovered after frozen for " << now - _duplicateStart << " ms, duplicates: " << _duplicateNumber;
+            if (_decodeParam.FrozenCallback)
+            {
+                _decodeParam.FrozenCallback(_id.c_str(), false);
+            }
+        }
+        _duplicateStart = 0;
+        return false;
+    }
+
+    _duplicateNumber++;
+    _duplicatesMetric->Add();
+    if (_duplicateStart <= 0)
+    {
+        _duplicateStart = now;
+    }
+    if (!_frozen && now - _duplicateStart >= _decodeParam.frozen_duration)
+    {
+        _frozen = true;
+        _frozenMetric->Set(1);
+        LOG(WARNING) << Name() << "(" << _id << ") stream frozen, no new frame for " << now - _duplicateStart << " ms, duplicates: " << _duplicateNumber;
+        if (_decodeParam.FrozenCallback)
+        {
+            _decodeParam.FrozenCallback(_id.c_str(), true);
+        }
+    }
+    return true;
+}
+
 bool BaseDecoder::ReviseFrame(DecodedFrame& decodedFrame)
 {
     if (!decodedFrame.mat.empty())
@@ -7,6 +7,7 @@
 #include "DecodedFrameQueue.h"
 
 #include "FPS.h"
+#include "Metrics.h"
 
 #include <thread>
 #include <mutex>
@@ -89,6 +90,9 @@ public:
     inline void SetFaceParam(const FaceParam& faceParam) { _faceParam = faceParam; }
     inline const FaceParam& GetFaceParam() const { return _faceParam; }
 
+    inline long long GetDuplicateNumber() const { return _duplicateNumber; }
+    inline bool IsFrozen() const { return _frozen; }
+
 protected:
     virtual bool Init();
     virtual void Uninit();
@@ -109,6 +113,14 @@ protected:
     bool ReviseFrame(const cv::Mat& origin, cv::Mat& revised, double rotateAngle);
     bool ReviseFrame(const cv::cuda::GpuMat& origin, cv::cuda::GpuMat& revised, double rotateAngle);
 
+    /**
+    * @brief check whether the frame repeats the last one by a sampled luma grid \n
+    * decoders sampling the luma plane before colour conversion set _lumaSampled and call IsDuplicateLuma
+    */
+    bool IsDuplicateFrame(const DecodedFrame& decodedFrame);
+    bool IsDuplicateLuma(const unsigned char* plane, int width, int height, int stride);
+    bool IsDuplicate();
+
 protected:
     // URL
     std::string _url;
@@ -138,6 +150,14 @@ protected:
 
     bool _buffered;
 
+    // duplicate frame check
+    bool _lumaSampled;
+    std::vector<unsigned char> _samples;
+    std::vector<unsigned char> _lastSamples;
+    long long _duplicateNumber;
+    long long _duplicateStart;
+    volatile bool _frozen;
+
     FaceParam _faceParam;
     int _detectFramePos;
 
@@ -147,6 +167,12 @@ protected:
 
     FPStat fpstat;
 
+    // labeled with the source id, shared by decoders reopening the source
+    MetricCounter* _framesMetric;
+    MetricCounter* _duplicatesMetric;
+    MetricGauge* _frozenMetric;
+    MetricHistogram* _readCostsMetric;
+
 private:
     BaseDecoder();
     BaseDecoder(const BaseDecoder&);
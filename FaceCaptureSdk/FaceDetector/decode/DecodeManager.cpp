@@ -1,6 +1,7 @@
 #include "DecodeManager.h"
 
 #include "DirectoryDecoder.h"
+#include "WatchDecoder.h"
 #include "OpencvDecoder.h"
 #include "Dxva2Decoder.h"
 #include "GpuDecoder.h"
@@ -193,6 +194,21 @@ BaseDecoder* DecodeManager::OpenDirectory(const std::string& url, const DecoderP
     return baseDecoder;
 }
 
+BaseDecoder* DecodeManager::OpenWatchFolder(const std::string& url, const DecoderParam& decoderParam, const DecodeParam& decodeParam, const WatchParam& watchParam, const std::string& id) throw(BaseException)
+{
+    if (_license_number <= 0)
+    {
+        throw BaseException(0, "OpenWatchFolder(" + url + ") can not be opened: license limitation");
+    }
+
+    BaseDecoder* baseDecoder = new WatchDecoder(url, decoderParam, decodeParam, watchParam, id);
+    if (baseDecoder)
+    {
+        TryCreateDecoder(baseDecoder);
+    }
+    return baseDecoder;
+}
+
 void DecodeManager::CloseDecoder(BaseDecoder* baseDecoder) throw(BaseException)
 {
     if (baseDecoder)
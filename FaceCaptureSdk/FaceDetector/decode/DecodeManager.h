@@ -21,6 +21,8 @@ public:
 
     static BaseDecoder* OpenDirectory(const std::string&, const DecoderParam&, const DecodeParam&, const std::string&) throw(BaseException);
 
+    static BaseDecoder* OpenWatchFolder(const std::string&, const DecoderParam&, const DecodeParam&, const WatchParam&, const std::string&) throw(BaseException);
+
     static void CloseDecoder(BaseDecoder*);
 
 private:
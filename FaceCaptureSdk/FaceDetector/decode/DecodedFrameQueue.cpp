@@ -92,11 +92,11 @@ void DecodedFrameQueue::Reserve(DecodedFrame& decodedFrame)
     {
         if (!decodedFrame.mat.empty())
         {
-            XMatPool<cv::Mat>::Free(decodedFrame.mat, _gpuIndex);
+            XMatPool<cv::Mat>::Free(decodedFrame.mat, decodedFrame.poolIndex);
         }
         else if (!decodedFrame.gpumat.empty())
         {
-            XMatPool<cv::cuda::GpuMat>::Free(decodedFrame.gpumat, _gpuIndex);
+            XMatPool<cv::cuda::GpuMat>::Free(decodedFrame.gpumat, decodedFrame.poolIndex);
         }
     }
 }
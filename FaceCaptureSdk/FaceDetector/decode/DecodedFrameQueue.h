@@ -4,8 +4,10 @@
 
 #include "DecodedFrame.h"
 
+#include <ctime>
 #include <memory>
 #include <mutex>
+#include <queue>
 #include <condition_variable>
 
 class DecodedFrameQueue
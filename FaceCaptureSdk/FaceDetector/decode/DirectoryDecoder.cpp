@@ -2,6 +2,7 @@
 #include "DirectoryDecoder.h"
 #include "AutoLock.h"
 #include "Performance.h"
+#include "ThreadAffinity.h"
 
 #define GLOG_NO_ABBREVIATED_SEVERITIES
 #define GOOGLE_GLOG_DLL_DECL
@@ -11,7 +12,8 @@ DirectoryDecoder::DirectoryDecoder(const std::string& url, const DecoderParam& d
     : BaseDecoder(url, decoderParam, decodeParam, id)
     , _currentFramePostion(0LL), _files()
     , _decoder(nullptr), _read_buffer(nullptr)
-    , _frame()
+    , _prefetcher(), _decodeWorkers(), _prefetching(false)
+    , _prefetchLocker(), _prefetchCondition(), _readItems(), _readyItems(), _inflightNumber(0), _nextSequence(0)
 {
 }
 
@@ -60,12 +62,16 @@ bool DirectoryDecoder::Init()
 
     _currentFramePostion = 0;
 
+    StartPipeline();
+
     return true;
 }
 
 void DirectoryDecoder::Uninit()
 {
     AUTOLOCK(_decoderLocker);
+    StopPipeline();
+
     if (_files.size() > 0)
     {
         _files.clear();
@@ -90,44 +96,256 @@ void DirectoryDecoder::Uninit()
 
 bool DirectoryDecoder::ReadFrame(DecodedFrame& frame)
 {
-    if (_currentFramePostion >= _files.size())
+    PrefetchedPtr prefetched;
     {
-        _currentFramePostion = 0;
-    }
+        WAIT_MILLISEC_TILL_COND(_prefetchCondition, _prefetchLocker, 1000,
+            [this](){ return !_readyItems.empty() && (!_decoderParam.ordered || _readyItems.begin()->first == _nextSequence); });
+        if (_readyItems.empty() || (_decoderParam.ordered && _readyItems.begin()->first != _nextSequence))
+        {
+            return false;
+        }
 
-    FileSystem::FNode& fnode = _files[_currentFramePostion++];
-    std::fstream fs(_url + fnode.info.name, std::ios::in | std::ios::binary);
+        prefetched = _readyItems.begin()->second;
+        _readyItems.erase(_readyItems.begin());
+        _inflightNumber--;
+        _nextSequence = prefetched->sequence + 1;
+    }
+    WAKEUP_ALL(_prefetchCondition);
 
-    frame.position = _currentFramePostion;
-#if 1
-    if (!fs.is_open())
+    frame.position = prefetched->position;
+    if (prefetched->failed)
     {
-        fs.clear();
-        LOG(ERROR) << _url + fnode.info.name << " open failed";
+        LOG(ERROR) << prefetched->file << " read or decode failed";
         return false;
     }
+
+    frame.id = prefetched->position;
+    if (!prefetched->mat.empty())
+    {
+        frame.mat = prefetched->mat;
+    }
     else
     {
-        frame.id = _currentFramePostion;
-        frame.imdata = rawptr(new std::vector<char>());
-        fs.seekg(0, std::ios::end);
-        auto end = fs.tellg();
-        fs.seekg(0, std::ios::beg);
-        frame.imdata->resize(end);
-        fs.read((char *)(frame.imdata->data()), end);
-        fs.close();
-        return true;
+        frame.imdata = prefetched->data;
+    }
+    return true;
+}
+
+void DirectoryDecoder::StartPipeline()
+{
+    _readItems.clear();
+    _readyItems.clear();
+    _inflightNumber = 0;
+    _nextSequence = 0;
+
+    // no more workers than cores, decoding is cpu bound
+    int threadNumber = _decoderParam.decode_threads;
+    int coreNumber = (int)std::thread::hardware_concurrency();
+    if (coreNumber > 0)
+    {
+        threadNumber = (std::min)(threadNumber, coreNumber);
+    }
+
+    _prefetching = true;
+    for (int idx = 0; idx < threadNumber; ++idx)
+    {
+        _decodeWorkers.push_back(std::thread(&DirectoryDecoder::DecodeImages, this));
+    }
+    _prefetcher = std::thread(&DirectoryDecoder::Prefetch, this);
+
+    LOG(INFO) << Name() << "(" << _id << ") files: " << _files.size() << ", decode threads: " << threadNumber
+        << ", ordered: " << _decoderParam.ordered << ", max short edge: " << _decoderParam.max_short_edge;
+}
+
+void DirectoryDecoder::StopPipeline()
+{
+    if (_prefetching)
+    {
+        _prefetching = false;
+        WAKEUP_ALL(_prefetchCondition);
+    }
+    WAIT_TO_EXIT(_prefetcher);
+    for (size_t idx = 0; idx < _decodeWorkers.size(); ++idx)
+    {
+        WAIT_TO_EXIT(_decodeWorkers[idx]);
     }
-#else
+    _decodeWorkers.clear();
+
+    _readItems.clear();
+    _readyItems.clear();
+    _inflightNumber = 0;
+}
 
-    if (_frame.empty())
+void DirectoryDecoder::Prefetch()
+{
+    ThreadAffinity::Bind(THREAD_DECODER, _decoderParam.device_index);
+
+    size_t windowSize = (size_t)(std::max)(_decoderParam.buffer_size, 1);
+    unsigned long long sequence = 0;
+    while (_prefetching)
     {
-        _frame = cv::imread(_url + fnode.info.name, cv::IMREAD_COLOR);
+        {
+            WAIT_MILLISEC_TILL_COND(_prefetchCondition, _prefetchLocker, 1000,
+                [&](){ return !_prefetching || (!_files.empty() && _inflightNumber < windowSize); });
+            if (!_prefetching || _files.empty() || _inflightNumber >= windowSize)
+            {
+                continue;
+            }
+        }
+
+        if (_currentFramePostion >= _files.size())
+        {
+            _currentFramePostion = 0;
+        }
+
+        PrefetchedPtr prefetched = std::make_shared<Prefetched>();
+        prefetched->sequence = sequence++;
+        prefetched->position = ++_currentFramePostion;
+        prefetched->file = _url + _files[(size_t)_currentFramePostion - 1].info.name;
+        prefetched->data = rawptr(new std::vector<char>());
+        prefetched->failed = !ReadAll(prefetched->file, *prefetched->data);
+
+        {
+            AUTOLOCK(_prefetchLocker);
+            _inflightNumber++;
+            if (prefetched->failed || _decodeWorkers.empty())
+            {
+                _readyItems[prefetched->sequence] = prefetched;
+            }
+            else
+            {
+                _readItems.push_back(prefetched);
+            }
+        }
+        WAKEUP_ALL(_prefetchCondition);
     }
-    frame.mat = _frame;
-    return !frame.mat.empty();
-#endif
 }
 
+void DirectoryDecoder::DecodeImages()
+{
+    ThreadAffinity::Bind(THREAD_DECODER, _decoderParam.device_index);
+
+    while (_prefetching)
+    {
+        PrefetchedPtr prefetched;
+        {
+            WAIT_MILLISEC_TILL_COND(_prefetchCondition, _prefetchLocker, 1000, [this](){ return !_prefetching || !_readItems.empty(); });
+            if (!_prefetching || _readItems.empty())
+            {
+                continue;
+            }
+            prefetched = _readItems.front();
+            _readItems.pop_front();
+        }
+
+        prefetched->mat = cv::imdecode(*prefetched->data, ReducedFlag(*prefetched->data));
+        prefetched->failed = prefetched->mat.empty();
+        prefetched->data.reset();
 
+        {
+            AUTOLOCK(_prefetchLocker);
+            _readyItems[prefetched->sequence] = prefetched;
+        }
+        WAKEUP_ALL(_prefetchCondition);
+    }
+}
+
+bool DirectoryDecoder::ReadAll(const std::string& file, std::vector<char>& data)
+{
+    // sequential scan makes the system read ahead aggressively
+    HANDLE handle = CreateFileA(file.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (handle == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    bool success = false;
+    LARGE_INTEGER fileSize;
+    if (GetFileSizeEx(handle, &fileSize) && fileSize.QuadPart > 0 && fileSize.QuadPart < (1LL << 31))
+    {
+        data.resize((size_t)fileSize.QuadPart);
+        DWORD readSize = 0;
+        success = ::ReadFile(handle, &data[0], (DWORD)data.size(), &readSize, NULL) && readSize == data.size();
+    }
+    CloseHandle(handle);
+    return success;
+}
+
+bool DirectoryDecoder::JpegSize(const std::vector<char>& data, int& width, int& height)
+{
+    const unsigned char* bytes = (const unsigned char*)data.data();
+    size_t size = data.size();
+    if (size < 4 || bytes[0] != 0xFF || bytes[1] != 0xD8)
+    {
+        return false;
+    }
+
+    size_t offset = 2;
+    while (offset + 4 <= size)
+    {
+        if (bytes[offset] != 0xFF)
+        {
+            return false;
+        }
+
+        unsigned char marker = bytes[offset + 1];
+        if (marker == 0xFF)
+        {
+            // fill byte
+            offset++;
+            continue;
+        }
+        if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD8))
+        {
+            // marker without length
+            offset += 2;
+            continue;
+        }
+
+        size_t length = ((size_t)bytes[offset + 2] << 8) | bytes[offset + 3];
+        // SOFn, except DHT, JPG and DAC
+        if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC)
+        {
+            if (offset + 9 > size)
+            {
+                return false;
+            }
+            height = (bytes[offset + 5] << 8) | bytes[offset + 6];
+            width = (bytes[offset + 7] << 8) | bytes[offset + 8];
+            return width > 0 && height > 0;
+        }
+        if (marker == 0xDA || length < 2)
+        {
+            return false;
+        }
+        offset += 2 + length;
+    }
+    return false;
+}
+
+int DirectoryDecoder::ReducedFlag(const std::vector<char>& data) const
+{
+    // libjpeg scales while decoding DCT blocks, much cheaper than decoding full size and resizing
+    int width = 0, height = 0;
+    int maxShortEdge = _decoderParam.max_short_edge;
+    if (maxShortEdge <= 0 || !JpegSize(data, width, height))
+    {
+        return cv::IMREAD_COLOR;
+    }
+
+    int shortEdge = (std::min)(width, height);
+    if (shortEdge >= maxShortEdge * 8)
+    {
+        return cv::IMREAD_REDUCED_COLOR_8;
+    }
+    else if (shortEdge >= maxShortEdge * 4)
+    {
+        return cv::IMREAD_REDUCED_COLOR_4;
+    }
+    else if (shortEdge >= maxShortEdge * 2)
+    {
+        return cv::IMREAD_REDUCED_COLOR_2;
+    }
+    return cv::IMREAD_COLOR;
+}
 
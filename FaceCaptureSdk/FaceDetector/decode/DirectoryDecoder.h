@@ -4,8 +4,15 @@
 #include "BaseDecoder.h"
 #include "FileSystem.h"
 #include <queue>
+#include <map>
 #include "jpeg_codec.h"
 
+/**
+* @brief directory decoder \n
+* files are read ahead by a prefetch thread, and decoded by decode_threads workers if it is set,
+* at most buffer_size images are read and not taken yet;
+* images are taken in file name order, or in the order they are decoded if ordered is false
+*/
 class DirectoryDecoder : public BaseDecoder
 {
 public:
@@ -22,6 +29,28 @@ protected:
     void Uninit();
     bool ReadFrame(DecodedFrame& frame) override;
 
+private:
+    struct Prefetched
+    {
+        unsigned long long sequence = 0;
+        unsigned long long position = 0;
+        std::string file = "";
+        rawptr data = nullptr;
+        cv::Mat mat = {};
+        bool failed = false;
+    };
+    typedef std::shared_ptr<Prefetched> PrefetchedPtr;
+
+    void StartPipeline();
+    void StopPipeline();
+
+    void Prefetch();
+    void DecodeImages();
+
+    static bool ReadAll(const std::string& file, std::vector<char>& data);
+    static bool JpegSize(const std::vector<char>& data, int& width, int& height);
+    int ReducedFlag(const std::vector<char>& data) const;
+
 private:
     unsigned long long _currentFramePostion;
     FileSystem::FNodeVector _files;
@@ -29,7 +58,16 @@ private:
     jpeg_codec::decoder_instance* _decoder;
     unsigned char* _read_buffer;
 
-    cv::Mat _frame;
+    std::thread _prefetcher;
+    std::vector<std::thread> _decodeWorkers;
+    volatile bool _prefetching;
+
+    std::mutex _prefetchLocker;
+    std::condition_variable _prefetchCondition;
+    std::deque<PrefetchedPtr> _readItems;                       // read, waiting to be decoded
+    std::map<unsigned long long, PrefetchedPtr> _readyItems;    // ready to be taken, by sequence
+    size_t _inflightNumber;                                     // read and not taken yet
+    unsigned long long _nextSequence;                           // next sequence to be taken in order
 };
 
 #endif
@@ -1,5 +1,7 @@
 
 #include "Dxva2Decoder.h"
+#include "ThreadAffinity.h"
+#include "LogThrottle.h"
 
 #define GLOG_NO_ABBREVIATED_SEVERITIES
 #define GOOGLE_GLOG_DLL_DECL
@@ -30,6 +32,18 @@ Dxva2Decoder::~Dxva2Decoder()
 {
 }
 
+/**
+* @brief whether data[0] of the format is an 8 bits luma plane, like yuv420p and nv12 \n
+*
+*/
+static bool HasLumaPlane(int format)
+{
+    const AVPixFmtDescriptor* descriptor = av_pix_fmt_desc_get((AVPixelFormat)format);
+    return descriptor && (descriptor->flags & AV_PIX_FMT_FLAG_PLANAR)
+        && !(descriptor->flags & (AV_PIX_FMT_FLAG_RGB | AV_PIX_FMT_FLAG_PAL | AV_PIX_FMT_FLAG_HWACCEL))
+        && descriptor->comp[0].depth == 8;
+}
+
 static int dxva2_retrieve_data_copy(AVCodecContext *s, AVFrame *frame, AVFrame *dstframe)
 {
     LPDIRECT3DSURFACE9 surface = (LPDIRECT3DSURFACE9)frame->data[3];
@@ -131,55 +145,76 @@ bool Dxva2Decoder::ReadFrame(DecodedFrame& frame)
             // CPU decoding
             if (_swsContextForCPU)
             {
-                sws_scale(
-                    _swsContextForCPU,
-                    (const uint8_t* const*)_srcAvFrame->data,
-                    _srcAvFrame->linesize,
-                    0,
-                    _codecContext->height,
-                    _bgrAvFrame->data,
-                    _bgrAvFrame->linesize);
-
-                cv::Mat decodedFrame(cv::Size(_codecContext->width, _codecContext->height), CV_8UC3);
-                memcpy(decodedFrame.data, _avBuffer, _bufferSize);
-                frame.mat = decodedFrame;
-                frame.id = _nextFrameId++;
-                
-                readFrameOk = true;
-            }
-            else
-            {
-                // copy data from GPU to CPU
-                if (0 == dxva2_retrieve_data_copy(_codecContext, _srcAvFrame, _dstAvFrame))
+                // duplicates are dropped on the luma plane before colour conversion
+                _lumaSampled = HasLumaPlane(_srcAvFrame->format);
+                if (_lumaSampled && IsDuplicateLuma(_srcAvFrame->data[0], _srcAvFrame->width, _srcAvFrame->height, _srcAvFrame->linesize[0]))
+                {
+                    // the frame is left empty and dropped as a duplicate
+                    frame.id = _nextFrameId++;
+                    readFrameOk = true;
+                }
+                else
                 {
-                    GetGPUSWSContext(_swsContextForGPU, *_dstAvFrame);
-
                     sws_scale(
-                        _swsContextForGPU,
-                        (const uint8_t* const*)_dstAvFrame->data,
-                        _dstAvFrame->linesize,
+                        _swsContextForCPU,
+                        (const uint8_t* const*)_srcAvFrame->data,
+                        _srcAvFrame->linesize,
                         0,
-                        _dstAvFrame->height,
+                        _codecContext->height,
                         _bgrAvFrame->data,
                         _bgrAvFrame->linesize);
 
-                    cv::Mat decodedFrame(cv::Size(_dstAvFrame->width, _dstAvFrame->height), CV_8UC3);
+                    cv::Mat decodedFrame(cv::Size(_codecContext->width, _codecContext->height), CV_8UC3);
                     memcpy(decodedFrame.data, _avBuffer, _bufferSize);
                     frame.mat = decodedFrame;
                     frame.id = _nextFrameId++;
-
+                
                     readFrameOk = true;
                 }
+            }
+            else
+            {
+                // copy data from GPU to CPU
+                if (0 == dxva2_retrieve_data_copy(_codecContext, _srcAvFrame, _dstAvFrame))
+                {
+                    _lumaSampled = HasLumaPlane(_dstAvFrame->format);
+                    if (_lumaSampled && IsDuplicateLuma(_dstAvFrame->data[0], _dstAvFrame->width, _dstAvFrame->height, _dstAvFrame->linesize[0]))
+                    {
+                        // the frame is left empty and dropped as a duplicate
+                        frame.id = _nextFrameId++;
+                        readFrameOk = true;
+                    }
+                    else
+                    {
+                        GetGPUSWSContext(_swsContextForGPU, *_dstAvFrame);
+
+                        sws_scale(
+                            _swsContextForGPU,
+                            (const uint8_t* const*)_dstAvFrame->data,
+                            _dstAvFrame->linesize,
+                            0,
+                            _dstAvFrame->height,
+                            _bgrAvFrame->data,
+                            _bgrAvFrame->linesize);
+
+                        cv::Mat decodedFrame(cv::Size(_dstAvFrame->width, _dstAvFrame->height), CV_8UC3);
+                        memcpy(decodedFrame.data, _avBuffer, _bufferSize);
+                        frame.mat = decodedFrame;
+                        frame.id = _nextFrameId++;
+
+                        readFrameOk = true;
+                    }
+                }
                 else
                 {
-                    LOG(ERROR) << __FUNCTION__ << " failed to copy data from GPU to CPU when decoding image frame";
+                    LOG_EVERY_MS(ERROR, 1000) << __FUNCTION__ << " failed to copy data from GPU to CPU when decoding image frame";
                 }
             }
         }
     }
     else
     {
-        LOG(ERROR) << __FUNCTION__ << " decode image frame from packet failed";
+        LOG_EVERY_MS(ERROR, 1000) << __FUNCTION__ << " decode image frame from packet failed";
     }
 
     _packetBuffer.Free(packet);
@@ -350,6 +385,8 @@ bool Dxva2Decoder::StartReadPacket()
 
 void Dxva2Decoder::ReadPacket()
 {
+    ThreadAffinity::Bind(THREAD_DECODER, _decoderParam.device_index);
+
     while (_readingPacket)
     {
         // check packet validity
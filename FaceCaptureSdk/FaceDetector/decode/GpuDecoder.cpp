@@ -3,6 +3,7 @@
 #include "XMatPool.h"
 
 #include "AutoLock.h"
+#include "LogThrottle.h"
 
 #include "StreamParsor.h"
 #include "CudaOperation.h"
@@ -27,6 +28,8 @@ MatDecoder::MatDecoder(const std::string& url, const DecoderParam& decoderParam,
     _sdkDecoderParam.max_surfaces = decoderParam.buffer_size;
 
     _sdkDecoderParam.log_level = decoder::LOG_LEVEL_FATAL;
+
+    _buffered = true;
 }
 
 MatDecoder::~MatDecoder()
@@ -115,7 +118,17 @@ bool MatDecoder::ReadFrame(DecodedFrame& frame)
     {
         frame.position = (long long)(_origFrameInterval * _nextFrameId);
         _nextFrameId++;
-        frame.mat = decoded_frame.mat.clone();
+        // pooled buffers were first touched by decoder threads of the device, so they stay on its numa node;
+        // a buffer still shared by captures (scence or face of origin) is left to them
+        if (XMatPool<cv::Mat>::Alloc(decoded_frame.mat, frame.mat, _sdkDecoderParam.device_index)
+            && frame.mat.u && frame.mat.u->refcount == 1 && frame.mat.type() == decoded_frame.mat.type())
+        {
+            decoded_frame.mat.copyTo(frame.mat);
+        }
+        else
+        {
+            frame.mat = decoded_frame.mat.clone();
+        }
         frame.id = decoded_frame.frame_index;
 
         ret = decoder::unref_frame<cv::Mat>(_decoder, decoded_frame);
@@ -123,7 +136,7 @@ bool MatDecoder::ReadFrame(DecodedFrame& frame)
         {
             char error_str[ERROR_STRING_LEN] = { '\0' };
             decoder::decoder_error_string(error_str, ERROR_STRING_LEN, ret);
-            LOG(WARNING) << __FUNCTION__ << " unref_frame<cv::Mat> failed: " << error_str;
+            LOG_EVERY_MS(WARNING, 1000) << __FUNCTION__ << " unref_frame<cv::Mat> failed: " << error_str;
         }
         return true;
     }
@@ -255,7 +268,7 @@ bool GpuMatDecoder::ReadFrame(DecodedFrame& frame)
         {
             char error_str[ERROR_STRING_LEN] = { '\0' };
             decoder::decoder_error_string(error_str, ERROR_STRING_LEN, ret);
-            LOG(WARNING) << __FUNCTION__ << " unref_frame<cv::cuda::GpuMat> failed: " << error_str;
+            LOG_EVERY_MS(WARNING, 1000) << __FUNCTION__ << " unref_frame<cv::cuda::GpuMat> failed: " << error_str;
         }
         return copyCudaSuccess;
     }
@@ -0,0 +1,617 @@
+
+#include "WatchDecoder.h"
+#include "AutoLock.h"
+#include "ThreadAffinity.h"
+
+#include <algorithm>
+#include <cstring>
+
+#define GLOG_NO_ABBREVIATED_SEVERITIES
+#define GOOGLE_GLOG_DLL_DECL
+#include "glog/logging.h"
+
+WatchDecoder::WatchDecoder(const std::string& url, const DecoderParam& decoderParam, const DecodeParam& decodeParam, const WatchParam& watchParam, const std::string& id)
+    : BaseDecoder(url, decoderParam, decodeParam, id)
+    , _watchParam(watchParam), _cursorFile()
+    , _directory(INVALID_HANDLE_VALUE), _watcher(), _watching(false)
+    , _watchLocker(), _watchCondition(), _candidates(), _delivered(), _queued(), _processed(), _retries(), _watchError()
+    , _acknowledgements(std::make_shared<Acknowledgements>())
+    , _cursor(nullptr), _position(0)
+{
+}
+
+WatchDecoder::~WatchDecoder()
+{
+}
+
+bool WatchDecoder::Init()
+{
+    AUTOLOCK(_decoderLocker);
+
+    // check directory
+    if (!FileSystem::Exist(_url))
+    {
+        _errorMessage = "watch folder(" + _url + ") can not be opened, reason: path not found";
+        LOG(INFO) << _errorMessage;
+        return false;
+    }
+
+    char ch = _url[_url.size() - 1];
+    // check path pattern
+    if (ch != '/' && ch != '\\')
+    {
+        _url += "/";
+    }
+
+    if (_watchParam.processed == WATCH_MOVE)
+    {
+        if (_watchParam.processed_path.empty() || (!FileSystem::Exist(_watchParam.processed_path) && !FileSystem::MakeDir(_watchParam.processed_path)))
+        {
+            _errorMessage = "watch folder(" + _url + ") can not be opened, reason: processed path(" + _watchParam.processed_path + ") can not be created";
+            LOG(INFO) << _errorMessage;
+            return false;
+        }
+
+        ch = _watchParam.processed_path[_watchParam.processed_path.size() - 1];
+        if (ch != '/' && ch != '\\')
+        {
+            _watchParam.processed_path += "/";
+        }
+    }
+    _cursorFile = _watchParam.cursor_file.empty() ? _url + ".watch_cursor" : _watchParam.cursor_file;
+
+    _directory = CreateFileA(_url.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, NULL);
+    if (_directory == INVALID_HANDLE_VALUE)
+    {
+        _errorMessage = "watch folder(" + _url + ") can not be opened, reason: " + std::to_string(GetLastError());
+        LOG(INFO) << _errorMessage;
+        return false;
+    }
+
+    _candidates.clear();
+    _delivered.clear();
+    _queued.clear();
+    _processed.clear();
+    _retries.clear();
+    _watchError = "";
+    LoadCursor();
+
+    // watch before listing, images dropped while listing are not missed
+    _watching = true;
+    _watcher = std::thread(&WatchDecoder::Watch, this);
+
+    FileSystem::FNodeVector files;
+    FileSystem::ListFile(_url, files);
+    {
+        AUTOLOCK(_watchLocker);
+        std::map<std::string, long long> recorded;
+        recorded.swap(_processed);
+
+        FileSystem::FNodeVector unprocessed;
+        for (size_t idx = 0; idx < files.size(); ++idx)
+        {
+            std::map<std::string, long long>::iterator it = recorded.find(files[idx].info.name);
+            if (it == recorded.end() || it->second != (long long)files[idx].info.time_write)
+            {
+                unprocessed.push_back(files[idx]);
+            }
+            else if (_watchParam.processed == WATCH_KEEP)
+            {
+                _processed.insert(*it);
+            }
+            else
+            {
+                // recorded but not deleted or moved before last exit
+                Process(it->first);
+            }
+        }
+        files.swap(unprocessed);
+    }
+    Enqueue(files);
+
+    // rewrite the cursor with images still kept only
+    if (!SaveCursor())
+    {
+        _errorMessage = "watch folder(" + _url + ") can not be opened, reason: cursor file(" + _cursorFile + ") can not be written";
+        LOG(INFO) << _errorMessage;
+        StopWatch();
+        return false;
+    }
+
+    _errorMessage = "";
+    {
+        AUTOLOCK(_watchLocker);
+        LOG(INFO) << Name() << "(" << _id << ") create success, unprocessed: " << _candidates.size() << ", processed: " << _processed.size();
+    }
+    return true;
+}
+
+void WatchDecoder::Uninit()
+{
+    AUTOLOCK(_decoderLocker);
+    StopWatch();
+
+    if (_cursor)
+    {
+        fclose(_cursor);
+        _cursor = nullptr;
+    }
+
+    // images taken but not committed are taken again after restart
+    LOG(INFO) << Name() << "(" << _id << ") destroy success, not committed: " << _candidates.size() + _delivered.size();
+    _candidates.clear();
+    _delivered.clear();
+    _queued.clear();
+    _processed.clear();
+    _retries.clear();
+}
+
+bool WatchDecoder::ReadFrame(DecodedFrame& frame)
+{
+    while (_decoding)
+    {
+        Commit();
+
+        std::vector<std::string> names;
+        bool full = false;
+        {
+            AUTOLOCK(_watchLocker);
+            if (!_watchError.empty())
+            {
+                _errorMessage = _watchError;
+                break;
+            }
+            names.assign(_candidates.begin(), _candidates.end());
+            full = _delivered.size() >= (size_t)(std::max)(_decoderParam.buffer_size, 1);
+        }
+
+        // back pressure, wait for the detector to acknowledge taken images
+        if (full)
+        {
+            WAIT_MILLISEC_TILL_COND(_acknowledgements->condition, _acknowledgements->locker, 200, [&](){ return !_acknowledgements->results.empty(); });
+            continue;
+        }
+
+        size_t busyNumber = 0;
+        for (size_t idx = 0; idx < names.size(); ++idx)
+        {
+            rawptr data;
+            long long writeTime = 0;
+            int taken = Take(names[idx], data, writeTime);
+            if (taken == TAKE_BUSY)
+            {
+                busyNumber++;
+                continue;
+            }
+
+            unsigned long long position = taken == TAKE_OK ? ++_position : 0;
+            {
+                AUTOLOCK(_watchLocker);
+                _candidates.erase(std::find(_candidates.begin(), _candidates.end(), names[idx]));
+                if (taken == TAKE_OK)
+                {
+                    Delivered delivered = { names[idx], writeTime, position };
+                    _delivered.push_back(delivered);
+                }
+                else
+                {
+                    // it is notified again if it is written later
+                    _queued.erase(names[idx]);
+                }
+            }
+
+            if (taken == TAKE_FAILED)
+            {
+                LOG(WARNING) << Name() << "(" << _id << ") read " << _url << names[idx] << " failed";
+            }
+            else if (taken == TAKE_OK)
+            {
+                frame.id = frame.position = position;
+                frame.imdata = data;
+
+                std::shared_ptr<Acknowledgements> acknowledgements = _acknowledgements;
+                frame.ack = std::make_shared<FrameAck>([acknowledgements, position](bool processed)
+                {
+                    Acknowledgement acknowledgement = { position, processed };
+                    {
+                        AUTOLOCK(acknowledgements->locker);
+                        acknowledgements->results.push_back(acknowledgement);
+                    }
+                    WAKEUP_ONE(acknowledgements->condition);
+                });
+                return true;
+            }
+        }
+
+        // busy images are tried again after a while, the writer may have closed them
+        WAIT_MILLISEC_TILL_COND(_watchCondition, _watchLocker, 200, [&](){ return !_watchError.empty() || _candidates.size() > busyNumber; });
+    }
+
+    // do not spin while the watch is broken, the decoder restarts after failureThreshold
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    return false;
+}
+
+void WatchDecoder::StopWatch()
+{
+    if (_watching)
+    {
+        _watching = false;
+        WAKEUP_ALL(_watchCondition);
+    }
+    WAIT_TO_EXIT(_watcher);
+
+    if (_directory != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(_directory);
+        _directory = INVALID_HANDLE_VALUE;
+    }
+}
+
+void WatchDecoder::Watch()
+{
+    ThreadAffinity::Bind(THREAD_DECODER, _decoderParam.device_index);
+
+    // notifications are DWORD aligned
+    std::vector<DWORD> buffer(16 * 1024);
+    OVERLAPPED overlapped;
+    memset(&overlapped, 0, sizeof(overlapped));
+    overlapped.hEvent = CreateEventA(NULL, TRUE, FALSE, NULL);
+
+    while (_watching)
+    {
+        ResetEvent(overlapped.hEvent);
+        if (!ReadDirectoryChangesW(_directory, &buffer[0], (DWORD)(buffer.size() * sizeof(DWORD)), FALSE,
+            FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE, NULL, &overlapped, NULL))
+        {
+            Fail("watch failed: " + std::to_string(GetLastError()));
+            break;
+        }
+
+        DWORD waited = WAIT_TIMEOUT;
+        while (_watching && (waited = WaitForSingleObject(overlapped.hEvent, 500)) == WAIT_TIMEOUT);
+
+        DWORD transferred = 0;
+        if (waited != WAIT_OBJECT_0)
+        {
+            // the pending read writes into buffer, it must be done before buffer is released
+            CancelIo(_directory);
+            GetOverlappedResult(_directory, &overlapped, &transferred, TRUE);
+            if (_watching)
+            {
+                Fail("watch wait failed: " + std::to_string(GetLastError()));
+            }
+            break;
+        }
+
+        if (!GetOverlappedResult(_directory, &overlapped, &transferred, FALSE))
+        {
+            // the folder is removed or not accessible any more
+            Fail("watch failed: " + std::to_string(GetLastError()));
+            break;
+        }
+
+        if (transferred == 0)
+        {
+            // notifications overflowed the buffer and are lost
+            LOG(WARNING) << Name() << "(" << _id << ") watch overflowed, rescan " << _url;
+            FileSystem::FNodeVector files;
+            FileSystem::ListFile(_url, files);
+            Enqueue(files);
+            continue;
+        }
+
+        const char* entry = (const char*)&buffer[0];
+        while (true)
+        {
+            const FILE_NOTIFY_INFORMATION* information = (const FILE_NOTIFY_INFORMATION*)entry;
+            if (information->Action == FILE_ACTION_ADDED || information->Action == FILE_ACTION_MODIFIED
+                || information->Action == FILE_ACTION_RENAMED_NEW_NAME)
+            {
+                char name[MAX_PATH * 2] = { 0 };
+                int length = WideCharToMultiByte(CP_ACP, 0, information->FileName, information->FileNameLength / sizeof(WCHAR),
+                    name, sizeof(name) - 1, NULL, NULL);
+                if (length > 0)
+                {
+                    Enqueue(std::string(name, length), -1);
+                }
+            }
+
+            if (information->NextEntryOffset == 0)
+            {
+                break;
+            }
+            entry += information->NextEntryOffset;
+        }
+    }
+
+    CloseHandle(overlapped.hEvent);
+}
+
+void WatchDecoder::Fail(const std::string& reason)
+{
+    LOG(ERROR) << Name() << "(" << _id << ") " << reason;
+    {
+        AUTOLOCK(_watchLocker);
+        _watchError = "watch folder(" + _url + ") " + reason;
+    }
+    WAKEUP_ALL(_watchCondition);
+}
+
+void WatchDecoder::Enqueue(const std::string& name, long long writeTime)
+{
+    if (!IsImage(name))
+    {
+        return;
+    }
+
+    {
+        AUTOLOCK(_watchLocker);
+        // a file being written is notified many times
+        if (_queued.find(name) != _queued.end())
+        {
+            return;
+        }
+
+        std::map<std::string, long long>::iterator it = _processed.find(name);
+        if (it != _processed.end())
+        {
+            if (writeTime < 0)
+            {
+                writeTime = WriteTime(_url + name);
+            }
+            if (writeTime == it->second)
+            {
+                return;
+            }
+            // written again after it is processed
+            _processed.erase(it);
+        }
+
+        _queued.insert(name);
+        _candidates.push_back(name);
+    }
+    WAKEUP_ONE(_watchCondition);
+}
+
+void WatchDecoder::Enqueue(FileSystem::FNodeVector& files)
+{
+    // oldest first, as if they were notified in the order they were written
+    std::sort(files.begin(), files.end(), [](const FileSystem::FNode& f, const FileSystem::FNode& s){
+        return f.info.time_write < s.info.time_write || (f.info.time_write == s.info.time_write && strcmp(f.info.name, s.info.name) < 0); });
+
+    for (size_t idx = 0; idx < files.size(); ++idx)
+    {
+        Enqueue(files[idx].info.name, (long long)files[idx].info.time_write);
+    }
+}
+
+int WatchDecoder::Take(const std::string& name, rawptr& data, long long& writeTime)
+{
+    // not shared, so the open fails while the writer still holds the file
+    HANDLE handle = CreateFileA((_url + name).c_str(), GENERIC_READ, 0, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (handle == INVALID_HANDLE_VALUE)
+    {
+        DWORD error = GetLastError();
+        if (error == ERROR_SHARING_VIOLATION || error == ERROR_LOCK_VIOLATION)
+        {
+            return TAKE_BUSY;
+        }
+        return (error == ERROR_FILE_NOT_FOUND || error == ERROR_PATH_NOT_FOUND) ? TAKE_GONE : TAKE_FAILED;
+    }
+
+    int taken = TAKE_FAILED;
+    LARGE_INTEGER fileSize;
+    FILETIME lastWrite;
+    if (GetFileSizeEx(handle, &fileSize) && GetFileTime(handle, NULL, NULL, &lastWrite))
+    {
+        if (fileSize.QuadPart == 0)
+        {
+            // created but not written yet
+            taken = TAKE_GONE;
+        }
+        else if (fileSize.QuadPart < (1LL << 31))
+        {
+            data = std::make_shared<std::vector<char>>((size_t)fileSize.QuadPart);
+            DWORD readSize = 0;
+            if (::ReadFile(handle, &(*data)[0], (DWORD)data->size(), &readSize, NULL) && readSize == data->size())
+            {
+                writeTime = Seconds(lastWrite);
+                taken = TAKE_OK;
+            }
+        }
+    }
+    CloseHandle(handle);
+    return taken;
+}
+
+void WatchDecoder::Commit()
+{
+    std::vector<Acknowledgement> results;
+    {
+        AUTOLOCK(_acknowledgements->locker);
+        results.swap(_acknowledgements->results);
+    }
+    if (results.empty())
+    {
+        return;
+    }
+
+    std::vector<Delivered> committed;
+    std::vector<std::string> abandoned;
+    {
+        AUTOLOCK(_watchLocker);
+        for (size_t idx = 0; idx < results.size(); ++idx)
+        {
+            unsigned long long position = results[idx].position;
+            std::deque<Delivered>::iterator it = std::find_if(_delivered.begin(), _delivered.end(), [position](const Delivered& delivered){ return delivered.position == position; });
+            if (it == _delivered.end())
+            {
+                // taken before restart
+                continue;
+            }
+            Delivered delivered = *it;
+            _delivered.erase(it);
+
+            if (!results[idx].processed && _retries[delivered.name]++ < _watchParam.retry_times)
+            {
+                // dropped on the way, take it again before the newer ones
+                _candidates.push_front(delivered.name);
+                continue;
+            }
+
+            if (!results[idx].processed)
+            {
+                abandoned.push_back(delivered.name);
+            }
+            _retries.erase(delivered.name);
+            committed.push_back(delivered);
+        }
+    }
+    if (committed.empty())
+    {
+        return;
+    }
+
+    for (size_t idx = 0; idx < abandoned.size(); ++idx)
+    {
+        LOG(WARNING) << Name() << "(" << _id << ") " << _url << abandoned[idx] << " is dropped " << _watchParam.retry_times + 1 << " times, commit it without detection";
+    }
+
+    // record first, an image recorded but not deleted or moved is finished after restart
+    if (_cursor)
+    {
+        for (size_t idx = 0; idx < committed.size(); ++idx)
+        {
+            fprintf(_cursor, "%s\t%lld\n", committed[idx].name.c_str(), committed[idx].writeTime);
+        }
+        fflush(_cursor);
+    }
+
+    for (size_t idx = 0; idx < committed.size(); ++idx)
+    {
+        Process(committed[idx].name);
+    }
+
+    AUTOLOCK(_watchLocker);
+    for (size_t idx = 0; idx < committed.size(); ++idx)
+    {
+        _queued.erase(committed[idx].name);
+        if (_watchParam.processed == WATCH_KEEP)
+        {
+            _processed[committed[idx].name] = committed[idx].writeTime;
+        }
+    }
+}
+
+void WatchDecoder::Process(const std::string& name)
+{
+    std::string file = _url + name;
+    if (_watchParam.processed == WATCH_DELETE)
+    {
+        if (!DeleteFileA(file.c_str()))
+        {
+            DWORD error = GetLastError();
+            if (error != ERROR_FILE_NOT_FOUND)
+            {
+                LOG(WARNING) << Name() << "(" << _id << ") delete " << file << " failed: " << error;
+            }
+        }
+    }
+    else if (_watchParam.processed == WATCH_MOVE)
+    {
+        std::string target = _watchParam.processed_path + name;
+        if (!MoveFileExA(file.c_str(), target.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_COPY_ALLOWED))
+        {
+            DWORD error = GetLastError();
+            if (error != ERROR_FILE_NOT_FOUND)
+            {
+                LOG(WARNING) << Name() << "(" << _id << ") move " << file << " to " << target << " failed: " << error;
+            }
+        }
+    }
+}
+
+void WatchDecoder::LoadCursor()
+{
+    FILE* f = fopen(_cursorFile.c_str(), "rb");
+    if (!f)
+    {
+        return;
+    }
+
+    char line[MAX_PATH * 2 + 32];
+    while (fgets(line, sizeof(line), f))
+    {
+        char* separator = strrchr(line, '\t');
+        if (separator)
+        {
+            *separator = '\0';
+            _processed[line] = atoll(separator + 1);
+        }
+    }
+    fclose(f);
+}
+
+bool WatchDecoder::SaveCursor()
+{
+    // write a temporary file then rename it, a crash never leaves a partial cursor
+    std::string temporary = _cursorFile + ".tmp";
+    FILE* f = fopen(temporary.c_str(), "wb");
+    if (!f)
+    {
+        return false;
+    }
+
+    {
+        AUTOLOCK(_watchLocker);
+        for (std::map<std::string, long long>::const_iterator it = _processed.begin(); it != _processed.end(); ++it)
+        {
+            fprintf(f, "%s\t%lld\n", it->first.c_str(), it->second);
+        }
+    }
+    bool saved = fflush(f) == 0;
+    fclose(f);
+
+    if (!saved || !MoveFileExA(temporary.c_str(), _cursorFile.c_str(), MOVEFILE_REPLACE_EXISTING))
+    {
+        DeleteFileA(temporary.c_str());
+        return false;
+    }
+
+    _cursor = fopen(_cursorFile.c_str(), "ab");
+    return _cursor != nullptr;
+}
+
+bool WatchDecoder::IsImage(const std::string& name)
+{
+    std::string::size_type dot = name.rfind('.');
+    if (dot == std::string::npos)
+    {
+        return false;
+    }
+
+    std::string extension = name.substr(dot + 1);
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    return extension == "jpg" || extension == "jpeg" || extension == "png" || extension == "bmp";
+}
+
+long long WatchDecoder::WriteTime(const std::string& file)
+{
+    WIN32_FILE_ATTRIBUTE_DATA attribute;
+    if (!GetFileAttributesExA(file.c_str(), GetFileExInfoStandard, &attribute))
+    {
+        return -1;
+    }
+    return Seconds(attribute.ftLastWriteTime);
+}
+
+long long WatchDecoder::Seconds(const FILETIME& fileTime)
+{
+    // same as time_write of _finddata_t, seconds since 1970
+    ULARGE_INTEGER value;
+    value.LowPart = fileTime.dwLowDateTime;
+    value.HighPart = fileTime.dwHighDateTime;
+    return (long long)((value.QuadPart - 116444736000000000ULL) / 10000000ULL);
+}
@@ -0,0 +1,106 @@
+
+#ifndef _WATCHDECODER_HEADER_H_
+#define _WATCHDECODER_HEADER_H_
+
+#include "BaseDecoder.h"
+#include "FileSystem.h"
+
+#include <deque>
+#include <set>
+#include <map>
+
+#include <windows.h>
+
+/**
+* @brief watch folder decoder \n
+* images dropped into the folder are taken as soon as the directory change is notified,
+* an image is taken only when its writer has closed it, so partially written files are skipped till they are complete;
+* an image is committed when the detector acknowledges it (see FrameAck): it is recorded in the cursor file,
+* then kept, deleted or moved by watchParam.processed; an image dropped before it is detected is taken again,
+* up to watchParam.retry_times, and images not committed are taken again after restart, so every image is processed
+* at least once; no more images than buffer_size are taken and not acknowledged, so the frame queue never discards one
+*/
+class WatchDecoder : public BaseDecoder
+{
+public:
+    WatchDecoder(const std::string& url, const DecoderParam&, const DecodeParam&, const WatchParam&, const std::string&);
+    virtual ~WatchDecoder();
+
+    const char* Name() const
+    {
+        return "WatchDecoder";
+    }
+
+protected:
+    bool Init();
+    void Uninit();
+    bool ReadFrame(DecodedFrame& frame) override;
+
+private:
+    enum { TAKE_OK, TAKE_BUSY, TAKE_GONE, TAKE_FAILED };
+
+    struct Delivered
+    {
+        std::string name;
+        long long writeTime;          // seconds, an image written again is not the processed one
+        unsigned long long position;  // of the frame, acknowledgements refer to it
+    };
+
+    struct Acknowledgement
+    {
+        unsigned long long position;
+        bool processed;
+    };
+
+    /**
+    * @brief acknowledgements of the frames, shared with them, as they may be released after the decoder \n
+    */
+    struct Acknowledgements
+    {
+        std::mutex locker;
+        std::condition_variable condition;
+        std::vector<Acknowledgement> results;
+    };
+
+    void StopWatch();
+    void Watch();
+    void Fail(const std::string& reason);
+    void Enqueue(const std::string& name, long long writeTime);
+    void Enqueue(FileSystem::FNodeVector& files);
+
+    int Take(const std::string& name, rawptr& data, long long& writeTime);
+    void Commit();
+    void Process(const std::string& name);
+
+    void LoadCursor();
+    bool SaveCursor();
+
+    static bool IsImage(const std::string& name);
+    static long long WriteTime(const std::string& file);
+    static long long Seconds(const FILETIME& fileTime);
+
+private:
+    WatchParam _watchParam;
+    std::string _cursorFile;
+
+    HANDLE _directory;
+    std::thread _watcher;
+    volatile bool _watching;
+
+    std::mutex _watchLocker;
+    std::condition_variable _watchCondition;
+    std::deque<std::string> _candidates;                      // notified, not taken yet, in arrival order
+    std::deque<Delivered> _delivered;                         // taken, not committed yet
+    std::set<std::string> _queued;                            // names in candidates or delivered
+    std::map<std::string, long long> _processed;              // committed and kept, with write time
+    std::map<std::string, int> _retries;                      // dropped before detection, with times taken again
+    std::string _watchError;
+
+    std::shared_ptr<Acknowledgements> _acknowledgements;
+
+    FILE* _cursor;
+    unsigned long long _position;
+};
+
+#endif
+
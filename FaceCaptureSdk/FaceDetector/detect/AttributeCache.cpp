@@ -0,0 +1,237 @@
+
+#include "AttributeCache.h"
+#include "TimeStamp.h"
+
+AttributeCache::Ballot::Ballot()
+    : settled(false), value(-1)
+    , _counts(), _streakValue(-1), _streak(0), _total(0)
+{
+}
+
+void AttributeCache::Ballot::Vote(int result, int votes)
+{
+    if (settled)
+    {
+        return;
+    }
+
+    int count = ++_counts[result];
+    _total++;
+
+    if (result == _streakValue)
+    {
+        _streak++;
+    }
+    else
+    {
+        _streakValue = result;
+        _streak = 1;
+    }
+
+    if (_streak >= votes)
+    {
+        // consistent results in a row
+        value = result;
+        settled = true;
+        return;
+    }
+
+    if (value < 0 || count > _counts[value])
+    {
+        value = result;
+    }
+
+    // never settled in a row, take the majority
+    settled = _total >= votes * 2;
+}
+
+AttributeCache::AttributeCache(size_t capacity, int votes)
+    : _locker(), _recentKeys(), _trackAttributes()
+    , _capacity(capacity > 0 ? capacity : 1), _votes(votes > 0 ? votes : 1)
+{
+}
+
+AttributeCache::~AttributeCache()
+{
+}
+
+int AttributeCache::Lookup(const SourceId& sourceId, int timeout, FaceBox& faceBox)
+{
+    long long now = TimeStamp<MILLISECONDS>::Now();
+
+    AUTOLOCK(_locker);
+    TrackAttributes::iterator it = _trackAttributes.find(TrackKey(sourceId, faceBox.id));
+    if (it == _trackAttributes.end())
+    {
+        return 0;
+    }
+
+    TrackAttribute& trackAttribute = Touch(it->first, now);
+    if (timeout > 0 && now - trackAttribute.accessTime > timeout)
+    {
+        // the track id was reused by a new face
+        trackAttribute = TrackAttribute();
+    }
+    trackAttribute.accessTime = now;
+
+    int settled = SettledMask(trackAttribute);
+    Fill(trackAttribute, settled, faceBox);
+    return settled;
+}
+
+void AttributeCache::Vote(const SourceId& sourceId, int analyzed, FaceBox& faceBox)
+{
+    long long now = TimeStamp<MILLISECONDS>::Now();
+
+    AUTOLOCK(_locker);
+    TrackAttribute& trackAttribute = Touch(TrackKey(sourceId, faceBox.id), now);
+    trackAttribute.accessTime = now;
+
+    int voted = 0;
+    if ((analyzed & ATTRIBUTE_GLASSES) && faceBox.glasses >= 0)
+    {
+        trackAttribute.glasses.Vote(faceBox.glasses, _votes);
+        voted |= ATTRIBUTE_GLASSES;
+    }
+    if ((analyzed & ATTRIBUTE_MASK) && faceBox.mask >= 0)
+    {
+        trackAttribute.mask.Vote(faceBox.mask, _votes);
+        voted |= ATTRIBUTE_MASK;
+    }
+    if ((analyzed & ATTRIBUTE_AGE_GENDER) && faceBox.gender >= 0)
+    {
+        if (!trackAttribute.gender.settled && faceBox.age >= 0)
+        {
+            trackAttribute.ageSum += faceBox.age;
+            trackAttribute.ageNumber++;
+        }
+        trackAttribute.gender.Vote(faceBox.gender, _votes);
+        voted |= ATTRIBUTE_AGE_GENDER;
+    }
+    if ((analyzed & ATTRIBUTE_AGE_ETHNIC) && faceBox.age_group >= 0 && faceBox.ethnic >= 0)
+    {
+        trackAttribute.ageEthnic.Vote((faceBox.age_group << 16) | (faceBox.ethnic & 0xFFFF), _votes);
+        voted |= ATTRIBUTE_AGE_ETHNIC;
+    }
+
+    // report the voted results instead of the single frame ones
+    Fill(trackAttribute, voted, faceBox);
+}
+
+void AttributeCache::Remove(const SourceId& sourceId)
+{
+    AUTOLOCK(_locker);
+    for (TrackKeys::iterator it = _recentKeys.begin(); it != _recentKeys.end();)
+    {
+        if (it->first == sourceId)
+        {
+            _trackAttributes.erase(*it);
+            it = _recentKeys.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+void AttributeCache::Transfer(const SourceId& sourceId, AttributeCache& target)
+{
+    // most recent first
+    std::list<std::pair<TrackKey, TrackAttribute>> moved;
+    {
+        AUTOLOCK(_locker);
+        for (TrackKeys::iterator it = _recentKeys.begin(); it != _recentKeys.end();)
+        {
+            if (it->first == sourceId)
+            {
+                TrackAttributes::iterator attributeIt = _trackAttributes.find(*it);
+                moved.push_back(std::make_pair(*it, attributeIt->second.first));
+                _trackAttributes.erase(attributeIt);
+                it = _recentKeys.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+
+    AUTOLOCK(target._locker);
+    for (std::list<std::pair<TrackKey, TrackAttribute>>::reverse_iterator it = moved.rbegin(); it != moved.rend(); ++it)
+    {
+        target.Touch(it->first, it->second.accessTime) = it->second;
+    }
+}
+
+AttributeCache::TrackAttribute& AttributeCache::Touch(const TrackKey& trackKey, long long now)
+{
+    TrackAttributes::iterator it = _trackAttributes.find(trackKey);
+    if (it != _trackAttributes.end())
+    {
+        // move to the most recent
+        _recentKeys.splice(_recentKeys.begin(), _recentKeys, it->second.second);
+        return it->second.first;
+    }
+
+    // evict the least recent
+    while (_trackAttributes.size() >= _capacity && !_recentKeys.empty())
+    {
+        _trackAttributes.erase(_recentKeys.back());
+        _recentKeys.pop_back();
+    }
+
+    _recentKeys.push_front(trackKey);
+    TrackAttributeNode& trackAttributeNode = _trackAttributes[trackKey];
+    trackAttributeNode.first.accessTime = now;
+    trackAttributeNode.second = _recentKeys.begin();
+    return trackAttributeNode.first;
+}
+
+int AttributeCache::SettledMask(const TrackAttribute& trackAttribute)
+{
+    int settled = 0;
+    if (trackAttribute.glasses.settled)
+    {
+        settled |= ATTRIBUTE_GLASSES;
+    }
+    if (trackAttribute.mask.settled)
+    {
+        settled |= ATTRIBUTE_MASK;
+    }
+    if (trackAttribute.gender.settled)
+    {
+        settled |= ATTRIBUTE_AGE_GENDER;
+    }
+    if (trackAttribute.ageEthnic.settled)
+    {
+        settled |= ATTRIBUTE_AGE_ETHNIC;
+    }
+    return settled;
+}
+
+void AttributeCache::Fill(const TrackAttribute& trackAttribute, int mask, FaceBox& faceBox)
+{
+    if (mask & ATTRIBUTE_GLASSES)
+    {
+        faceBox.glasses = trackAttribute.glasses.value;
+    }
+    if (mask & ATTRIBUTE_MASK)
+    {
+        faceBox.mask = trackAttribute.mask.value;
+    }
+    if (mask & ATTRIBUTE_AGE_GENDER)
+    {
+        faceBox.gender = trackAttribute.gender.value;
+        if (trackAttribute.ageNumber > 0)
+        {
+            faceBox.age = trackAttribute.ageSum / trackAttribute.ageNumber;
+        }
+    }
+    if (mask & ATTRIBUTE_AGE_ETHNIC)
+    {
+        faceBox.age_group = trackAttribute.ageEthnic.value >> 16;
+        faceBox.ethnic = trackAttribute.ageEthnic.value & 0xFFFF;
+    }
+}
+
@@ -0,0 +1,108 @@
+
+#ifndef _ATTRIBUTECACHE_HEADER_H_
+#define _ATTRIBUTECACHE_HEADER_H_
+
+#include "FaceSdkApi.h"
+
+#include <map>
+#include <list>
+#include <mutex>
+
+/**
+* @brief bounded LRU cache of face attributes keyed by track \n
+* each attribute is voted by the analyzed results of the track, it is settled
+* after votes consistent results in a row (or majority of 2 * votes results),
+* settled attribute will not be analyzed again until the track is evicted or timeout
+*/
+class AttributeCache
+{
+public:
+    enum Attribute
+    {
+        ATTRIBUTE_GLASSES    = 0x01,
+        ATTRIBUTE_MASK       = 0x02,
+        ATTRIBUTE_AGE_GENDER = 0x04,
+        ATTRIBUTE_AGE_ETHNIC = 0x08
+    };
+
+public:
+    AttributeCache(size_t capacity, int votes);
+    ~AttributeCache();
+
+    /**
+    * @brief get settled attributes of the track \n
+    * @param timeout  attributes of the track not touched in this duration are discarded (ms)
+    * @param faceBox  face box of the track, settled attributes will be filled in
+    * @return mask of settled attributes
+    */
+    int Lookup(const SourceId& sourceId, int timeout, FaceBox& faceBox);
+
+    /**
+    * @brief vote the analyzed attributes of the track \n
+    * analyzed attributes of faceBox will be replaced by the voted ones
+    * @param analyzed mask of analyzed attributes
+    */
+    void Vote(const SourceId& sourceId, int analyzed, FaceBox& faceBox);
+
+    void Remove(const SourceId& sourceId);
+
+    /**
+    * @brief move attributes of the source to target, for a source moved with its tracks \n
+    * they keep their recency, the least recent ones of target are evicted if it is full
+    */
+    void Transfer(const SourceId& sourceId, AttributeCache& target);
+
+private:
+    class Ballot
+    {
+    public:
+        Ballot();
+
+        void Vote(int result, int votes);
+
+        bool settled;
+        int value;
+
+    private:
+        std::map<int, int> _counts;
+        int _streakValue;
+        int _streak;
+        int _total;
+    };
+
+    struct TrackAttribute
+    {
+        long long accessTime = 0;
+        Ballot glasses;
+        Ballot mask;
+        Ballot gender;
+        Ballot ageEthnic;
+        int ageSum = 0;
+        int ageNumber = 0;
+    };
+
+    typedef std::pair<SourceId, int> TrackKey;
+    typedef std::list<TrackKey> TrackKeys;
+    typedef std::pair<TrackAttribute, TrackKeys::iterator> TrackAttributeNode;
+    typedef std::map<TrackKey, TrackAttributeNode> TrackAttributes;
+
+    TrackAttribute& Touch(const TrackKey& trackKey, long long now);
+
+    static int SettledMask(const TrackAttribute& trackAttribute);
+    static void Fill(const TrackAttribute& trackAttribute, int mask, FaceBox& faceBox);
+
+private:
+    std::mutex _locker;
+    TrackKeys _recentKeys;
+    TrackAttributes _trackAttributes;
+
+    size_t _capacity;
+    int _votes;
+
+private:
+    AttributeCache(const AttributeCache&);
+    AttributeCache& operator=(const AttributeCache&);
+};
+
+#endif
+
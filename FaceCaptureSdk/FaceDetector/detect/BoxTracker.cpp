@@ -0,0 +1,299 @@
+
+#include "BoxTracker.h"
+#include "TimeStamp.h"
+
+#include <algorithm>
+
+// kalman filter noise, position in pixel and velocity in pixel per frame
+static const float PROCESS_NOISE = 1.0f;
+static const float MEASUREMENT_NOISE = 4.0f;
+static const float INITIAL_POSITION_COVARIANCE = 10.0f;
+static const float INITIAL_VELOCITY_COVARIANCE = 100.0f;
+
+// a tracked face missed by this many detections in a row has left the scene,
+// one miss is kept for association only, so that a blurred frame does not change its track id
+static const int MAX_MISSED_DETECTIONS = 2;
+
+BoxTracker::KalmanAxis::KalmanAxis()
+    : _position(0.0f), _velocity(0.0f)
+    , _p00(INITIAL_POSITION_COVARIANCE), _p01(0.0f), _p10(0.0f), _p11(INITIAL_VELOCITY_COVARIANCE)
+{
+}
+
+void BoxTracker::KalmanAxis::Init(float position)
+{
+    _position = position;
+    _velocity = 0.0f;
+    _p00 = INITIAL_POSITION_COVARIANCE;
+    _p01 = _p10 = 0.0f;
+    _p11 = INITIAL_VELOCITY_COVARIANCE;
+}
+
+void BoxTracker::KalmanAxis::Predict()
+{
+    // x = F * x, P = F * P * F' + Q, F = [1 1; 0 1]
+    _position += _velocity;
+
+    float p00 = _p00 + _p01 + _p10 + _p11 + PROCESS_NOISE * 0.25f;
+    float p01 = _p01 + _p11 + PROCESS_NOISE * 0.5f;
+    float p10 = _p10 + _p11 + PROCESS_NOISE * 0.5f;
+    float p11 = _p11 + PROCESS_NOISE;
+
+    _p00 = p00;
+    _p01 = p01;
+    _p10 = p10;
+    _p11 = p11;
+}
+
+void BoxTracker::KalmanAxis::Update(float position)
+{
+    // only position is measured, H = [1 0]
+    float residual = position - _position;
+    float s = _p00 + MEASUREMENT_NOISE;
+    float k0 = _p00 / s;
+    float k1 = _p10 / s;
+
+    _position += k0 * residual;
+    _velocity += k1 * residual;
+
+    float p00 = (1.0f - k0) * _p00;
+    float p01 = (1.0f - k0) * _p01;
+    float p10 = _p10 - k1 * _p00;
+    float p11 = _p11 - k1 * _p01;
+
+    _p00 = p00;
+    _p01 = p01;
+    _p10 = p10;
+    _p11 = p11;
+}
+
+BoxTracker::BoxTracker()
+    : _locker(), _sourceTracks()
+{
+}
+
+BoxTracker::~BoxTracker()
+{
+}
+
+void BoxTracker::Track(ApiImagePtr& apiImagePtr, bool detected, FaceSdkBoxes& faceSdkBoxes)
+{
+    const FaceParam& faceParam = apiImagePtr->faceParam;
+
+    cv::Size resolution = apiImagePtr->Resolution();
+    int maxWidth = resolution.width;
+    int maxHeight = resolution.height;
+
+    long long now = TimeStamp<MILLISECONDS>::Now();
+
+    AUTOLOCK(_locker);
+    SourceTrack& sourceTrack = _sourceTracks[apiImagePtr->sourceId];
+    TrackedFaces& trackedFaces = sourceTrack.trackedFaces;
+
+    // discard the faces which were not detected again for a while
+    TrackedFaces::iterator it = trackedFaces.begin();
+    while (it != trackedFaces.end())
+    {
+        if (now - it->updateTime > faceParam.cpu_track_timeout)
+        {
+            it = trackedFaces.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+
+    for (size_t idx = 0; idx < trackedFaces.size(); ++idx)
+    {
+        PredictTrackedFace(trackedFaces[idx], maxWidth, maxHeight);
+    }
+
+    if (!detected)
+    {
+        // missed faces may have left, do not make boxes of them
+        for (size_t idx = 0; idx < trackedFaces.size(); ++idx)
+        {
+            if (trackedFaces[idx].missedNumber == 0 && trackedFaces[idx].box.width > 0 && trackedFaces[idx].box.height > 0)
+            {
+                faceSdkBoxes.push_back(trackedFaces[idx].box);
+            }
+        }
+    }
+    else
+    {
+        Associate(sourceTrack, faceSdkBoxes, faceParam.cpu_track_iou, now);
+    }
+}
+
+void BoxTracker::Remove(const SourceId& sourceId)
+{
+    AUTOLOCK(_locker);
+    _sourceTracks.erase(sourceId);
+}
+
+void BoxTracker::Transfer(const SourceId& sourceId, BoxTracker& target)
+{
+    SourceTrack sourceTrack;
+    {
+        AUTOLOCK(_locker);
+        SourceTracks::iterator it = _sourceTracks.find(sourceId);
+        if (it == _sourceTracks.end())
+        {
+            return;
+        }
+        sourceTrack = it->second;
+        _sourceTracks.erase(it);
+    }
+
+    AUTOLOCK(target._locker);
+    target._sourceTracks[sourceId] = sourceTrack;
+}
+
+float BoxTracker::IOU(const FaceSdkBox& a, const FaceSdkBox& b)
+{
+    int left = (std::max)(a.x, b.x);
+    int top = (std::max)(a.y, b.y);
+    int right = (std::min)(a.x + a.width, b.x + b.width);
+    int bottom = (std::min)(a.y + a.height, b.y + b.height);
+    if (right <= left || bottom <= top)
+    {
+        return 0.0f;
+    }
+
+    float intersection = (float)(right - left) * (bottom - top);
+    float unions = (float)a.width * a.height + (float)b.width * b.height - intersection;
+    return unions > 0.0f ? intersection / unions : 0.0f;
+}
+
+void BoxTracker::InitTrackedFace(TrackedFace& trackedFace, const FaceSdkBox& box)
+{
+    trackedFace.box = box;
+    trackedFace.centerX.Init(box.x + box.width * 0.5f);
+    trackedFace.centerY.Init(box.y + box.height * 0.5f);
+    trackedFace.width.Init((float)box.width);
+    trackedFace.height.Init((float)box.height);
+}
+
+void BoxTracker::UpdateTrackedFace(TrackedFace& trackedFace, const FaceSdkBox& box)
+{
+    trackedFace.box = box;
+    trackedFace.centerX.Update(box.x + box.width * 0.5f);
+    trackedFace.centerY.Update(box.y + box.height * 0.5f);
+    trackedFace.width.Update((float)box.width);
+    trackedFace.height.Update((float)box.height);
+}
+
+void BoxTracker::PredictTrackedFace(TrackedFace& trackedFace, int maxWidth, int maxHeight)
+{
+    trackedFace.centerX.Predict();
+    trackedFace.centerY.Predict();
+    trackedFace.width.Predict();
+    trackedFace.height.Predict();
+
+    FaceSdkBox& box = trackedFace.box;
+    box.width = (int)trackedFace.width.Position();
+    box.height = (int)trackedFace.height.Position();
+    box.x = (int)(trackedFace.centerX.Position() - box.width * 0.5f);
+    box.y = (int)(trackedFace.centerY.Position() - box.height * 0.5f);
+
+    // keep the face box inside the image
+    if (box.x < 0)
+    {
+        box.width += box.x;
+        box.x = 0;
+    }
+    if (box.y < 0)
+    {
+        box.height += box.y;
+        box.y = 0;
+    }
+    if (maxWidth > 0 && box.x + box.width > maxWidth)
+    {
+        box.width = maxWidth - box.x;
+    }
+    if (maxHeight > 0 && box.y + box.height > maxHeight)
+    {
+        box.height = maxHeight - box.y;
+    }
+}
+
+void BoxTracker::Associate(SourceTrack& sourceTrack, FaceSdkBoxes& detectedBoxes, float minIOU, long long now)
+{
+    TrackedFaces& trackedFaces = sourceTrack.trackedFaces;
+    std::vector<char> trackedMatched(trackedFaces.size(), 0);
+    std::vector<char> detectedMatched(detectedBoxes.size(), 0);
+
+    // greedy association, the pair with largest IOU first
+    while (true)
+    {
+        float bestIOU = minIOU;
+        int bestTracked = -1, bestDetected = -1;
+        for (size_t trackedIdx = 0; trackedIdx < trackedFaces.size(); ++trackedIdx)
+        {
+            if (trackedMatched[trackedIdx])
+            {
+                continue;
+            }
+            for (size_t detectedIdx = 0; detectedIdx < detectedBoxes.size(); ++detectedIdx)
+            {
+                if (detectedMatched[detectedIdx])
+                {
+                    continue;
+                }
+                float iou = IOU(trackedFaces[trackedIdx].box, detectedBoxes[detectedIdx]);
+                if (iou >= bestIOU)
+                {
+                    bestIOU = iou;
+                    bestTracked = (int)trackedIdx;
+                    bestDetected = (int)detectedIdx;
+                }
+            }
+        }
+
+        if (bestTracked < 0)
+        {
+            break;
+        }
+
+        trackedMatched[bestTracked] = 1;
+        detectedMatched[bestDetected] = 1;
+
+        TrackedFace& trackedFace = trackedFaces[bestTracked];
+        detectedBoxes[bestDetected].number = trackedFace.id;
+        UpdateTrackedFace(trackedFace, detectedBoxes[bestDetected]);
+        trackedFace.missedNumber = 0;
+        trackedFace.updateTime = now;
+    }
+
+    // faces not detected again, discard them after too many misses
+    size_t keptNumber = 0;
+    for (size_t trackedIdx = 0; trackedIdx < trackedFaces.size(); ++trackedIdx)
+    {
+        if (!trackedMatched[trackedIdx] && ++trackedFaces[trackedIdx].missedNumber >= MAX_MISSED_DETECTIONS)
+        {
+            continue;
+        }
+        if (keptNumber != trackedIdx)
+        {
+            trackedFaces[keptNumber] = trackedFaces[trackedIdx];
+        }
+        keptNumber++;
+    }
+    trackedFaces.resize(keptNumber);
+
+    // new faces
+    for (size_t detectedIdx = 0; detectedIdx < detectedBoxes.size(); ++detectedIdx)
+    {
+        if (!detectedMatched[detectedIdx])
+        {
+            TrackedFace trackedFace;
+            trackedFace.id = sourceTrack.nextId++;
+            trackedFace.updateTime = now;
+            detectedBoxes[detectedIdx].number = trackedFace.id;
+            InitTrackedFace(trackedFace, detectedBoxes[detectedIdx]);
+            trackedFaces.push_back(trackedFace);
+        }
+    }
+}
+
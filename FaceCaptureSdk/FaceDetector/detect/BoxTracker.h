@@ -0,0 +1,96 @@
+
+#ifndef _BOXTRACKER_HEADER_H_
+#define _BOXTRACKER_HEADER_H_
+
+#include "FaceSdkApi.h"
+
+#include <map>
+#include <mutex>
+
+/**
+* @brief cpu face box tracker \n
+* associate detected faces with tracked faces by IOU and propagate
+* tracked faces between detections by constant velocity kalman filter
+*/
+class BoxTracker
+{
+public:
+    BoxTracker();
+    ~BoxTracker();
+
+    /**
+    * @brief track faces of one image \n
+    * detected face boxes will be assigned track id (number), tracked faces which are not detected
+    * are missed and discarded after a second miss in a row; on a track only image
+    * face boxes will be predicted from the tracked faces of the same source which were not missed
+    * @param apiImagePtr  image to track
+    * @param detected     the image was detected, even if no face was found
+    * @param faceSdkBoxes [in] detected face boxes, [out] tracked face boxes
+    */
+    void Track(ApiImagePtr& apiImagePtr, bool detected, FaceSdkBoxes& faceSdkBoxes);
+
+    void Remove(const SourceId& sourceId);
+
+    /**
+    * @brief move tracked faces of the source to target \n
+    * tracks go on with the same track ids on target
+    */
+    void Transfer(const SourceId& sourceId, BoxTracker& target);
+
+private:
+    /**
+    * @brief one dimension constant velocity kalman filter \n
+    */
+    class KalmanAxis
+    {
+    public:
+        KalmanAxis();
+
+        void Init(float position);
+        void Predict();
+        void Update(float position);
+
+        float Position() const { return _position; }
+
+    private:
+        float _position;
+        float _velocity;
+        float _p00, _p01, _p10, _p11;
+    };
+
+    struct TrackedFace
+    {
+        int id = -1;
+        int missedNumber = 0;
+        long long updateTime = 0;
+        FaceSdkBox box;
+        KalmanAxis centerX, centerY, width, height;
+    };
+    typedef std::vector<TrackedFace> TrackedFaces;
+
+    struct SourceTrack
+    {
+        int nextId = 0;
+        TrackedFaces trackedFaces;
+    };
+    typedef std::map<SourceId, SourceTrack> SourceTracks;
+
+    static float IOU(const FaceSdkBox& a, const FaceSdkBox& b);
+
+    static void InitTrackedFace(TrackedFace& trackedFace, const FaceSdkBox& box);
+    static void UpdateTrackedFace(TrackedFace& trackedFace, const FaceSdkBox& box);
+    static void PredictTrackedFace(TrackedFace& trackedFace, int maxWidth, int maxHeight);
+
+    void Associate(SourceTrack& sourceTrack, FaceSdkBoxes& detectedBoxes, float minIOU, long long now);
+
+private:
+    std::mutex _locker;
+    SourceTracks _sourceTracks;
+
+private:
+    BoxTracker(const BoxTracker&);
+    BoxTracker& operator=(const BoxTracker&);
+};
+
+#endif
+
@@ -0,0 +1,912 @@
+
+#include "CaptureArchive.h"
+#include "FileSystem.h"
+#include "TimeStamp.h"
+#include "ThreadAffinity.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+#define GLOG_NO_ABBREVIATED_SEVERITIES
+#define GOOGLE_GLOG_DLL_DECL
+#include "glog/logging.h"
+
+static const unsigned long long ARCHIVE_ALIGNMENT = 8;
+
+static unsigned long long AlignUp(unsigned long long size)
+{
+    return (size + ARCHIVE_ALIGNMENT - 1) & ~(ARCHIVE_ALIGNMENT - 1);
+}
+
+static void AppendBytes(std::vector<char>& buffer, const void* data, size_t size)
+{
+    if (size > 0)
+    {
+        const char* bytes = (const char*)data;
+        buffer.insert(buffer.end(), bytes, bytes + size);
+    }
+}
+
+static bool EncodeJpeg(const cv::Mat& image, int quality, std::vector<uchar>& jpeg)
+{
+    jpeg.clear();
+    if (image.empty())
+    {
+        return true;
+    }
+
+    std::vector<int> params;
+    params.push_back(cv::IMWRITE_JPEG_QUALITY);
+    params.push_back(quality);
+    return cv::imencode(".jpg", image, jpeg, params);
+}
+
+static void DecodeJpeg(const char* data, unsigned int size, cv::Mat& image)
+{
+    if (size > 0)
+    {
+        image = cv::imdecode(cv::Mat(1, (int)size, CV_8UC1, (void*)data), cv::IMREAD_COLOR);
+    }
+}
+
+static void ReadFloats(const char* data, unsigned int number, std::vector<float>& values)
+{
+    values.resize(number);
+    if (number > 0)
+    {
+        memcpy(&values[0], data, number * sizeof(float));
+    }
+}
+
+bool ArchiveRecordView::Parse(const char* record, unsigned long long size)
+{
+    header = (const ArchiveRecordHeader*)record;
+    if (size < sizeof(ArchiveRecordHeader) || header->magic != ARCHIVE_RECORD_MAGIC || header->size != size)
+    {
+        return false;
+    }
+
+    unsigned long long totalSize = sizeof(ArchiveRecordHeader) + (unsigned long long)header->sourceIdSize
+        + ((unsigned long long)header->keypointsNumber + header->visiblesNumber + header->anglesNumber) * sizeof(float)
+        + header->featureSize + header->faceSize + header->alignedSize + header->scenceSize;
+    if (totalSize > size)
+    {
+        return false;
+    }
+
+    sourceId = record + sizeof(ArchiveRecordHeader);
+    keypoints = sourceId + header->sourceIdSize;
+    visibles = keypoints + header->keypointsNumber * sizeof(float);
+    angles = visibles + header->visiblesNumber * sizeof(float);
+    feature = angles + header->anglesNumber * sizeof(float);
+    face = feature + header->featureSize;
+    aligned = face + header->faceSize;
+    scence = aligned + header->alignedSize;
+    return true;
+}
+
+void ArchiveSegmentIndex::Add(const SourceId& sourceId, long long timestamp, unsigned long long offset, unsigned int size)
+{
+    Entry entry;
+    entry.timestamp = timestamp;
+    entry.offset = offset;
+    entry.size = size;
+    sources[sourceId].push_back(entry);
+
+    beginTime = (std::min)(beginTime, timestamp);
+    endTime = (std::max)(endTime, timestamp);
+}
+
+void ArchiveSegmentIndex::Sort()
+{
+    for (SourceEntries::iterator it = sources.begin(); it != sources.end(); ++it)
+    {
+        std::stable_sort(it->second.begin(), it->second.end());
+    }
+}
+
+size_t ArchiveSegmentIndex::Scan(const char* view, unsigned long long viewSize)
+{
+    if (usedSize == 0)
+    {
+        const ArchiveSegmentHeader* header = (const ArchiveSegmentHeader*)view;
+        if (viewSize < sizeof(ArchiveSegmentHeader) || header->magic != ARCHIVE_SEGMENT_MAGIC || header->version != ARCHIVE_VERSION)
+        {
+            return 0;
+        }
+        usedSize = sizeof(ArchiveSegmentHeader);
+    }
+
+    size_t number = 0;
+    while (usedSize + sizeof(ArchiveRecordHeader) <= viewSize)
+    {
+        const ArchiveRecordHeader* header = (const ArchiveRecordHeader*)(view + usedSize);
+        if (header->magic != ARCHIVE_RECORD_MAGIC)
+        {
+            break;
+        }
+        // the record is complete once its magic is seen
+        MemoryBarrier();
+
+        if (header->size < sizeof(ArchiveRecordHeader) || usedSize + header->size > viewSize
+            || header->sourceIdSize > header->size - sizeof(ArchiveRecordHeader))
+        {
+            break;
+        }
+
+        Add(SourceId(view + usedSize + sizeof(ArchiveRecordHeader), header->sourceIdSize), header->timestamp, usedSize, header->size);
+        usedSize += header->size;
+        number++;
+    }
+
+    if (number > 0)
+    {
+        Sort();
+    }
+    return number;
+}
+
+bool ArchiveSegmentIndex::Load(const std::string& file)
+{
+    FILE* f = fopen(file.c_str(), "rb");
+    if (!f)
+    {
+        return false;
+    }
+
+    bool success = false;
+    do
+    {
+        ArchiveIndexHeader header;
+        if (fread(&header, sizeof(header), 1, f) != 1 || header.magic != ARCHIVE_INDEX_MAGIC || header.version != ARCHIVE_VERSION)
+        {
+            break;
+        }
+
+        SourceIds sourceIds(header.sourceNumber);
+        bool valid = true;
+        for (unsigned int idx = 0; idx < header.sourceNumber && valid; ++idx)
+        {
+            unsigned int size = 0;
+            valid = fread(&size, sizeof(size), 1, f) == 1 && size < 4096;
+            if (valid && size > 0)
+            {
+                sourceIds[idx].resize(size);
+                valid = fread(&sourceIds[idx][0], size, 1, f) == 1;
+            }
+        }
+        if (!valid)
+        {
+            break;
+        }
+
+        std::vector<ArchiveIndexEntry> entries(header.entryNumber);
+        if (header.entryNumber > 0 && fread(&entries[0], sizeof(ArchiveIndexEntry), entries.size(), f) != entries.size())
+        {
+            break;
+        }
+
+        for (size_t idx = 0; idx < entries.size() && valid; ++idx)
+        {
+            const ArchiveIndexEntry& entry = entries[idx];
+            valid = entry.sourceIndex < sourceIds.size();
+            if (valid)
+            {
+                Add(sourceIds[entry.sourceIndex], entry.timestamp, entry.offset, entry.size);
+            }
+        }
+        if (!valid)
+        {
+            break;
+        }
+
+        usedSize = header.usedSize;
+        success = true;
+    } while (false);
+
+    fclose(f);
+    return success;
+}
+
+bool ArchiveSegmentIndex::Save(const std::string& file) const
+{
+    // write a temporary file then rename it, a reader never sees a partial index
+    std::string temporary = file + ".tmp";
+    FILE* f = fopen(temporary.c_str(), "wb");
+    if (!f)
+    {
+        return false;
+    }
+
+    ArchiveIndexHeader header;
+    header.magic = ARCHIVE_INDEX_MAGIC;
+    header.version = ARCHIVE_VERSION;
+    header.sourceNumber = (unsigned int)sources.size();
+    header.entryNumber = 0;
+    header.usedSize = usedSize;
+    for (SourceEntries::const_iterator it = sources.begin(); it != sources.end(); ++it)
+    {
+        header.entryNumber += (unsigned int)it->second.size();
+    }
+
+    std::vector<char> buffer;
+    AppendBytes(buffer, &header, sizeof(header));
+    for (SourceEntries::const_iterator it = sources.begin(); it != sources.end(); ++it)
+    {
+        unsigned int size = (unsigned int)it->first.size();
+        AppendBytes(buffer, &size, sizeof(size));
+        AppendBytes(buffer, it->first.data(), size);
+    }
+
+    unsigned int sourceIndex = 0;
+    for (SourceEntries::const_iterator it = sources.begin(); it != sources.end(); ++it, ++sourceIndex)
+    {
+        for (size_t idx = 0; idx < it->second.size(); ++idx)
+        {
+            ArchiveIndexEntry entry;
+            entry.timestamp = it->second[idx].timestamp;
+            entry.offset = it->second[idx].offset;
+            entry.size = it->second[idx].size;
+            entry.sourceIndex = sourceIndex;
+            AppendBytes(buffer, &entry, sizeof(entry));
+        }
+    }
+
+    bool success = fwrite(&buffer[0], buffer.size(), 1, f) == 1;
+    success = fclose(f) == 0 && success;
+
+    if (!success || !MoveFileExA(temporary.c_str(), file.c_str(), MOVEFILE_REPLACE_EXISTING))
+    {
+        DeleteFileA(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+std::mutex CaptureArchive::_archivesLocker;
+std::map<std::string, std::weak_ptr<CaptureArchive>> CaptureArchive::_archives;
+
+CaptureArchivePtr CaptureArchive::Open(const ArchiveParam& archiveParam) throw(BaseException)
+{
+    AUTOLOCK(_archivesLocker);
+    CaptureArchivePtr captureArchivePtr = _archives[archiveParam.path].lock();
+    if (!captureArchivePtr)
+    {
+        captureArchivePtr.reset(new CaptureArchive(archiveParam));
+        captureArchivePtr->Start();
+        _archives[archiveParam.path] = captureArchivePtr;
+    }
+    return captureArchivePtr;
+}
+
+CaptureArchive::CaptureArchive(const ArchiveParam& archiveParam)
+    : _archiveParam(archiveParam), _segmentSize((unsigned long long)(std::max)(archiveParam.segmentSize, 1) << 20)
+    , _writer(), _writing(false)
+    , _pendingLocker(), _pendingCondition(), _pending()
+    , _sequence(0), _segmentFile(INVALID_HANDLE_VALUE), _segmentMapping(NULL), _segmentView(nullptr), _segmentCapacity(0), _segmentIndex()
+    , _statisticLocker(), _statistic(), _lastReportTime(TimeStamp<MILLISECONDS>::Now())
+{
+}
+
+CaptureArchive::~CaptureArchive()
+{
+    Stop();
+}
+
+void CaptureArchive::Start() throw(BaseException)
+{
+    const std::string& path = _archiveParam.path;
+    if (!FileSystem::Exist(path) && !FileSystem::MakeDir(path))
+    {
+        throw BaseException(0, "capture archive directory can not be created: " + path);
+    }
+
+    // segments left unsealed by last run are sealed first
+    std::vector<unsigned int> sequences;
+    ListSegments(path, sequences);
+    for (size_t idx = 0; idx < sequences.size(); ++idx)
+    {
+        if (!FileSystem::Exist(IndexFile(SegmentFile(path, sequences[idx]))))
+        {
+            RecoverSegment(sequences[idx]);
+        }
+    }
+    _sequence = sequences.empty() ? 0 : sequences.back();
+    RemoveSegments();
+
+    _writing = true;
+    _writer = std::thread(&CaptureArchive::Write, this);
+
+    LOG(INFO) << "capture archive started: " << path << ", last segment: " << _sequence;
+}
+
+void CaptureArchive::Stop()
+{
+    if (_writing)
+    {
+        _writing = false;
+        WAKEUP_ALL(_pendingCondition);
+    }
+    WAIT_TO_EXIT(_writer);
+}
+
+void CaptureArchive::Append(const CaptureResults& captureResults)
+{
+    if (captureResults.empty())
+    {
+        return;
+    }
+
+    long long droppedNumber = 0;
+    {
+        AUTOLOCK(_pendingLocker);
+        for (size_t idx = 0; idx < captureResults.size(); ++idx)
+        {
+            // shallow copy, images are shared, the caller may change the result after GetCapture
+            _pending.push_back(CaptureResultPtr(new CaptureResult(*captureResults[idx])));
+        }
+
+        while ((int)_pending.size() > (std::max)(_archiveParam.bufferSize, 1))
+        {
+            _pending.pop_front();
+            droppedNumber++;
+        }
+    }
+    WAKEUP_ONE(_pendingCondition);
+
+    if (droppedNumber > 0)
+    {
+        AUTOLOCK(_statisticLocker);
+        _statistic.droppedNumber += droppedNumber;
+    }
+}
+
+void CaptureArchive::GetStatistics(Statistic& statistic)
+{
+    AUTOLOCK(_statisticLocker);
+    statistic = _statistic;
+}
+
+std::string CaptureArchive::SegmentFile(const std::string& path, unsigned int sequence)
+{
+    char name[32] = { 0 };
+    sprintf(name, "%010u.seg", sequence);
+    return path + "/" + name;
+}
+
+std::string CaptureArchive::IndexFile(const std::string& segmentFile)
+{
+    return segmentFile.substr(0, segmentFile.size() - 4) + ".idx";
+}
+
+void CaptureArchive::ListSegments(const std::string& path, std::vector<unsigned int>& sequences)
+{
+    FileSystem::FNodeVector files;
+    FileSystem::ListFile(path, files);
+    for (size_t idx = 0; idx < files.size(); ++idx)
+    {
+        const char* name = files[idx].info.name;
+        char* end = nullptr;
+        unsigned long sequence = strtoul(name, &end, 10);
+        if (end != name && strcmp(end, ".seg") == 0)
+        {
+            sequences.push_back((unsigned int)sequence);
+        }
+    }
+    std::sort(sequences.begin(), sequences.end());
+}
+
+void CaptureArchive::Write()
+{
+    ThreadAffinity::Bind(THREAD_SERVICE, -1);
+
+    std::vector<char> record;
+    while (true)
+    {
+        std::deque<CaptureResultPtr> pending;
+        {
+            WAIT_MILLISEC_TILL_COND(_pendingCondition, _pendingLocker, 1000, [this](){ return !_writing || !_pending.empty(); });
+            pending.swap(_pending);
+        }
+
+        long long droppedNumber = 0;
+        for (size_t idx = 0; idx < pending.size(); ++idx)
+        {
+            if (!WriteOne(pending[idx], record))
+            {
+                droppedNumber++;
+            }
+        }
+
+        if (droppedNumber > 0)
+        {
+            AUTOLOCK(_statisticLocker);
+            _statistic.droppedNumber += droppedNumber;
+        }
+
+        Report();
+
+        // captures pushed before stopping are written
+        if (!_writing && pending.empty())
+        {
+            break;
+        }
+    }
+
+    SealSegment();
+}
+
+bool CaptureArchive::Encode(const CaptureResult& captureResult, int jpegQuality, bool withScence, std::vector<char>& record)
+{
+    const FaceBox& faceBox = captureResult.faceBox;
+
+    std::vector<uchar> face, aligned, scence;
+    if (!EncodeJpeg(captureResult.face, jpegQuality, face)
+        || !EncodeJpeg(captureResult.aligned, jpegQuality, aligned)
+        || (withScence && !EncodeJpeg(captureResult.scence, jpegQuality, scence)))
+    {
+        return false;
+    }
+
+    ArchiveRecordHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = ARCHIVE_RECORD_MAGIC;
+    header.timestamp = captureResult.timestamp;
+    header.position = captureResult.position;
+    header.frameId = captureResult.frameId;
+    header.id = faceBox.id;
+    header.x = faceBox.x;
+    header.y = faceBox.y;
+    header.width = faceBox.width;
+    header.height = faceBox.height;
+    header.confidence = faceBox.confidence;
+    header.keypointsConfidence = faceBox.keypointsConfidence;
+    header.badness = faceBox.badness;
+    header.clarity = faceBox.clarity;
+    header.brightness = faceBox.brightness;
+    header.age = faceBox.age;
+    header.age_group = faceBox.age_group;
+    header.gender = faceBox.gender;
+    header.ethnic = faceBox.ethnic;
+    header.glasses = faceBox.glasses;
+    header.mask = faceBox.mask;
+    header.sourceIdSize = (unsigned int)captureResult.sourceId.size();
+    header.keypointsNumber = (unsigned int)faceBox.keypoints.size();
+    header.visiblesNumber = (unsigned int)faceBox.visibles.size();
+    header.anglesNumber = (unsigned int)faceBox.angles.size();
+    header.featureSize = (unsigned int)faceBox.feature.size();
+    header.faceSize = (unsigned int)face.size();
+    header.alignedSize = (unsigned int)aligned.size();
+    header.scenceSize = (unsigned int)scence.size();
+
+    record.clear();
+    AppendBytes(record, &header, sizeof(header));
+    AppendBytes(record, captureResult.sourceId.data(), captureResult.sourceId.size());
+    AppendBytes(record, faceBox.keypoints.data(), faceBox.keypoints.size() * sizeof(float));
+    AppendBytes(record, faceBox.visibles.data(), faceBox.visibles.size() * sizeof(float));
+    AppendBytes(record, faceBox.angles.data(), faceBox.angles.size() * sizeof(float));
+    AppendBytes(record, faceBox.feature.data(), faceBox.feature.size());
+    AppendBytes(record, face.data(), face.size());
+    AppendBytes(record, aligned.data(), aligned.size());
+    AppendBytes(record, scence.data(), scence.size());
+    record.resize((size_t)AlignUp(record.size()), 0);
+
+    ((ArchiveRecordHeader*)&record[0])->size = (unsigned int)record.size();
+    return true;
+}
+
+bool CaptureArchive::WriteOne(const CaptureResultPtr& captureResultPtr, std::vector<char>& record)
+{
+    const CaptureResult& captureResult = *captureResultPtr;
+    if (!Encode(captureResult, _archiveParam.jpegQuality, _archiveParam.archiveScence, record))
+    {
+        return false;
+    }
+    unsigned int size = (unsigned int)record.size();
+
+    if (!_segmentView || _segmentIndex.usedSize + size > _segmentCapacity)
+    {
+        SealSegment();
+        if (!OpenSegment(sizeof(ArchiveSegmentHeader) + size))
+        {
+            return false;
+        }
+    }
+
+    // magic is published at last, so readers never see a partial record
+    unsigned long long offset = _segmentIndex.usedSize;
+    char* target = _segmentView + offset;
+    memcpy(target + sizeof(unsigned int), &record[sizeof(unsigned int)], size - sizeof(unsigned int));
+    MemoryBarrier();
+    *(volatile unsigned int*)target = ARCHIVE_RECORD_MAGIC;
+
+    _segmentIndex.Add(captureResult.sourceId, captureResult.timestamp, offset, size);
+    _segmentIndex.usedSize += size;
+
+    AUTOLOCK(_statisticLocker);
+    _statistic.appendedNumber++;
+    _statistic.appendedBytes += size;
+    return true;
+}
+
+bool CaptureArchive::OpenSegment(unsigned long long minSize)
+{
+    std::string file = SegmentFile(_archiveParam.path, _sequence + 1);
+    unsigned long long capacity = AlignUp((std::max)(_segmentSize, minSize));
+
+    // the file is extended to capacity by the mapping, and shrunk to used size when sealed
+    _segmentFile = CreateFileA(file.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (_segmentFile == INVALID_HANDLE_VALUE)
+    {
+        LOG(ERROR) << "capture archive segment can not be created: " << file << ", error: " << GetLastError();
+        return false;
+    }
+
+    _segmentMapping = CreateFileMappingA(_segmentFile, NULL, PAGE_READWRITE, (DWORD)(capacity >> 32), (DWORD)(capacity & 0xFFFFFFFF), NULL);
+    if (_segmentMapping)
+    {
+        _segmentView = (char*)MapViewOfFile(_segmentMapping, FILE_MAP_WRITE, 0, 0, (SIZE_T)capacity);
+    }
+
+    if (!_segmentView)
+    {
+        LOG(ERROR) << "capture archive segment can not be mapped: " << file << ", size: " << capacity << ", error: " << GetLastError();
+        if (_segmentMapping)
+        {
+            CloseHandle(_segmentMapping);
+            _segmentMapping = NULL;
+        }
+        CloseHandle(_segmentFile);
+        _segmentFile = INVALID_HANDLE_VALUE;
+        DeleteFileA(file.c_str());
+        return false;
+    }
+
+    ArchiveSegmentHeader header;
+    header.magic = ARCHIVE_SEGMENT_MAGIC;
+    header.version = ARCHIVE_VERSION;
+    header.createTime = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    memcpy(_segmentView, &header, sizeof(header));
+
+    _sequence++;
+    _segmentCapacity = capacity;
+    _segmentIndex = ArchiveSegmentIndex();
+    _segmentIndex.usedSize = sizeof(header);
+    return true;
+}
+
+void CaptureArchive::SealSegment()
+{
+    if (!_segmentView)
+    {
+        return;
+    }
+
+    std::string file = SegmentFile(_archiveParam.path, _sequence);
+    FlushViewOfFile(_segmentView, (SIZE_T)_segmentIndex.usedSize);
+    UnmapViewOfFile(_segmentView);
+    _segmentView = nullptr;
+    CloseHandle(_segmentMapping);
+    _segmentMapping = NULL;
+
+    // it fails while a reader maps the segment, the zero tail is skipped by readers then
+    LARGE_INTEGER usedSize;
+    usedSize.QuadPart = (LONGLONG)_segmentIndex.usedSize;
+    if (!SetFilePointerEx(_segmentFile, usedSize, NULL, FILE_BEGIN) || !SetEndOfFile(_segmentFile))
+    {
+        LOG(WARNING) << "capture archive segment can not be truncated: " << file << ", error: " << GetLastError();
+    }
+    CloseHandle(_segmentFile);
+    _segmentFile = INVALID_HANDLE_VALUE;
+
+    _segmentIndex.Sort();
+    if (!_segmentIndex.Save(IndexFile(file)))
+    {
+        LOG(ERROR) << "capture archive index can not be saved: " << IndexFile(file);
+    }
+
+    {
+        AUTOLOCK(_statisticLocker);
+        _statistic.sealedSegments++;
+    }
+
+    _segmentIndex = ArchiveSegmentIndex();
+    _segmentCapacity = 0;
+
+    RemoveSegments();
+}
+
+void CaptureArchive::RecoverSegment(unsigned int sequence)
+{
+    std::string file = SegmentFile(_archiveParam.path, sequence);
+    HANDLE handle = CreateFileA(file.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (handle == INVALID_HANDLE_VALUE)
+    {
+        LOG(WARNING) << "capture archive segment can not be recovered: " << file << ", error: " << GetLastError();
+        return;
+    }
+
+    ArchiveSegmentIndex index;
+    size_t number = 0;
+    LARGE_INTEGER fileSize;
+    if (GetFileSizeEx(handle, &fileSize) && fileSize.QuadPart > 0)
+    {
+        HANDLE mapping = CreateFileMappingA(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+        const char* view = mapping ? (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+        if (view)
+        {
+            number = index.Scan(view, (unsigned long long)fileSize.QuadPart);
+            UnmapViewOfFile(view);
+        }
+        if (mapping)
+        {
+            CloseHandle(mapping);
+        }
+    }
+
+    if (index.usedSize > 0)
+    {
+        LARGE_INTEGER usedSize;
+        usedSize.QuadPart = (LONGLONG)index.usedSize;
+        SetFilePointerEx(handle, usedSize, NULL, FILE_BEGIN);
+        SetEndOfFile(handle);
+    }
+    CloseHandle(handle);
+
+    if (index.usedSize == 0)
+    {
+        DeleteFileA(file.c_str());
+        LOG(WARNING) << "invalid capture archive segment was removed: " << file;
+    }
+    else if (index.Save(IndexFile(file)))
+    {
+        LOG(INFO) << "capture archive segment recovered: " << file << ", records: " << number;
+    }
+}
+
+void CaptureArchive::RemoveSegments()
+{
+    if (_archiveParam.segmentNumber <= 0)
+    {
+        return;
+    }
+
+    std::vector<unsigned int> sequences;
+    ListSegments(_archiveParam.path, sequences);
+    for (size_t idx = 0; idx + _archiveParam.segmentNumber < sequences.size(); ++idx)
+    {
+        // readers mapping it keep the data until they unmap
+        std::string file = SegmentFile(_archiveParam.path, sequences[idx]);
+        DeleteFileA(file.c_str());
+        DeleteFileA(IndexFile(file).c_str());
+    }
+}
+
+void CaptureArchive::Report()
+{
+    long long now = TimeStamp<MILLISECONDS>::Now();
+    if (now - _lastReportTime < 60000)
+    {
+        return;
+    }
+    _lastReportTime = now;
+
+    Statistic statistic;
+    GetStatistics(statistic);
+    LOG(INFO) << "capture archive(" << _archiveParam.path << ") appended: " << statistic.appendedNumber
+        << " (" << (statistic.appendedBytes >> 20) << " MB), dropped: " << statistic.droppedNumber
+        << ", sealed segments: " << statistic.sealedSegments << ", current segment: " << _sequence;
+}
+
+CaptureArchiveReader::CaptureArchiveReader(const std::string& path)
+    : _path(path), _locker(), _segments()
+{
+}
+
+CaptureArchiveReader::~CaptureArchiveReader()
+{
+    for (Segments::iterator it = _segments.begin(); it != _segments.end(); ++it)
+    {
+        Unmap(*it->second);
+    }
+}
+
+bool CaptureArchiveReader::Query(const SourceId& sourceId, long long beginTime, long long endTime, CaptureResults& captureResults)
+{
+    AUTOLOCK(_locker);
+    Refresh();
+
+    size_t queriedNumber = captureResults.size();
+    for (Segments::iterator it = _segments.begin(); it != _segments.end(); ++it)
+    {
+        Segment& segment = *it->second;
+        if (!segment.sealed)
+        {
+            // new records of the segment being written
+            if (!Map(segment))
+            {
+                continue;
+            }
+            segment.index.Scan(segment.view, segment.viewSize);
+        }
+
+        if (segment.index.beginTime <= endTime && segment.index.endTime >= beginTime && (segment.view || Map(segment)))
+        {
+            ArchiveSegmentIndex::SourceEntries& sources = segment.index.sources;
+            ArchiveSegmentIndex::SourceEntries::iterator source = sourceId.empty() ? sources.begin() : sources.find(sourceId);
+            for (; source != sources.end(); ++source)
+            {
+                const ArchiveSegmentIndex::Entries& entries = source->second;
+                ArchiveSegmentIndex::Entry first;
+                first.timestamp = beginTime;
+                for (ArchiveSegmentIndex::Entries::const_iterator entry = std::lower_bound(entries.begin(), entries.end(), first);
+                    entry != entries.end() && entry->timestamp <= endTime; ++entry)
+                {
+                    CaptureResultPtr captureResultPtr;
+                    if (entry->offset + entry->size <= segment.viewSize && Decode(segment.view + entry->offset, entry->size, captureResultPtr))
+                    {
+                        captureResults.push_back(captureResultPtr);
+                    }
+                }
+
+                if (!sourceId.empty())
+                {
+                    break;
+                }
+            }
+        }
+
+        // the writer can not shrink a mapped segment
+        if (!segment.sealed)
+        {
+            Unmap(segment);
+        }
+    }
+
+    std::stable_sort(captureResults.begin() + queriedNumber, captureResults.end(),
+        [](const CaptureResultPtr& f, const CaptureResultPtr& s){ return f->timestamp < s->timestamp; });
+    return captureResults.size() > queriedNumber;
+}
+
+void CaptureArchiveReader::Refresh()
+{
+    std::vector<unsigned int> sequences;
+    CaptureArchive::ListSegments(_path, sequences);
+
+    Segments segments;
+    for (size_t idx = 0; idx < sequences.size(); ++idx)
+    {
+        SegmentPtr segmentPtr;
+        Segments::iterator it = _segments.find(sequences[idx]);
+        if (it != _segments.end())
+        {
+            segmentPtr = it->second;
+            _segments.erase(it);
+        }
+        else
+        {
+            segmentPtr = std::make_shared<Segment>();
+            segmentPtr->file = CaptureArchive::SegmentFile(_path, sequences[idx]);
+        }
+
+        if (!segmentPtr->sealed && FileSystem::Exist(CaptureArchive::IndexFile(segmentPtr->file)))
+        {
+            // sealed since last refresh, saved index takes the place of the scanned one
+            ArchiveSegmentIndex index;
+            if (index.Load(CaptureArchive::IndexFile(segmentPtr->file)))
+            {
+                Unmap(*segmentPtr);
+                segmentPtr->index = index;
+                segmentPtr->sealed = true;
+            }
+        }
+        segments[sequences[idx]] = segmentPtr;
+    }
+
+    // removed segments
+    for (Segments::iterator it = _segments.begin(); it != _segments.end(); ++it)
+    {
+        Unmap(*it->second);
+    }
+    _segments.swap(segments);
+}
+
+bool CaptureArchiveReader::Map(Segment& segment)
+{
+    if (segment.view)
+    {
+        return true;
+    }
+
+    segment.handle = CreateFileA(segment.file.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (segment.handle == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (GetFileSizeEx(segment.handle, &fileSize) && fileSize.QuadPart > 0)
+    {
+        segment.mapping = CreateFileMappingA(segment.handle, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (segment.mapping)
+        {
+            segment.view = (const char*)MapViewOfFile(segment.mapping, FILE_MAP_READ, 0, 0, 0);
+            segment.viewSize = (unsigned long long)fileSize.QuadPart;
+        }
+    }
+
+    if (!segment.view)
+    {
+        Unmap(segment);
+        return false;
+    }
+    return true;
+}
+
+void CaptureArchiveReader::Unmap(Segment& segment)
+{
+    if (segment.view)
+    {
+        UnmapViewOfFile(segment.view);
+        segment.view = nullptr;
+    }
+    segment.viewSize = 0;
+
+    if (segment.mapping)
+    {
+        CloseHandle(segment.mapping);
+        segment.mapping = NULL;
+    }
+    if (segment.handle != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(segment.handle);
+        segment.handle = INVALID_HANDLE_VALUE;
+    }
+}
+
+bool CaptureArchiveReader::Decode(const char* record, unsigned int size, CaptureResultPtr& captureResultPtr)
+{
+    ArchiveRecordView view;
+    if (!view.Parse(record, size))
+    {
+        return false;
+    }
+    const ArchiveRecordHeader& header = *view.header;
+
+    captureResultPtr = std::make_shared<CaptureResult>();
+    CaptureResult& captureResult = *captureResultPtr;
+    captureResult.timestamp = header.timestamp;
+    captureResult.position = header.position;
+    captureResult.frameId = header.frameId;
+
+    FaceBox& faceBox = captureResult.faceBox;
+    faceBox.id = header.id;
+    faceBox.x = header.x;
+    faceBox.y = header.y;
+    faceBox.width = header.width;
+    faceBox.height = header.height;
+    faceBox.confidence = header.confidence;
+    faceBox.keypointsConfidence = header.keypointsConfidence;
+    faceBox.badness = header.badness;
+    faceBox.clarity = header.clarity;
+    faceBox.brightness = header.brightness;
+    faceBox.age = header.age;
+    faceBox.age_group = header.age_group;
+    faceBox.gender = header.gender;
+    faceBox.ethnic = header.ethnic;
+    faceBox.glasses = header.glasses;
+    faceBox.mask = header.mask;
+
+    captureResult.sourceId.assign(view.sourceId, header.sourceIdSize);
+    ReadFloats(view.keypoints, header.keypointsNumber, faceBox.keypoints);
+    ReadFloats(view.visibles, header.visiblesNumber, faceBox.visibles);
+    ReadFloats(view.angles, header.anglesNumber, faceBox.angles);
+    faceBox.feature.assign(view.feature, view.feature + header.featureSize);
+
+    DecodeJpeg(view.face, header.faceSize, captureResult.face);
+    DecodeJpeg(view.aligned, header.alignedSize, captureResult.aligned);
+    DecodeJpeg(view.scence, header.scenceSize, captureResult.scence);
+    return true;
+}
@@ -0,0 +1,276 @@
+
+#ifndef _CAPTUREARCHIVE_HEADER_H_
+#define _CAPTUREARCHIVE_HEADER_H_
+
+#include "FaceSdkApi.h"
+#include "FaceDetectCore.h"
+#include "BaseException.h"
+
+#include <map>
+#include <deque>
+#include <climits>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+#include <windows.h>
+
+/**
+* @brief on disk layout of capture archive \n
+* <seq>.seg : segment header, then records appended one by one, every record is 8 bytes aligned;
+*             record magic is written at last, so a zero magic ends the valid part of an unsealed segment
+* <seq>.idx : written when the segment is sealed, index header, source id table,
+*             then entries sorted by (source, timestamp)
+*/
+#define ARCHIVE_SEGMENT_MAGIC 0x52414346 // FCAR
+#define ARCHIVE_RECORD_MAGIC  0x44524346 // FCRD
+#define ARCHIVE_INDEX_MAGIC   0x58494346 // FCIX
+#define ARCHIVE_VERSION       1
+
+struct ArchiveSegmentHeader
+{
+    unsigned int magic;
+    unsigned int version;
+    long long createTime;
+};
+
+struct ArchiveRecordHeader
+{
+    unsigned int magic;
+    unsigned int size;            // whole record size, header and padding included
+
+    long long timestamp;
+    long long position;
+    unsigned long long frameId;
+
+    int id, x, y, width, height;
+    float confidence, keypointsConfidence, badness, clarity, brightness;
+    int age, age_group, gender, ethnic, glasses, mask;
+
+    // sections follow the header in this order
+    unsigned int sourceIdSize;    // bytes
+    unsigned int keypointsNumber; // floats
+    unsigned int visiblesNumber;  // floats
+    unsigned int anglesNumber;    // floats
+    unsigned int featureSize;     // bytes
+    unsigned int faceSize;        // jpeg bytes
+    unsigned int alignedSize;     // jpeg bytes
+    unsigned int scenceSize;      // jpeg bytes
+};
+
+/**
+* @brief sections of one record, pointers into the record buffer \n
+* floats are not aligned, they should be copied out
+*/
+struct ArchiveRecordView
+{
+    const ArchiveRecordHeader* header = nullptr;
+    const char* sourceId = nullptr;
+    const char* keypoints = nullptr;
+    const char* visibles = nullptr;
+    const char* angles = nullptr;
+    const char* feature = nullptr;
+    const char* face = nullptr;
+    const char* aligned = nullptr;
+    const char* scence = nullptr;
+
+    /**
+    * @brief check the record and locate its sections \n
+    * @return false if the record is broken
+    */
+    bool Parse(const char* record, unsigned long long size);
+};
+
+struct ArchiveIndexHeader
+{
+    unsigned int magic;
+    unsigned int version;
+    unsigned int sourceNumber;    // source table: size(unsigned int) and bytes of every source id
+    unsigned int entryNumber;
+    unsigned long long usedSize;  // valid bytes of the segment
+};
+
+struct ArchiveIndexEntry
+{
+    long long timestamp;
+    unsigned long long offset;
+    unsigned int size;
+    unsigned int sourceIndex;
+};
+
+/**
+* @brief in memory index of one segment \n
+*
+*/
+struct ArchiveSegmentIndex
+{
+    struct Entry
+    {
+        long long timestamp;
+        unsigned long long offset;
+        unsigned int size;
+
+        bool operator<(const Entry& rhs) const
+        {
+            return timestamp < rhs.timestamp;
+        }
+    };
+    typedef std::vector<Entry> Entries;
+    typedef std::map<SourceId, Entries> SourceEntries;
+
+    SourceEntries sources;
+    long long beginTime = LLONG_MAX;
+    long long endTime = LLONG_MIN;
+    unsigned long long usedSize = 0;
+
+    void Add(const SourceId& sourceId, long long timestamp, unsigned long long offset, unsigned int size);
+    void Sort();
+
+    /**
+    * @brief scan records from usedSize, stops at the first invalid record \n
+    * @return number of records added
+    */
+    size_t Scan(const char* view, unsigned long long viewSize);
+
+    bool Load(const std::string& file);
+    bool Save(const std::string& file) const;
+};
+
+class CaptureArchive;
+typedef std::shared_ptr<CaptureArchive> CaptureArchivePtr;
+
+/**
+* @brief append only capture archive writer \n
+* captures are queued and written by a background thread into a memory mapped segment,
+* the segment is sealed and its index is saved when it is full, then a new one is started;
+* detectors and extractors configured with the same path share one writer
+*/
+class CaptureArchive
+{
+public:
+    struct Statistic
+    {
+        long long appendedNumber = 0; // captures written
+        long long droppedNumber = 0;  // captures dropped because of buffer overflow or write failure
+        long long appendedBytes = 0;
+        long long sealedSegments = 0;
+    };
+
+public:
+    /**
+    * @brief get the shared writer of archiveParam.path, create and start it if it does not exist \n
+    */
+    static CaptureArchivePtr Open(const ArchiveParam& archiveParam) throw(BaseException);
+
+    ~CaptureArchive();
+
+    void Append(const CaptureResults& captureResults);
+
+    void GetStatistics(Statistic& statistic);
+
+    static std::string SegmentFile(const std::string& path, unsigned int sequence);
+    static std::string IndexFile(const std::string& segmentFile);
+    static void ListSegments(const std::string& path, std::vector<unsigned int>& sequences);
+
+    /**
+    * @brief serialize one capture into a record, images are encoded as jpeg \n
+    */
+    static bool Encode(const CaptureResult& captureResult, int jpegQuality, bool withScence, std::vector<char>& record);
+
+private:
+    explicit CaptureArchive(const ArchiveParam& archiveParam);
+
+    void Start() throw(BaseException);
+    void Stop();
+
+    void Write();
+    bool WriteOne(const CaptureResultPtr& captureResultPtr, std::vector<char>& record);
+
+    bool OpenSegment(unsigned long long minSize);
+    void SealSegment();
+    void RecoverSegment(unsigned int sequence);
+    void RemoveSegments();
+
+    void Report();
+
+private:
+    static std::mutex _archivesLocker;
+    static std::map<std::string, std::weak_ptr<CaptureArchive>> _archives;
+
+    ArchiveParam _archiveParam;
+    unsigned long long _segmentSize;
+
+    std::thread _writer;
+    volatile bool _writing;
+
+    std::mutex _pendingLocker;
+    std::condition_variable _pendingCondition;
+    std::deque<CaptureResultPtr> _pending;
+
+    unsigned int _sequence;
+    HANDLE _segmentFile;
+    HANDLE _segmentMapping;
+    char* _segmentView;
+    unsigned long long _segmentCapacity;
+    ArchiveSegmentIndex _segmentIndex;
+
+    std::mutex _statisticLocker;
+    Statistic _statistic;
+    long long _lastReportTime;
+
+private:
+    CaptureArchive(const CaptureArchive&);
+    CaptureArchive& operator=(const CaptureArchive&);
+};
+
+/**
+* @brief capture archive reader \n
+* segments are memory mapped read only, sealed ones use their saved index,
+* the unsealed one is scanned incrementally on every query
+*/
+class CaptureArchiveReader
+{
+public:
+    explicit CaptureArchiveReader(const std::string& path);
+    ~CaptureArchiveReader();
+
+    /**
+    * @brief get captures of sourceId in [beginTime, endTime], ordered by timestamp \n
+    * @param sourceId empty means all sources
+    */
+    bool Query(const SourceId& sourceId, long long beginTime, long long endTime, CaptureResults& captureResults);
+
+    static bool Decode(const char* record, unsigned int size, CaptureResultPtr& captureResultPtr);
+
+private:
+    struct Segment
+    {
+        std::string file;
+        bool sealed = false;
+        HANDLE handle = INVALID_HANDLE_VALUE;
+        HANDLE mapping = NULL;
+        const char* view = nullptr;
+        unsigned long long viewSize = 0;
+        ArchiveSegmentIndex index;
+    };
+    typedef std::shared_ptr<Segment> SegmentPtr;
+    typedef std::map<unsigned int, SegmentPtr> Segments;
+
+    void Refresh();
+
+    static bool Map(Segment& segment);
+    static void Unmap(Segment& segment);
+
+private:
+    std::string _path;
+
+    std::mutex _locker;
+    Segments _segments;
+
+private:
+    CaptureArchiveReader(const CaptureArchiveReader&);
+    CaptureArchiveReader& operator=(const CaptureArchiveReader&);
+};
+
+#endif
+
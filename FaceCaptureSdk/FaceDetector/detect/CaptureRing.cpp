@@ -0,0 +1,305 @@
+#include "CaptureRing.h"
+#include "TimeStamp.h"
+
+#include <cstring>
+#include <algorithm>
+
+#define GLOG_NO_ABBREVIATED_SEVERITIES
+#define GOOGLE_GLOG_DLL_DECL
+#include "glog/logging.h"
+
+static unsigned int ImageSize(const cv::Mat& image)
+{
+    return image.empty() ? 0 : (unsigned int)(image.total() * image.elemSize());
+}
+
+static char* WriteBytes(char* target, const void* data, size_t size)
+{
+    if (size > 0)
+    {
+        memcpy(target, data, size);
+    }
+    return target + size;
+}
+
+/**
+* @brief copy pixels row by row, face images are rois of the frame and not continuous \n
+*
+*/
+static char* WriteImage(char* target, const cv::Mat& image, RingImage& ringImage)
+{
+    ringImage.width = image.cols;
+    ringImage.height = image.rows;
+    ringImage.type = image.type();
+    ringImage.size = ImageSize(image);
+    if (ringImage.size == 0)
+    {
+        return target;
+    }
+
+    if (image.isContinuous())
+    {
+        return WriteBytes(target, image.data, ringImage.size);
+    }
+
+    size_t rowSize = image.cols * image.elemSize();
+    for (int row = 0; row < image.rows; ++row)
+    {
+        target = WriteBytes(target, image.ptr(row), rowSize);
+    }
+    return target;
+}
+
+static void ReadImage(const char* data, const RingImage& ringImage, cv::Mat& image)
+{
+    if (ringImage.size > 0 && ringImage.width > 0 && ringImage.height > 0)
+    {
+        cv::Mat view(ringImage.height, ringImage.width, ringImage.type, (void*)data);
+        if (ImageSize(view) == ringImage.size)
+        {
+            image = view.clone();
+        }
+    }
+}
+
+static void ReadFloats(const char* data, unsigned int number, std::vector<float>& values)
+{
+    values.resize(number);
+    if (number > 0)
+    {
+        memcpy(&values[0], data, number * sizeof(float));
+    }
+}
+
+std::mutex CaptureRing::_ringsLocker;
+std::map<std::string, std::weak_ptr<CaptureRing>> CaptureRing::_rings;
+
+CaptureRingPtr CaptureRing::Open(const RingParam& ringParam) throw(BaseException)
+{
+    AUTOLOCK(_ringsLocker);
+    CaptureRingPtr captureRingPtr = _rings[ringParam.name].lock();
+    if (!captureRingPtr)
+    {
+        captureRingPtr.reset(new CaptureRing(ringParam));
+        unsigned int slotSize = (unsigned int)(std::max)(captureRingPtr->_ringParam.slotSize, 1) << 10;
+        if (!captureRingPtr->_ringBuffer.Create(ringParam.name, (unsigned int)(std::max)(ringParam.slotNumber, 1), slotSize))
+        {
+            throw BaseException(0, "capture ring can not be created: " + ringParam.name + ", error: " + std::to_string(GetLastError()));
+        }
+        _rings[ringParam.name] = captureRingPtr;
+
+        LOG(INFO) << "capture ring created: " << ringParam.name << ", slots: " << ringParam.slotNumber << " * " << (slotSize >> 10) << " KB";
+    }
+    return captureRingPtr;
+}
+
+CaptureRing::CaptureRing(const RingParam& ringParam)
+    : _ringParam(ringParam), _publishLocker(), _ringBuffer()
+    , _statistic(), _lastReportTime(TimeStamp<MILLISECONDS>::Now())
+{
+}
+
+CaptureRing::~CaptureRing()
+{
+}
+
+void CaptureRing::Append(const CaptureResults& captureResults)
+{
+    if (captureResults.empty())
+    {
+        return;
+    }
+
+    AUTOLOCK(_publishLocker);
+    for (size_t idx = 0; idx < captureResults.size(); ++idx)
+    {
+        const CaptureResult& captureResult = *captureResults[idx];
+        if (Publish(captureResult, _ringParam.ringScence))
+        {
+            continue;
+        }
+
+        // scence is the largest part, it is left out before the capture is dropped
+        if (_ringParam.ringScence && !captureResult.scence.empty() && Publish(captureResult, false))
+        {
+            _statistic.scenceLeftNumber++;
+        }
+        else
+        {
+            _statistic.droppedNumber++;
+        }
+    }
+    Report();
+}
+
+bool CaptureRing::Publish(const CaptureResult& captureResult, bool withScence)
+{
+    const FaceBox& faceBox = captureResult.faceBox;
+    const cv::Mat& scence = withScence ? captureResult.scence : cv::Mat();
+
+    unsigned long long size = sizeof(RingRecordHeader) + captureResult.sourceId.size()
+        + (faceBox.keypoints.size() + faceBox.visibles.size() + faceBox.angles.size()) * sizeof(float)
+        + faceBox.feature.size() + ImageSize(captureResult.face) + ImageSize(captureResult.aligned) + ImageSize(scence);
+    char* record = size <= _ringBuffer.Capacity() ? _ringBuffer.Begin((unsigned int)size) : nullptr;
+    if (!record)
+    {
+        return false;
+    }
+
+    RingRecordHeader& header = *(RingRecordHeader*)record;
+    memset(&header, 0, sizeof(header));
+    header.magic = RING_RECORD_MAGIC;
+    header.size = (unsigned int)size;
+    header.timestamp = captureResult.timestamp;
+    header.position = captureResult.position;
+    header.frameId = captureResult.frameId;
+    header.publishTime = TimeStamp<MICROSECONDS>::Now();
+    header.id = faceBox.id;
+    header.x = faceBox.x;
+    header.y = faceBox.y;
+    header.width = faceBox.width;
+    header.height = faceBox.height;
+    header.confidence = faceBox.confidence;
+    header.keypointsConfidence = faceBox.keypointsConfidence;
+    header.badness = faceBox.badness;
+    header.clarity = faceBox.clarity;
+    header.brightness = faceBox.brightness;
+    header.age = faceBox.age;
+    header.age_group = faceBox.age_group;
+    header.gender = faceBox.gender;
+    header.ethnic = faceBox.ethnic;
+    header.glasses = faceBox.glasses;
+    header.mask = faceBox.mask;
+    header.sourceIdSize = (unsigned int)captureResult.sourceId.size();
+    header.keypointsNumber = (unsigned int)faceBox.keypoints.size();
+    header.visiblesNumber = (unsigned int)faceBox.visibles.size();
+    header.anglesNumber = (unsigned int)faceBox.angles.size();
+    header.featureSize = (unsigned int)faceBox.feature.size();
+
+    char* target = record + sizeof(RingRecordHeader);
+    target = WriteBytes(target, captureResult.sourceId.data(), captureResult.sourceId.size());
+    target = WriteBytes(target, faceBox.keypoints.data(), faceBox.keypoints.size() * sizeof(float));
+    target = WriteBytes(target, faceBox.visibles.data(), faceBox.visibles.size() * sizeof(float));
+    target = WriteBytes(target, faceBox.angles.data(), faceBox.angles.size() * sizeof(float));
+    target = WriteBytes(target, faceBox.feature.data(), faceBox.feature.size());
+    target = WriteImage(target, captureResult.face, header.face);
+    target = WriteImage(target, captureResult.aligned, header.aligned);
+    target = WriteImage(target, scence, header.scence);
+
+    _ringBuffer.Commit((unsigned int)size);
+
+    _statistic.publishedNumber++;
+    _statistic.publishedBytes += size;
+    return true;
+}
+
+void CaptureRing::GetStatistics(Statistic& statistic)
+{
+    AUTOLOCK(_publishLocker);
+    statistic = _statistic;
+}
+
+bool CaptureRing::Decode(const char* record, unsigned int size, CaptureResultPtr& captureResultPtr)
+{
+    RingRecordView view;
+    if (!view.Parse(record, size))
+    {
+        return false;
+    }
+    const RingRecordHeader& header = *view.header;
+
+    captureResultPtr = std::make_shared<CaptureResult>();
+    CaptureResult& captureResult = *captureResultPtr;
+    captureResult.timestamp = header.timestamp;
+    captureResult.position = header.position;
+    captureResult.frameId = header.frameId;
+
+    FaceBox& faceBox = captureResult.faceBox;
+    faceBox.id = header.id;
+    faceBox.x = header.x;
+    faceBox.y = header.y;
+    faceBox.width = header.width;
+    faceBox.height = header.height;
+    faceBox.confidence = header.confidence;
+    faceBox.keypointsConfidence = header.keypointsConfidence;
+    faceBox.badness = header.badness;
+    faceBox.clarity = header.clarity;
+    faceBox.brightness = header.brightness;
+    faceBox.age = header.age;
+    faceBox.age_group = header.age_group;
+    faceBox.gender = header.gender;
+    faceBox.ethnic = header.ethnic;
+    faceBox.glasses = header.glasses;
+    faceBox.mask = header.mask;
+
+    captureResult.sourceId.assign(view.sourceId, header.sourceIdSize);
+    ReadFloats(view.keypoints, header.keypointsNumber, faceBox.keypoints);
+    ReadFloats(view.visibles, header.visiblesNumber, faceBox.visibles);
+    ReadFloats(view.angles, header.anglesNumber, faceBox.angles);
+    faceBox.feature.assign(view.feature, view.feature + header.featureSize);
+
+    ReadImage(view.face, header.face, captureResult.face);
+    ReadImage(view.aligned, header.aligned, captureResult.aligned);
+    ReadImage(view.scence, header.scence, captureResult.scence);
+    return true;
+}
+
+void CaptureRing::Report()
+{
+    long long now = TimeStamp<MILLISECONDS>::Now();
+    if (now - _lastReportTime < 60000)
+    {
+        return;
+    }
+    _lastReportTime = now;
+
+    LOG(INFO) << "capture ring(" << _ringParam.name << ") published: " << _statistic.publishedNumber
+        << " (" << (_statistic.publishedBytes >> 20) << " MB), without scence: " << _statistic.scenceLeftNumber
+        << ", dropped: " << _statistic.droppedNumber << " (slot size: " << (_ringBuffer.Capacity() >> 10) << " KB)";
+}
+
+CaptureRingReader::CaptureRingReader()
+    : _locker(), _ringBuffer(), _record(), _lostNumber(0)
+{
+}
+
+CaptureRingReader::~CaptureRingReader()
+{
+}
+
+bool CaptureRingReader::Open(const std::string& name)
+{
+    AUTOLOCK(_locker);
+    return _ringBuffer.Open(name);
+}
+
+bool CaptureRingReader::Poll(CaptureResults& captureResults, int maxNumber)
+{
+    AUTOLOCK(_locker);
+    unsigned int lostNumber = 0;
+    while (maxNumber <= 0 || (int)captureResults.size() < maxNumber)
+    {
+        if (!_ringBuffer.Read(_record, lostNumber))
+        {
+            break;
+        }
+
+        CaptureResultPtr captureResultPtr;
+        if (_record.empty() || !CaptureRing::Decode(&_record[0], (unsigned int)_record.size(), captureResultPtr))
+        {
+            lostNumber++;
+            continue;
+        }
+        captureResults.push_back(captureResultPtr);
+    }
+    _lostNumber += lostNumber;
+    return !captureResults.empty();
+}
+
+void CaptureRingReader::GetStatus(long long& lostNumber, unsigned int& lag)
+{
+    AUTOLOCK(_locker);
+    lostNumber = _lostNumber;
+    lag = _ringBuffer.Lag();
+}
+
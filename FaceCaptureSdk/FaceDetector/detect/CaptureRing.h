@@ -0,0 +1,108 @@
+
+#ifndef _CAPTURERING_HEADER_H_
+#define _CAPTURERING_HEADER_H_
+
+#include "FaceSdkApi.h"
+#include "FaceDetectCore.h"
+#include "BaseException.h"
+#include "CaptureRingBuffer.h"
+
+#include <map>
+#include <mutex>
+
+class CaptureRing;
+typedef std::shared_ptr<CaptureRing> CaptureRingPtr;
+
+/**
+* @brief publisher of the shared memory capture ring \n
+* captures are serialized in place into the ring by the pushing thread, images as raw pixels,
+* so no encoding or extra copy is paid; detectors and extractors configured with the same name share one ring
+*/
+class CaptureRing
+{
+public:
+    struct Statistic
+    {
+        long long publishedNumber = 0;  // captures published
+        long long publishedBytes = 0;
+        long long scenceLeftNumber = 0; // captures published without scence because they do not fit a slot
+        long long droppedNumber = 0;    // captures dropped because they do not fit a slot
+    };
+
+public:
+    /**
+    * @brief get the shared ring of ringParam.name, create it if it does not exist \n
+    */
+    static CaptureRingPtr Open(const RingParam& ringParam) throw(BaseException);
+
+    ~CaptureRing();
+
+    void Append(const CaptureResults& captureResults);
+
+    void GetStatistics(Statistic& statistic);
+
+    /**
+    * @brief copy one record out into a capture \n
+    */
+    static bool Decode(const char* record, unsigned int size, CaptureResultPtr& captureResultPtr);
+
+private:
+    explicit CaptureRing(const RingParam& ringParam);
+
+    bool Publish(const CaptureResult& captureResult, bool withScence);
+
+    void Report();
+
+private:
+    static std::mutex _ringsLocker;
+    static std::map<std::string, std::weak_ptr<CaptureRing>> _rings;
+
+    RingParam _ringParam;
+
+    // the ring has one producer, pushing threads are serialized
+    std::mutex _publishLocker;
+    CaptureRingBuffer _ringBuffer;
+
+    Statistic _statistic;
+    long long _lastReportTime;
+
+private:
+    CaptureRing(const CaptureRing&);
+    CaptureRing& operator=(const CaptureRing&);
+};
+
+/**
+* @brief consumer of the shared memory capture ring \n
+* reading starts from the latest capture, captures overwritten before they are read are counted as lost
+*/
+class CaptureRingReader
+{
+public:
+    CaptureRingReader();
+    ~CaptureRingReader();
+
+    bool Open(const std::string& name);
+
+    /**
+    * @brief get captures published since last poll, at most maxNumber (0 means all) \n
+    */
+    bool Poll(CaptureResults& captureResults, int maxNumber);
+
+    /**
+    * @brief captures lost since opened and captures published but not read yet \n
+    */
+    void GetStatus(long long& lostNumber, unsigned int& lag);
+
+private:
+    std::mutex _locker;
+    CaptureRingBuffer _ringBuffer;
+    std::vector<char> _record;
+    long long _lostNumber;
+
+private:
+    CaptureRingReader(const CaptureRingReader&);
+    CaptureRingReader& operator=(const CaptureRingReader&);
+};
+
+#endif
+
@@ -0,0 +1,252 @@
+#include "CaptureRingBuffer.h"
+
+#include <cstring>
+#include <ctime>
+
+bool RingRecordView::Parse(const char* record, unsigned int size)
+{
+    header = (const RingRecordHeader*)record;
+    if (size < sizeof(RingRecordHeader) || header->magic != RING_RECORD_MAGIC || header->size != size)
+    {
+        return false;
+    }
+
+    unsigned long long totalSize = sizeof(RingRecordHeader) + (unsigned long long)header->sourceIdSize
+        + ((unsigned long long)header->keypointsNumber + header->visiblesNumber + header->anglesNumber) * sizeof(float)
+        + header->featureSize + header->face.size + header->aligned.size + header->scence.size;
+    if (totalSize > size)
+    {
+        return false;
+    }
+
+    sourceId = record + sizeof(RingRecordHeader);
+    keypoints = sourceId + header->sourceIdSize;
+    visibles = keypoints + header->keypointsNumber * sizeof(float);
+    angles = visibles + header->visiblesNumber * sizeof(float);
+    feature = angles + header->anglesNumber * sizeof(float);
+    face = feature + header->featureSize;
+    aligned = face + header->face.size;
+    scence = aligned + header->aligned.size;
+    return true;
+}
+
+CaptureRingBuffer::CaptureRingBuffer()
+    : _mapping(NULL), _view(nullptr), _header(nullptr), _cursor(0)
+{
+}
+
+CaptureRingBuffer::~CaptureRingBuffer()
+{
+    Close();
+}
+
+bool CaptureRingBuffer::Create(const std::string& name, unsigned int slotNumber, unsigned int slotSize)
+{
+    Close();
+
+    unsigned int number = 1;
+    while (number < slotNumber && number < 0x40000000)
+    {
+        number <<= 1;
+    }
+    unsigned int size = (slotSize + sizeof(RingSlotHeader) + RING_ALIGNMENT - 1) & ~(RING_ALIGNMENT - 1);
+    unsigned long long capacity = sizeof(RingHeader) + (unsigned long long)number * size;
+
+    HANDLE mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, (DWORD)(capacity >> 32), (DWORD)(capacity & 0xFFFFFFFF), name.c_str());
+    if (!mapping)
+    {
+        return false;
+    }
+    bool existed = GetLastError() == ERROR_ALREADY_EXISTS;
+
+    if (!Map(mapping, true))
+    {
+        return false;
+    }
+
+    if (existed && _header->magic == RING_MAGIC)
+    {
+        // readers keep the ring of last run alive, publishing continues from its sequence
+        if (_header->version != RING_VERSION || _header->slotNumber != number || _header->slotSize != size)
+        {
+            Close();
+            return false;
+        }
+        return true;
+    }
+
+    // magic is set at last, readers do not open a ring being initialized
+    _header->version = RING_VERSION;
+    _header->slotNumber = number;
+    _header->slotSize = size;
+    _header->createTime = (long long)time(nullptr);
+    _header->published = 0;
+    MemoryBarrier();
+    _header->magic = RING_MAGIC;
+    return true;
+}
+
+bool CaptureRingBuffer::Open(const std::string& name)
+{
+    Close();
+
+    HANDLE mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, name.c_str());
+    if (!mapping)
+    {
+        return false;
+    }
+
+    if (!Map(mapping, false))
+    {
+        return false;
+    }
+
+    if (_header->magic != RING_MAGIC || _header->version != RING_VERSION
+        || _header->slotNumber == 0 || (_header->slotNumber & (_header->slotNumber - 1)) != 0)
+    {
+        Close();
+        return false;
+    }
+
+    _cursor = _header->published;
+    return true;
+}
+
+bool CaptureRingBuffer::Map(HANDLE mapping, bool writable)
+{
+    _mapping = mapping;
+    _view = (char*)MapViewOfFile(_mapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0);
+    if (!_view)
+    {
+        Close();
+        return false;
+    }
+
+    // the whole view is checked against the geometry in the header
+    MEMORY_BASIC_INFORMATION information;
+    if (VirtualQuery(_view, &information, sizeof(information)) == 0 || information.RegionSize < sizeof(RingHeader))
+    {
+        Close();
+        return false;
+    }
+    _header = (RingHeader*)_view;
+
+    if (_header->magic == RING_MAGIC
+        && sizeof(RingHeader) + (unsigned long long)_header->slotNumber * _header->slotSize > information.RegionSize)
+    {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void CaptureRingBuffer::Close()
+{
+    if (_view)
+    {
+        UnmapViewOfFile(_view);
+        _view = nullptr;
+    }
+    if (_mapping)
+    {
+        CloseHandle(_mapping);
+        _mapping = NULL;
+    }
+    _header = nullptr;
+    _cursor = 0;
+}
+
+char* CaptureRingBuffer::Begin(unsigned int size)
+{
+    if (!_header || size > Capacity())
+    {
+        return nullptr;
+    }
+
+    // a slot left odd by a writer crashed in the middle stays odd
+    RingSlotHeader* slot = Slot(_header->published);
+    if ((slot->version & 1) == 0)
+    {
+        InterlockedIncrement((volatile LONG*)&slot->version);
+    }
+    MemoryBarrier();
+    slot->sequence = _header->published;
+    slot->size = 0;
+    return (char*)slot + sizeof(RingSlotHeader);
+}
+
+void CaptureRingBuffer::Commit(unsigned int size)
+{
+    unsigned int sequence = _header->published;
+    RingSlotHeader* slot = Slot(sequence);
+    slot->size = size;
+    MemoryBarrier();
+    InterlockedIncrement((volatile LONG*)&slot->version);
+    InterlockedExchange((volatile LONG*)&_header->published, (LONG)(sequence + 1));
+}
+
+bool CaptureRingBuffer::Read(std::vector<char>& record, unsigned int& lostNumber)
+{
+    if (!_header)
+    {
+        return false;
+    }
+
+    while (true)
+    {
+        unsigned int published = _header->published;
+        MemoryBarrier();
+
+        unsigned int lag = published - _cursor;
+        if (lag == 0)
+        {
+            return false;
+        }
+
+        // the producer is a whole ring ahead, records before the oldest slot are gone
+        if (lag > _header->slotNumber)
+        {
+            lostNumber += lag - _header->slotNumber;
+            _cursor = published - _header->slotNumber;
+        }
+
+        const RingSlotHeader* slot = Slot(_cursor);
+        unsigned int version = slot->version;
+        MemoryBarrier();
+        unsigned int size = slot->size;
+        bool valid = (version & 1) == 0 && slot->sequence == _cursor && size <= Capacity();
+        if (valid)
+        {
+            record.resize(size);
+            if (size > 0)
+            {
+                memcpy(&record[0], (const char*)slot + sizeof(RingSlotHeader), size);
+            }
+            MemoryBarrier();
+            valid = slot->version == version;
+        }
+
+        _cursor++;
+        if (valid)
+        {
+            return true;
+        }
+        lostNumber++;
+    }
+}
+
+unsigned int CaptureRingBuffer::Lag() const
+{
+    return _header ? _header->published - _cursor : 0;
+}
+
+unsigned int CaptureRingBuffer::Capacity() const
+{
+    return _header ? _header->slotSize - sizeof(RingSlotHeader) : 0;
+}
+
+RingSlotHeader* CaptureRingBuffer::Slot(unsigned int sequence) const
+{
+    return (RingSlotHeader*)(_view + sizeof(RingHeader) + (unsigned long long)(sequence & (_header->slotNumber - 1)) * _header->slotSize);
+}
+
@@ -0,0 +1,163 @@
+
+#ifndef _CAPTURERINGBUFFER_HEADER_H_
+#define _CAPTURERINGBUFFER_HEADER_H_
+
+#include <string>
+#include <vector>
+
+#include <windows.h>
+
+/**
+* @brief layout of the shared memory capture ring \n
+* header, then slotNumber slots of slotSize bytes, every slot starts with a slot header;
+* record n is written to slot (n & (slotNumber - 1)), the oldest record is overwritten when the ring is full;
+* the version of a slot is odd while it is written, a reader copies the record out and checks
+* that the version did not change, otherwise the record was overwritten under it
+* this file depends on windows only, so it can be built into processes reading the ring
+*/
+#define RING_MAGIC          0x47524346 // FCRG
+#define RING_RECORD_MAGIC   0x52524346 // FCRR
+#define RING_VERSION        1
+#define RING_ALIGNMENT      64
+
+struct RingHeader
+{
+    unsigned int magic;
+    unsigned int version;
+    unsigned int slotNumber;            // power of 2
+    unsigned int slotSize;              // bytes, slot header included
+    long long createTime;
+    volatile unsigned int published;    // sequence of the next record, wraps around
+    char reserved[RING_ALIGNMENT - 28];
+};
+
+struct RingSlotHeader
+{
+    volatile unsigned int version;      // odd while the slot is written
+    volatile unsigned int sequence;
+    unsigned int size;                  // record bytes
+    unsigned int reserved;
+};
+
+/**
+* @brief raw pixels of one image, rows are packed \n
+* type is opencv mat type, CV_8UC3 (16) for bgr images
+*/
+struct RingImage
+{
+    int width;
+    int height;
+    int type;
+    unsigned int size;
+};
+
+struct RingRecordHeader
+{
+    unsigned int magic;
+    unsigned int size;                  // whole record size, header included
+
+    long long timestamp;
+    long long position;
+    unsigned long long frameId;
+    long long publishTime;              // microseconds, when the record was published
+
+    int id, x, y, width, height;
+    float confidence, keypointsConfidence, badness, clarity, brightness;
+    int age, age_group, gender, ethnic, glasses, mask;
+
+    // sections follow the header in this order
+    unsigned int sourceIdSize;          // bytes
+    unsigned int keypointsNumber;       // floats
+    unsigned int visiblesNumber;        // floats
+    unsigned int anglesNumber;          // floats
+    unsigned int featureSize;           // bytes
+    RingImage face;
+    RingImage aligned;
+    RingImage scence;
+};
+
+/**
+* @brief sections of one record, pointers into the record buffer \n
+* floats are not aligned, they should be copied out
+*/
+struct RingRecordView
+{
+    const RingRecordHeader* header = nullptr;
+    const char* sourceId = nullptr;
+    const char* keypoints = nullptr;
+    const char* visibles = nullptr;
+    const char* angles = nullptr;
+    const char* feature = nullptr;
+    const char* face = nullptr;
+    const char* aligned = nullptr;
+    const char* scence = nullptr;
+
+    /**
+    * @brief check the record and locate its sections \n
+    * @return false if the record is broken
+    */
+    bool Parse(const char* record, unsigned int size);
+};
+
+/**
+* @brief single producer, multiple consumer ring in named shared memory \n
+* the producer never waits for consumers; every consumer keeps its own cursor, starting from
+* the latest record, and counts the records overwritten before it could read them as lost
+*/
+class CaptureRingBuffer
+{
+public:
+    CaptureRingBuffer();
+    ~CaptureRingBuffer();
+
+    /**
+    * @brief create the ring for writing, or attach to an existing one of the same geometry \n
+    * slotNumber is rounded up to a power of 2, slotSize is the max record size (bytes)
+    */
+    bool Create(const std::string& name, unsigned int slotNumber, unsigned int slotSize);
+
+    /**
+    * @brief open the ring read only \n
+    */
+    bool Open(const std::string& name);
+    void Close();
+
+    /**
+    * @brief reserve the next slot, the record is written in place and published by Commit \n
+    * the writer should be serialized by the caller
+    * @return nullptr if size does not fit a slot
+    */
+    char* Begin(unsigned int size);
+    void Commit(unsigned int size);
+
+    /**
+    * @brief copy the next record out \n
+    * @param lostNumber records overwritten before they could be read are added to it
+    * @return false if there is no new record
+    */
+    bool Read(std::vector<char>& record, unsigned int& lostNumber);
+
+    /**
+    * @brief records published but not read yet \n
+    */
+    unsigned int Lag() const;
+
+    unsigned int Capacity() const;
+
+private:
+    bool Map(HANDLE mapping, bool writable);
+    RingSlotHeader* Slot(unsigned int sequence) const;
+
+private:
+    HANDLE _mapping;
+    char* _view;
+    RingHeader* _header;
+    unsigned int _cursor;
+
+private:
+    CaptureRingBuffer(const CaptureRingBuffer&);
+    CaptureRingBuffer& operator=(const CaptureRingBuffer&);
+};
+
+#endif
+
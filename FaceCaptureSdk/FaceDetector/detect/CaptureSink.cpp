@@ -0,0 +1,641 @@
+
+#include "CaptureSink.h"
+#include "FileSystem.h"
+#include "TimeStamp.h"
+#include "ThreadAffinity.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+#define GLOG_NO_ABBREVIATED_SEVERITIES
+#define GOOGLE_GLOG_DLL_DECL
+#include "glog/logging.h"
+
+// retry interval of spilled batches while path is unavailable
+static const int SINK_RETRY_INTERVAL = 1000;
+
+/**
+* @brief source id may be an url, characters not allowed in file names are replaced \n
+*
+*/
+static std::string SafeName(const std::string& name)
+{
+    std::string safeName(name);
+    for (size_t idx = 0; idx < safeName.size(); ++idx)
+    {
+        char ch = safeName[idx];
+        if (!((ch >= '0' && ch <= '9') || (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || ch == '-' || ch == '.'))
+        {
+            safeName[idx] = '_';
+        }
+    }
+    return safeName.empty() ? "_" : safeName;
+}
+
+std::mutex CaptureSink::_sinksLocker;
+std::map<std::string, std::weak_ptr<CaptureSink>> CaptureSink::_sinks;
+
+CaptureSinkPtr CaptureSink::Open(const SinkParam& sinkParam) throw(BaseException)
+{
+    AUTOLOCK(_sinksLocker);
+    CaptureSinkPtr captureSinkPtr = _sinks[sinkParam.path].lock();
+    if (!captureSinkPtr)
+    {
+        captureSinkPtr.reset(new CaptureSink(sinkParam));
+        captureSinkPtr->Start();
+        _sinks[sinkParam.path] = captureSinkPtr;
+    }
+    return captureSinkPtr;
+}
+
+CaptureSink::CaptureSink(const SinkParam& sinkParam)
+    : _sinkParam(sinkParam)
+    , _committer(), _spiller(), _sinking(false)
+    , _pendingLocker(), _pendingCondition(), _pending()
+    , _spillLocker(), _spills(), _spillSequence(0), _spillBytes(0)
+    , _directories(), _journalDate(), _journal(INVALID_HANDLE_VALUE), _failing(false)
+    , _statisticLocker(), _statistic(), _lastReportTime(TimeStamp<MILLISECONDS>::Now())
+{
+    _sinkParam.bufferSize = (std::max)(_sinkParam.bufferSize, 1);
+    _sinkParam.batchSize = (std::max)(_sinkParam.batchSize, 1);
+    _sinkParam.batchTimeout = (std::max)(_sinkParam.batchTimeout, 1);
+}
+
+CaptureSink::~CaptureSink()
+{
+    Stop();
+
+    if (_journal != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(_journal);
+        _journal = INVALID_HANDLE_VALUE;
+    }
+}
+
+void CaptureSink::Start() throw(BaseException)
+{
+    if (!MakeDir(_sinkParam.path))
+    {
+        throw BaseException(0, "capture sink directory can not be created: " + _sinkParam.path);
+    }
+
+    if (SpillEnabled())
+    {
+        if (!FileSystem::Exist(_sinkParam.spillPath) && !FileSystem::MakeDir(_sinkParam.spillPath))
+        {
+            throw BaseException(0, "capture sink spill directory can not be created: " + _sinkParam.spillPath);
+        }
+
+        // batches spilled by last run are written first
+        FileSystem::FNodeVector files;
+        FileSystem::ListFile(_sinkParam.spillPath, files);
+        for (size_t idx = 0; idx < files.size(); ++idx)
+        {
+            const char* name = files[idx].info.name;
+            char* end = nullptr;
+            unsigned long sequence = strtoul(name, &end, 10);
+            if (end != name && strcmp(end, ".spl") == 0 && sequence > 0)
+            {
+                _spills.push_back(std::make_pair((unsigned int)sequence, (unsigned long long)files[idx].info.size));
+                _spillBytes += files[idx].info.size;
+            }
+        }
+        std::sort(_spills.begin(), _spills.end());
+        _spillSequence = _spills.empty() ? 0 : _spills.back().first;
+    }
+
+    _sinking = true;
+    _committer = std::thread(&CaptureSink::Commit, this);
+    if (SpillEnabled())
+    {
+        _spiller = std::thread(&CaptureSink::Spill, this);
+    }
+
+    LOG(INFO) << "capture sink started: " << _sinkParam.path << ", spilled batches: " << _spills.size();
+}
+
+void CaptureSink::Stop()
+{
+    if (_sinking)
+    {
+        _sinking = false;
+        WAKEUP_ALL(_pendingCondition);
+    }
+    WAIT_TO_EXIT(_spiller);
+    WAIT_TO_EXIT(_committer);
+}
+
+void CaptureSink::Append(const CaptureResults& captureResults)
+{
+    if (captureResults.empty())
+    {
+        return;
+    }
+
+    long long droppedNumber = 0;
+    {
+        AUTOLOCK(_pendingLocker);
+        for (size_t idx = 0; idx < captureResults.size(); ++idx)
+        {
+            // shallow copy, images are shared, the caller may change the result after GetCapture
+            _pending.push_back(CaptureResultPtr(new CaptureResult(*captureResults[idx])));
+        }
+
+        while ((int)_pending.size() > _sinkParam.bufferSize)
+        {
+            _pending.pop_front();
+            droppedNumber++;
+        }
+    }
+    WAKEUP_ALL(_pendingCondition);
+
+    AUTOLOCK(_statisticLocker);
+    _statistic.appendedNumber += (long long)captureResults.size();
+    _statistic.droppedOverflow += droppedNumber;
+}
+
+void CaptureSink::GetStatistics(Statistic& statistic)
+{
+    unsigned long long spillBytes = 0;
+    {
+        AUTOLOCK(_spillLocker);
+        spillBytes = _spillBytes;
+    }
+
+    AUTOLOCK(_statisticLocker);
+    _statistic.spilledBytes = (long long)spillBytes;
+    statistic = _statistic;
+}
+
+void CaptureSink::Commit()
+{
+    ThreadAffinity::Bind(THREAD_SERVICE, -1);
+
+    while (true)
+    {
+        // spilled captures are older than queued ones, so they are written first
+        unsigned int spillSequence = 0;
+        if (_sinking)
+        {
+            AUTOLOCK(_spillLocker);
+            if (!_spills.empty())
+            {
+                spillSequence = _spills.front().first;
+            }
+        }
+
+        if (spillSequence > 0)
+        {
+            SinkRecords records;
+            if (!ReadSpill(spillSequence, records))
+            {
+                RemoveSpill(spillSequence);
+            }
+            else if (WriteBatch(records))
+            {
+                RemoveSpill(spillSequence);
+
+                AUTOLOCK(_statisticLocker);
+                _statistic.unspilledNumber += (long long)records.size();
+            }
+            else
+            {
+                WAIT_MILLISEC_TILL_COND(_pendingCondition, _pendingLocker, SINK_RETRY_INTERVAL, [this](){ return !_sinking; });
+            }
+
+            Report();
+            continue;
+        }
+
+        std::deque<CaptureResultPtr> batch;
+        {
+            WAIT_MILLISEC_TILL_COND(_pendingCondition, _pendingLocker, _sinkParam.batchTimeout,
+                [this](){ return !_sinking || (int)_pending.size() >= _sinkParam.batchSize; });
+            TakePending(batch);
+        }
+
+        if (batch.empty())
+        {
+            if (!_sinking)
+            {
+                break;
+            }
+            Report();
+            continue;
+        }
+
+        SinkRecords records;
+        Encode(batch, records);
+        if (!records.empty())
+        {
+            if (!_sinking && SpillEnabled())
+            {
+                // stopping does not wait for a slow path, queued captures are written by next run
+                WriteSpill(records);
+            }
+            else if (!WriteBatch(records))
+            {
+                if (SpillEnabled())
+                {
+                    WriteSpill(records);
+                }
+                else
+                {
+                    Drop((long long)records.size(), false);
+                }
+            }
+        }
+
+        Report();
+    }
+}
+
+void CaptureSink::Spill()
+{
+    ThreadAffinity::Bind(THREAD_SERVICE, -1);
+
+    // the committer falls behind once half of the buffer is queued
+    size_t watermark = (size_t)(std::max)(_sinkParam.bufferSize / 2, 1);
+    unsigned long long spillSize = (unsigned long long)(std::max)(_sinkParam.spillSize, 1) << 20;
+
+    while (_sinking)
+    {
+        bool full = false;
+        {
+            AUTOLOCK(_spillLocker);
+            full = _spillBytes >= spillSize;
+        }
+
+        std::deque<CaptureResultPtr> batch;
+        {
+            WAIT_MILLISEC_TILL_COND(_pendingCondition, _pendingLocker, SINK_RETRY_INTERVAL,
+                [&](){ return !_sinking || (!full && _pending.size() >= watermark); });
+
+            // the committer handles the rest when stopping
+            if (!_sinking || full || _pending.size() < watermark)
+            {
+                continue;
+            }
+            TakePending(batch);
+        }
+
+        SinkRecords records;
+        Encode(batch, records);
+        if (!records.empty())
+        {
+            WriteSpill(records);
+        }
+    }
+}
+
+size_t CaptureSink::TakePending(std::deque<CaptureResultPtr>& batch)
+{
+    size_t number = (std::min)(_pending.size(), (size_t)_sinkParam.batchSize);
+    batch.insert(batch.end(), _pending.begin(), _pending.begin() + number);
+    _pending.erase(_pending.begin(), _pending.begin() + number);
+    return number;
+}
+
+void CaptureSink::Encode(const std::deque<CaptureResultPtr>& batch, SinkRecords& records)
+{
+    long long droppedNumber = 0;
+    records.reserve(batch.size());
+    for (size_t idx = 0; idx < batch.size(); ++idx)
+    {
+        records.push_back(std::vector<char>());
+        if (!CaptureArchive::Encode(*batch[idx], _sinkParam.jpegQuality, _sinkParam.sinkScence, records.back()))
+        {
+            records.pop_back();
+            droppedNumber++;
+        }
+    }
+    Drop(droppedNumber, false);
+}
+
+bool CaptureSink::WriteBatch(const SinkRecords& records)
+{
+    long long beginTime = TimeStamp<MILLISECONDS>::Now();
+
+    SYSTEMTIME now;
+    GetLocalTime(&now);
+    char date[16] = { 0 };
+    sprintf(date, "%04d%02d%02d", now.wYear, now.wMonth, now.wDay);
+    std::string datePath = _sinkParam.path + "/" + date;
+
+    bool success = MakeDir(datePath) && OpenJournal(date);
+
+    // files of the batch are written first and flushed together
+    std::vector<HANDLE> handles;
+    std::string journal;
+    for (size_t idx = 0; idx < records.size() && success; ++idx)
+    {
+        ArchiveRecordView view;
+        if (!view.Parse(&records[idx][0], records[idx].size()))
+        {
+            continue;
+        }
+        const ArchiveRecordHeader& header = *view.header;
+
+        std::string sourceId(view.sourceId, header.sourceIdSize);
+        std::string directory = SafeName(sourceId);
+        char name[96] = { 0 };
+        sprintf(name, "%lld_%llu_%d", header.timestamp, header.frameId, header.id);
+        std::string prefix = datePath + "/" + directory + "/" + name;
+
+        success = MakeDir(datePath + "/" + directory)
+            && WriteData(prefix + "_face.jpg", view.face, header.faceSize, handles)
+            && WriteData(prefix + "_aligned.jpg", view.aligned, header.alignedSize, handles)
+            && WriteData(prefix + "_scence.jpg", view.scence, header.scenceSize, handles)
+            && WriteData(prefix + "_feature.bin", view.feature, header.featureSize, handles);
+
+        char line[256] = { 0 };
+        sprintf(line, "%lld\t%llu\t%d\t%d,%d,%d,%d\t%.4f\t", header.timestamp, header.frameId, header.id,
+            header.x, header.y, header.width, header.height, header.confidence);
+        journal.append(line).append(sourceId).append("\t").append(directory).append("/").append(name).append("\n");
+    }
+
+    if (_sinkParam.syncWrite)
+    {
+        for (size_t idx = 0; idx < handles.size() && success; ++idx)
+        {
+            success = FlushFileBuffers(handles[idx]) != FALSE;
+        }
+    }
+    for (size_t idx = 0; idx < handles.size(); ++idx)
+    {
+        CloseHandle(handles[idx]);
+    }
+
+    // captures are committed once they are logged, a failed batch is written again with the same file names
+    if (success && !journal.empty())
+    {
+        DWORD written = 0;
+        success = ::WriteFile(_journal, journal.data(), (DWORD)journal.size(), &written, NULL) && written == journal.size();
+        if (success && _sinkParam.syncWrite)
+        {
+            success = FlushFileBuffers(_journal) != FALSE;
+        }
+    }
+
+    if (!success)
+    {
+        if (!_failing)
+        {
+            LOG(ERROR) << "capture sink can not write to: " << _sinkParam.path << ", error: " << GetLastError();
+        }
+        _failing = true;
+
+        // directories may be removed and the journal may be broken, open them again
+        _directories.clear();
+        if (_journal != INVALID_HANDLE_VALUE)
+        {
+            CloseHandle(_journal);
+            _journal = INVALID_HANDLE_VALUE;
+        }
+        return false;
+    }
+
+    if (_failing)
+    {
+        LOG(INFO) << "capture sink can write to: " << _sinkParam.path << " again";
+        _failing = false;
+    }
+
+    AUTOLOCK(_statisticLocker);
+    _statistic.committedNumber += (long long)records.size();
+    _statistic.commitNumber++;
+    _statistic.commitMilliseconds += TimeStamp<MILLISECONDS>::Now() - beginTime;
+    return true;
+}
+
+bool CaptureSink::WriteData(const std::string& file, const char* data, size_t size, std::vector<HANDLE>& handles)
+{
+    if (size == 0)
+    {
+        return true;
+    }
+
+    HANDLE handle = CreateFileA(file.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (handle == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+    handles.push_back(handle);
+
+    DWORD written = 0;
+    return ::WriteFile(handle, data, (DWORD)size, &written, NULL) && written == size;
+}
+
+bool CaptureSink::MakeDir(const std::string& path)
+{
+    if (_directories.find(path) != _directories.end())
+    {
+        return true;
+    }
+
+    if (!FileSystem::Exist(path) && !FileSystem::MakeDir(path))
+    {
+        // parent directories are created first
+        size_t slash = path.find_last_of("/\\");
+        if (slash == std::string::npos || slash == 0 || !MakeDir(path.substr(0, slash)) || !FileSystem::MakeDir(path))
+        {
+            return false;
+        }
+    }
+
+    _directories.insert(path);
+    return true;
+}
+
+bool CaptureSink::OpenJournal(const std::string& date)
+{
+    if (_journal != INVALID_HANDLE_VALUE && _journalDate == date)
+    {
+        return true;
+    }
+
+    if (_journal != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(_journal);
+        // directories of last day are not used any more
+        _directories.clear();
+    }
+
+    std::string file = _sinkParam.path + "/" + date + "/captures.log";
+    _journal = CreateFileA(file.c_str(), FILE_APPEND_DATA, FILE_SHARE_READ, NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    _journalDate = date;
+    return _journal != INVALID_HANDLE_VALUE;
+}
+
+bool CaptureSink::SpillEnabled() const
+{
+    return !_sinkParam.spillPath.empty();
+}
+
+void CaptureSink::WriteSpill(const SinkRecords& records)
+{
+    std::vector<char> buffer;
+    for (size_t idx = 0; idx < records.size(); ++idx)
+    {
+        buffer.insert(buffer.end(), records[idx].begin(), records[idx].end());
+    }
+
+    unsigned int sequence = 0;
+    {
+        AUTOLOCK(_spillLocker);
+        if (_spillBytes + buffer.size() <= (unsigned long long)(std::max)(_sinkParam.spillSize, 1) << 20)
+        {
+            sequence = ++_spillSequence;
+            _spillBytes += buffer.size();
+        }
+    }
+    if (sequence == 0)
+    {
+        Drop((long long)records.size(), true);
+        return;
+    }
+
+    std::string file = SpillFile(sequence);
+    HANDLE handle = CreateFileA(file.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    bool success = handle != INVALID_HANDLE_VALUE;
+    if (success)
+    {
+        DWORD written = 0;
+        success = ::WriteFile(handle, &buffer[0], (DWORD)buffer.size(), &written, NULL) && written == buffer.size();
+        if (success && _sinkParam.syncWrite)
+        {
+            success = FlushFileBuffers(handle) != FALSE;
+        }
+        CloseHandle(handle);
+    }
+
+    AUTOLOCK(_spillLocker);
+    if (!success)
+    {
+        LOG(ERROR) << "capture sink spill file can not be written: " << file << ", error: " << GetLastError();
+        DeleteFileA(file.c_str());
+        _spillBytes -= buffer.size();
+        Drop((long long)records.size(), false);
+        return;
+    }
+
+    // spilled by committer and spiller at the same time, keep them in order
+    std::pair<unsigned int, unsigned long long> spill(sequence, buffer.size());
+    _spills.insert(std::upper_bound(_spills.begin(), _spills.end(), spill), spill);
+
+    AUTOLOCK_1(_statisticLocker);
+    _statistic.spilledNumber += (long long)records.size();
+}
+
+bool CaptureSink::ReadSpill(unsigned int sequence, SinkRecords& records)
+{
+    std::string file = SpillFile(sequence);
+    FILE* f = fopen(file.c_str(), "rb");
+    if (!f)
+    {
+        LOG(ERROR) << "capture sink spill file can not be read: " << file;
+        return false;
+    }
+
+    std::vector<char> buffer;
+    if (fseek(f, 0, SEEK_END) == 0)
+    {
+        long size = ftell(f);
+        if (size > 0 && fseek(f, 0, SEEK_SET) == 0)
+        {
+            buffer.resize((size_t)size);
+            if (fread(&buffer[0], buffer.size(), 1, f) != 1)
+            {
+                buffer.clear();
+            }
+        }
+    }
+    fclose(f);
+
+    size_t offset = 0;
+    while (offset + sizeof(ArchiveRecordHeader) <= buffer.size())
+    {
+        const ArchiveRecordHeader* header = (const ArchiveRecordHeader*)&buffer[offset];
+        ArchiveRecordView view;
+        if (header->size > buffer.size() - offset || !view.Parse(&buffer[offset], header->size))
+        {
+            break;
+        }
+        records.push_back(std::vector<char>(buffer.begin() + offset, buffer.begin() + offset + header->size));
+        offset += header->size;
+    }
+
+    if (offset != buffer.size())
+    {
+        LOG(WARNING) << "capture sink spill file is broken: " << file << ", records read: " << records.size();
+    }
+    return true;
+}
+
+void CaptureSink::RemoveSpill(unsigned int sequence)
+{
+    DeleteFileA(SpillFile(sequence).c_str());
+
+    AUTOLOCK(_spillLocker);
+    for (std::deque<std::pair<unsigned int, unsigned long long>>::iterator it = _spills.begin(); it != _spills.end(); ++it)
+    {
+        if (it->first == sequence)
+        {
+            _spillBytes -= it->second;
+            _spills.erase(it);
+            break;
+        }
+    }
+}
+
+std::string CaptureSink::SpillFile(unsigned int sequence) const
+{
+    char name[32] = { 0 };
+    sprintf(name, "%010u.spl", sequence);
+    return _sinkParam.spillPath + "/" + name;
+}
+
+void CaptureSink::Drop(long long droppedNumber, bool overflow)
+{
+    if (droppedNumber > 0)
+    {
+        AUTOLOCK(_statisticLocker);
+        if (overflow)
+        {
+            _statistic.droppedOverflow += droppedNumber;
+        }
+        else
+        {
+            _statistic.droppedFailed += droppedNumber;
+        }
+    }
+}
+
+void CaptureSink::Report()
+{
+    long long now = TimeStamp<MILLISECONDS>::Now();
+    if (now - _lastReportTime < 60000)
+    {
+        return;
+    }
+    _lastReportTime = now;
+
+    size_t pendingNumber = 0;
+    {
+        AUTOLOCK(_pendingLocker);
+        pendingNumber = _pending.size();
+    }
+
+    Statistic statistic;
+    GetStatistics(statistic);
+    LOG(INFO) << "capture sink(" << _sinkParam.path << ") appended: " << statistic.appendedNumber
+        << ", committed: " << statistic.committedNumber << " in " << statistic.commitNumber << " batches"
+        << " (" << (statistic.commitNumber > 0 ? statistic.commitMilliseconds / statistic.commitNumber : 0) << " ms/batch)"
+        << ", pending: " << pendingNumber
+        << ", spilled: " << statistic.spilledNumber << ", unspilled: " << statistic.unspilledNumber
+        << " (" << (statistic.spilledBytes >> 20) << " MB left)"
+        << ", dropped: " << statistic.droppedOverflow << " overflow, " << statistic.droppedFailed << " failed";
+}
+
@@ -0,0 +1,118 @@
+
+#ifndef _CAPTURESINK_HEADER_H_
+#define _CAPTURESINK_HEADER_H_
+
+#include "CaptureArchive.h"
+
+#include <set>
+
+/**
+* @brief on disk layout of capture sink \n
+* <path>/<yyyyMMdd>/<source>/<timestamp>_<frame>_<face>_{face|aligned|scence}.jpg and _feature.bin
+* <path>/<yyyyMMdd>/captures.log : one tab separated line per capture, appended after its files are flushed
+* <spillPath>/<seq>.spl          : archive records of one batch waiting to be written to path
+*/
+typedef std::vector<std::vector<char>> SinkRecords;
+
+class CaptureSink;
+typedef std::shared_ptr<CaptureSink> CaptureSinkPtr;
+
+/**
+* @brief asynchronous capture persistence \n
+* captures are queued in memory and written to path in batches by a background thread,
+* files of one batch are flushed together and then logged, so one disk sync is paid per batch;
+* when path can not keep up, the oldest queued captures are spilled to local spillPath
+* and written back later, captures are dropped only when memory and spill space are both full;
+* detectors and extractors configured with the same path share one sink
+*/
+class CaptureSink
+{
+public:
+    struct Statistic
+    {
+        long long appendedNumber = 0;      // captures queued
+        long long committedNumber = 0;     // captures written to path
+        long long commitNumber = 0;        // batches written to path
+        long long commitMilliseconds = 0;  // time spent on writing batches
+        long long spilledNumber = 0;       // captures spilled
+        long long unspilledNumber = 0;     // spilled captures written to path
+        long long spilledBytes = 0;        // size of spilled captures not written yet
+        long long droppedOverflow = 0;     // captures dropped because memory and spill space are full
+        long long droppedFailed = 0;       // captures dropped because of encode or write failure
+    };
+
+public:
+    /**
+    * @brief get the shared sink of sinkParam.path, create and start it if it does not exist \n
+    */
+    static CaptureSinkPtr Open(const SinkParam& sinkParam) throw(BaseException);
+
+    ~CaptureSink();
+
+    void Append(const CaptureResults& captureResults);
+
+    void GetStatistics(Statistic& statistic);
+
+private:
+    explicit CaptureSink(const SinkParam& sinkParam);
+
+    void Start() throw(BaseException);
+    void Stop();
+
+    void Commit();
+    void Spill();
+
+    size_t TakePending(std::deque<CaptureResultPtr>& batch);
+    void Encode(const std::deque<CaptureResultPtr>& batch, SinkRecords& records);
+
+    bool WriteBatch(const SinkRecords& records);
+    bool WriteData(const std::string& file, const char* data, size_t size, std::vector<HANDLE>& handles);
+    bool MakeDir(const std::string& path);
+    bool OpenJournal(const std::string& date);
+
+    bool SpillEnabled() const;
+    void WriteSpill(const SinkRecords& records);
+    bool ReadSpill(unsigned int sequence, SinkRecords& records);
+    void RemoveSpill(unsigned int sequence);
+    std::string SpillFile(unsigned int sequence) const;
+
+    void Drop(long long droppedNumber, bool overflow);
+    void Report();
+
+private:
+    static std::mutex _sinksLocker;
+    static std::map<std::string, std::weak_ptr<CaptureSink>> _sinks;
+
+    SinkParam _sinkParam;
+
+    std::thread _committer;
+    std::thread _spiller;
+    volatile bool _sinking;
+
+    std::mutex _pendingLocker;
+    std::condition_variable _pendingCondition;
+    std::deque<CaptureResultPtr> _pending;
+
+    // spilled batches, oldest first
+    std::mutex _spillLocker;
+    std::deque<std::pair<unsigned int, unsigned long long>> _spills;
+    unsigned int _spillSequence;
+    unsigned long long _spillBytes;
+
+    // used by committer only
+    std::set<std::string> _directories;
+    std::string _journalDate;
+    HANDLE _journal;
+    bool _failing;
+
+    std::mutex _statisticLocker;
+    Statistic _statistic;
+    long long _lastReportTime;
+
+private:
+    CaptureSink(const CaptureSink&);
+    CaptureSink& operator=(const CaptureSink&);
+};
+
+#endif
+
@@ -0,0 +1,178 @@
+
+#include "DetectIntervalController.h"
+#include "TimeStamp.h"
+
+#include <algorithm>
+
+#define GLOG_NO_ABBREVIATED_SEVERITIES
+#define GOOGLE_GLOG_DLL_DECL
+#include "glog/logging.h"
+
+DetectIntervalController::DetectIntervalController(int reportInterval)
+    : _locker(), _intervalStates()
+    , _detectCostPerImage(0.0), _reportInterval(reportInterval), _lastReportTime(TimeStamp<MILLISECONDS>::Now())
+{
+}
+
+DetectIntervalController::~DetectIntervalController()
+{
+}
+
+void DetectIntervalController::Decide(ApiImagePtr& apiImagePtr)
+{
+    const FaceParam& faceParam = apiImagePtr->faceParam;
+    if (!faceParam.adaptive_detect_interval || apiImagePtr->portrait)
+    {
+        return;
+    }
+
+    AUTOLOCK(_locker);
+    IntervalState& intervalState = _intervalStates[apiImagePtr->sourceId];
+    intervalState.nominalInterval = (std::max)(1, faceParam.detect_interval);
+    if (intervalState.interval <= 0)
+    {
+        intervalState.interval = intervalState.nominalInterval;
+    }
+
+    intervalState.frameNumber++;
+    apiImagePtr->needetect = intervalState.framePosition == 0;
+    if (apiImagePtr->needetect)
+    {
+        intervalState.detectNumber++;
+    }
+
+    if (++intervalState.framePosition >= intervalState.interval)
+    {
+        intervalState.framePosition = 0;
+    }
+
+    UpdateMetrics(apiImagePtr->sourceId, intervalState, apiImagePtr->needetect);
+    Report();
+}
+
+void DetectIntervalController::Feedback(const ApiImagePtr& apiImagePtr, size_t faceNumber)
+{
+    const FaceParam& faceParam = apiImagePtr->faceParam;
+    if (!faceParam.adaptive_detect_interval || apiImagePtr->portrait)
+    {
+        return;
+    }
+
+    AUTOLOCK(_locker);
+    IntervalStates::iterator it = _intervalStates.find(apiImagePtr->sourceId);
+    if (it == _intervalStates.end())
+    {
+        return;
+    }
+
+    IntervalState& intervalState = it->second;
+    int minInterval = (std::max)(1, faceParam.min_detect_interval);
+    int maxInterval = (std::max)(minInterval, faceParam.max_detect_interval);
+
+    if (faceNumber > intervalState.lastFaceNumber)
+    {
+        // new faces appear
+        intervalState.interval = minInterval;
+    }
+    else if (faceNumber > 0)
+    {
+        // faces stay, back to the configured interval
+        if (intervalState.interval < intervalState.nominalInterval)
+        {
+            intervalState.interval++;
+        }
+        else if (intervalState.interval > intervalState.nominalInterval)
+        {
+            intervalState.interval--;
+        }
+    }
+    else
+    {
+        // empty scene
+        intervalState.interval++;
+    }
+
+    intervalState.interval = (std::min)((std::max)(intervalState.interval, minInterval), maxInterval);
+    intervalState.lastFaceNumber = faceNumber;
+}
+
+void DetectIntervalController::RecordDetectCost(long long milliseconds, size_t imageNumber)
+{
+    if (imageNumber == 0)
+    {
+        return;
+    }
+
+    double cost = (double)milliseconds / imageNumber;
+
+    AUTOLOCK(_locker);
+    _detectCostPerImage = _detectCostPerImage <= 0.0 ? cost : _detectCostPerImage * 0.9 + cost * 0.1;
+}
+
+void DetectIntervalController::Remove(const SourceId& sourceId)
+{
+    AUTOLOCK(_locker);
+    IntervalStates::iterator it = _intervalStates.find(sourceId);
+    if (it != _intervalStates.end())
+    {
+        // metrics are never removed, the source is not detected any more
+        if (it->second.intervalMetric)
+        {
+            it->second.intervalMetric->Set(0);
+        }
+        _intervalStates.erase(it);
+    }
+}
+
+void DetectIntervalController::ToStatistic(const SourceId& sourceId, const IntervalState& intervalState, Statistic& statistic)
+{
+    statistic.sourceId = sourceId;
+    statistic.interval = intervalState.interval;
+    statistic.frameNumber = intervalState.frameNumber;
+    statistic.detectNumber = intervalState.detectNumber;
+    statistic.savedNumber = intervalState.frameNumber / intervalState.nominalInterval - intervalState.detectNumber;
+    statistic.savedMilliseconds = statistic.savedNumber * _detectCostPerImage;
+}
+
+void DetectIntervalController::UpdateMetrics(const SourceId& sourceId, IntervalState& intervalState, bool detected)
+{
+    if (!intervalState.intervalMetric)
+    {
+        std::string labels = "source=\"" + sourceId + "\"";
+        intervalState.intervalMetric = MetricsRegistry::Gauge("detect_interval_frames", labels);
+        intervalState.framesMetric = MetricsRegistry::Counter("detect_interval_images_total", labels);
+        intervalState.detectionsMetric = MetricsRegistry::Counter("detect_interval_detections_total", labels);
+        intervalState.savedMetric = MetricsRegistry::Gauge("detect_interval_saved_detections", labels);
+        intervalState.savedMillisecondsMetric = MetricsRegistry::Gauge("detect_interval_saved_ms", labels);
+    }
+
+    long long savedNumber = intervalState.frameNumber / intervalState.nominalInterval - intervalState.detectNumber;
+    intervalState.intervalMetric->Set(intervalState.interval);
+    intervalState.framesMetric->Add();
+    if (detected)
+    {
+        intervalState.detectionsMetric->Add();
+    }
+    intervalState.savedMetric->Set(savedNumber);
+    intervalState.savedMillisecondsMetric->Set((long long)(savedNumber * _detectCostPerImage));
+}
+
+void DetectIntervalController::Report()
+{
+    long long now = TimeStamp<MILLISECONDS>::Now();
+    if (_reportInterval <= 0 || now - _lastReportTime < _reportInterval)
+    {
+        return;
+    }
+    _lastReportTime = now;
+
+    for (IntervalStates::iterator it = _intervalStates.begin(); it != _intervalStates.end(); ++it)
+    {
+        Statistic statistic;
+        ToStatistic(it->first, it->second, statistic);
+        LOG(INFO) << "source(" << statistic.sourceId << ") detect interval: " << statistic.interval
+            << ", frames: " << statistic.frameNumber << ", detected: " << statistic.detectNumber
+            << ", saved detections: " << statistic.savedNumber << ", saved detector time: " << statistic.savedMilliseconds << "ms";
+    }
+}
+
@@ -0,0 +1,87 @@
+
+#ifndef _DETECTINTERVALCONTROLLER_HEADER_H_
+#define _DETECTINTERVALCONTROLLER_HEADER_H_
+
+#include "FaceSdkApi.h"
+#include "Metrics.h"
+
+#include <map>
+#include <mutex>
+
+/**
+* @brief adaptive detect interval of each source \n
+* interval drops to min_detect_interval when new faces appear, goes back to
+* detect_interval while faces stay, and grows to max_detect_interval while no face is detected
+* the effective interval and the detections saved of each source are kept in MetricsRegistry
+*/
+class DetectIntervalController
+{
+public:
+    struct Statistic
+    {
+        SourceId sourceId;
+        int interval = 0;               // effective detect interval (frame)
+        long long frameNumber = 0;      // frames fed to detector or tracker
+        long long detectNumber = 0;     // frames detected
+        long long savedNumber = 0;      // detections saved compared with fixed detect_interval, negative means more detections
+        double savedMilliseconds = 0.0; // detector time saved (ms)
+    };
+
+public:
+    DetectIntervalController(int reportInterval = 60000);
+    ~DetectIntervalController();
+
+    /**
+    * @brief decide if the image should be detected, only for adaptive sources \n
+    */
+    void Decide(ApiImagePtr& apiImagePtr);
+
+    /**
+    * @brief feed back the detected face number of one image \n
+    */
+    void Feedback(const ApiImagePtr& apiImagePtr, size_t faceNumber);
+
+    /**
+    * @brief record the cost of one detection batch \n
+    */
+    void RecordDetectCost(long long milliseconds, size_t imageNumber);
+
+    void Remove(const SourceId& sourceId);
+
+private:
+    struct IntervalState
+    {
+        int interval = 0;
+        int framePosition = 0;
+        int nominalInterval = 1;
+        size_t lastFaceNumber = 0;
+        long long frameNumber = 0;
+        long long detectNumber = 0;
+
+        MetricGauge* intervalMetric = nullptr;
+        MetricCounter* framesMetric = nullptr;
+        MetricCounter* detectionsMetric = nullptr;
+        MetricGauge* savedMetric = nullptr;
+        MetricGauge* savedMillisecondsMetric = nullptr;
+    };
+    typedef std::map<SourceId, IntervalState> IntervalStates;
+
+    void ToStatistic(const SourceId& sourceId, const IntervalState& intervalState, Statistic& statistic);
+    void UpdateMetrics(const SourceId& sourceId, IntervalState& intervalState, bool detected);
+    void Report();
+
+private:
+    std::mutex _locker;
+    IntervalStates _intervalStates;
+
+    double _detectCostPerImage; // ms
+    int _reportInterval;
+    long long _lastReportTime;
+
+private:
+    DetectIntervalController(const DetectIntervalController&);
+    DetectIntervalController& operator=(const DetectIntervalController&);
+};
+
+#endif
+
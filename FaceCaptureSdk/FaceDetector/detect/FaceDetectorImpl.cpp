@@ -8,6 +8,9 @@
 #include "DecodeManager.h"
 
 #include "GpuCtxIndex.h"
+#include "ThreadAffinity.h"
+
+#include <algorithm>
 
 #define GLOG_NO_ABBREVIATED_SEVERITIES
 #define GOOGLE_GLOG_DLL_DECL
@@ -17,6 +20,17 @@
 
 static const float FLOAT_CONFIGURED = 0.0001f;
 
+LoadShedder FaceDetector::_loadShedder;
+
+/**
+* @brief number of a stage buffer, it is written under the buffer locker \n
+*/
+static size_t LockedNumber(std::mutex& locker, const size_t& number)
+{
+    AUTOLOCK(locker);
+    return number;
+}
+
 void ResetFaceStat(FaceStat& faceStat)
 {
     faceStat.trackedFrameNumber = 0;
@@ -24,7 +38,7 @@ void ResetFaceStat(FaceStat& faceStat)
 
 FaceDetector::Worker::Worker(FaceDetector& manager, int gpuIndex, FaceSdkParam& channelParam)
     : _manager(manager), _gpuIndex(gpuIndex), _ctxIndex(0)
-    , _worker(), _working(false)
+    , _worker(), _working(false), _waitMicroseconds(0), _totalMicroseconds(0)
     , _channelParam(channelParam), _channel(nullptr)
 {
     memset(_name, 0, sizeof(_name));
@@ -65,6 +79,18 @@ int FaceDetector::Worker::Stop()
     return 0;
 }
 
+void FaceDetector::Worker::GetTimes(long long& busyMicroseconds, long long& totalMicroseconds)
+{
+    totalMicroseconds = _totalMicroseconds;
+    busyMicroseconds = totalMicroseconds - _waitMicroseconds;
+}
+
+bool FaceDetector::Worker::Fetched(bool fetched, long long fetchBeginTime)
+{
+    _waitMicroseconds += TimeStamp<MICROSECONDS>::Now() - fetchBeginTime;
+    return fetched;
+}
+
 int FaceDetector::Worker::CreateThreadChannel()
 {
     FaceSdkResult res = FaceSdkOk;
@@ -121,6 +147,8 @@ void FaceDetector::Worker::Execute()
 {
     _manager.InitializingCurrentState();
 
+    ThreadAffinity::Bind(THREAD_WORKER, _gpuIndex);
+
     // configure working device and create channel
     int err = CreateThreadChannel();
     if (0 == err)
@@ -133,7 +161,9 @@ void FaceDetector::Worker::Execute()
         // start to work
         while (_working)
         {
+            long long workBeginTime = TimeStamp<MICROSECONDS>::Now();
             Work();
+            _totalMicroseconds += TimeStamp<MICROSECONDS>::Now() - workBeginTime;
         }
 
         LOG(INFO) << _name << "(" << std::this_thread::get_id() << ") stop work";
@@ -168,7 +198,8 @@ void FaceDetector::Detector::Work()
     // we should detect images that have the same resolution at one time
     // that is the limitation of the SDK
     START_EVALUATE(FetchOneDetect);
-    if (_manager.FetchOneDetect(apiImageIPtrBatch))
+    long long fetchBeginTime = TimeStamp<MICROSECONDS>::Now();
+    if (Fetched(_manager.FetchOneDetect(apiImageIPtrBatch), fetchBeginTime))
     {
         PRINT_COSTS(FetchOneDetect);
 
@@ -177,7 +208,10 @@ void FaceDetector::Detector::Work()
         ApiImagePtrBuffer trackApiImageIPtrBuffer, nextApiImageIPtrBuffer;
         size_t trackSize = 0, nextSize = 0;
         START_EVALUATE(DetectFacesByResolutionGroup);
-        if (DetectFacesByResolutionGroup(apiImageIPtrBatch, trackApiImageIPtrBuffer, trackSize, nextApiImageIPtrBuffer, nextSize))
+        long long detectBeginTime = TimeStamp<MICROSECONDS>::Now();
+        bool detected = DetectFacesByResolutionGroup(apiImageIPtrBatch, trackApiImageIPtrBuffer, trackSize, nextApiImageIPtrBuffer, nextSize);
+        _manager.RecordDetectBatch(TimeStamp<MICROSECONDS>::Now() - detectBeginTime);
+        if (detected)
         {
             PRINT_COSTS(DetectFacesByResolutionGroup);
 
@@ -243,7 +277,15 @@ bool FaceDetector::Detector::DetectFacesByResolutionGroup(ApiImagePtrBatch& apiI
     for (size_t idx = 0; idx < batchSize; ++idx)
     {
         ApiImagePtr& apiImagePtr = apiImageIPtrBatch[idx];
-        int resolution = apiImagePtr->ResolutionType();
+
+        // only detect the bounding rectangle of regions of interest
+        cv::Rect roiRect;
+        if (RoiMask::BoundingRect(apiImagePtr->faceParam, apiImagePtr->Resolution(), roiRect))
+        {
+            apiImagePtr->CreateRoiImage(roiRect);
+        }
+
+        int resolution = apiImagePtr->DetectResolutionType();
         ResolutionGroup::iterator groupItr = resolutionGroup.find(resolution);
         if (groupItr == resolutionGroup.end())
         {
@@ -265,24 +307,51 @@ bool FaceDetector::Detector::DetectFacesByResolutionGroup(ApiImagePtrBatch& apiI
         {
             ApiImagePtr& apiImageIPtr = apiImageIPtrBatch[index];
 
-            detectedfaceSdkImages.push_back(apiImageIPtr->sdkImage);
+            detectedfaceSdkImages.push_back(apiImageIPtr->DetectImage());
             detectedApiImagePtrs.push_back(apiImageIPtr);
         }
 
         MultiFaceSdkBoxes multiFaceSdkBoxes;
         START_EVALUATE(DetectFaces);
+        long long detectStart = TimeStamp<MILLISECONDS>::Now();
         if (detectedfaceSdkImages.size() <= 0 || DetectFaces(_channel, detectedfaceSdkImages, multiFaceSdkBoxes, _manager._detectParam.faceThreshold) != FaceSdkOk)
         {
             continue;
         }
+        _manager._detectIntervalController.RecordDetectCost(TimeStamp<MILLISECONDS>::Now() - detectStart, detectedfaceSdkImages.size());
         PRINT_COSTS(DetectFaces);
 
         for (size_t detectIndex = 0; detectIndex < detectedApiImagePtrs.size(); ++detectIndex)
         {
-            if (multiFaceSdkBoxes[detectIndex].size() > 0)
+            ApiImagePtr& detectedApiImageIPtr = detectedApiImagePtrs[detectIndex];
+            FaceSdkBoxes& detectedFaceSdkBoxes = multiFaceSdkBoxes[detectIndex];
+
+            // detected, its decoder commits it when its faces leave the pipeline
+            if (detectedApiImageIPtr->ack)
+            {
+                detectedApiImageIPtr->ack->processed = true;
+            }
+
+            // map faces in cropped image back to the whole image
+            if (detectedApiImageIPtr->roiImage)
             {
-                ApiImagePtr& detectedApiImageIPtr = detectedApiImagePtrs[detectIndex];
-                detectedApiImageIPtr->sdkBoxes.swap(multiFaceSdkBoxes[detectIndex]);
+                const cv::Rect& roiRect = detectedApiImageIPtr->roiRect;
+                for (size_t boxIndex = 0; boxIndex < detectedFaceSdkBoxes.size(); ++boxIndex)
+                {
+                    detectedFaceSdkBoxes[boxIndex].x += roiRect.x;
+                    detectedFaceSdkBoxes[boxIndex].y += roiRect.y;
+                }
+                detectedApiImageIPtr->DestroyRoiImage();
+            }
+            RoiMask::Filter(detectedApiImageIPtr->faceParam, detectedApiImageIPtr->Resolution(), detectedFaceSdkBoxes);
+
+            _manager._detectIntervalController.Feedback(detectedApiImageIPtr, detectedFaceSdkBoxes.size());
+
+            // the cpu tracker has to see detections without face too, or faces which left are tracked on
+            bool cpuTracked = detectedApiImageIPtr->faceParam.cpu_track && !detectedApiImageIPtr->portrait && _manager._trackParam.threadCount > 0;
+            if (detectedFaceSdkBoxes.size() > 0 || cpuTracked)
+            {
+                detectedApiImageIPtr->sdkBoxes.swap(detectedFaceSdkBoxes);
                 
                 // portrait does not have track id, so we have to change it to which the user provided
                 if (detectedApiImageIPtr->portrait)
@@ -324,7 +393,8 @@ void FaceDetector::Tracker::Work()
 {
     ApiImagePtrBatch apiImageIPtrBatch;
     START_EVALUATE(FetchOneTrack);
-    if (_manager.FetchOneTrack(apiImageIPtrBatch))
+    long long fetchBeginTime = TimeStamp<MICROSECONDS>::Now();
+    if (Fetched(_manager.FetchOneTrack(apiImageIPtrBatch), fetchBeginTime))
     {
         PRINT_COSTS(FetchOneTrack);
 
@@ -368,8 +438,10 @@ bool FaceDetector::Tracker::TrackOne(ApiImagePtrBatch& apiImageIPtrBatch, ApiIma
     DECLARE_FPS_STATIC(5000);
 
     size_t trackSize = apiImageIPtrBatch.size();
-    FaceSdkImages faceSdkImages(trackSize);
-    SourceIds sourceIds(trackSize);
+    FaceSdkImages faceSdkImages;
+    SourceIds sourceIds;
+    MultiFaceSdkBoxes sdkTrackedBoxes;
+    std::vector<size_t> sdkTrackedIndexes;
     MultiFaceSdkBoxes multiFaceSdkBoxes(trackSize);
     for (size_t idxBefore = 0; idxBefore < trackSize; ++idxBefore)
     {
@@ -378,16 +450,42 @@ bool FaceDetector::Tracker::TrackOne(ApiImagePtrBatch& apiImageIPtrBatch, ApiIma
 
         TRACK("%s image(%s:%d) at: %lld\n", __FUNCTION__, apiImageIPtr->sourceId, apiImageIPtr->imageId, TimeStamp<MILLISECONDS>::Now());
 
-        faceSdkImages[idxBefore] = apiImageIPtr->sdkImage;
-        sourceIds[idxBefore] = apiImageIPtr->sourceId;
         multiFaceSdkBoxes[idxBefore].swap(apiImageIPtr->sdkBoxes);
+
+        // cpu tracker does not need the GPU batch
+        if (apiImageIPtr->faceParam.cpu_track)
+        {
+            _manager._boxTracker.Track(apiImageIPtr, apiImageIPtr->needetect, multiFaceSdkBoxes[idxBefore]);
+        }
+        else
+        {
+            faceSdkImages.push_back(apiImageIPtr->sdkImage);
+            sourceIds.push_back(apiImageIPtr->sourceId);
+            sdkTrackedIndexes.push_back(idxBefore);
+        }
     }
-    START_EVALUATE(Track);
-    if (Track(_channel, faceSdkImages, multiFaceSdkBoxes, _manager._detectParam.faceThreshold, sourceIds) != FaceSdkOk)
+
+    if (!faceSdkImages.empty())
     {
-        return false;
+        sdkTrackedBoxes.resize(faceSdkImages.size());
+        for (size_t idx = 0; idx < sdkTrackedIndexes.size(); ++idx)
+        {
+            sdkTrackedBoxes[idx].swap(multiFaceSdkBoxes[sdkTrackedIndexes[idx]]);
+        }
+
+        START_EVALUATE(Track);
+        FaceSdkResult res = Track(_channel, faceSdkImages, sdkTrackedBoxes, _manager._detectParam.faceThreshold, sourceIds);
+        if (res != FaceSdkOk)
+        {
+            LOG(ERROR) << _name << "track " << faceSdkImages.size() << " images failed, error code: " << res;
+            return false;
+        }
+        for (size_t idx = 0; idx < sdkTrackedIndexes.size(); ++idx)
+        {
+            multiFaceSdkBoxes[sdkTrackedIndexes[idx]].swap(sdkTrackedBoxes[idx]);
+        }
+        PRINT_COSTS(Track);
     }
-    PRINT_COSTS(Track);
 
     STATISTIC_FPS(trackSize, __FUNCTION__);
 
@@ -405,6 +503,9 @@ bool FaceDetector::Tracker::TrackOne(ApiImagePtrBatch& apiImageIPtrBatch, ApiIma
 
         PRINT("%s face number: %d\n", __FUNCTION__, trackedFaceSdkBoxes.size());
 
+        // tracked faces may move out of regions of interest
+        RoiMask::Filter(faceParam, apiImageIPtr->Resolution(), trackedFaceSdkBoxes);
+
         // check if has face
         if (trackedFaceSdkBoxes.size() > 0)
         {
@@ -447,7 +548,8 @@ void FaceDetector::Evaluator::Work()
 {
     ApiImagePtrBatch apiImageIPtrBatch;
     START_EVALUATE(FetchOneEvaluates);
-    if (_manager.FetchOneEvaluates(apiImageIPtrBatch))
+    long long fetchBeginTime = TimeStamp<MICROSECONDS>::Now();
+    if (Fetched(_manager.FetchOneEvaluates(apiImageIPtrBatch), fetchBeginTime))
     {
         PRINT_COSTS(FetchOneEvaluates);
 
@@ -513,7 +615,27 @@ bool FaceDetector::Evaluator::EvaluateOneBadness(ApiImagePtrBatch& apiImageIPtrB
 {
     DECLARE_FPS_STATIC(5000);
 
+    // reject blurry and dark faces on cpu before the sdk evaluates them
+    START_EVALUATE(QualityPrefilter);
+    QualityPrefilter& qualityPrefilter = _manager._qualityPrefilter;
+    ApiImagePtrBatch prefilteredApiImageIPtrBatch;
+    prefilteredApiImageIPtrBatch.reserve(apiImageIPtrBatch.size());
+    for (size_t idx = 0; idx < apiImageIPtrBatch.size(); ++idx)
+    {
+        if (qualityPrefilter.Filter(apiImageIPtrBatch[idx]))
+        {
+            prefilteredApiImageIPtrBatch.push_back(apiImageIPtrBatch[idx]);
+        }
+    }
+    apiImageIPtrBatch.swap(prefilteredApiImageIPtrBatch);
+    PRINT_COSTS(QualityPrefilter);
+
     size_t batchSize = apiImageIPtrBatch.size();
+    if (batchSize == 0)
+    {
+        return false;
+    }
+
     FaceSdkImages faceSdkImages(batchSize);
     MultiFaceSdkBoxes multiFaceSdkBoxes(batchSize);
     for (size_t idxBefore = 0; idxBefore < batchSize; ++idxBefore)
@@ -556,7 +678,8 @@ void FaceDetector::KeyPointer::Work()
 {
     ApiImagePtrBatch apiImageIPtrBatch;
     START_EVALUATE(FetchOneDetectKeypoints);
-    if (_manager.FetchOneDetectKeypoints(apiImageIPtrBatch))
+    long long fetchBeginTime = TimeStamp<MICROSECONDS>::Now();
+    if (Fetched(_manager.FetchOneDetectKeypoints(apiImageIPtrBatch), fetchBeginTime))
     {
         PRINT_COSTS(FetchOneDetectKeypoints);
 
@@ -726,7 +849,8 @@ void FaceDetector::Aligner::Work()
 {
     ApiImagePtrBatch apiImageIPtrBatch;
     START_EVALUATE(FetchOneAlign);
-    if (_manager.FetchOneAlign(apiImageIPtrBatch))
+    long long fetchBeginTime = TimeStamp<MICROSECONDS>::Now();
+    if (Fetched(_manager.FetchOneAlign(apiImageIPtrBatch), fetchBeginTime))
     {
         PRINT_COSTS(FetchOneAlign);
 
@@ -798,7 +922,7 @@ bool FaceDetector::Aligner::AlignOne(ApiImagePtrBatch& apiImageIPtrBatch, Analyz
     int devIndex = _manager._alignParam.deviceIndex;
 
     const AnalyzeParam& analyzeParam = _manager._analyzeParam;
-    FaceAttriFinder& faceAttriFinder = _manager._faceAttriFinder;
+    AttributeCache& attributeCache = _manager._attributeCache;
     BestFaceFinder& bestFaceFinder = _manager._bestFaceFinder;
 
     bool hasExtractor = _manager._faceExtractor != nullptr;
@@ -825,31 +949,46 @@ bool FaceDetector::Aligner::AlignOne(ApiImagePtrBatch& apiImageIPtrBatch, Analyz
                 // get the face box information
                 ApiImage::ToFaceBox(faceBox, afterSdkBox);
 
+                // results of frames which must not be lost hold the acknowledgement till they are emitted
+                auto newAnalyzeResult = [&]() -> AnalyzeResultPtr
+                {
+                    AnalyzeResultPtr analyzeResultPtr(new AnalyzeResult(devIndex, GenerateCaptureResult(apiImageIPtr, faceBox), afterSdkBox.aligned, faceParam));
+                    analyzeResultPtr->ack = apiImageIPtr->ack;
+                    return analyzeResultPtr;
+                };
+
                 PRINT("%s face info: %d(%d,%d,%d,%d)\n", __FUNCTION__, faceBox.id, faceBox.x, faceBox.y, faceBox.width, faceBox.height);
                 
                 // need to analyze face attribute
-                if (analyzeParam.threadCount > 0
-                    && ((faceParam.analyze_mask && analyzeParam.analyze_mask)
-                    || (faceParam.analyze_glasses && analyzeParam.analyze_glasses)
-                    || (faceParam.analyze_age_ethnic && analyzeParam.analyze_age_ethnic)
-                    || (faceParam.analyze_age_gender && analyzeParam.analyze_age_gender)
-                    || (faceParam.clarity > 0.0f && analyzeParam.analyze_clarity)
-                    || (faceParam.brightness > 0.0f && analyzeParam.analyze_brightness))
-                    )
+                int attributes = 0;
+                if (faceParam.analyze_mask && analyzeParam.analyze_mask)
                 {
-                    FaceBox oldFaceBox;
-                    if (faceAttriFinder.Find(faceBox.id, oldFaceBox, sourceId))
-                    {
-                        faceBox.mask = oldFaceBox.mask;
-                        faceBox.glasses = oldFaceBox.glasses;
-                        faceBox.age = oldFaceBox.age;
-                        faceBox.gender = oldFaceBox.gender;
-                        faceBox.age_group = oldFaceBox.age_group;
-                        faceBox.ethnic = oldFaceBox.ethnic;
-                    }
-                    else
+                    attributes |= AttributeCache::ATTRIBUTE_MASK;
+                }
+                if (faceParam.analyze_glasses && analyzeParam.analyze_glasses)
+                {
+                    attributes |= AttributeCache::ATTRIBUTE_GLASSES;
+                }
+                if (faceParam.analyze_age_ethnic && analyzeParam.analyze_age_ethnic)
+                {
+                    attributes |= AttributeCache::ATTRIBUTE_AGE_ETHNIC;
+                }
+                if (faceParam.analyze_age_gender && analyzeParam.analyze_age_gender)
+                {
+                    attributes |= AttributeCache::ATTRIBUTE_AGE_GENDER;
+                }
+                bool evaluate = (faceParam.clarity > 0.0f && analyzeParam.analyze_clarity)
+                    || (faceParam.brightness > 0.0f && analyzeParam.analyze_brightness);
+
+                if (analyzeParam.threadCount > 0 && (attributes != 0 || evaluate))
+                {
+                    // reuse the settled attributes of the track
+                    int settled = attributeCache.Lookup(sourceId, faceParam.analyze_result_timeout, faceBox);
+                    if (evaluate || (settled & attributes) != attributes)
                     {
-                        toAnalyzeResultPtrBuffer.push_back(AnalyzeResultPtr(new AnalyzeResult(devIndex, GenerateCaptureResult(apiImageIPtr, faceBox), afterSdkBox.aligned, faceParam)));
+                        AnalyzeResultPtr analyzeResultPtr = newAnalyzeResult();
+                        analyzeResultPtr->inflight = apiImageIPtr->inflight;
+                        toAnalyzeResultPtrBuffer.push_back(analyzeResultPtr);
                         toAnalyzeResultPtrBufferSize++;
                         continue;
                     }
@@ -864,25 +1003,30 @@ bool FaceDetector::Aligner::AlignOne(ApiImagePtrBatch& apiImageIPtrBatch, Analyz
                         {
                             if (betterAnalyzeResultPtr->captureResultPtr->faceBox.keypointsConfidence < faceBox.keypointsConfidence)
                             {
-                                bestFaceFinder.Update(faceBox.id, AnalyzeResultPtr(new AnalyzeResult(devIndex, GenerateCaptureResult(apiImageIPtr, faceBox), afterSdkBox.aligned, faceParam)), sourceId);
+                                bestFaceFinder.Update(faceBox.id, newAnalyzeResult(), sourceId);
                             }
                         }
                         else
                         {
-                            bestFaceFinder.Update(faceBox.id, AnalyzeResultPtr(new AnalyzeResult(devIndex, GenerateCaptureResult(apiImageIPtr, faceBox), afterSdkBox.aligned, faceParam)), sourceId);
+                            bestFaceFinder.Update(faceBox.id, newAnalyzeResult(), sourceId);
                         }
                     }
                     else
                     {
                         if (faceParam.choose_entry_timeout > 0)
                         {
-                            bestFaceFinder.Add(faceBox.id, AnalyzeResultPtr(new AnalyzeResult(devIndex, GenerateCaptureResult(apiImageIPtr, faceBox), afterSdkBox.aligned, faceParam)), faceParam.choose_best_interval, sourceId, faceParam.choose_entry_timeout, faceParam.choose_best_interval);
+                            bestFaceFinder.Add(faceBox.id, newAnalyzeResult(), faceParam.choose_best_interval, sourceId, faceParam.choose_entry_timeout, faceParam.choose_best_interval);
+                        }
+                        else if (faceParam.extract_best_only && faceParam.extract_feature && hasExtractor)
+                        {
+                            // defer extraction till best face finder commits the track
+                            bestFaceFinder.Add(faceBox.id, newAnalyzeResult(), faceParam.choose_best_interval, sourceId, 0, faceParam.choose_best_interval);
                         }
                         else
                         {
                             if (faceParam.extract_feature && hasExtractor)
                             {
-                                toExtractResultPtrBuffer.push_back(AnalyzeResultPtr(new AnalyzeResult(devIndex, GenerateCaptureResult(apiImageIPtr, faceBox), afterSdkBox.aligned, faceParam)));
+                                toExtractResultPtrBuffer.push_back(newAnalyzeResult());
                                 toExtractResultPtrBufferSize++;
                             }
                             else
@@ -897,7 +1041,7 @@ bool FaceDetector::Aligner::AlignOne(ApiImagePtrBatch& apiImageIPtrBatch, Analyz
                 {
                     if (faceParam.extract_feature && hasExtractor)
                     {
-                        toExtractResultPtrBuffer.push_back(AnalyzeResultPtr(new AnalyzeResult(devIndex, GenerateCaptureResult(apiImageIPtr, faceBox), afterSdkBox.aligned, faceParam)));
+                        toExtractResultPtrBuffer.push_back(newAnalyzeResult());
                         toExtractResultPtrBufferSize++;
                     }
                     else
@@ -937,7 +1081,8 @@ void FaceDetector::FaceAttrAnalyzer::Work()
 {
     AnalyzeResultPtrBatch analyzedResultPtrs;
     START_EVALUATE(FetchOneAnalyze);
-    if (_manager.FetchOneAnalyze(analyzedResultPtrs))
+    long long fetchBeginTime = TimeStamp<MICROSECONDS>::Now();
+    if (Fetched(_manager.FetchOneAnalyze(analyzedResultPtrs), fetchBeginTime))
     {
         PRINT_COSTS(FetchOneAnalyze);
 
@@ -964,6 +1109,16 @@ void FaceDetector::FaceAttrAnalyzer::Work()
             PRINT_COSTS(PushOneResults);
         }
 
+        // analyzed faces leave the pipeline of their sources,
+        // the acknowledgement goes on with the results till they are emitted
+        for each (AnalyzeResultPtr analyzeResultPtr in analyzedResultPtrs)
+        {
+            if (analyzeResultPtr)
+            {
+                analyzeResultPtr->inflight.reset();
+            }
+        }
+
         PRINT_FUNCTION_COSTS();
     }
 }
@@ -976,8 +1131,12 @@ void FaceDetector::FaceAttrAnalyzer::AnalyzeOne(AnalyzeResultPtrBatch& analyzedR
     bool analyze_brightness = _manager._analyzeParam.analyze_brightness;
     int devIndex = _manager._analyzeParam.deviceIndex;
 
+    AttributeCache& attributeCache = _manager._attributeCache;
+
     size_t batchSize = analyzedResultPtrs.size();
     FaceSdkImages ageGenderAnalyzeSdkImages, ageEthicAnalyzeSdkImages, claritySdkImages;
+    // attributes to be analyzed of each face, the settled ones are taken from cache
+    std::vector<int> analyzedAttributes(batchSize, 0);
     
     START_EVALUATE(BrightMaskGlass);
     for (size_t idxBefore = 0; idxBefore <batchSize; ++idxBefore)
@@ -989,11 +1148,30 @@ void FaceDetector::FaceAttrAnalyzer::AnalyzeOne(AnalyzeResultPtrBatch& analyzedR
             FaceBox& faceBox = analyzedResultPtr->captureResultPtr->faceBox;
             const FaceParam& faceParam = analyzedResultPtr->faceParam;
 
-            if (_channelParam.enableAnalyzeAgeGender && faceParam.analyze_age_gender)
+            int settled = attributeCache.Lookup(analyzedResultPtr->captureResultPtr->sourceId, faceParam.analyze_result_timeout, faceBox);
+            int& attributes = analyzedAttributes[idxBefore];
+            if (_channelParam.enableAnalyzeAgeGender && faceParam.analyze_age_gender && !(settled & AttributeCache::ATTRIBUTE_AGE_GENDER))
+            {
+                attributes |= AttributeCache::ATTRIBUTE_AGE_GENDER;
+            }
+            if (_channelParam.enableAnalyzeAgeEthnic && faceParam.analyze_age_ethnic && !(settled & AttributeCache::ATTRIBUTE_AGE_ETHNIC))
+            {
+                attributes |= AttributeCache::ATTRIBUTE_AGE_ETHNIC;
+            }
+            if (_channelParam.enableAnalyzeGlasses && faceParam.analyze_glasses && !(settled & AttributeCache::ATTRIBUTE_GLASSES))
+            {
+                attributes |= AttributeCache::ATTRIBUTE_GLASSES;
+            }
+            if (_channelParam.enableAnalyzeMask && faceParam.analyze_mask && !(settled & AttributeCache::ATTRIBUTE_MASK))
+            {
+                attributes |= AttributeCache::ATTRIBUTE_MASK;
+            }
+
+            if (attributes & AttributeCache::ATTRIBUTE_AGE_GENDER)
             {
                 ageGenderAnalyzeSdkImages.push_back(analyzedResultPtr->alignedImage);
             }
-            if (_channelParam.enableAnalyzeAgeEthnic && faceParam.analyze_age_ethnic)
+            if (attributes & AttributeCache::ATTRIBUTE_AGE_ETHNIC)
             {
                 ageEthicAnalyzeSdkImages.push_back(analyzedResultPtr->alignedImage);
             }
@@ -1002,7 +1180,7 @@ void FaceDetector::FaceAttrAnalyzer::AnalyzeOne(AnalyzeResultPtrBatch& analyzedR
                 claritySdkImages.push_back(analyzedResultPtr->alignedImage);
             }
 
-            if (_channelParam.enableAnalyzeGlasses && faceParam.analyze_glasses)
+            if (attributes & AttributeCache::ATTRIBUTE_GLASSES)
             {
                 bool glasses = false;
                 // analyze glass state
@@ -1012,7 +1190,7 @@ void FaceDetector::FaceAttrAnalyzer::AnalyzeOne(AnalyzeResultPtrBatch& analyzedR
                 faceBox.glasses = glasses ? 1 : 0;
             }
 
-            if (_channelParam.enableAnalyzeMask && faceParam.analyze_mask)
+            if (attributes & AttributeCache::ATTRIBUTE_MASK)
             {
                 bool mask = false;
                 // analyze mask state
@@ -1051,9 +1229,7 @@ void FaceDetector::FaceAttrAnalyzer::AnalyzeOne(AnalyzeResultPtrBatch& analyzedR
                 FaceBox& faceBox = analyzedResultPtr->captureResultPtr->faceBox;
                 if (analyzedResultPtr->alignedImage)
                 {
-                    const FaceParam faceParam = analyzedResultPtr->faceParam;
-
-                    if (_channelParam.enableAnalyzeAgeEthnic && faceParam.analyze_age_ethnic)
+                    if (analyzedAttributes[idxAfter] & AttributeCache::ATTRIBUTE_AGE_ETHNIC)
                     {
                         faceBox.age_group = ageGroups[ageIndex];
                         faceBox.ethnic = ethnics[ageIndex++];
@@ -1082,9 +1258,7 @@ void FaceDetector::FaceAttrAnalyzer::AnalyzeOne(AnalyzeResultPtrBatch& analyzedR
                 FaceBox& faceBox = analyzedResultPtr->captureResultPtr->faceBox;
                 if (analyzedResultPtr->alignedImage)
                 {
-                    const FaceParam faceParam = analyzedResultPtr->faceParam;
-
-                    if (_channelParam.enableAnalyzeAgeGender && faceParam.analyze_age_gender)
+                    if (analyzedAttributes[idxAfter] & AttributeCache::ATTRIBUTE_AGE_GENDER)
                     {
                         faceBox.age = ages[ageIndex];
                         faceBox.gender = genders[ageIndex++];
@@ -1127,16 +1301,22 @@ void FaceDetector::FaceAttrAnalyzer::AnalyzeOne(AnalyzeResultPtrBatch& analyzedR
     START_EVALUATE(UpdateAnalyseResult);
 
     bool hasExtractor = _manager._faceExtractor != nullptr;
-    FaceAttriFinder& faceAttriFinder = _manager._faceAttriFinder;
     BestFaceFinder& bestFaceFinder = _manager._bestFaceFinder;
     // construct capture result
-    for each(AnalyzeResultPtr analyzeResultPtr in analyzedResultPtrs)
+    for (size_t idxAfter = 0; idxAfter < batchSize; ++idxAfter)
     {
+        AnalyzeResultPtr& analyzeResultPtr = analyzedResultPtrs[idxAfter];
         const CaptureResultPtr& captureResultPtr = analyzeResultPtr->captureResultPtr;
         const FaceParam& faceParam = analyzeResultPtr->faceParam;
         const SourceId& sourceId = captureResultPtr->sourceId;
         FaceBox& faceBox = captureResultPtr->faceBox;
 
+        // vote face attribute before the result is shared
+        if (analyzedAttributes[idxAfter] != 0)
+        {
+            attributeCache.Vote(sourceId, analyzedAttributes[idxAfter], faceBox);
+        }
+
         if (faceParam.choose_best_interval > 0)
         {
             AnalyzeResultPtr betterAnalyzeResultPtr(nullptr);
@@ -1160,6 +1340,11 @@ void FaceDetector::FaceAttrAnalyzer::AnalyzeOne(AnalyzeResultPtrBatch& analyzedR
                 {
                     bestFaceFinder.Add(faceBox.id, analyzeResultPtr, faceParam.choose_best_interval, sourceId, faceParam.choose_entry_timeout, faceParam.choose_best_interval);
                 }
+                else if (faceParam.extract_best_only && faceParam.extract_feature && hasExtractor)
+                {
+                    // defer extraction till best face finder commits the track
+                    bestFaceFinder.Add(faceBox.id, analyzeResultPtr, faceParam.choose_best_interval, sourceId, 0, faceParam.choose_best_interval);
+                }
                 else
                 {
                     if (faceParam.extract_feature && hasExtractor)
@@ -1187,9 +1372,6 @@ void FaceDetector::FaceAttrAnalyzer::AnalyzeOne(AnalyzeResultPtrBatch& analyzedR
                 captureResults.push_back(captureResultPtr);
             }
         }
-
-        // update face attribute
-        faceAttriFinder.Add(faceBox.id, faceBox, 0, sourceId, 0, faceParam.analyze_result_timeout);
     }
     PRINT_COSTS(UpdateAnalyseResult);
 
@@ -1207,23 +1389,27 @@ void FaceDetector::BestFaceFinderCallback(void* context, AnalyzeResultPtrBuffer&
 
 FaceDetector::FaceDetector(const ModelParam& modelParam, const DetectParam& detectParam, 
     const TrackParam& trackParam, const EvaluateParam& evaluateParam, const KeypointParam& keypointParam, 
-    const AlignParam& alignParam, const AnalyzeParam& analyzerParam, const ResultParam& resultParam, FaceExtractor* faceExtractor)
+    const AlignParam& alignParam, const AnalyzeParam& analyzerParam, const ResultParam& resultParam, FaceExtractor* faceExtractor, const ScaleParam& scaleParam)
     : _started(false), _error_code(0)
-    , _contextLocker(), _baseDecoders()
+    , _contextLocker(), _baseDecoders(), _inflights()
+    , _loadLocker(), _detectBatchMilliseconds(0.0f), _pixelRate(0.0f), _fetchedPixels(0), _fetchBeginTime(0)
     , _prepareDetectBuffer(), _preparingDetectBuffer()
+    , _motionGate(), _detectIntervalController()
     , _oneWorkerReady(), _oneWorkerReadyLocker()
+    , _scaleLocker(), _stageScaler(scaleParam, STAGE_DETECT, STAGE_ANALYZE, StageTimesCallback, ScaleStageCallback, this)
     , _modelParam(modelParam), _resultParam(resultParam), _channelParam()
     , _faceExtractor(faceExtractor)
     , _detectParam(detectParam), _updateDetectBatchSizeDynamic(detectParam.batchSize <= 0), _detectors(), _detectBufferCondition(), _detectBufferLocker(), _detectBuffer(), _detectImageNumber(0)
-    , _trackParam(trackParam), _updateTrackBatchSizeDynamic(trackParam.batchSize <= 0), _trackers(), _trackBufferCondition(), _trackBufferLocker(), _trackBuffer(), _trackImageNumber(0)
-    , _evaluateParam(evaluateParam), _updateEvaluateBatchSizeDynamic(evaluateParam.batchSize <= 0), _evaluators(), _evaluateBufferCondition(), _evaluateBufferLocker(), _evaluateBuffer(), _evaluateImageNumber(0)
+    , _trackParam(trackParam), _updateTrackBatchSizeDynamic(trackParam.batchSize <= 0), _trackers(), _boxTracker(), _trackBufferCondition(), _trackBufferLocker(), _trackBuffer(), _trackImageNumber(0)
+    , _evaluateParam(evaluateParam), _updateEvaluateBatchSizeDynamic(evaluateParam.batchSize <= 0), _evaluators(), _evaluateBufferCondition(), _evaluateBufferLocker(), _evaluateBuffer(), _evaluateImageNumber(0), _qualityPrefilter()
     , _keypointParam(keypointParam), _updateKeypointBatchSizeDynamic(keypointParam.batchSize <= 0), _keypointers(), _keyPointsBufferCondition(), _keyPointsBufferLocker(), _keyPointsBuffer(), _keypointsImageNumber(0)
     , _alignParam(alignParam), _updateAlignBatchSizeDynamic(alignParam.batchSize <= 0), _aligners(), _alignBufferCondition(), _alignBufferLocker(), _alignBuffer(), _alignImageNumber(0)
     , _analyzeParam(analyzerParam), _faceAttrAnalyzerPtrs(), _faceAttrAnalyzeBufferCondition(), _faceAttrAnalyzeBufferLocker(), _faceAttrAnalyzeBuffer(), _faceNumberToAnalyze(0)
-    , _outputBufferLocker(), _outputBuffer(), _resultFaceNumber(0)
+    , _outputBufferLocker(), _outputBuffer(), _resultFaceNumber(0), _captureArchive(), _captureSink(), _captureRing()
     , _faceStatFinder(10, nullptr, nullptr, this, ResetFaceStat)
-    , _faceAttriFinder(10, nullptr, nullptr, this, nullptr)
+    , _attributeCache(analyzerParam.cacheSize, analyzerParam.cacheVotes)
     , _bestFaceFinder(10, nullptr, BestFaceFinderCallback, this, ResetAnalyzeResultPtr)
+    , _extractedQualityFinder(10, nullptr, nullptr, this, nullptr)
 {
     _channelParam.modelDir = _modelParam.path;
     _channelParam.featureModel = _modelParam.name;
@@ -1235,6 +1421,9 @@ FaceDetector::FaceDetector(const ModelParam& modelParam, const DetectParam& dete
 
     _channelParam.thresholdT = _trackParam.threshold;
 
+    memset(_retiredBusyMicroseconds, 0, sizeof(_retiredBusyMicroseconds));
+    memset(_retiredTotalMicroseconds, 0, sizeof(_retiredTotalMicroseconds));
+
     // initialize to one
     if (_updateDetectBatchSizeDynamic)
     {
@@ -1270,6 +1459,19 @@ void FaceDetector::Start() throw(BaseException)
 
         try
         {
+            if (!_resultParam.archiveParam.path.empty())
+            {
+                _captureArchive = CaptureArchive::Open(_resultParam.archiveParam);
+            }
+            if (!_resultParam.sinkParam.path.empty())
+            {
+                _captureSink = CaptureSink::Open(_resultParam.sinkParam);
+            }
+            if (!_resultParam.ringParam.name.empty())
+            {
+                _captureRing = CaptureRing::Open(_resultParam.ringParam);
+            }
+
             StartOneDetector(_detectParam.deviceIndex);
             StartOneTracker(_trackParam.deviceIndex);
             StartOneBadnessEvalutor(_evaluateParam.deviceIndex);
@@ -1284,16 +1486,27 @@ void FaceDetector::Start() throw(BaseException)
         }
 
         StartPrepareDetectBuffer();
+
+        _stageScaler.Start();
     }
 }
 
 void FaceDetector::Stop()
 {
-    if (_started)
+    // a scaling past the started check adds its workers before they are stopped, later ones add none
+    bool started = false;
     {
+        AUTOLOCK(_scaleLocker);
+        started = _started;
         _started = false;
+    }
+
+    if (started)
+    {
+        _stageScaler.Stop();
 
         StopPrepareDetectBuffer();
+        _loadShedder.RemoveDetector(this);
 
         StopAnalyzers();
         StopAligners();
@@ -1301,6 +1514,10 @@ void FaceDetector::Stop()
         StopBadnessEvalutors();
         StopTrackers();
         StopDetectors();
+
+        _captureArchive.reset();
+        _captureSink.reset();
+        _captureRing.reset();
     }
 }
 
@@ -1311,28 +1528,9 @@ void FaceDetector::AddDecoder(BaseDecoder* baseDecoder, const FaceParam& facePar
         AUTOLOCK(_contextLocker);
         baseDecoder->SetFaceParam(faceParam);
         _baseDecoders.push_back(baseDecoder);
+        _inflights[baseDecoder->Id()] = std::make_shared<int>(0);
 
-        int batchSize = _baseDecoders.size();
-        if (_updateDetectBatchSizeDynamic)
-        {
-            _detectParam.batchSize = batchSize;
-        }
-        if (_updateTrackBatchSizeDynamic)
-        {
-            _trackParam.batchSize = batchSize;
-        }
-        if (_updateEvaluateBatchSizeDynamic)
-        {
-            _evaluateParam.batchSize = batchSize;
-        }
-        if (_updateKeypointBatchSizeDynamic)
-        {
-            _keypointParam.batchSize = batchSize;
-        }
-        if (_updateAlignBatchSizeDynamic)
-        {
-            _alignParam.batchSize = batchSize;
-        }
+        UpdateBatchSizes();
     }
 }
 
@@ -1346,33 +1544,90 @@ void FaceDetector::DeleteDecoder(BaseDecoder* baseDecoder)
             if (_baseDecoders[idx] == baseDecoder)
             {
                 _baseDecoders.erase(_baseDecoders.begin() + idx);
+                _inflights.erase(baseDecoder->Id());
+                _motionGate.Remove(baseDecoder->Id());
+                _detectIntervalController.Remove(baseDecoder->Id());
+                _loadShedder.Remove(baseDecoder->Id());
+                _boxTracker.Remove(baseDecoder->Id());
+                _attributeCache.Remove(baseDecoder->Id());
+                _qualityPrefilter.Remove(baseDecoder->Id());
                 break;
             }
         }
 
-        int batchSize = _baseDecoders.size();
-        batchSize = batchSize == 0 ? 1 : batchSize;
-        if (_updateDetectBatchSizeDynamic)
-        {
-            _detectParam.batchSize = batchSize;
-        }
-        if (_updateTrackBatchSizeDynamic)
-        {
-            _trackParam.batchSize = batchSize;
-        }
-        if (_updateEvaluateBatchSizeDynamic)
-        {
-            _evaluateParam.batchSize = batchSize;
-        }
-        if (_updateKeypointBatchSizeDynamic)
+        UpdateBatchSizes();
+    }
+}
+
+bool FaceDetector::MoveDecoder(BaseDecoder* baseDecoder, FaceDetector& target, int drainTimeout)
+{
+    if (!baseDecoder || &target == this)
+    {
+        return false;
+    }
+
+    const SourceId& sourceId = baseDecoder->Id();
+
+    // stop fetching, frames fetched already go on in the pipeline
+    std::shared_ptr<int> inflight = nullptr;
+    {
+        AUTOLOCK(_contextLocker);
+        BaseDecoders::iterator it = std::find(_baseDecoders.begin(), _baseDecoders.end(), baseDecoder);
+        if (it == _baseDecoders.end())
         {
-            _keypointParam.batchSize = batchSize;
+            return false;
         }
-        if (_updateAlignBatchSizeDynamic)
+        _baseDecoders.erase(it);
+
+        std::map<SourceId, std::shared_ptr<int>>::iterator inflightIt = _inflights.find(sourceId);
+        if (inflightIt != _inflights.end())
         {
-            _alignParam.batchSize = batchSize;
+            inflight = inflightIt->second;
+            _inflights.erase(inflightIt);
         }
+
+        UpdateBatchSizes();
     }
+
+    // wait till the fetched frames are analyzed, so that tracks and best faces they update are moved
+    long long beginTime = TimeStamp<MILLISECONDS>::Now();
+    while (inflight && inflight.use_count() > 1 && TimeStamp<MILLISECONDS>::Now() - beginTime < drainTimeout)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    if (inflight && inflight.use_count() > 1)
+    {
+        LOG(WARNING) << "source " << sourceId << " is moved with " << inflight.use_count() - 1 << " frames not drained in " << drainTimeout << "ms";
+    }
+
+    _motionGate.Remove(sourceId);
+    _detectIntervalController.Remove(sourceId);
+    _loadShedder.Remove(sourceId);
+    _qualityPrefilter.Remove(sourceId);
+
+    const FaceParam& faceParam = baseDecoder->GetFaceParam();
+    if (faceParam.cpu_track)
+    {
+        // track ids go on on target, so do the best faces and voted attributes of tracks
+        _boxTracker.Transfer(sourceId, target._boxTracker);
+        _attributeCache.Transfer(sourceId, target._attributeCache);
+        _faceStatFinder.Transfer(sourceId, target._faceStatFinder);
+        _bestFaceFinder.Transfer(sourceId, target._bestFaceFinder);
+        _extractedQualityFinder.Transfer(sourceId, target._extractedQualityFinder);
+    }
+    else
+    {
+        // sdk tracker of target numbers tracks by itself, tracks can not go on there,
+        // report best faces of the tracks now instead of dropping them
+        _boxTracker.Remove(sourceId);
+        _attributeCache.Remove(sourceId);
+        _faceStatFinder.Flush(sourceId);
+        _bestFaceFinder.Flush(sourceId);
+        _extractedQualityFinder.Flush(sourceId);
+    }
+
+    target.AddDecoder(baseDecoder, faceParam);
+    return true;
 }
 
 void FaceDetector::DelFaceExtractor()
@@ -1407,6 +1662,141 @@ int FaceDetector::GetDeviceIndex()
     }
 }
 
+void FaceDetector::GetLoad(DetectorLoad& detectorLoad)
+{
+    detectorLoad.deviceIndex = GetDeviceIndex();
+    {
+        AUTOLOCK(_contextLocker);
+        detectorLoad.sourceNumber = (int)_baseDecoders.size();
+    }
+
+    detectorLoad.queuedNumber = (int)(LockedNumber(_detectBufferLocker, _detectImageNumber) + LockedNumber(_trackBufferLocker, _trackImageNumber)
+        + LockedNumber(_evaluateBufferLocker, _evaluateImageNumber) + LockedNumber(_keyPointsBufferLocker, _keypointsImageNumber)
+        + LockedNumber(_alignBufferLocker, _alignImageNumber) + LockedNumber(_faceAttrAnalyzeBufferLocker, _faceNumberToAnalyze));
+    detectorLoad.bufferUsage = BufferUsage();
+
+    AUTOLOCK(_loadLocker);
+    detectorLoad.batchMilliseconds = _detectBatchMilliseconds;
+    detectorLoad.pixelRate = _pixelRate;
+}
+
+bool FaceDetector::ScaleStage(int stage, int threadCount)
+{
+    AUTOLOCK(_scaleLocker);
+    if (!_started || threadCount <= 0)
+    {
+        return false;
+    }
+
+    switch (stage)
+    {
+    case STAGE_DETECT:
+        return !_detectors.empty() && ScaleWorkers(_detectors, stage, _detectParam.deviceIndex, _detectParam.threadCount, threadCount);
+    case STAGE_TRACK:
+        return !_trackers.empty() && ScaleWorkers(_trackers, stage, _trackParam.deviceIndex, _trackParam.threadCount, threadCount);
+    case STAGE_EVALUATE:
+        return !_evaluators.empty() && ScaleWorkers(_evaluators, stage, _evaluateParam.deviceIndex, _evaluateParam.threadCount, threadCount);
+    case STAGE_KEYPOINT:
+        return !_keypointers.empty() && ScaleWorkers(_keypointers, stage, _keypointParam.deviceIndex, _keypointParam.threadCount, threadCount);
+    case STAGE_ALIGN:
+        return !_aligners.empty() && ScaleWorkers(_aligners, stage, _alignParam.deviceIndex, _alignParam.threadCount, threadCount);
+    case STAGE_ANALYZE:
+        return !_faceAttrAnalyzerPtrs.empty() && ScaleWorkers(_faceAttrAnalyzerPtrs, stage, _analyzeParam.deviceIndex, _analyzeParam.threadCount, threadCount);
+    default:
+        return false;
+    }
+}
+
+void FaceDetector::GetStageStatistics(std::vector<StageStatistic>& stageStatistics)
+{
+    _stageScaler.GetStatistics(stageStatistics);
+}
+
+template<class T>
+bool FaceDetector::ScaleWorkers(std::vector<std::shared_ptr<T>>& workers, int stage, int gpuIndex, int& threadCount, int scaledThreadCount)
+{
+    while ((int)workers.size() < scaledThreadCount)
+    {
+        std::shared_ptr<T> workerPtr(new T(*this, gpuIndex, _channelParam));
+        workerPtr->Start(gpuIndex >= 0 ? GpuCtxIndex::Next(gpuIndex) : 0);
+        try
+        {
+            WaitNotify(__FUNCTION__);
+        }
+        catch (BaseException& ex)
+        {
+            LOG(ERROR) << ex.Description();
+            workerPtr->ReadyToStop();
+            workerPtr->Stop();
+            break;
+        }
+        workers.push_back(workerPtr);
+    }
+
+    // the retired worker finishes its current batch, its times are kept for the stage
+    while ((int)workers.size() > scaledThreadCount)
+    {
+        std::shared_ptr<T> workerPtr = workers.back();
+        workers.pop_back();
+        workerPtr->ReadyToStop();
+        workerPtr->Stop();
+
+        long long busyMicroseconds = 0, totalMicroseconds = 0;
+        workerPtr->GetTimes(busyMicroseconds, totalMicroseconds);
+        _retiredBusyMicroseconds[stage] += busyMicroseconds;
+        _retiredTotalMicroseconds[stage] += totalMicroseconds;
+    }
+
+    threadCount = (int)workers.size();
+    LOG(INFO) << "workers of stage " << stage << " on GPU:" << gpuIndex << " are scaled to " << threadCount;
+    return threadCount == scaledThreadCount;
+}
+
+template<class T>
+bool FaceDetector::SumWorkerTimes(std::vector<std::shared_ptr<T>>& workers, int stage, int& threadCount, long long& busyMicroseconds, long long& totalMicroseconds)
+{
+    threadCount = (int)workers.size();
+    busyMicroseconds = _retiredBusyMicroseconds[stage];
+    totalMicroseconds = _retiredTotalMicroseconds[stage];
+    for (size_t idx = 0; idx < workers.size(); ++idx)
+    {
+        long long workerBusyMicroseconds = 0, workerTotalMicroseconds = 0;
+        workers[idx]->GetTimes(workerBusyMicroseconds, workerTotalMicroseconds);
+        busyMicroseconds += workerBusyMicroseconds;
+        totalMicroseconds += workerTotalMicroseconds;
+    }
+    return !workers.empty();
+}
+
+bool FaceDetector::StageTimesCallback(void* context, int stage, int& threadCount, long long& busyMicroseconds, long long& totalMicroseconds)
+{
+    FaceDetector* faceDetector = (FaceDetector*)context;
+
+    AUTOLOCK(faceDetector->_scaleLocker);
+    switch (stage)
+    {
+    case STAGE_DETECT:
+        return faceDetector->SumWorkerTimes(faceDetector->_detectors, stage, threadCount, busyMicroseconds, totalMicroseconds);
+    case STAGE_TRACK:
+        return faceDetector->SumWorkerTimes(faceDetector->_trackers, stage, threadCount, busyMicroseconds, totalMicroseconds);
+    case STAGE_EVALUATE:
+        return faceDetector->SumWorkerTimes(faceDetector->_evaluators, stage, threadCount, busyMicroseconds, totalMicroseconds);
+    case STAGE_KEYPOINT:
+        return faceDetector->SumWorkerTimes(faceDetector->_keypointers, stage, threadCount, busyMicroseconds, totalMicroseconds);
+    case STAGE_ALIGN:
+        return faceDetector->SumWorkerTimes(faceDetector->_aligners, stage, threadCount, busyMicroseconds, totalMicroseconds);
+    case STAGE_ANALYZE:
+        return faceDetector->SumWorkerTimes(faceDetector->_faceAttrAnalyzerPtrs, stage, threadCount, busyMicroseconds, totalMicroseconds);
+    default:
+        return false;
+    }
+}
+
+bool FaceDetector::ScaleStageCallback(void* context, int stage, int threadCount)
+{
+    return ((FaceDetector*)context)->ScaleStage(stage, threadCount);
+}
+
 void FaceDetector::StartOneDetector(int gpuIndex) throw(BaseException)
 {
     for (int idx = 0; idx < _detectParam.threadCount; ++idx)
@@ -1425,6 +1815,7 @@ void FaceDetector::StartOneDetector(int gpuIndex) throw(BaseException)
 
 void FaceDetector::StopDetectors()
 {
+    AUTOLOCK(_scaleLocker);
     for each (DetectorPtr detectorPtr in _detectors)
     {
         detectorPtr->ReadyToStop();
@@ -1451,6 +1842,7 @@ void FaceDetector::StartOneTracker(int gpuIndex) throw(BaseException)
 
 void FaceDetector::StopTrackers()
 {
+    AUTOLOCK(_scaleLocker);
     for each (TrackerPtr trackerPtr in _trackers)
     {
         trackerPtr->ReadyToStop();
@@ -1477,6 +1869,7 @@ void FaceDetector::StartOneBadnessEvalutor(int gpuIndex) throw(BaseException)
 
 void FaceDetector::StopBadnessEvalutors()
 {
+    AUTOLOCK(_scaleLocker);
     for each (EvaluatorPtr badnessEvaluator in _evaluators)
     {
         badnessEvaluator->ReadyToStop();
@@ -1503,6 +1896,7 @@ void FaceDetector::StartOneKeypointer(int gpuIndex) throw(BaseException)
 
 void FaceDetector::StopKeypointers()
 {
+    AUTOLOCK(_scaleLocker);
     for each (KeyPointerPtr keypointerPtr in _keypointers)
     {
         keypointerPtr->ReadyToStop();
@@ -1529,6 +1923,7 @@ void FaceDetector::StartOneAligner(int gpuIndex) throw(BaseException)
 
 void FaceDetector::StopAligners()
 {
+    AUTOLOCK(_scaleLocker);
     for each (AlignerPtr alignerPtr in _aligners)
     {
         alignerPtr->ReadyToStop();
@@ -1560,6 +1955,7 @@ void FaceDetector::StartOneAnalyzer(int gpuIndex) throw(BaseException)
 
 void FaceDetector::StopAnalyzers()
 {
+    AUTOLOCK(_scaleLocker);
     for each (FaceAttrAnalyzerPtr faceAttrAnalyzerPtr in _faceAttrAnalyzerPtrs)
     {
         faceAttrAnalyzerPtr->ReadyToStop();
@@ -1634,9 +2030,10 @@ void FaceDetector::PushOneTrack(ApiImagePtrBuffer& apiImageIPtrBuffer, int size)
     AUTOLOCK(_trackBufferLocker);
     for each (ApiImagePtr apiImagePtr in apiImageIPtrBuffer)
     {
-        // full detect and track or track only image
+        // full detect and track or track only image, the cpu tracker takes detected images as they are,
+        // it has to see which of its images carry detections
         int detectInterval = apiImagePtr->faceParam.detect_interval;
-        if (detectInterval <= 1 || !apiImagePtr->needetect)
+        if (detectInterval <= 1 || !apiImagePtr->needetect || apiImagePtr->faceParam.cpu_track)
         {
             _trackBuffer.push_back(apiImagePtr);
             _trackImageNumber++;
@@ -1651,6 +2048,7 @@ void FaceDetector::PushOneTrack(ApiImagePtrBuffer& apiImageIPtrBuffer, int size)
                 if (buff->sourceId == apiImagePtr->sourceId && sdkBoxes.empty() && buff->timestamp < apiImagePtr->timestamp)
                 {
                     sdkBoxes.swap(apiImagePtr->sdkBoxes);
+                    buff->needetect = true;
                     processed = true;
                     break;
                 }
@@ -1771,6 +2169,26 @@ bool FaceDetector::FetchOneDetectKeypoints(ApiImagePtrBatch& apiImageIPtrBatch)
 
 void FaceDetector::PushOneAlign(ApiImagePtrBuffer& apiImageIPtrBuffer, int size)
 {
+    // overloaded, drop the captures
+    ApiImagePtrBuffer::iterator it = apiImageIPtrBuffer.begin();
+    while (it != apiImageIPtrBuffer.end())
+    {
+        if (_loadShedder.AdmitCapture(*it))
+        {
+            ++it;
+        }
+        else
+        {
+            it = apiImageIPtrBuffer.erase(it);
+            size--;
+        }
+    }
+
+    if (size <= 0)
+    {
+        return;
+    }
+
     AUTOLOCK(_alignBufferLocker);
     long long poppedSize = PushBuffer(_alignBuffer, _alignImageNumber, _alignParam.bufferSize, apiImageIPtrBuffer, size);
     if (poppedSize > 0)
@@ -1821,12 +2239,78 @@ void FaceDetector::PushOneExtract(AnalyzeResultPtrBuffer& analyzeResultPtrBuffer
 {
     if (_faceExtractor)
     {
-        _faceExtractor->PushOneExtract(analyzeResultPtrBuffer, size);
+        // faces not better enough than the extracted ones are captured without feature
+        CaptureResults captureResults;
+        AnalyzeResultPtrBuffer::iterator it = analyzeResultPtrBuffer.begin();
+        while (it != analyzeResultPtrBuffer.end())
+        {
+            if (NeedExtract(*it))
+            {
+                ++it;
+            }
+            else
+            {
+                captureResults.push_back((*it)->captureResultPtr);
+                it = analyzeResultPtrBuffer.erase(it);
+                size--;
+            }
+        }
+
+        if (captureResults.size() > 0)
+        {
+            PushOneResults(captureResults);
+        }
+
+        if (size > 0)
+        {
+            _faceExtractor->PushOneExtract(analyzeResultPtrBuffer, size);
+        }
+    }
+}
+
+bool FaceDetector::NeedExtract(const AnalyzeResultPtr& analyzeResultPtr)
+{
+    const FaceParam& faceParam = analyzeResultPtr->faceParam;
+    if (faceParam.extract_quality_margin < 0.0f)
+    {
+        return true;
+    }
+
+    const CaptureResultPtr& captureResultPtr = analyzeResultPtr->captureResultPtr;
+    const FaceBox& faceBox = captureResultPtr->faceBox;
+
+    float extractedQuality = 0.0f;
+    if (_extractedQualityFinder.Find(faceBox.id, extractedQuality, captureResultPtr->sourceId))
+    {
+        if (faceBox.keypointsConfidence < extractedQuality + faceParam.extract_quality_margin)
+        {
+            return false;
+        }
+        _extractedQualityFinder.Update(faceBox.id, faceBox.keypointsConfidence, captureResultPtr->sourceId);
+    }
+    else
+    {
+        // forget the track when it is not captured any more
+        _extractedQualityFinder.Add(faceBox.id, faceBox.keypointsConfidence, 0, captureResultPtr->sourceId, 0, (std::max)(faceParam.analyze_result_timeout, 1000));
     }
+    return true;
 }
 
 void FaceDetector::PushOneResults(CaptureResults& captureResults)
 {
+    if (_captureArchive)
+    {
+        _captureArchive->Append(captureResults);
+    }
+    if (_captureSink)
+    {
+        _captureSink->Append(captureResults);
+    }
+    if (_captureRing)
+    {
+        _captureRing->Append(captureResults);
+    }
+
     AUTOLOCK(_outputBufferLocker);
     _outputBuffer.push(captureResults);
     _resultFaceNumber += captureResults.size();
@@ -1846,6 +2330,40 @@ void FaceDetector::PushOneResults(CaptureResults& captureResults)
     }
 }
 
+float FaceDetector::BufferUsage()
+{
+    float usage = 0.0f;
+    if (_detectParam.bufferSize > 0)
+    {
+        usage = (std::max)(usage, (float)LockedNumber(_detectBufferLocker, _detectImageNumber) / _detectParam.bufferSize);
+    }
+    if (_trackParam.bufferSize > 0)
+    {
+        usage = (std::max)(usage, (float)LockedNumber(_trackBufferLocker, _trackImageNumber) / _trackParam.bufferSize);
+    }
+    if (_evaluateParam.bufferSize > 0)
+    {
+        usage = (std::max)(usage, (float)LockedNumber(_evaluateBufferLocker, _evaluateImageNumber) / _evaluateParam.bufferSize);
+    }
+    if (_keypointParam.bufferSize > 0)
+    {
+        usage = (std::max)(usage, (float)LockedNumber(_keyPointsBufferLocker, _keypointsImageNumber) / _keypointParam.bufferSize);
+    }
+    if (_alignParam.bufferSize > 0)
+    {
+        usage = (std::max)(usage, (float)LockedNumber(_alignBufferLocker, _alignImageNumber) / _alignParam.bufferSize);
+    }
+    if (_analyzeParam.bufferSize > 0)
+    {
+        usage = (std::max)(usage, (float)LockedNumber(_faceAttrAnalyzeBufferLocker, _faceNumberToAnalyze) / _analyzeParam.bufferSize);
+    }
+    if (_faceExtractor)
+    {
+        usage = (std::max)(usage, _faceExtractor->BufferUsage());
+    }
+    return usage;
+}
+
 void FaceDetector::PushBests(AnalyzeResultPtrBuffer& analyzeResultPtrBuffer)
 {
     if (_faceExtractor)
@@ -1909,17 +2427,26 @@ void FaceDetector::StartPrepareDetectBuffer()
 
 void FaceDetector::PrepareDetectBuffer()
 {
+    ThreadAffinity::Bind(THREAD_WORKER, _detectParam.deviceIndex);
+
     while (_preparingDetectBuffer)
     {
         START_FUNCTION_EVALUATE();
         
         ApiImagePtrBuffer detectBuffer, trackBuffer;
         int detectBufferSize = 0, trackBufferSize = 0;
+        std::vector<int> priorities;
+        long long fetchedPixels = 0;
         START_EVALUATE(FetchDecodedFrame);
         {
             AUTOLOCK(_contextLocker);
             for each(BaseDecoder* baseDecoder in _baseDecoders)
             {
+                if (baseDecoder)
+                {
+                    priorities.push_back(baseDecoder->GetFaceParam().priority);
+                }
+
                 DecodedFrame decodedFrame;
                 if (baseDecoder && baseDecoder->GetFrame(decodedFrame))
                 {
@@ -1931,6 +2458,32 @@ void FaceDetector::PrepareDetectBuffer()
                     {
                         //apiImagePtr->Show();
 
+                        apiImagePtr->inflight = _inflights[baseDecoder->Id()];
+                        fetchedPixels += apiImagePtr->Resolution().area();
+
+                        _detectIntervalController.Decide(apiImagePtr);
+
+                        // frames which must not be lost are always detected, their decoder holds them back instead of shedding
+                        if (apiImagePtr->ack)
+                        {
+                            apiImagePtr->needetect = true;
+                        }
+                        // overloaded, shed the frame
+                        else if (!_loadShedder.Admit(apiImagePtr))
+                        {
+                            continue;
+                        }
+
+                        // static frame need not to be detected, track it or drop it
+                        if (!apiImagePtr->ack && (apiImagePtr->needetect || _trackParam.threadCount <= 0) && !_motionGate.Pass(apiImagePtr))
+                        {
+                            if (_trackParam.threadCount <= 0)
+                            {
+                                continue;
+                            }
+                            apiImagePtr->needetect = false;
+                        }
+
                         if (apiImagePtr->needetect || _trackParam.threadCount <= 0)
                         {
                             detectBuffer.push_back(apiImagePtr);
@@ -1946,6 +2499,9 @@ void FaceDetector::PrepareDetectBuffer()
             }
         }
 
+        _loadShedder.Evaluate(this, BufferUsage(), priorities);
+        RecordFetchedPixels(fetchedPixels);
+
         // if no frame decoded, then wait for 1ms
         if (trackBufferSize == 0 && detectBufferSize == 0)
         {
@@ -1999,9 +2555,67 @@ ApiImagePtr FaceDetector::FromDecodedFrame(DecodedFrame& decodeFrame, const Face
         apiImagePtr->position = decodeFrame.position;
         apiImagePtr->needetect = decodeFrame.needDetect;
     }
+
+    if (apiImagePtr)
+    {
+        apiImagePtr->poolIndex = decodeFrame.poolIndex;
+        apiImagePtr->ack = decodeFrame.ack;
+    }
     return apiImagePtr;
 }
 
+void FaceDetector::UpdateBatchSizes()
+{
+    int batchSize = _baseDecoders.size();
+    batchSize = batchSize == 0 ? 1 : batchSize;
+    if (_updateDetectBatchSizeDynamic)
+    {
+        _detectParam.batchSize = batchSize;
+    }
+    if (_updateTrackBatchSizeDynamic)
+    {
+        _trackParam.batchSize = batchSize;
+    }
+    if (_updateEvaluateBatchSizeDynamic)
+    {
+        _evaluateParam.batchSize = batchSize;
+    }
+    if (_updateKeypointBatchSizeDynamic)
+    {
+        _keypointParam.batchSize = batchSize;
+    }
+    if (_updateAlignBatchSizeDynamic)
+    {
+        _alignParam.batchSize = batchSize;
+    }
+}
+
+void FaceDetector::RecordDetectBatch(long long microseconds)
+{
+    // exponential moving average, recent batches weigh more
+    AUTOLOCK(_loadLocker);
+    _detectBatchMilliseconds = 0.8f * _detectBatchMilliseconds + 0.2f * (microseconds / 1000.0f);
+}
+
+void FaceDetector::RecordFetchedPixels(long long pixels)
+{
+    long long now = TimeStamp<MILLISECONDS>::Now();
+
+    AUTOLOCK(_loadLocker);
+    _fetchedPixels += pixels;
+    if (_fetchBeginTime == 0)
+    {
+        _fetchBeginTime = now;
+    }
+    else if (now - _fetchBeginTime >= 1000)
+    {
+        float pixelRate = _fetchedPixels * 1000.0f / (now - _fetchBeginTime) / 1000000.0f;
+        _pixelRate = 0.5f * _pixelRate + 0.5f * pixelRate;
+        _fetchedPixels = 0;
+        _fetchBeginTime = now;
+    }
+}
+
 void FaceDetector::InitializingCurrentState()
 {
     _error_code = 0;
@@ -2,6 +2,14 @@
 #define _FACEDETECTOR_IMPLEMENT_HEADER_H_
 
 #include "FaceExtractorImpl.h"
+#include "MotionGate.h"
+#include "BoxTracker.h"
+#include "RoiMask.h"
+#include "DetectIntervalController.h"
+#include "LoadShedder.h"
+#include "AttributeCache.h"
+#include "QualityPrefilter.h"
+#include "StageScaler.h"
 
 #include "SnapStruct.h"
 
@@ -12,14 +20,13 @@ typedef std::map<int, ResolutionIndex> ResolutionGroup;
 typedef std::vector<ApiImagePtr> ApiImagePtrBatch;
 typedef std::list<ApiImagePtr> ApiImagePtrBuffer;
 
-typedef BestFinder<int, FaceBox, std::string> FaceAttriFinder;
-
 struct FaceStat
 {
     int trackId = -1;
     int trackedFrameNumber = 0;
 };
 typedef BestFinder<int, FaceStat, std::string> FaceStatFinder;
+typedef BestFinder<int, float, std::string> ExtractedQualityFinder;
 void ResetFaceStat(FaceStat& faceStat);
 
 class SnapMachine;
@@ -37,9 +44,17 @@ private:
         void ReadyToStop();
         int Stop();
 
+        /**
+        * @brief get cumulative times of the worker \n
+        * busy time is running time not spent waiting for a batch
+        */
+        void GetTimes(long long& busyMicroseconds, long long& totalMicroseconds);
+
     protected:
         int CreateThreadChannel();
 
+        bool Fetched(bool fetched, long long fetchBeginTime);
+
         void Execute();
 
         virtual void Work();
@@ -53,6 +68,9 @@ private:
         char _name[128];
         bool _working;
 
+        std::atomic<long long> _waitMicroseconds;
+        std::atomic<long long> _totalMicroseconds;
+
         FaceSdkParam _channelParam;
         FaceSdkChannel* _channel;
 
@@ -197,7 +215,7 @@ private:
 public:
     FaceDetector(const ModelParam& modelParam, const DetectParam& detectParam, const TrackParam& trackParam, 
         const EvaluateParam& evaluateParam, const KeypointParam& keypointParam, const AlignParam& alignParam, 
-        const AnalyzeParam& analyzerParam, const ResultParam& resultParam, FaceExtractor*);
+        const AnalyzeParam& analyzerParam, const ResultParam& resultParam, FaceExtractor*, const ScaleParam& scaleParam = ScaleParam());
     ~FaceDetector();
 
     void Start() throw(BaseException);
@@ -205,6 +223,14 @@ public:
 
     void AddDecoder(BaseDecoder* baseDecoder, const FaceParam& faceParam);
     void DeleteDecoder(BaseDecoder* baseDecoder);
+
+    /**
+    * @brief move the decoder to target \n
+    * frames of the decoder already fetched are drained here for at most drainTimeout (ms) first,
+    * then tracks and best faces of the decoder are handed to target
+    * @return false if the decoder is not fetched by this detector
+    */
+    bool MoveDecoder(BaseDecoder* baseDecoder, FaceDetector& target, int drainTimeout);
     
     void DelFaceExtractor();
 
@@ -212,6 +238,18 @@ public:
 
     int GetDeviceIndex();
 
+    void GetLoad(DetectorLoad& detectorLoad);
+
+    /**
+    * @brief add or retire workers of a stage while running \n
+    * retired workers finish their current batch first, only stages enabled at start can be scaled
+    * and each keeps one worker at least
+    * @return false if the stage is not enabled or not all workers could be started
+    */
+    bool ScaleStage(int stage, int threadCount);
+
+    void GetStageStatistics(std::vector<StageStatistic>& stageStatistics);
+
 private:
     ApiImagePtr FromDecodedFrame(DecodedFrame& decodeFrame, const FaceParam& faceParam);
 
@@ -220,6 +258,19 @@ private:
     void NotifyMe(int err);
     void WaitNotify(const char*) throw(BaseException);
 
+    void UpdateBatchSizes();
+
+    void RecordDetectBatch(long long microseconds);
+    void RecordFetchedPixels(long long pixels);
+
+    template<class T>
+    bool ScaleWorkers(std::vector<std::shared_ptr<T>>& workers, int stage, int gpuIndex, int& threadCount, int scaledThreadCount);
+    template<class T>
+    bool SumWorkerTimes(std::vector<std::shared_ptr<T>>& workers, int stage, int& threadCount, long long& busyMicroseconds, long long& totalMicroseconds);
+
+    static bool StageTimesCallback(void*, int stage, int& threadCount, long long& busyMicroseconds, long long& totalMicroseconds);
+    static bool ScaleStageCallback(void*, int stage, int threadCount);
+
     void StartOneDetector(int gpuIndex) throw(BaseException);
     void StopDetectors();
 
@@ -260,10 +311,13 @@ private:
     bool FetchOneAnalyze(AnalyzeResultPtrBatch& analyzeResultPtrs);
 
     void PushOneExtract(AnalyzeResultPtrBuffer& analyzeResultPtrBuffer, int size);
+    bool NeedExtract(const AnalyzeResultPtr& analyzeResultPtr);
 
     void PushOneResults(CaptureResults& captureResults);
 
     void PushBests(AnalyzeResultPtrBuffer& analyzeResultPtrBuffer);
+
+    float BufferUsage();
 private:
     bool _started;
     volatile int _error_code;
@@ -271,6 +325,14 @@ private:
 private:
     std::mutex _contextLocker;
     BaseDecoders _baseDecoders;
+    std::map<SourceId, std::shared_ptr<int>> _inflights; // held by images of each decoder in the pipeline
+
+private:
+    std::mutex _loadLocker;
+    float _detectBatchMilliseconds;
+    float _pixelRate;
+    long long _fetchedPixels;
+    long long _fetchBeginTime;
 
 private:
     void StartPrepareDetectBuffer();
@@ -280,10 +342,20 @@ private:
     std::thread _prepareDetectBuffer;
     bool _preparingDetectBuffer;
 
+    MotionGate _motionGate;
+    DetectIntervalController _detectIntervalController;
+    static LoadShedder _loadShedder; // shared by the detectors of all devices
+
 private:
     std::condition_variable _oneWorkerReady;
     std::mutex _oneWorkerReadyLocker;
 
+private:
+    std::mutex _scaleLocker; // guards workers of all stages
+    long long _retiredBusyMicroseconds[STAGE_NUMBER];
+    long long _retiredTotalMicroseconds[STAGE_NUMBER];
+    StageScaler _stageScaler;
+
 private:
     ModelParam _modelParam;
     ResultParam _resultParam;
@@ -304,6 +376,7 @@ private:
     TrackParam _trackParam;
     bool _updateTrackBatchSizeDynamic;
     TrackerPtrs _trackers;
+    BoxTracker _boxTracker;
     std::condition_variable _trackBufferCondition;
     std::mutex _trackBufferLocker;
     ApiImagePtrBuffer _trackBuffer;
@@ -317,6 +390,7 @@ private:
     std::mutex _evaluateBufferLocker;
     ApiImagePtrBuffer _evaluateBuffer;
     size_t _evaluateImageNumber;
+    QualityPrefilter _qualityPrefilter;
 
 private:
     KeypointParam _keypointParam;
@@ -348,15 +422,21 @@ private:
     std::mutex _outputBufferLocker;
     CaptureResultsQueue _outputBuffer;
     long long _resultFaceNumber;
+    CaptureArchivePtr _captureArchive;
+    CaptureSinkPtr _captureSink;
+    CaptureRingPtr _captureRing;
 
 private:
     FaceStatFinder _faceStatFinder;
-    FaceAttriFinder _faceAttriFinder;
+    AttributeCache _attributeCache;
 
 private:
     static void BestFaceFinderCallback(void*, AnalyzeResultPtrBuffer& analyzedResultPtrBuffer);
     BestFaceFinder _bestFaceFinder;
 
+private:
+    ExtractedQualityFinder _extractedQualityFinder;
+
 private:
     FaceDetector();
     FaceDetector(const FaceDetector&);
@@ -7,6 +7,7 @@
 #include "DecodeManager.h"
 
 #include "GpuCtxIndex.h"
+#include "ThreadAffinity.h"
 
 #define GLOG_NO_ABBREVIATED_SEVERITIES
 #define GOOGLE_GLOG_DLL_DECL
@@ -21,7 +22,7 @@ void ResetAnalyzeResultPtr(AnalyzeResultPtr& analyzeResultPtr)
 
 FaceExtractor::Worker::Worker(FaceExtractor& manager, int gpuIndex, FaceSdkParam& channelParam)
     : _manager(manager), _gpuIndex(gpuIndex), _ctxIndex(0)
-    , _worker(), _working(false)
+    , _worker(), _working(false), _waitMicroseconds(0), _totalMicroseconds(0)
     , _channelParam(channelParam), _channel(nullptr)
 {
     memset(_name, 0, sizeof(_name));
@@ -62,6 +63,18 @@ int FaceExtractor::Worker::Stop()
     return 0;
 }
 
+void FaceExtractor::Worker::GetTimes(long long& busyMicroseconds, long long& totalMicroseconds)
+{
+    totalMicroseconds = _totalMicroseconds;
+    busyMicroseconds = totalMicroseconds - _waitMicroseconds;
+}
+
+bool FaceExtractor::Worker::Fetched(bool fetched, long long fetchBeginTime)
+{
+    _waitMicroseconds += TimeStamp<MICROSECONDS>::Now() - fetchBeginTime;
+    return fetched;
+}
+
 int FaceExtractor::Worker::CreateThreadChannel()
 {
     FaceSdkResult res = FaceSdkOk;
@@ -118,6 +131,8 @@ void FaceExtractor::Worker::Execute()
 {
     _manager.InitializingCurrentState();
 
+    ThreadAffinity::Bind(THREAD_WORKER, _gpuIndex);
+
     // configure working device and create channel
     int err = CreateThreadChannel();
     if (0 == err)
@@ -130,7 +145,9 @@ void FaceExtractor::Worker::Execute()
         // start to work
         while (_working)
         {
+            long long workBeginTime = TimeStamp<MICROSECONDS>::Now();
             Work();
+            _totalMicroseconds += TimeStamp<MICROSECONDS>::Now() - workBeginTime;
         }
 
         LOG(INFO) << _name << "(" << std::this_thread::get_id() << ") stop work";
@@ -164,7 +181,8 @@ void FaceExtractor::Extractor::Work()
 {
     AnalyzeResultPtrBatch analyzedResultPtrBatch;
     START_EVALUATE(FetchOneExtract);
-    if (_manager.FetchOneExtract(analyzedResultPtrBatch))
+    long long fetchBeginTime = TimeStamp<MICROSECONDS>::Now();
+    if (Fetched(_manager.FetchOneExtract(analyzedResultPtrBatch), fetchBeginTime))
     {
         PRINT_COSTS(FetchOneExtract);
 
@@ -183,6 +201,17 @@ void FaceExtractor::Extractor::Work()
                 PRINT_COSTS(PushOneResults);
             }
         }
+        else
+        {
+            // frames which must not be lost are tried again
+            for each (AnalyzeResultPtr analyzeResultPtr in analyzedResultPtrBatch)
+            {
+                if (analyzeResultPtr && analyzeResultPtr->ack)
+                {
+                    analyzeResultPtr->ack->processed = false;
+                }
+            }
+        }
 
         PRINT_FUNCTION_COSTS();
     }
@@ -243,18 +272,37 @@ bool FaceExtractor::Extractor::ExtractOne(AnalyzeResultPtrBatch& analyzedResultP
 
         currentFaceBox.age = ages[idxAfter];
         currentFaceBox.gender = genders[idxAfter] > 0.50f ? 0 : 1;
+
+        // same person captured by another source recently
+        if (_manager._extractParam.dedupThreshold >= 0.0f && _manager._featureIndex.Deduplicate(captrueResultPtr, _manager._extractParam.dedupKeepBetter))
+        {
+            continue;
+        }
+
+        // compress output feature
+        if (_manager._extractParam.featureEncoding != FEATURE_ENCODING_RAW && !feature.empty())
+        {
+            std::vector<char> encoded;
+            if (FeatureCodec::Encode(_manager._extractParam.featureEncoding, feature, encoded))
+            {
+                feature.swap(encoded);
+            }
+        }
         captureResults.push_back(captrueResultPtr);
     }
 
     return true;
 }
 
-FaceExtractor::FaceExtractor(const ModelParam& modelParam, const ExtractParam& extractParam, const ResultParam& resultParam)
+FaceExtractor::FaceExtractor(const ModelParam& modelParam, const ExtractParam& extractParam, const ResultParam& resultParam, const ScaleParam& scaleParam)
     : _started(false), _error_code(0)
     , _oneWorkerReady(), _oneWorkerReadyLocker()
     , _modelParam(modelParam), _resultParam(resultParam), _extractParam(extractParam), _channelParam()
+    , _scaleLocker(), _retiredBusyMicroseconds(0), _retiredTotalMicroseconds(0)
+    , _stageScaler(scaleParam, STAGE_EXTRACT, STAGE_EXTRACT, StageTimesCallback, ScaleStageCallback, this)
     , _extractorPtrs(), _extractBufferCondition(), _extractBufferLocker(), _extractBuffer(), _faceNumberToExtract(0)
-    , _outputBufferLocker(), _outputBuffer(), _resultFaceNumber(0)
+    , _featureIndex(extractParam.dedupThreshold, extractParam.dedupWindow)
+    , _outputBufferLocker(), _outputBuffer(), _resultFaceNumber(0), _captureArchive(), _captureSink(), _captureRing()
 {
     _channelParam.featureModel = _modelParam.name;
     _channelParam.modelDir = _modelParam.path;
@@ -273,6 +321,19 @@ void FaceExtractor::Start() throw(BaseException)
 
         try
         {
+            if (!_resultParam.archiveParam.path.empty())
+            {
+                _captureArchive = CaptureArchive::Open(_resultParam.archiveParam);
+            }
+            if (!_resultParam.sinkParam.path.empty())
+            {
+                _captureSink = CaptureSink::Open(_resultParam.sinkParam);
+            }
+            if (!_resultParam.ringParam.name.empty())
+            {
+                _captureRing = CaptureRing::Open(_resultParam.ringParam);
+            }
+
             if (_extractParam.deviceIndex >= 0)
             {
                 StartOneExtractor(_extractParam.deviceIndex);
@@ -287,6 +348,8 @@ void FaceExtractor::Start() throw(BaseException)
             Stop();
             throw ex;
         }
+
+        _stageScaler.Start();
     }
 }
 
@@ -296,7 +359,13 @@ void FaceExtractor::Stop()
     {
         _started = false;
 
+        _stageScaler.Stop();
+
         StopExtractors();
+
+        _captureArchive.reset();
+        _captureSink.reset();
+        _captureRing.reset();
     }
 }
 
@@ -315,6 +384,80 @@ bool FaceExtractor::GetCapture(CaptureResults& captureResults)
     return captureResults.size() > 0;
 }
 
+bool FaceExtractor::ScaleStage(int stage, int threadCount)
+{
+    AUTOLOCK(_scaleLocker);
+    if (!_started || stage != STAGE_EXTRACT || threadCount <= 0 || _extractorPtrs.empty())
+    {
+        return false;
+    }
+
+    int gpuIndex = _extractParam.deviceIndex >= 0 ? _extractParam.deviceIndex : -1;
+    while ((int)_extractorPtrs.size() < threadCount)
+    {
+        ExtractorPtr extractorPtr(new Extractor(*this, gpuIndex, _channelParam));
+        extractorPtr->Start(GpuCtxIndex::Next(gpuIndex));
+        try
+        {
+            WaitNotify(__FUNCTION__);
+        }
+        catch (BaseException& ex)
+        {
+            LOG(ERROR) << ex.Description();
+            extractorPtr->ReadyToStop();
+            extractorPtr->Stop();
+            break;
+        }
+        _extractorPtrs.push_back(extractorPtr);
+    }
+
+    // the retired extractor finishes its current batch, its times are kept for the stage
+    while ((int)_extractorPtrs.size() > threadCount)
+    {
+        ExtractorPtr extractorPtr = _extractorPtrs.back();
+        _extractorPtrs.pop_back();
+        extractorPtr->ReadyToStop();
+        extractorPtr->Stop();
+
+        long long busyMicroseconds = 0, totalMicroseconds = 0;
+        extractorPtr->GetTimes(busyMicroseconds, totalMicroseconds);
+        _retiredBusyMicroseconds += busyMicroseconds;
+        _retiredTotalMicroseconds += totalMicroseconds;
+    }
+
+    _extractParam.threadCount = (int)_extractorPtrs.size();
+    LOG(INFO) << "extractors on GPU:" << gpuIndex << " are scaled to " << _extractParam.threadCount;
+    return _extractParam.threadCount == threadCount;
+}
+
+void FaceExtractor::GetStageStatistics(std::vector<StageStatistic>& stageStatistics)
+{
+    _stageScaler.GetStatistics(stageStatistics);
+}
+
+bool FaceExtractor::StageTimesCallback(void* context, int stage, int& threadCount, long long& busyMicroseconds, long long& totalMicroseconds)
+{
+    FaceExtractor* faceExtractor = (FaceExtractor*)context;
+
+    AUTOLOCK(faceExtractor->_scaleLocker);
+    threadCount = (int)faceExtractor->_extractorPtrs.size();
+    busyMicroseconds = faceExtractor->_retiredBusyMicroseconds;
+    totalMicroseconds = faceExtractor->_retiredTotalMicroseconds;
+    for each (ExtractorPtr extractorPtr in faceExtractor->_extractorPtrs)
+    {
+        long long extractorBusyMicroseconds = 0, extractorTotalMicroseconds = 0;
+        extractorPtr->GetTimes(extractorBusyMicroseconds, extractorTotalMicroseconds);
+        busyMicroseconds += extractorBusyMicroseconds;
+        totalMicroseconds += extractorTotalMicroseconds;
+    }
+    return stage == STAGE_EXTRACT && threadCount > 0;
+}
+
+bool FaceExtractor::ScaleStageCallback(void* context, int stage, int threadCount)
+{
+    return ((FaceExtractor*)context)->ScaleStage(stage, threadCount);
+}
+
 void FaceExtractor::StartOneExtractor(int gpuIndex) throw(BaseException)
 {
     for (int idx = 0; idx < _extractParam.threadCount; ++idx)
@@ -333,6 +476,7 @@ void FaceExtractor::StartOneExtractor(int gpuIndex) throw(BaseException)
 
 void FaceExtractor::StopExtractors()
 {
+    AUTOLOCK(_scaleLocker);
     for each (ExtractorPtr extractorPtr in _extractorPtrs)
     {
         extractorPtr->ReadyToStop();
@@ -353,6 +497,12 @@ void FaceExtractor::PushOneExtract(AnalyzeResultPtrBuffer& analyzeResultPtrBuffe
     WAKEUP_ALL(_extractBufferCondition);
 }
 
+float FaceExtractor::BufferUsage()
+{
+    AUTOLOCK(_extractBufferLocker);
+    return _extractParam.bufferSize > 0 ? (float)_faceNumberToExtract / _extractParam.bufferSize : 0.0f;
+}
+
 bool FaceExtractor::FetchOneExtract(AnalyzeResultPtrBatch& analyzeResultPtrs)
 {
     WAIT_MILLISEC_TILL_COND(_extractBufferCondition, _extractBufferLocker, _extractParam.batchTimeout, [this](){ return _faceNumberToExtract >= _extractParam.batchSize; });
@@ -369,6 +519,19 @@ void FaceExtractor::PushOneResults(CaptureResults& captureResults)
 {
     if (captureResults.size() > 0)
     {
+        if (_captureArchive)
+        {
+            _captureArchive->Append(captureResults);
+        }
+        if (_captureSink)
+        {
+            _captureSink->Append(captureResults);
+        }
+        if (_captureRing)
+        {
+            _captureRing->Append(captureResults);
+        }
+
         AUTOLOCK(_outputBufferLocker);
         _outputBuffer.push(captureResults);
         _resultFaceNumber += captureResults.size();
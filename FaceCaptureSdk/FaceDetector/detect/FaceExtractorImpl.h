@@ -8,6 +8,12 @@
 #include "Performance.h"
 #include "Finder.h"
 #include "BaseDecoder.h"
+#include "FeatureIndex.h"
+#include "FeatureCodec.h"
+#include "CaptureArchive.h"
+#include "CaptureSink.h"
+#include "CaptureRing.h"
+#include "StageScaler.h"
 
 typedef BestFinder<int, AnalyzeResultPtr, std::string> BestFaceFinder;
 
@@ -27,9 +33,17 @@ private:
         void ReadyToStop();
         int Stop();
 
+        /**
+        * @brief get cumulative times of the worker \n
+        * busy time is running time not spent waiting for a batch
+        */
+        void GetTimes(long long& busyMicroseconds, long long& totalMicroseconds);
+
     protected:
         int CreateThreadChannel();
 
+        bool Fetched(bool fetched, long long fetchBeginTime);
+
         void Execute();
 
         virtual void Work();
@@ -43,6 +57,9 @@ private:
         char _name[128];
         bool _working;
 
+        std::atomic<long long> _waitMicroseconds;
+        std::atomic<long long> _totalMicroseconds;
+
         FaceSdkParam _channelParam;
         FaceSdkChannel* _channel;
 
@@ -74,7 +91,7 @@ private:
     typedef std::vector<ExtractorPtr> ExtractorPtrs;
 
 public:
-    FaceExtractor(const ModelParam& modelParam, const ExtractParam& extractParam, const ResultParam& resultParam);
+    FaceExtractor(const ModelParam& modelParam, const ExtractParam& extractParam, const ResultParam& resultParam, const ScaleParam& scaleParam = ScaleParam());
     ~FaceExtractor();
 
     void Start() throw(BaseException);
@@ -84,6 +101,18 @@ public:
 
     void PushOneExtract(AnalyzeResultPtrBuffer& analyzeResultPtrBuffer, int size);
 
+    float BufferUsage();
+
+    /**
+    * @brief add or retire extractors while running \n
+    * retired extractors finish their current batch first, extract can be scaled only if it is enabled at start
+    * and one extractor is kept at least
+    * @return false if stage is not STAGE_EXTRACT, extract is not enabled or not all extractors could be started
+    */
+    bool ScaleStage(int stage, int threadCount);
+
+    void GetStageStatistics(std::vector<StageStatistic>& stageStatistics);
+
 public:
     static size_t PushBuffer(AnalyzeResultPtrBuffer& buffer, size_t& size, int threshold, AnalyzeResultPtrBuffer& addedBuffer, int addedSize);
     static bool FetchBatch(AnalyzeResultPtrBuffer& buffer, size_t& size, int threshold, AnalyzeResultPtrBatch& apiImageIPtrBatch);
@@ -94,6 +123,9 @@ private:
     void NotifyMe(int err);
     void WaitNotify(const char*) throw(BaseException);
 
+    static bool StageTimesCallback(void*, int stage, int& threadCount, long long& busyMicroseconds, long long& totalMicroseconds);
+    static bool ScaleStageCallback(void*, int stage, int threadCount);
+
     void StartOneExtractor(int gpuIndex) throw(BaseException);
     void StopExtractors();
 
@@ -116,6 +148,12 @@ private:
     ExtractParam _extractParam;
     FaceSdkParam _channelParam;
 
+private:
+    std::mutex _scaleLocker; // guards extractors
+    long long _retiredBusyMicroseconds;
+    long long _retiredTotalMicroseconds;
+    StageScaler _stageScaler;
+
 private:
     ExtractorPtrs _extractorPtrs;
     std::condition_variable _extractBufferCondition;
@@ -123,10 +161,16 @@ private:
     AnalyzeResultPtrBuffer _extractBuffer;
     size_t _faceNumberToExtract;
 
+private:
+    FeatureIndex _featureIndex;
+
 private:
     std::mutex _outputBufferLocker;
     CaptureResultsQueue _outputBuffer;
     long long _resultFaceNumber;
+    CaptureArchivePtr _captureArchive;
+    CaptureSinkPtr _captureSink;
+    CaptureRingPtr _captureRing;
 
 private:
     FaceExtractor();
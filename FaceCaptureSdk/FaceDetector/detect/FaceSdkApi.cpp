@@ -7,6 +7,9 @@
 
 #include "jpeg_codec_util.h"
 
+#include <opencv2/cudawarping.hpp>
+#include <algorithm>
+
 #define GLOG_NO_ABBREVIATED_SEVERITIES
 #define GOOGLE_GLOG_DLL_DECL
 #include "glog/logging.h"
@@ -29,15 +32,22 @@
 
 ApiImage::ApiImage(const FaceParam& faceParamRef, const SourceId& sourceIdRef, FrameId frameId, int devIndex, long long generatedAt, bool toBeBuffered)
     : sourceId(sourceIdRef), imageId(frameId), timestamp(generatedAt), position(0)
-    , sdkImage(nullptr), sdkBoxes(), faceBoxIds()
+    , sdkImage(nullptr), roiImage(nullptr), roiRect(), sdkBoxes(), faceBoxIds()
     , needetect(false), portrait(false), buffered(toBeBuffered)
-    , deviceIndex(devIndex)
+    , deviceIndex(devIndex), poolIndex(devIndex)
     , origin(), scence()
+    , inflight(), ack()
     , faceParam(faceParamRef)
 {}
 
 ApiImage::~ApiImage()
 {
+    if (roiImage)
+    {
+        DestroyImage(roiImage);
+        roiImage = nullptr;
+    }
+
     if (sdkImage)
     {
         DestroyImage(sdkImage);
@@ -74,6 +84,65 @@ void ApiImage::ScaleRect(const cv::Rect& src, int maxWidth, int maxHeight, cv::R
     dst.height &= 0xFFFE;
 }
 
+void ApiImage::DestroyRoiImage()
+{
+    if (roiImage)
+    {
+        DestroyImage(roiImage);
+        roiImage = nullptr;
+    }
+}
+
+void ApiImage::ToGrayThumbnail(const cv::Mat& src, cv::Mat& gray, int width)
+{
+    if (src.empty() || width <= 0)
+    {
+        gray.release();
+        return;
+    }
+
+    cv::Mat resized;
+    if (src.cols > width)
+    {
+        cv::resize(src, resized, cv::Size(width, src.rows * width / src.cols), 0, 0, cv::INTER_AREA);
+    }
+    else
+    {
+        resized = src;
+    }
+
+    switch (resized.channels())
+    {
+    case 3:
+        cv::cvtColor(resized, gray, cv::COLOR_BGR2GRAY);
+        break;
+    case 4:
+        cv::cvtColor(resized, gray, cv::COLOR_BGRA2GRAY);
+        break;
+    default:
+        gray = resized.clone();
+        break;
+    }
+}
+
+void ApiImage::ToGrayChip(const cv::Mat& src, const cv::Rect& rect, cv::Mat& gray, int size)
+{
+    cv::Rect chipRect = rect & cv::Rect(0, 0, src.cols, src.rows);
+    if (chipRect.area() <= 0 || size <= 0)
+    {
+        gray.release();
+        return;
+    }
+
+    // longer side is shrunk to size
+    int width = chipRect.width;
+    if ((std::max)(chipRect.width, chipRect.height) > size)
+    {
+        width = (std::max)(1, chipRect.width * size / (std::max)(chipRect.width, chipRect.height));
+    }
+    ToGrayThumbnail(src(chipRect), gray, width);
+}
+
 void ApiImage::UpdatePortraitTrackId()
 {
     for (size_t idx = 0; idx < sdkBoxes.size() && idx < faceBoxIds.size(); ++idx)
@@ -182,11 +251,47 @@ void ApiRaw::KeepFace(cv::cuda::Stream&, cv::Mat& face, int x, int y, int width,
     }
 }
 
+void ApiRaw::Thumbnail(cv::Mat& gray, int width)
+{
+    ToGrayThumbnail(origin, gray, width);
+}
+
+void ApiRaw::FaceChip(const cv::Rect& rect, cv::Mat& gray, int size)
+{
+    ToGrayChip(origin, rect, gray, size);
+}
+
 int ApiRaw::ResolutionType()
 {
     return (origin.cols << 14) + origin.rows;
 }
 
+bool ApiRaw::CreateRoiImage(const cv::Rect& rect)
+{
+    DestroyRoiImage();
+    if (origin.empty() || rect.area() <= 0)
+    {
+        return false;
+    }
+
+    roi = origin(rect).clone();
+    if (FaceSdkOk != CreateImageByMat(roiImage, roi))
+    {
+        roiImage = nullptr;
+        roi.release();
+        return false;
+    }
+
+    roiRect = rect;
+    return true;
+}
+
+void ApiRaw::DestroyRoiImage()
+{
+    ApiImage::DestroyRoiImage();
+    roi.release();
+}
+
 ApiMat::ApiMat(const FaceParam& faceParamRef, const SourceId& sourceId, FrameId frameId, Image& img, int devIndex, long long generatedAt, bool toBeBuffered, const cv::Mat& scenceImage/* = cv::Mat()*/, const FaceRects& faceRectsP/* = {}*/)
     : ApiImage(faceParamRef, sourceId, frameId, devIndex, generatedAt, toBeBuffered), image(img), faceRects(faceRectsP)
 {
@@ -210,7 +315,7 @@ ApiMat::~ApiMat()
 {
     if (buffered)
     {
-        XMatPool<cv::Mat>::Free(origin);
+        XMatPool<cv::Mat>::Free(origin, poolIndex);
     }
     TRACK("%s image(%s:%d) at: %lld\n", __FUNCTION__, sourceId, imageId, TimeStamp<MILLISECONDS>::Now());
 }
@@ -308,11 +413,47 @@ void ApiMat::KeepFace(cv::cuda::Stream&, cv::Mat& face, int x, int y, int width,
     }
 }
 
+void ApiMat::Thumbnail(cv::Mat& gray, int width)
+{
+    ToGrayThumbnail(origin, gray, width);
+}
+
+void ApiMat::FaceChip(const cv::Rect& rect, cv::Mat& gray, int size)
+{
+    ToGrayChip(image, rect, gray, size);
+}
+
 int ApiMat::ResolutionType()
 {
     return (image.cols << 14) + image.rows;
 }
 
+bool ApiMat::CreateRoiImage(const cv::Rect& rect)
+{
+    DestroyRoiImage();
+    if (image.empty() || rect.area() <= 0)
+    {
+        return false;
+    }
+
+    roi = image(rect).clone();
+    if (FaceSdkOk != CreateImageByMat(roiImage, roi))
+    {
+        roiImage = nullptr;
+        roi.release();
+        return false;
+    }
+
+    roiRect = rect;
+    return true;
+}
+
+void ApiMat::DestroyRoiImage()
+{
+    ApiImage::DestroyRoiImage();
+    roi.release();
+}
+
 void ApiMat::UpdatePortraitTrackId()
 {
     if (portrait)
@@ -351,7 +492,7 @@ ApiGpuMat::~ApiGpuMat()
 {
     if (buffered)
     {
-        XMatPool<cv::cuda::GpuMat>::Free(image, deviceIndex);
+        XMatPool<cv::cuda::GpuMat>::Free(image, poolIndex);
     }
     TRACK("%s image(%s:%d) at: %lld\n", __FUNCTION__, sourceId, imageId, TimeStamp<MILLISECONDS>::Now());
 }
@@ -431,8 +572,83 @@ void ApiGpuMat::KeepFace(cv::cuda::Stream& stream, cv::Mat& face, int x, int y,
     }
 }
 
+void ApiGpuMat::Thumbnail(cv::Mat& gray, int width)
+{
+    if (!origin.empty())
+    {
+        ToGrayThumbnail(origin, gray, width);
+    }
+    else if (!image.empty() && width > 0)
+    {
+        // shrink on device and only download the small one
+        cv::Mat small;
+        if (image.cols > width)
+        {
+            cv::cuda::GpuMat resized;
+            cv::cuda::resize(image, resized, cv::Size(width, image.rows * width / image.cols));
+            resized.download(small);
+        }
+        else
+        {
+            image.download(small);
+        }
+        ToGrayThumbnail(small, gray, width);
+    }
+    else
+    {
+        gray.release();
+    }
+}
+
+void ApiGpuMat::FaceChip(const cv::Rect& rect, cv::Mat& gray, int size)
+{
+    if (!origin.empty())
+    {
+        ToGrayChip(origin, rect, gray, size);
+        return;
+    }
+
+    cv::Rect chipRect = rect & cv::Rect(0, 0, image.cols, image.rows);
+    if (chipRect.area() <= 0)
+    {
+        gray.release();
+        return;
+    }
+
+    // only download the face region
+    cv::Mat chip;
+    image(chipRect).download(chip);
+    ToGrayChip(chip, cv::Rect(0, 0, chip.cols, chip.rows), gray, size);
+}
+
 int ApiGpuMat::ResolutionType()
 {
     return (image.cols << 14) + image.rows;
 }
 
+bool ApiGpuMat::CreateRoiImage(const cv::Rect& rect)
+{
+    DestroyRoiImage();
+    if (image.empty() || rect.area() <= 0)
+    {
+        return false;
+    }
+
+    roi = image(rect).clone();
+    if (FaceSdkOk != CreateImageByGpuMat(roiImage, roi))
+    {
+        roiImage = nullptr;
+        roi.release();
+        return false;
+    }
+
+    roiRect = rect;
+    return true;
+}
+
+void ApiGpuMat::DestroyRoiImage()
+{
+    ApiImage::DestroyRoiImage();
+    roi.release();
+}
+
@@ -64,6 +64,8 @@ public:
     long long position;
 
     FaceSdkImage* sdkImage;
+    FaceSdkImage* roiImage; // cropped by roiRect for detecting only
+    cv::Rect roiRect;
     FaceSdkBoxes sdkBoxes;
     FaceBoxIds faceBoxIds;
 
@@ -72,10 +74,14 @@ public:
     bool buffered;
 
     int deviceIndex;
+    int poolIndex;  // of XMatPool a buffered image came from, the decoder may be on another device
 
     cv::Mat origin;
     cv::Mat scence;
 
+    std::shared_ptr<void> inflight; // held while the image is in the pipeline, see FaceDetector::MoveDecoder
+    FrameAckPtr ack;                // of frames which must not be lost, processed once detected
+
     const FaceParam& faceParam;
 
     ApiImage(const FaceParam& faceParamRef, const SourceId& sourceId, FrameId frameId, int devIndex, long long generatedAt, bool toBeBuffered);
@@ -87,10 +93,35 @@ public:
     virtual int ResolutionType() = 0;
     virtual void KeepScence(cv::cuda::Stream& stream) = 0;
     virtual void KeepFace(cv::cuda::Stream& stream, cv::Mat& face, int x, int y, int width, int height) = 0;
+    virtual void Thumbnail(cv::Mat& gray, int width) = 0;
+    virtual void FaceChip(const cv::Rect& rect, cv::Mat& gray, int size) = 0;
+
+    virtual bool CreateRoiImage(const cv::Rect& rect) = 0;
+    virtual void DestroyRoiImage();
 
     virtual void UpdatePortraitTrackId();
 
+    inline cv::Size Resolution()
+    {
+        int resolutionType = ResolutionType();
+        return cv::Size(resolutionType >> 14, resolutionType & 0x3FFF);
+    }
+
+    inline FaceSdkImage* DetectImage()
+    {
+        return roiImage ? roiImage : sdkImage;
+    }
+
+    inline int DetectResolutionType()
+    {
+        return roiImage ? (roiRect.width << 14) + roiRect.height : ResolutionType();
+    }
+
     void ScaleRect(const cv::Rect&, int maxWidth, int maxHeight, cv::Rect&);
+
+protected:
+    static void ToGrayThumbnail(const cv::Mat& src, cv::Mat& gray, int width);
+    static void ToGrayChip(const cv::Mat& src, const cv::Rect& rect, cv::Mat& gray, int size);
     
 private:
     ApiImage(const ApiImage&);
@@ -105,6 +136,7 @@ public:
 
 public:
     Image image;
+    cv::Mat roi;
 
     ApiRaw(const FaceParam& faceParamRef, const SourceId& sourceId, FrameId frameId, Image& img, int devIndex, long long generatedAt, bool toBeBuffered);
     ~ApiRaw();
@@ -114,7 +146,12 @@ public:
 
     void KeepScence(cv::cuda::Stream& stream);
     void KeepFace(cv::cuda::Stream& stream, cv::Mat& face, int x, int y, int width, int height);
+    void Thumbnail(cv::Mat& gray, int width);
+    void FaceChip(const cv::Rect& rect, cv::Mat& gray, int size);
     int ResolutionType();
+
+    bool CreateRoiImage(const cv::Rect& rect);
+    void DestroyRoiImage();
 };
 typedef std::shared_ptr<ApiRaw> ApiRawPtr;
 
@@ -125,6 +162,7 @@ public:
 
 public:
     Image image;
+    Image roi;
     FaceRects faceRects;
 
     ApiMat(const FaceParam& faceParamRef, const SourceId& sourceId, FrameId frameId, Image& img, int devIndex, long long generatedAt, bool toBeBuffered, const cv::Mat& scenceImage = cv::Mat(), const FaceRects& faceRects = {});
@@ -135,8 +173,13 @@ public:
 
     void KeepScence(cv::cuda::Stream& stream);
     void KeepFace(cv::cuda::Stream& stream, cv::Mat& face, int x, int y, int width, int height);
+    void Thumbnail(cv::Mat& gray, int width);
+    void FaceChip(const cv::Rect& rect, cv::Mat& gray, int size);
     int ResolutionType();
 
+    bool CreateRoiImage(const cv::Rect& rect);
+    void DestroyRoiImage();
+
     void UpdatePortraitTrackId();
 };
 typedef std::shared_ptr<ApiMat> ApiMatPtr;
@@ -148,6 +191,7 @@ public:
 
 public:
     Image image;
+    Image roi;
 
     ApiGpuMat(const FaceParam& faceParamRef, const SourceId& sourceId, FrameId frameId, GpuMat& img, int devIndex, long long generatedAt, bool toBeBuffered);
     ~ApiGpuMat();
@@ -157,7 +201,12 @@ public:
 
     void KeepScence(cv::cuda::Stream& stream);
     void KeepFace(cv::cuda::Stream& stream, cv::Mat& face, int x, int y, int width, int height);
+    void Thumbnail(cv::Mat& gray, int width);
+    void FaceChip(const cv::Rect& rect, cv::Mat& gray, int size);
     int ResolutionType();
+
+    bool CreateRoiImage(const cv::Rect& rect);
+    void DestroyRoiImage();
 };
 typedef std::shared_ptr<ApiGpuMat> ApiGpuMatPtr;
 
@@ -165,7 +214,7 @@ class AnalyzeResult
 {
 public:
     AnalyzeResult(int devIndex, CaptureResultPtr& capture, FaceSdkImage* original, const FaceParam& faceParamRef)
-        : gpuIndex(devIndex), captureResultPtr(capture), alignedMat(), alignedImage(nullptr), faceParam(faceParamRef)
+        : gpuIndex(devIndex), captureResultPtr(capture), alignedMat(), alignedImage(nullptr), inflight(), ack(), faceParam(faceParamRef)
     {
         if (original)
         {
@@ -219,6 +268,8 @@ public:
     CaptureResultPtr captureResultPtr;
     cv::Mat alignedMat;
     FaceSdkImage* alignedImage;
+    std::shared_ptr<void> inflight; // held till the attributes are analyzed
+    FrameAckPtr ack;                // held till the result is emitted, the frame is acknowledged after all of its results
     const FaceParam& faceParam;
 
 private:
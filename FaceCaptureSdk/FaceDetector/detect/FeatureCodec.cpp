@@ -0,0 +1,421 @@
+
+#include "FeatureCodec.h"
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <immintrin.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+/**
+* @brief whether the cpu has AVX2, FMA and F16C and the os saves ymm registers \n
+* only FeatureCodecAvx2.cpp is built for AVX2, the kernels call it when this is true
+*/
+static bool DetectAvx2()
+{
+    unsigned int registers[4] = { 0 };
+#if defined(_MSC_VER)
+    __cpuid((int*)registers, 0);
+    if (registers[0] < 7)
+    {
+        return false;
+    }
+    __cpuid((int*)registers, 1);
+#else
+    if (!__get_cpuid(1, &registers[0], &registers[1], &registers[2], &registers[3]))
+    {
+        return false;
+    }
+#endif
+
+    // fma, osxsave, avx, f16c
+    const unsigned int features = (1u << 12) | (1u << 27) | (1u << 28) | (1u << 29);
+    if ((registers[2] & features) != features)
+    {
+        return false;
+    }
+
+    unsigned long long xcr0 = 0;
+#if defined(_MSC_VER)
+    xcr0 = _xgetbv(0);
+#else
+    unsigned int xcr0Low = 0, xcr0High = 0;
+    __asm__ __volatile__("xgetbv" : "=a"(xcr0Low), "=d"(xcr0High) : "c"(0));
+    xcr0 = ((unsigned long long)xcr0High << 32) | xcr0Low;
+#endif
+    if ((xcr0 & 6) != 6)
+    {
+        return false;
+    }
+
+#if defined(_MSC_VER)
+    __cpuidex((int*)registers, 7, 0);
+#else
+    if (!__get_cpuid_count(7, 0, &registers[0], &registers[1], &registers[2], &registers[3]))
+    {
+        return false;
+    }
+#endif
+    return (registers[1] & (1u << 5)) != 0;
+}
+
+// detected when the module is loaded, before any kernel runs
+static const bool AVX2_SUPPORTED = DetectAvx2();
+
+/**
+* @brief convert 4 halfs in the low 16 bits of each lane to floats with SSE2 \n
+* exponent is rebiased by multiplying 2^112, which also covers subnormals
+*/
+static inline __m128 HalfToFloat(__m128i half)
+{
+    __m128i expmant = _mm_and_si128(half, _mm_set1_epi32(0x7FFF));
+    __m128i sign = _mm_slli_epi32(_mm_xor_si128(half, expmant), 16);
+    __m128 scaled = _mm_mul_ps(_mm_castsi128_ps(_mm_slli_epi32(expmant, 13)), _mm_castsi128_ps(_mm_set1_epi32((254 - 15) << 23)));
+    __m128i infnan = _mm_and_si128(_mm_cmpgt_epi32(expmant, _mm_set1_epi32(0x7BFF)), _mm_set1_epi32(255 << 23));
+    return _mm_or_ps(scaled, _mm_castsi128_ps(_mm_or_si128(sign, infnan)));
+}
+
+bool FeatureCodec::Encode(int encoding, const std::vector<char>& raw, std::vector<char>& encoded)
+{
+    size_t dimension = raw.size() / sizeof(float);
+    if (dimension == 0)
+    {
+        return false;
+    }
+
+    std::vector<float> values(dimension);
+    memcpy(&values[0], &raw[0], dimension * sizeof(float));
+
+    switch (encoding)
+    {
+    case FEATURE_ENCODING_RAW:
+        encoded = raw;
+        return true;
+
+    case FEATURE_ENCODING_FLOAT16:
+        {
+            encoded.resize(dimension * sizeof(unsigned short));
+            unsigned short* halfs = (unsigned short*)&encoded[0];
+            for (size_t idx = 0; idx < dimension; ++idx)
+            {
+                halfs[idx] = ToFloat16(values[idx]);
+            }
+        }
+        return true;
+
+    case FEATURE_ENCODING_INT8:
+        {
+            // one scale for the whole vector
+            float maxValue = 0.0f;
+            for (size_t idx = 0; idx < dimension; ++idx)
+            {
+                maxValue = (std::max)(maxValue, std::fabs(values[idx]));
+            }
+            float scale = maxValue > 0.0f ? maxValue / 127.0f : 1.0f;
+
+            encoded.resize(sizeof(float) + dimension);
+            memcpy(&encoded[0], &scale, sizeof(float));
+            signed char* quantized = (signed char*)&encoded[sizeof(float)];
+            for (size_t idx = 0; idx < dimension; ++idx)
+            {
+                float value = std::floor(values[idx] / scale + 0.5f);
+                quantized[idx] = (signed char)(std::min)((std::max)(value, -127.0f), 127.0f);
+            }
+        }
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+bool FeatureCodec::Decode(int encoding, const std::vector<char>& encoded, std::vector<float>& feature)
+{
+    size_t dimension = Dimension(encoding, encoded.size());
+    if (dimension == 0)
+    {
+        return false;
+    }
+
+    feature.resize(dimension);
+    switch (encoding)
+    {
+    case FEATURE_ENCODING_RAW:
+        memcpy(&feature[0], &encoded[0], dimension * sizeof(float));
+        return true;
+
+    case FEATURE_ENCODING_FLOAT16:
+        {
+            const unsigned short* halfs = (const unsigned short*)&encoded[0];
+            for (size_t idx = 0; idx < dimension; ++idx)
+            {
+                feature[idx] = FromFloat16(halfs[idx]);
+            }
+        }
+        return true;
+
+    case FEATURE_ENCODING_INT8:
+        {
+            float scale = 0.0f;
+            memcpy(&scale, &encoded[0], sizeof(float));
+            const signed char* quantized = (const signed char*)&encoded[sizeof(float)];
+            for (size_t idx = 0; idx < dimension; ++idx)
+            {
+                feature[idx] = quantized[idx] * scale;
+            }
+        }
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+size_t FeatureCodec::Dimension(int encoding, size_t bytes)
+{
+    switch (encoding)
+    {
+    case FEATURE_ENCODING_RAW:
+        return bytes / sizeof(float);
+    case FEATURE_ENCODING_FLOAT16:
+        return bytes / sizeof(unsigned short);
+    case FEATURE_ENCODING_INT8:
+        return bytes > sizeof(float) ? bytes - sizeof(float) : 0;
+    default:
+        return 0;
+    }
+}
+
+float FeatureCodec::Similarity(int encoding, const std::vector<char>& a, const std::vector<char>& b)
+{
+    size_t dimension = Dimension(encoding, a.size());
+    if (dimension == 0 || a.size() != b.size())
+    {
+        return 0.0f;
+    }
+
+    double dot = 0.0, normA = 0.0, normB = 0.0;
+    switch (encoding)
+    {
+    case FEATURE_ENCODING_RAW:
+        {
+            const float* fa = (const float*)&a[0];
+            const float* fb = (const float*)&b[0];
+            dot = DotFloat(fa, fb, dimension);
+            normA = DotFloat(fa, fa, dimension);
+            normB = DotFloat(fb, fb, dimension);
+        }
+        break;
+
+    case FEATURE_ENCODING_FLOAT16:
+        {
+            const unsigned short* ha = (const unsigned short*)&a[0];
+            const unsigned short* hb = (const unsigned short*)&b[0];
+            dot = DotFloat16(ha, hb, dimension);
+            normA = DotFloat16(ha, ha, dimension);
+            normB = DotFloat16(hb, hb, dimension);
+        }
+        break;
+
+    case FEATURE_ENCODING_INT8:
+        {
+            // scales are cancelled by the norms
+            const signed char* qa = (const signed char*)&a[sizeof(float)];
+            const signed char* qb = (const signed char*)&b[sizeof(float)];
+            dot = DotInt8(qa, qb, dimension);
+            normA = DotInt8(qa, qa, dimension);
+            normB = DotInt8(qb, qb, dimension);
+        }
+        break;
+
+    default:
+        return 0.0f;
+    }
+
+    double norm = std::sqrt(normA * normB);
+    return norm > 0.0 ? (float)(dot / norm) : 0.0f;
+}
+
+float FeatureCodec::DotFloat(const float* a, const float* b, size_t dimension)
+{
+    if (AVX2_SUPPORTED)
+    {
+        return DotFloatAvx2(a, b, dimension);
+    }
+
+    size_t idx = 0;
+    __m128 sum4 = _mm_setzero_ps();
+    for (; idx + 4 <= dimension; idx += 4)
+    {
+        sum4 = _mm_add_ps(sum4, _mm_mul_ps(_mm_loadu_ps(a + idx), _mm_loadu_ps(b + idx)));
+    }
+
+    // horizontal sum
+    sum4 = _mm_add_ps(sum4, _mm_movehl_ps(sum4, sum4));
+    sum4 = _mm_add_ss(sum4, _mm_shuffle_ps(sum4, sum4, 1));
+    float sum = _mm_cvtss_f32(sum4);
+
+    for (; idx < dimension; ++idx)
+    {
+        sum += a[idx] * b[idx];
+    }
+    return sum;
+}
+
+float FeatureCodec::DotFloat16(const unsigned short* a, const unsigned short* b, size_t dimension)
+{
+    if (AVX2_SUPPORTED)
+    {
+        return DotFloat16Avx2(a, b, dimension);
+    }
+
+    size_t idx = 0;
+    __m128 sum4 = _mm_setzero_ps();
+    __m128i zero = _mm_setzero_si128();
+    for (; idx + 8 <= dimension; idx += 8)
+    {
+        __m128i va = _mm_loadu_si128((const __m128i*)(a + idx));
+        __m128i vb = _mm_loadu_si128((const __m128i*)(b + idx));
+        sum4 = _mm_add_ps(sum4, _mm_mul_ps(HalfToFloat(_mm_unpacklo_epi16(va, zero)), HalfToFloat(_mm_unpacklo_epi16(vb, zero))));
+        sum4 = _mm_add_ps(sum4, _mm_mul_ps(HalfToFloat(_mm_unpackhi_epi16(va, zero)), HalfToFloat(_mm_unpackhi_epi16(vb, zero))));
+    }
+
+    // horizontal sum
+    sum4 = _mm_add_ps(sum4, _mm_movehl_ps(sum4, sum4));
+    sum4 = _mm_add_ss(sum4, _mm_shuffle_ps(sum4, sum4, 1));
+    float sum = _mm_cvtss_f32(sum4);
+
+    for (; idx < dimension; ++idx)
+    {
+        sum += FromFloat16(a[idx]) * FromFloat16(b[idx]);
+    }
+    return sum;
+}
+
+int FeatureCodec::DotInt8(const signed char* a, const signed char* b, size_t dimension)
+{
+    if (AVX2_SUPPORTED)
+    {
+        return DotInt8Avx2(a, b, dimension);
+    }
+
+    size_t idx = 0;
+    __m128i sum4 = _mm_setzero_si128();
+    for (; idx + 16 <= dimension; idx += 16)
+    {
+        // sign extend to int16 by unpacking with itself and shifting
+        __m128i va = _mm_loadu_si128((const __m128i*)(a + idx));
+        __m128i vb = _mm_loadu_si128((const __m128i*)(b + idx));
+        __m128i aLow = _mm_srai_epi16(_mm_unpacklo_epi8(va, va), 8);
+        __m128i aHigh = _mm_srai_epi16(_mm_unpackhi_epi8(va, va), 8);
+        __m128i bLow = _mm_srai_epi16(_mm_unpacklo_epi8(vb, vb), 8);
+        __m128i bHigh = _mm_srai_epi16(_mm_unpackhi_epi8(vb, vb), 8);
+        sum4 = _mm_add_epi32(sum4, _mm_madd_epi16(aLow, bLow));
+        sum4 = _mm_add_epi32(sum4, _mm_madd_epi16(aHigh, bHigh));
+    }
+
+    // horizontal sum
+    sum4 = _mm_add_epi32(sum4, _mm_shuffle_epi32(sum4, _MM_SHUFFLE(1, 0, 3, 2)));
+    sum4 = _mm_add_epi32(sum4, _mm_shuffle_epi32(sum4, _MM_SHUFFLE(2, 3, 0, 1)));
+    int sum = _mm_cvtsi128_si32(sum4);
+
+    for (; idx < dimension; ++idx)
+    {
+        sum += a[idx] * b[idx];
+    }
+    return sum;
+}
+
+unsigned short FeatureCodec::ToFloat16(float value)
+{
+    unsigned int bits = 0;
+    memcpy(&bits, &value, sizeof(float));
+
+    unsigned int sign = (bits >> 16) & 0x8000;
+    unsigned int mantissa = bits & 0x7FFFFF;
+    int exponent = (int)((bits >> 23) & 0xFF);
+
+    if (exponent == 0xFF)
+    {
+        // inf or nan
+        return (unsigned short)(sign | 0x7C00 | (mantissa ? 0x200 : 0));
+    }
+
+    exponent = exponent - 127 + 15;
+    if (exponent >= 0x1F)
+    {
+        // overflow to inf
+        return (unsigned short)(sign | 0x7C00);
+    }
+
+    if (exponent <= 0)
+    {
+        // subnormal or zero
+        if (exponent < -10)
+        {
+            return (unsigned short)sign;
+        }
+        mantissa |= 0x800000;
+        int shift = 14 - exponent;
+        unsigned int half = mantissa >> shift;
+        if ((mantissa >> (shift - 1)) & 1)
+        {
+            half++;
+        }
+        return (unsigned short)(sign | half);
+    }
+
+    // rounding may carry into exponent, which is still right
+    unsigned int half = sign | (exponent << 10) | (mantissa >> 13);
+    if (mantissa & 0x1000)
+    {
+        half++;
+    }
+    return (unsigned short)half;
+}
+
+float FeatureCodec::FromFloat16(unsigned short value)
+{
+    unsigned int sign = (unsigned int)(value & 0x8000) << 16;
+    int exponent = (value >> 10) & 0x1F;
+    unsigned int mantissa = value & 0x3FF;
+
+    unsigned int bits = 0;
+    if (exponent == 0)
+    {
+        if (mantissa == 0)
+        {
+            bits = sign;
+        }
+        else
+        {
+            // normalize the subnormal
+            exponent = 1;
+            while (!(mantissa & 0x400))
+            {
+                mantissa <<= 1;
+                exponent--;
+            }
+            mantissa &= 0x3FF;
+            bits = sign | ((unsigned int)(exponent + 127 - 15) << 23) | (mantissa << 13);
+        }
+    }
+    else if (exponent == 0x1F)
+    {
+        bits = sign | 0x7F800000 | (mantissa << 13);
+    }
+    else
+    {
+        bits = sign | ((unsigned int)(exponent + 127 - 15) << 23) | (mantissa << 13);
+    }
+
+    float result = 0.0f;
+    memcpy(&result, &bits, sizeof(float));
+    return result;
+}
+
@@ -0,0 +1,58 @@
+
+#ifndef _FEATURECODEC_HEADER_H_
+#define _FEATURECODEC_HEADER_H_
+
+#include "FaceDetectCore.h"
+
+#include <cstddef>
+#include <vector>
+
+/**
+* @brief encodings of face feature and distance kernels \n
+* FEATURE_ENCODING_RAW     : float32 * dimension, as the sdk outputs
+* FEATURE_ENCODING_FLOAT16 : IEEE half * dimension
+* FEATURE_ENCODING_INT8    : float32 scale, then int8 * dimension, value = int8 * scale
+* kernels use AVX2, FMA and F16C when the cpu has them, SSE otherwise
+*/
+class FeatureCodec
+{
+public:
+    /**
+    * @brief encode the raw feature \n
+    */
+    static bool Encode(int encoding, const std::vector<char>& raw, std::vector<char>& encoded);
+
+    /**
+    * @brief decode the encoded feature to float32 \n
+    */
+    static bool Decode(int encoding, const std::vector<char>& encoded, std::vector<float>& feature);
+
+    /**
+    * @brief dimension of the encoded feature \n
+    */
+    static size_t Dimension(int encoding, size_t bytes);
+
+    /**
+    * @brief cosine similarity of two features with the same encoding \n
+    */
+    static float Similarity(int encoding, const std::vector<char>& a, const std::vector<char>& b);
+
+    static float DotFloat(const float* a, const float* b, size_t dimension);
+    static float DotFloat16(const unsigned short* a, const unsigned short* b, size_t dimension);
+    static int DotInt8(const signed char* a, const signed char* b, size_t dimension);
+
+    static unsigned short ToFloat16(float value);
+    static float FromFloat16(unsigned short value);
+
+private:
+    // FeatureCodecAvx2.cpp, the only file built with /arch:AVX2
+    static float DotFloatAvx2(const float* a, const float* b, size_t dimension);
+    static float DotFloat16Avx2(const unsigned short* a, const unsigned short* b, size_t dimension);
+    static int DotInt8Avx2(const signed char* a, const signed char* b, size_t dimension);
+
+private:
+    FeatureCodec();
+};
+
+#endif
+
@@ -0,0 +1,91 @@
+
+#include "FeatureCodec.h"
+
+// msvc builds this file with /arch:AVX2, other compilers get the instruction sets here
+#if !defined(_MSC_VER)
+#pragma GCC target("avx2,fma,f16c")
+#endif
+
+#include <immintrin.h>
+
+/**
+* @brief AVX2 kernels of FeatureCodec, called only when the cpu has AVX2, FMA and F16C \n
+* the upper halves of the ymm registers are cleared before returning to the SSE code of the callers
+*/
+float FeatureCodec::DotFloatAvx2(const float* a, const float* b, size_t dimension)
+{
+    size_t idx = 0;
+    __m256 sum8 = _mm256_setzero_ps();
+    for (; idx + 8 <= dimension; idx += 8)
+    {
+        sum8 = _mm256_fmadd_ps(_mm256_loadu_ps(a + idx), _mm256_loadu_ps(b + idx), sum8);
+    }
+    __m128 sum4 = _mm_add_ps(_mm256_castps256_ps128(sum8), _mm256_extractf128_ps(sum8, 1));
+    _mm256_zeroupper();
+
+    for (; idx + 4 <= dimension; idx += 4)
+    {
+        sum4 = _mm_add_ps(sum4, _mm_mul_ps(_mm_loadu_ps(a + idx), _mm_loadu_ps(b + idx)));
+    }
+
+    // horizontal sum
+    sum4 = _mm_add_ps(sum4, _mm_movehl_ps(sum4, sum4));
+    sum4 = _mm_add_ss(sum4, _mm_shuffle_ps(sum4, sum4, 1));
+    float sum = _mm_cvtss_f32(sum4);
+
+    for (; idx < dimension; ++idx)
+    {
+        sum += a[idx] * b[idx];
+    }
+    return sum;
+}
+
+float FeatureCodec::DotFloat16Avx2(const unsigned short* a, const unsigned short* b, size_t dimension)
+{
+    size_t idx = 0;
+    __m256 sum8 = _mm256_setzero_ps();
+    for (; idx + 8 <= dimension; idx += 8)
+    {
+        __m256 va = _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)(a + idx)));
+        __m256 vb = _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)(b + idx)));
+        sum8 = _mm256_fmadd_ps(va, vb, sum8);
+    }
+    __m128 sum4 = _mm_add_ps(_mm256_castps256_ps128(sum8), _mm256_extractf128_ps(sum8, 1));
+    _mm256_zeroupper();
+
+    // horizontal sum
+    sum4 = _mm_add_ps(sum4, _mm_movehl_ps(sum4, sum4));
+    sum4 = _mm_add_ss(sum4, _mm_shuffle_ps(sum4, sum4, 1));
+    float sum = _mm_cvtss_f32(sum4);
+
+    for (; idx < dimension; ++idx)
+    {
+        sum += FromFloat16(a[idx]) * FromFloat16(b[idx]);
+    }
+    return sum;
+}
+
+int FeatureCodec::DotInt8Avx2(const signed char* a, const signed char* b, size_t dimension)
+{
+    size_t idx = 0;
+    __m256i sum8 = _mm256_setzero_si256();
+    for (; idx + 16 <= dimension; idx += 16)
+    {
+        __m256i va = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)(a + idx)));
+        __m256i vb = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)(b + idx)));
+        sum8 = _mm256_add_epi32(sum8, _mm256_madd_epi16(va, vb));
+    }
+    __m128i sum4 = _mm_add_epi32(_mm256_castsi256_si128(sum8), _mm256_extracti128_si256(sum8, 1));
+    _mm256_zeroupper();
+
+    // horizontal sum
+    sum4 = _mm_add_epi32(sum4, _mm_shuffle_epi32(sum4, _MM_SHUFFLE(1, 0, 3, 2)));
+    sum4 = _mm_add_epi32(sum4, _mm_shuffle_epi32(sum4, _MM_SHUFFLE(2, 3, 0, 1)));
+    int sum = _mm_cvtsi128_si32(sum4);
+
+    for (; idx < dimension; ++idx)
+    {
+        sum += a[idx] * b[idx];
+    }
+    return sum;
+}
@@ -0,0 +1,157 @@
+
+#include "FeatureIndex.h"
+#include "FeatureCodec.h"
+#include "TimeStamp.h"
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+#define GLOG_NO_ABBREVIATED_SEVERITIES
+#define GOOGLE_GLOG_DLL_DECL
+#include "glog/logging.h"
+
+FeatureIndex::FeatureIndex(float threshold, int window, int shardNumber, int reportInterval)
+    : _locker(), _shards(), _dimension(0)
+    , _threshold(threshold), _window((std::max)(window, 1)), _shardSpan((std::max)(_window / (std::max)(shardNumber, 1), 1))
+    , _reportInterval(reportInterval), _lastReportTime(TimeStamp<MILLISECONDS>::Now())
+    , _checkedNumber(0), _suppressedNumber(0), _replacedNumber(0)
+{
+}
+
+FeatureIndex::~FeatureIndex()
+{
+}
+
+bool FeatureIndex::Deduplicate(const CaptureResultPtr& captureResultPtr, bool keepBetter)
+{
+    std::vector<float> normalized;
+    if (!Normalize(captureResultPtr->faceBox.feature, normalized))
+    {
+        return false;
+    }
+
+    const SourceId& sourceId = captureResultPtr->sourceId;
+    float quality = captureResultPtr->faceBox.keypointsConfidence;
+    long long now = TimeStamp<MILLISECONDS>::Now();
+
+    AUTOLOCK(_locker);
+    Expire(now);
+    Report(now);
+
+    if (_shards.empty())
+    {
+        _dimension = normalized.size();
+    }
+    else if (normalized.size() != _dimension)
+    {
+        return false;
+    }
+    _checkedNumber++;
+
+    // search the most similar one from other sources
+    float bestSimilarity = -1.0f;
+    Shard* bestShard = nullptr;
+    size_t bestIndex = 0;
+    for (Shards::iterator it = _shards.begin(); it != _shards.end(); ++it)
+    {
+        Shard& shard = *it;
+        for (size_t idx = 0; idx < shard.entries.size(); ++idx)
+        {
+            if (shard.entries[idx].sourceId == sourceId)
+            {
+                continue;
+            }
+
+            float similarity = FeatureCodec::DotFloat(&normalized[0], &shard.features[idx * _dimension], _dimension);
+            if (similarity > bestSimilarity)
+            {
+                bestSimilarity = similarity;
+                bestShard = &shard;
+                bestIndex = idx;
+            }
+        }
+    }
+
+    if (bestShard && bestSimilarity >= _threshold)
+    {
+        Entry& entry = bestShard->entries[bestIndex];
+        if (keepBetter && quality > entry.quality)
+        {
+            // the better one takes the place
+            memcpy(&bestShard->features[bestIndex * _dimension], &normalized[0], _dimension * sizeof(float));
+            entry.sourceId = sourceId;
+            entry.quality = quality;
+            _replacedNumber++;
+            return false;
+        }
+
+        _suppressedNumber++;
+        return true;
+    }
+
+    if (_shards.empty() || now - _shards.back().startTime >= _shardSpan)
+    {
+        _shards.push_back(Shard());
+        _shards.back().startTime = now;
+    }
+
+    Shard& shard = _shards.back();
+    Entry entry;
+    entry.sourceId = sourceId;
+    entry.quality = quality;
+    shard.entries.push_back(entry);
+    shard.features.insert(shard.features.end(), normalized.begin(), normalized.end());
+    return false;
+}
+
+bool FeatureIndex::Normalize(const std::vector<char>& feature, std::vector<float>& normalized)
+{
+    size_t dimension = feature.size() / sizeof(float);
+    if (dimension == 0)
+    {
+        return false;
+    }
+
+    normalized.resize(dimension);
+    memcpy(&normalized[0], &feature[0], dimension * sizeof(float));
+
+    float norm = std::sqrt(FeatureCodec::DotFloat(&normalized[0], &normalized[0], dimension));
+    if (!(norm > 0.0f))
+    {
+        return false;
+    }
+
+    for (size_t idx = 0; idx < dimension; ++idx)
+    {
+        normalized[idx] /= norm;
+    }
+    return true;
+}
+
+void FeatureIndex::Expire(long long now)
+{
+    while (!_shards.empty() && _shards.front().startTime + _shardSpan + _window <= now)
+    {
+        _shards.pop_front();
+    }
+}
+
+void FeatureIndex::Report(long long now)
+{
+    if (_reportInterval <= 0 || now - _lastReportTime < _reportInterval)
+    {
+        return;
+    }
+    _lastReportTime = now;
+
+    size_t entryNumber = 0;
+    for (Shards::iterator it = _shards.begin(); it != _shards.end(); ++it)
+    {
+        entryNumber += it->entries.size();
+    }
+
+    LOG(INFO) << "feature deduplication checked: " << _checkedNumber << ", suppressed: " << _suppressedNumber
+        << ", replaced: " << _replacedNumber << ", indexed: " << entryNumber << " in " << _shards.size() << " shards";
+}
+
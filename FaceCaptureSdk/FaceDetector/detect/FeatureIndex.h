@@ -0,0 +1,69 @@
+
+#ifndef _FEATUREINDEX_HEADER_H_
+#define _FEATUREINDEX_HEADER_H_
+
+#include "FaceSdkApi.h"
+
+#include <deque>
+#include <mutex>
+
+/**
+* @brief flat index of recent face features for cross source deduplication \n
+* features are taken as float vectors and normalized, so dot product is cosine similarity;
+* entries are kept in shards by arrival time, the whole shard is dropped when it leaves the window
+*/
+class FeatureIndex
+{
+public:
+    FeatureIndex(float threshold, int window, int shardNumber = 4, int reportInterval = 60000);
+    ~FeatureIndex();
+
+    /**
+    * @brief check the capture against recent captures of other sources \n
+    * @param keepBetter if the capture duplicates a worse one, it replaces the indexed one and is not suppressed
+    * @return true if the capture should be suppressed
+    */
+    bool Deduplicate(const CaptureResultPtr& captureResultPtr, bool keepBetter);
+
+private:
+    struct Entry
+    {
+        SourceId sourceId;
+        float quality = 0.0f;
+    };
+
+    struct Shard
+    {
+        long long startTime = 0;
+        std::vector<Entry> entries;
+        std::vector<float> features; // entries.size() * dimension
+    };
+    typedef std::deque<Shard> Shards;
+
+    static bool Normalize(const std::vector<char>& feature, std::vector<float>& normalized);
+
+    void Expire(long long now);
+    void Report(long long now);
+
+private:
+    std::mutex _locker;
+    Shards _shards;
+    size_t _dimension;
+
+    float _threshold;
+    int _window;
+    int _shardSpan;
+
+    int _reportInterval;
+    long long _lastReportTime;
+    long long _checkedNumber;
+    long long _suppressedNumber;
+    long long _replacedNumber;
+
+private:
+    FeatureIndex(const FeatureIndex&);
+    FeatureIndex& operator=(const FeatureIndex&);
+};
+
+#endif
+
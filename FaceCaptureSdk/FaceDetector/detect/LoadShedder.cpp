@@ -0,0 +1,154 @@
+
+#include "LoadShedder.h"
+#include "TimeStamp.h"
+
+#include <algorithm>
+
+#define GLOG_NO_ABBREVIATED_SEVERITIES
+#define GOOGLE_GLOG_DLL_DECL
+#include "glog/logging.h"
+
+LoadShedder::LoadShedder(float highWatermark, float lowWatermark, int evaluateInterval)
+    : _locker(), _shedStates(), _detectorReports()
+    , _priorities(), _level(0)
+    , _highWatermark(highWatermark), _lowWatermark(lowWatermark)
+    , _evaluateInterval(evaluateInterval), _lastEvaluateTime(0)
+    , _shedDetectNumber(0), _skippedFrameNumber(0), _droppedCaptureNumber(0)
+{
+}
+
+LoadShedder::~LoadShedder()
+{
+}
+
+void LoadShedder::Evaluate(const void* detector, float pressure, const std::vector<int>& priorities)
+{
+    long long now = TimeStamp<MILLISECONDS>::Now();
+
+    AUTOLOCK(_locker);
+    DetectorReport& detectorReport = _detectorReports[detector];
+    detectorReport.pressure = pressure;
+    detectorReport.priorities = priorities;
+
+    if (now - _lastEvaluateTime < _evaluateInterval)
+    {
+        return;
+    }
+    _lastEvaluateTime = now;
+
+    // the fullest detector decides, priority classes are ranked over the sources of all detectors
+    pressure = 0.0f;
+    std::vector<int> sortedPriorities;
+    for (DetectorReports::iterator it = _detectorReports.begin(); it != _detectorReports.end(); ++it)
+    {
+        pressure = (std::max)(pressure, it->second.pressure);
+        sortedPriorities.insert(sortedPriorities.end(), it->second.priorities.begin(), it->second.priorities.end());
+    }
+    std::sort(sortedPriorities.begin(), sortedPriorities.end());
+    sortedPriorities.erase(std::unique(sortedPriorities.begin(), sortedPriorities.end()), sortedPriorities.end());
+    _priorities.swap(sortedPriorities);
+
+    int maxLevel = (int)_priorities.size() * SHED_ACTION_NUMBER;
+    int level = (std::min)(_level, maxLevel);
+    if (pressure >= _highWatermark && level < maxLevel)
+    {
+        level++;
+    }
+    else if (pressure <= _lowWatermark && level > 0)
+    {
+        level--;
+    }
+
+    if (level != _level)
+    {
+        if (level > _level)
+        {
+            int step = level - 1;
+            LOG(WARNING) << "load shedding level: " << _level << " -> " << level << ", pressure: " << pressure
+                << ", start to " << ActionName(step % SHED_ACTION_NUMBER + 1) << " for priority " << _priorities[step / SHED_ACTION_NUMBER];
+        }
+        else
+        {
+            LOG(WARNING) << "load shedding level: " << _level << " -> " << level << ", pressure: " << pressure;
+        }
+        LOG(WARNING) << "load shedding total, shed detects: " << _shedDetectNumber << ", skipped frames: " << _skippedFrameNumber
+            << ", dropped captures: " << _droppedCaptureNumber;
+
+        _level = level;
+    }
+}
+
+bool LoadShedder::Admit(ApiImagePtr& apiImagePtr)
+{
+    AUTOLOCK(_locker);
+    int action = Action(apiImagePtr->faceParam.priority);
+    if (action == SHED_NONE)
+    {
+        return true;
+    }
+
+    ShedState& shedState = _shedStates[apiImagePtr->sourceId];
+    if (action >= SHED_SKIP_FRAME && (shedState.frameNumber++ & 1))
+    {
+        _skippedFrameNumber++;
+        return false;
+    }
+
+    if (apiImagePtr->needetect && (shedState.detectNumber++ & 1))
+    {
+        apiImagePtr->needetect = false;
+        _shedDetectNumber++;
+    }
+
+    return true;
+}
+
+bool LoadShedder::AdmitCapture(const ApiImagePtr& apiImagePtr)
+{
+    AUTOLOCK(_locker);
+    if (Action(apiImagePtr->faceParam.priority) >= SHED_DROP_CAPTURE)
+    {
+        _droppedCaptureNumber += apiImagePtr->sdkBoxes.size();
+        return false;
+    }
+    return true;
+}
+
+void LoadShedder::Remove(const SourceId& sourceId)
+{
+    AUTOLOCK(_locker);
+    _shedStates.erase(sourceId);
+}
+
+void LoadShedder::RemoveDetector(const void* detector)
+{
+    AUTOLOCK(_locker);
+    _detectorReports.erase(detector);
+}
+
+int LoadShedder::Action(int priority)
+{
+    if (_level <= 0)
+    {
+        return SHED_NONE;
+    }
+
+    int index = (int)(std::lower_bound(_priorities.begin(), _priorities.end(), priority) - _priorities.begin());
+    return (std::min)((std::max)(_level - index * SHED_ACTION_NUMBER, (int)SHED_NONE), (int)SHED_ACTION_NUMBER);
+}
+
+const char* LoadShedder::ActionName(int action)
+{
+    switch (action)
+    {
+    case SHED_DETECT_INTERVAL:
+        return "raise detect interval";
+    case SHED_SKIP_FRAME:
+        return "skip frames";
+    case SHED_DROP_CAPTURE:
+        return "drop captures";
+    default:
+        return "none";
+    }
+}
+
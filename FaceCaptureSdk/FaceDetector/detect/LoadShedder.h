@@ -0,0 +1,102 @@
+
+#ifndef _LOADSHEDDER_HEADER_H_
+#define _LOADSHEDDER_HEADER_H_
+
+#include "FaceSdkApi.h"
+
+#include <map>
+#include <mutex>
+
+/**
+* @brief admission controller for overloaded detectors \n
+* one instance is shared by the detectors of all devices, each reports the usage of its fullest stage buffer;
+* shedding level goes up when the fullest buffer of them is above high watermark
+* and goes down when it is below low watermark, each level adds one action
+* to the lowest priority class of all sources which is not fully shed:
+* raise detect interval, then skip frames, then drop captures
+*/
+class LoadShedder
+{
+public:
+    enum ShedAction
+    {
+        SHED_NONE = 0,
+        SHED_DETECT_INTERVAL,   // detect every second frame that needs to be detected
+        SHED_SKIP_FRAME,        // skip every second frame
+        SHED_DROP_CAPTURE,      // drop all captures
+        SHED_ACTION_NUMBER = SHED_DROP_CAPTURE
+    };
+
+public:
+    LoadShedder(float highWatermark = 0.8f, float lowWatermark = 0.3f, int evaluateInterval = 500);
+    ~LoadShedder();
+
+    /**
+    * @brief report the load of a detector and update shedding level \n
+    * @param detector   the reporting detector
+    * @param pressure   usage of its fullest stage buffer, [0.0, 1.0]
+    * @param priorities priority classes of its current sources
+    */
+    void Evaluate(const void* detector, float pressure, const std::vector<int>& priorities);
+
+    /**
+    * @brief forget the load of a stopped detector \n
+    */
+    void RemoveDetector(const void* detector);
+
+    /**
+    * @brief admit one decoded frame \n
+    * may clear its detect flag, return false if the frame should be skipped
+    */
+    bool Admit(ApiImagePtr& apiImagePtr);
+
+    /**
+    * @brief check if captures of the image should be generated \n
+    */
+    bool AdmitCapture(const ApiImagePtr& apiImagePtr);
+
+    void Remove(const SourceId& sourceId);
+
+private:
+    struct ShedState
+    {
+        long long frameNumber = 0;
+        long long detectNumber = 0;
+    };
+    typedef std::map<SourceId, ShedState> ShedStates;
+
+    struct DetectorReport
+    {
+        float pressure = 0.0f;
+        std::vector<int> priorities;
+    };
+    typedef std::map<const void*, DetectorReport> DetectorReports;
+
+    int Action(int priority);
+
+    static const char* ActionName(int action);
+
+private:
+    std::mutex _locker;
+    ShedStates _shedStates;
+    DetectorReports _detectorReports;
+
+    std::vector<int> _priorities;
+    int _level;
+
+    float _highWatermark;
+    float _lowWatermark;
+    int _evaluateInterval;
+    long long _lastEvaluateTime;
+
+    long long _shedDetectNumber;
+    long long _skippedFrameNumber;
+    long long _droppedCaptureNumber;
+
+private:
+    LoadShedder(const LoadShedder&);
+    LoadShedder& operator=(const LoadShedder&);
+};
+
+#endif
+
@@ -0,0 +1,82 @@
+
+#include "MotionGate.h"
+#include "TimeStamp.h"
+
+#define GLOG_NO_ABBREVIATED_SEVERITIES
+#define GOOGLE_GLOG_DLL_DECL
+#include "glog/logging.h"
+
+MotionGate::MotionGate()
+    : _locker(), _motionStates()
+{
+}
+
+MotionGate::~MotionGate()
+{
+}
+
+bool MotionGate::Pass(ApiImagePtr& apiImagePtr)
+{
+    const FaceParam& faceParam = apiImagePtr->faceParam;
+    if (!faceParam.motion_gate)
+    {
+        return true;
+    }
+
+    cv::Mat thumbnail;
+    apiImagePtr->Thumbnail(thumbnail, THUMBNAIL_WIDTH);
+    if (thumbnail.empty())
+    {
+        return true;
+    }
+
+    long long now = TimeStamp<MILLISECONDS>::Now();
+
+    AUTOLOCK(_locker);
+    MotionState& motionState = _motionStates[apiImagePtr->sourceId];
+
+    bool moved = HasMotion(motionState.thumbnail, thumbnail, faceParam);
+    motionState.thumbnail = thumbnail;
+
+    if (moved || (faceParam.motion_force_interval > 0 && now - motionState.lastDetectTime >= faceParam.motion_force_interval))
+    {
+        motionState.lastDetectTime = now;
+        return true;
+    }
+
+    if (++motionState.skippedNumber % 1000 == 0)
+    {
+        LOG(INFO) << "source(" << apiImagePtr->sourceId << ") skipped " << motionState.skippedNumber << " static frames by motion gate";
+    }
+    return false;
+}
+
+void MotionGate::Remove(const SourceId& sourceId)
+{
+    AUTOLOCK(_locker);
+    _motionStates.erase(sourceId);
+}
+
+bool MotionGate::HasMotion(const cv::Mat& last, const cv::Mat& current, const FaceParam& faceParam)
+{
+    // first frame or resolution changed
+    if (last.empty() || last.size() != current.size())
+    {
+        return true;
+    }
+
+    cv::Rect region((int)(faceParam.motion_region_x * current.cols), (int)(faceParam.motion_region_y * current.rows),
+        (int)(faceParam.motion_region_width * current.cols), (int)(faceParam.motion_region_height * current.rows));
+    region &= cv::Rect(0, 0, current.cols, current.rows);
+    if (region.area() <= 0)
+    {
+        return true;
+    }
+
+    cv::Mat diff;
+    cv::absdiff(last(region), current(region), diff);
+    cv::threshold(diff, diff, faceParam.motion_pixel_threshold, 255, cv::THRESH_BINARY);
+
+    return cv::countNonZero(diff) >= faceParam.motion_threshold * region.area();
+}
+
@@ -0,0 +1,49 @@
+
+#ifndef _MOTIONGATE_HEADER_H_
+#define _MOTIONGATE_HEADER_H_
+
+#include "FaceSdkApi.h"
+
+#include <map>
+#include <mutex>
+
+/**
+* @brief cheap cpu motion check in front of detector \n
+* compare down-sampled gray frame with last checked frame of same source,
+* frames without motion in motion region do not need to be detected
+*/
+class MotionGate
+{
+public:
+    static const int THUMBNAIL_WIDTH = 160;
+
+public:
+    MotionGate();
+    ~MotionGate();
+
+    bool Pass(ApiImagePtr& apiImagePtr);
+
+    void Remove(const SourceId& sourceId);
+
+private:
+    struct MotionState
+    {
+        cv::Mat thumbnail;
+        long long lastDetectTime = 0;
+        long long skippedNumber = 0;
+    };
+    typedef std::map<SourceId, MotionState> MotionStates;
+
+    bool HasMotion(const cv::Mat& last, const cv::Mat& current, const FaceParam& faceParam);
+
+private:
+    std::mutex _locker;
+    MotionStates _motionStates;
+
+private:
+    MotionGate(const MotionGate&);
+    MotionGate& operator=(const MotionGate&);
+};
+
+#endif
+
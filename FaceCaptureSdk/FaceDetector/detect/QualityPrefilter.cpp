@@ -0,0 +1,122 @@
+
+#include "QualityPrefilter.h"
+#include "TimeStamp.h"
+
+#define GLOG_NO_ABBREVIATED_SEVERITIES
+#define GOOGLE_GLOG_DLL_DECL
+#include "glog/logging.h"
+
+QualityPrefilter::QualityPrefilter(int chipSize, int reportInterval)
+    : _locker(), _statistics()
+    , _chipSize(chipSize), _reportInterval(reportInterval), _lastReportTime(TimeStamp<MILLISECONDS>::Now())
+{
+}
+
+QualityPrefilter::~QualityPrefilter()
+{
+}
+
+bool QualityPrefilter::Filter(ApiImagePtr& apiImagePtr)
+{
+    const FaceParam& faceParam = apiImagePtr->faceParam;
+    FaceSdkBoxes& sdkBoxes = apiImagePtr->sdkBoxes;
+    if ((faceParam.prefilter_clarity < 0.0f && faceParam.prefilter_brightness < 0.0f) || sdkBoxes.empty())
+    {
+        return !sdkBoxes.empty();
+    }
+
+    long long blurryNumber = 0, darkNumber = 0;
+    FaceSdkBoxes passedSdkBoxes;
+    passedSdkBoxes.reserve(sdkBoxes.size());
+    for (size_t idx = 0; idx < sdkBoxes.size(); ++idx)
+    {
+        const FaceSdkBox& sdkBox = sdkBoxes[idx];
+
+        cv::Mat gray;
+        apiImagePtr->FaceChip(cv::Rect(sdkBox.x, sdkBox.y, sdkBox.width, sdkBox.height), gray, _chipSize);
+        if (gray.empty())
+        {
+            // can not be scored on cpu, leave it to the sdk
+            passedSdkBoxes.push_back(sdkBox);
+            continue;
+        }
+
+        float clarity = 0.0f, brightness = 0.0f;
+        Score(gray, clarity, brightness);
+
+        if (faceParam.prefilter_brightness >= 0.0f && brightness < faceParam.prefilter_brightness)
+        {
+            darkNumber++;
+        }
+        else if (faceParam.prefilter_clarity >= 0.0f && clarity < faceParam.prefilter_clarity)
+        {
+            blurryNumber++;
+        }
+        else
+        {
+            passedSdkBoxes.push_back(sdkBox);
+        }
+    }
+
+    {
+        AUTOLOCK(_locker);
+        SourceStatistic& sourceStatistic = _statistics[apiImagePtr->sourceId];
+        if (!sourceStatistic.checkedMetric)
+        {
+            std::string labels = "source=\"" + apiImagePtr->sourceId + "\"";
+            sourceStatistic.checkedMetric = MetricsRegistry::Counter("prefilter_faces_total", labels);
+            sourceStatistic.blurryMetric = MetricsRegistry::Counter("prefilter_rejected_faces_total", labels + ",reason=\"blurry\"");
+            sourceStatistic.darkMetric = MetricsRegistry::Counter("prefilter_rejected_faces_total", labels + ",reason=\"dark\"");
+        }
+        sourceStatistic.checkedMetric->Add(sdkBoxes.size());
+        sourceStatistic.blurryMetric->Add(blurryNumber);
+        sourceStatistic.darkMetric->Add(darkNumber);
+
+        Statistic& statistic = sourceStatistic.statistic;
+        statistic.sourceId = apiImagePtr->sourceId;
+        statistic.checkedNumber += sdkBoxes.size();
+        statistic.blurryNumber += blurryNumber;
+        statistic.darkNumber += darkNumber;
+
+        Report();
+    }
+
+    sdkBoxes.swap(passedSdkBoxes);
+    return !sdkBoxes.empty();
+}
+
+void QualityPrefilter::Remove(const SourceId& sourceId)
+{
+    AUTOLOCK(_locker);
+    _statistics.erase(sourceId);
+}
+
+void QualityPrefilter::Score(const cv::Mat& gray, float& clarity, float& brightness)
+{
+    // both are vectorized by opencv
+    cv::Mat laplacian;
+    cv::Laplacian(gray, laplacian, CV_16S);
+
+    cv::Scalar mean, stddev;
+    cv::meanStdDev(laplacian, mean, stddev);
+    clarity = (float)(stddev[0] * stddev[0]);
+    brightness = (float)(cv::mean(gray)[0] / 255.0);
+}
+
+void QualityPrefilter::Report()
+{
+    long long now = TimeStamp<MILLISECONDS>::Now();
+    if (_reportInterval <= 0 || now - _lastReportTime < _reportInterval)
+    {
+        return;
+    }
+    _lastReportTime = now;
+
+    for (SourceStatistics::iterator it = _statistics.begin(); it != _statistics.end(); ++it)
+    {
+        const Statistic& statistic = it->second.statistic;
+        LOG(INFO) << "source(" << statistic.sourceId << ") prefilter faces: " << statistic.checkedNumber
+            << ", rejected blurry: " << statistic.blurryNumber << ", rejected dark: " << statistic.darkNumber;
+    }
+}
+
@@ -0,0 +1,74 @@
+
+#ifndef _QUALITYPREFILTER_HEADER_H_
+#define _QUALITYPREFILTER_HEADER_H_
+
+#include "FaceSdkApi.h"
+#include "Metrics.h"
+
+#include <map>
+#include <mutex>
+
+/**
+* @brief cpu quality prefilter of tracked faces \n
+* scores the downsampled gray chip of each face box by laplacian variance (clarity)
+* and mean luminance (brightness), rejects hopeless faces before they take
+* badness, keypoint, align and extract batch slots; faces scored and rejected of each source
+* are counted in MetricsRegistry, rejected ones by reason
+*/
+class QualityPrefilter
+{
+public:
+    struct Statistic
+    {
+        SourceId sourceId;
+        long long checkedNumber = 0;    // faces scored
+        long long blurryNumber = 0;     // faces rejected by prefilter_clarity
+        long long darkNumber = 0;       // faces rejected by prefilter_brightness
+    };
+
+public:
+    QualityPrefilter(int chipSize = 64, int reportInterval = 60000);
+    ~QualityPrefilter();
+
+    /**
+    * @brief remove the hopeless faces from sdkBoxes of the image \n
+    * @return false if no face is left
+    */
+    bool Filter(ApiImagePtr& apiImagePtr);
+
+    void Remove(const SourceId& sourceId);
+
+    /**
+    * @brief score one gray chip \n
+    * @param clarity    variance of laplacian
+    * @param brightness mean luminance, [0.0, 1.0]
+    */
+    static void Score(const cv::Mat& gray, float& clarity, float& brightness);
+
+private:
+    struct SourceStatistic
+    {
+        Statistic statistic;
+        MetricCounter* checkedMetric = nullptr;
+        MetricCounter* blurryMetric = nullptr;
+        MetricCounter* darkMetric = nullptr;
+    };
+    typedef std::map<SourceId, SourceStatistic> SourceStatistics;
+
+    void Report();
+
+private:
+    std::mutex _locker;
+    SourceStatistics _statistics;
+
+    int _chipSize;
+    int _reportInterval;
+    long long _lastReportTime;
+
+private:
+    QualityPrefilter(const QualityPrefilter&);
+    QualityPrefilter& operator=(const QualityPrefilter&);
+};
+
+#endif
+
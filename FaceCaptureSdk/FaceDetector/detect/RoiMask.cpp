@@ -0,0 +1,103 @@
+
+#include "RoiMask.h"
+
+bool RoiMask::BoundingRect(const FaceParam& faceParam, const cv::Size& frameSize, cv::Rect& rect)
+{
+    cv::Rect frameRect(0, 0, frameSize.width, frameSize.height);
+    cv::Rect bounding;
+    bool included = false;
+    for (size_t idx = 0; idx < faceParam.rois.size(); ++idx)
+    {
+        const FaceRoi& faceRoi = faceParam.rois[idx];
+        if (faceRoi.exclude || faceRoi.points.size() < 6)
+        {
+            continue;
+        }
+
+        std::vector<cv::Point2f> polygon;
+        ToPolygon(faceRoi, frameSize, polygon);
+        cv::Rect polygonRect = cv::boundingRect(polygon);
+        bounding = included ? (bounding | polygonRect) : polygonRect;
+        included = true;
+    }
+
+    if (!included)
+    {
+        rect = frameRect;
+        return false;
+    }
+
+    // keep even offset and size for image codec
+    bounding &= frameRect;
+    bounding.x &= ~1;
+    bounding.y &= ~1;
+    bounding.width = (bounding.width + 1) & ~1;
+    bounding.height = (bounding.height + 1) & ~1;
+    rect = bounding & frameRect;
+
+    return rect.area() > 0 && rect != frameRect;
+}
+
+bool RoiMask::Contains(const FaceParam& faceParam, const cv::Size& frameSize, const FaceSdkBox& faceSdkBox)
+{
+    cv::Point2f center(faceSdkBox.x + faceSdkBox.width * 0.5f, faceSdkBox.y + faceSdkBox.height * 0.5f);
+
+    bool hasInclude = false, included = false;
+    for (size_t idx = 0; idx < faceParam.rois.size(); ++idx)
+    {
+        const FaceRoi& faceRoi = faceParam.rois[idx];
+        if (faceRoi.points.size() < 6)
+        {
+            continue;
+        }
+
+        std::vector<cv::Point2f> polygon;
+        ToPolygon(faceRoi, frameSize, polygon);
+        bool inside = cv::pointPolygonTest(polygon, center, false) >= 0;
+        if (faceRoi.exclude)
+        {
+            if (inside)
+            {
+                return false;
+            }
+        }
+        else
+        {
+            hasInclude = true;
+            included = included || inside;
+        }
+    }
+
+    return !hasInclude || included;
+}
+
+void RoiMask::Filter(const FaceParam& faceParam, const cv::Size& frameSize, FaceSdkBoxes& faceSdkBoxes)
+{
+    if (faceParam.rois.empty())
+    {
+        return;
+    }
+
+    FaceSdkBoxes::iterator it = faceSdkBoxes.begin();
+    while (it != faceSdkBoxes.end())
+    {
+        if (Contains(faceParam, frameSize, *it))
+        {
+            ++it;
+        }
+        else
+        {
+            it = faceSdkBoxes.erase(it);
+        }
+    }
+}
+
+void RoiMask::ToPolygon(const FaceRoi& faceRoi, const cv::Size& frameSize, std::vector<cv::Point2f>& polygon)
+{
+    polygon.reserve(faceRoi.points.size() / 2);
+    for (size_t idx = 0; idx + 1 < faceRoi.points.size(); idx += 2)
+    {
+        polygon.push_back(cv::Point2f(faceRoi.points[idx] * frameSize.width, faceRoi.points[idx + 1] * frameSize.height));
+    }
+}
+
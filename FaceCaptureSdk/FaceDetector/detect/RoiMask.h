@@ -0,0 +1,43 @@
+
+#ifndef _ROIMASK_HEADER_H_
+#define _ROIMASK_HEADER_H_
+
+#include "FaceSdkApi.h"
+
+/**
+* @brief region of interest of one source \n
+* include/exclude polygons are defined by FaceParam::rois relative to frame size
+*/
+class RoiMask
+{
+public:
+    /**
+    * @brief get the rectangle to be detected \n
+    * @param faceParam  capture rules of the source
+    * @param frameSize  frame resolution
+    * @param rect       bounding rectangle of all include regions
+    * @return true if rectangle is smaller than frame, that means frame should be cropped before detecting
+    */
+    static bool BoundingRect(const FaceParam& faceParam, const cv::Size& frameSize, cv::Rect& rect);
+
+    /**
+    * @brief check if the face center is inside include regions and outside exclude regions \n
+    */
+    static bool Contains(const FaceParam& faceParam, const cv::Size& frameSize, const FaceSdkBox& faceSdkBox);
+
+    /**
+    * @brief drop the faces which are not in regions of interest \n
+    */
+    static void Filter(const FaceParam& faceParam, const cv::Size& frameSize, FaceSdkBoxes& faceSdkBoxes);
+
+private:
+    static void ToPolygon(const FaceRoi& faceRoi, const cv::Size& frameSize, std::vector<cv::Point2f>& polygon);
+
+private:
+    RoiMask();
+    RoiMask(const RoiMask&);
+    RoiMask& operator=(const RoiMask&);
+};
+
+#endif
+
@@ -6,6 +6,10 @@
 
 #include "TimeStamp.h"
 #include "Performance.h"
+#include "ThreadAffinity.h"
+#include "AutoLock.h"
+
+#include <map>
 
 #define GLOG_NO_ABBREVIATED_SEVERITIES
 #define GOOGLE_GLOG_DLL_DECL
@@ -14,6 +18,101 @@
 #define HC_IN_BUFFER_SIZE 512
 #define HC_OUT_BUFFER_SIZE 1024*4
 
+std::mutex SnapDecodePool::_runLocker;
+std::mutex SnapDecodePool::_locker;
+std::condition_variable SnapDecodePool::_taskCondition;
+std::condition_variable SnapDecodePool::_doneCondition;
+std::vector<std::thread> SnapDecodePool::_workers;
+volatile bool SnapDecodePool::_running = false;
+const std::function<void(size_t)>* SnapDecodePool::_task = nullptr;
+size_t SnapDecodePool::_taskNumber = 0;
+std::atomic<size_t> SnapDecodePool::_nextTask(0);
+int SnapDecodePool::_busyNumber = 0;
+
+void SnapDecodePool::Run(size_t taskNumber, const std::function<void(size_t)>& task)
+{
+    if (taskNumber == 0)
+    {
+        return;
+    }
+
+    AUTOLOCK_1(_runLocker);
+    {
+        AUTOLOCK(_locker);
+        if (!_running && taskNumber > 1)
+        {
+            // the calling thread is one of the decoders
+            _running = true;
+            unsigned int threadNumber = (std::max)(std::thread::hardware_concurrency(), 2u) - 1;
+            for (unsigned int idx = 0; idx < threadNumber; ++idx)
+            {
+                _workers.push_back(std::thread(&SnapDecodePool::Work));
+            }
+        }
+
+        _task = &task;
+        _taskNumber = taskNumber;
+        _nextTask = 0;
+    }
+    WAKEUP_ALL(_taskCondition);
+
+    RunTasks();
+
+    // images taken by the workers may be still decoding, the task must not be used after return
+    WAIT_TILL_COND(_doneCondition, _locker, []{ return _busyNumber == 0; });
+    _task = nullptr;
+    _taskNumber = 0;
+}
+
+void SnapDecodePool::Destroy()
+{
+    AUTOLOCK_1(_runLocker);
+    {
+        AUTOLOCK(_locker);
+        _running = false;
+    }
+    WAKEUP_ALL(_taskCondition);
+
+    for (size_t idx = 0; idx < _workers.size(); ++idx)
+    {
+        WAIT_TO_EXIT(_workers[idx]);
+    }
+    _workers.clear();
+}
+
+void SnapDecodePool::Work()
+{
+    ThreadAffinity::Bind(THREAD_DECODER, -1);
+
+    while (true)
+    {
+        {
+            WAIT_TILL_COND(_taskCondition, _locker, []{ return !_running || (_task && _nextTask < _taskNumber); });
+            if (!_running)
+            {
+                break;
+            }
+            _busyNumber++;
+        }
+
+        RunTasks();
+
+        {
+            AUTOLOCK(_locker);
+            _busyNumber--;
+        }
+        WAKEUP_ALL(_doneCondition);
+    }
+}
+
+void SnapDecodePool::RunTasks()
+{
+    for (size_t idx = _nextTask++; idx < _taskNumber; idx = _nextTask++)
+    {
+        (*_task)(idx);
+    }
+}
+
 bool SnapMachine::DecodeFrame(const std::vector<unsigned char>& scence, cv::Mat& mat, const std::vector<FaceInfo>& faceInfos, std::vector<cv::Mat>& mats)
 {
     if (!scence.empty())
@@ -48,88 +147,136 @@ const int SnapMachine::GetGpuIndex() const
 
 bool SnapMachine::Snap(const ImageParam& imageParam)
 {
-    if (imageParam.scenceImage.size() > 0)
+    ApiImagePtrBuffer apiImageIPtrBuffer;
+    if (Prepare(imageParam, apiImageIPtrBuffer) != FEED_SUCCESS)
+    {
+        return false;
+    }
+
+    if (!apiImageIPtrBuffer.empty())
     {
-        cv::Mat scenceMat;
-        std::vector<cv::Mat> faceMats;
-        if (DecodeFrame(imageParam.scenceImage, scenceMat, imageParam.faceInfos, faceMats))
+        _faceDetector->PushOneDetect(apiImageIPtrBuffer, (int)apiImageIPtrBuffer.size());
+    }
+    return true;
+}
+
+void SnapMachine::SnapBatch(const std::vector<SnapMachine*>& snapMachines, const std::vector<ImageParam>& imageParams, std::vector<int>& results)
+{
+    size_t imageNumber = (std::min)(snapMachines.size(), imageParams.size());
+    results.assign(imageNumber, FEED_NO_CAMERA);
+
+    // decode in parallel
+    std::vector<ApiImagePtrBuffer> prepared(imageNumber);
+    SnapDecodePool::Run(imageNumber, [&](size_t idx)
+    {
+        if (snapMachines[idx])
         {
-            const std::vector<FaceInfo>& faceInfos = imageParam.faceInfos;
-            if (faceInfos.size() > 0)
-            {
-                cv::Mat canvasMat;
-                FaceRects faceRects;
-                FaceBoxIds faceBoxIds;
-                for (size_t idx = 0; idx < faceInfos.size(); ++idx)
-                {
-                    const FaceInfo& faceInfo = faceInfos[idx];
+            results[idx] = snapMachines[idx]->Prepare(imageParams[idx], prepared[idx]);
+        }
+    });
 
-                    cv::Mat facemat;
-                    // based on scence image
-                    if (faceInfo.faceImage.empty())
-                    {
-                        facemat = scenceMat(cv::Rect(faceInfo.x, faceInfo.y, faceInfo.width, faceInfo.height)).clone();
-                    }
-                    else // based on face image
-                    {
-                        facemat = faceMats[idx];                        
-                    }
+    // one push per detector, images keep their order in the batch
+    std::map<FaceDetector*, ApiImagePtrBuffer> detectorBuffers;
+    for (size_t idx = 0; idx < imageNumber; ++idx)
+    {
+        if (results[idx] == FEED_SUCCESS && !prepared[idx].empty())
+        {
+            ApiImagePtrBuffer& detectorBuffer = detectorBuffers[snapMachines[idx]->_faceDetector];
+            detectorBuffer.splice(detectorBuffer.end(), prepared[idx]);
+        }
+    }
+    for (std::map<FaceDetector*, ApiImagePtrBuffer>::iterator it = detectorBuffers.begin(); it != detectorBuffers.end(); ++it)
+    {
+        it->first->PushOneDetect(it->second, (int)it->second.size());
+    }
+}
 
-                    if (!facemat.empty())
-                    {
-                        if (_faceDetector->GetDeviceIndex() < 0)
-                        {
-                            ApiImagePtr apiImageIPtr = ApiImagePtr(new ApiMat(_faceParam, _id, imageParam.frameId, facemat, _faceDetector->GetDeviceIndex(), imageParam.timestamp, false, scenceMat));
-                            if (apiImageIPtr)
-                            {
-                                apiImageIPtr->portrait = true;
-                                apiImageIPtr->faceBoxIds.push_back(faceInfo.id);
-                                _faceDetector->PushOneDetect(ApiImagePtrBuffer{ apiImageIPtr }, 1);
-                            }
-                        }
-                        else
-                        {
-                            // GPU mode, we use scence image size canvas
-                            if (canvasMat.empty())
-                            {
-                                canvasMat = scenceMat.clone();
-                                canvasMat.setTo(cv::Scalar(0, 0, 0));
-                            }
-                            if (!canvasMat.empty() && facemat.cols <= canvasMat.cols && facemat.rows <= canvasMat.rows)
-                            {
-                                cv::Rect rect(faceInfo.x >= 0 ? faceInfo.x : 0, faceInfo.y >= 0 ? faceInfo.y : 0, facemat.cols, facemat.rows);
-                                facemat.copyTo(canvasMat(rect));
-                                faceRects.push_back(rect);
-                                faceBoxIds.push_back(faceInfo.id);
-                            }
-                        }
-                    }
-                }
+int SnapMachine::Prepare(const ImageParam& imageParam, std::list<ApiImagePtr>& apiImageIPtrBuffer)
+{
+    if (imageParam.scenceImage.empty())
+    {
+        return FEED_EMPTY_IMAGE;
+    }
+
+    cv::Mat scenceMat;
+    std::vector<cv::Mat> faceMats;
+    if (!DecodeFrame(imageParam.scenceImage, scenceMat, imageParam.faceInfos, faceMats))
+    {
+        return FEED_DECODE_FAILED;
+    }
 
-                if (!canvasMat.empty() && !faceRects.empty())
+    const std::vector<FaceInfo>& faceInfos = imageParam.faceInfos;
+    if (faceInfos.size() > 0)
+    {
+        cv::Mat canvasMat;
+        FaceRects faceRects;
+        FaceBoxIds faceBoxIds;
+        for (size_t idx = 0; idx < faceInfos.size(); ++idx)
+        {
+            const FaceInfo& faceInfo = faceInfos[idx];
+
+            cv::Mat facemat;
+            // based on scence image
+            if (faceInfo.faceImage.empty())
+            {
+                facemat = scenceMat(cv::Rect(faceInfo.x, faceInfo.y, faceInfo.width, faceInfo.height)).clone();
+            }
+            else // based on face image
+            {
+                facemat = faceMats[idx];                        
+            }
+
+            if (!facemat.empty())
+            {
+                if (_faceDetector->GetDeviceIndex() < 0)
                 {
-                    ApiImagePtr apiImageIPtr = ApiImagePtr(new ApiMat(_faceParam, _id, imageParam.frameId, canvasMat, _faceDetector->GetDeviceIndex(), imageParam.timestamp, false, scenceMat, faceRects));
+                    ApiImagePtr apiImageIPtr = ApiImagePtr(new ApiMat(_faceParam, _id, imageParam.frameId, facemat, _faceDetector->GetDeviceIndex(), imageParam.timestamp, false, scenceMat));
                     if (apiImageIPtr)
                     {
                         apiImageIPtr->portrait = true;
-                        apiImageIPtr->faceBoxIds.swap(faceBoxIds);
-                        _faceDetector->PushOneDetect(ApiImagePtrBuffer{ apiImageIPtr }, 1);
+                        apiImageIPtr->faceBoxIds.push_back(faceInfo.id);
+                        apiImageIPtrBuffer.push_back(apiImageIPtr);
                     }
                 }
-            } 
-            else
-            {
-                ApiImagePtr apiImageIPtr = ApiImagePtr(new ApiMat(_faceParam, _id, imageParam.frameId, scenceMat, _faceDetector->GetDeviceIndex(), imageParam.timestamp, false));
-                if (apiImageIPtr)
+                else
                 {
-                    _faceDetector->PushOneDetect(ApiImagePtrBuffer{ apiImageIPtr }, 1);
+                    // GPU mode, we use scence image size canvas
+                    if (canvasMat.empty())
+                    {
+                        canvasMat = scenceMat.clone();
+                        canvasMat.setTo(cv::Scalar(0, 0, 0));
+                    }
+                    if (!canvasMat.empty() && facemat.cols <= canvasMat.cols && facemat.rows <= canvasMat.rows)
+                    {
+                        cv::Rect rect(faceInfo.x >= 0 ? faceInfo.x : 0, faceInfo.y >= 0 ? faceInfo.y : 0, facemat.cols, facemat.rows);
+                        facemat.copyTo(canvasMat(rect));
+                        faceRects.push_back(rect);
+                        faceBoxIds.push_back(faceInfo.id);
+                    }
                 }
             }
-            
-            return true;
+        }
+
+        if (!canvasMat.empty() && !faceRects.empty())
+        {
+            ApiImagePtr apiImageIPtr = ApiImagePtr(new ApiMat(_faceParam, _id, imageParam.frameId, canvasMat, _faceDetector->GetDeviceIndex(), imageParam.timestamp, false, scenceMat, faceRects));
+            if (apiImageIPtr)
+            {
+                apiImageIPtr->portrait = true;
+                apiImageIPtr->faceBoxIds.swap(faceBoxIds);
+                apiImageIPtrBuffer.push_back(apiImageIPtr);
+            }
+        }
+    } 
+    else
+    {
+        ApiImagePtr apiImageIPtr = ApiImagePtr(new ApiMat(_faceParam, _id, imageParam.frameId, scenceMat, _faceDetector->GetDeviceIndex(), imageParam.timestamp, false));
+        if (apiImageIPtr)
+        {
+            apiImageIPtrBuffer.push_back(apiImageIPtr);
         }
     }
-    return false;
+    return FEED_SUCCESS;
 }
 
 int SnapMachine::Init()
@@ -7,6 +7,13 @@
 #include "SnapStruct.h"
 
 #include <string>
+#include <list>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 #include "HCNetSDK.h"
 
@@ -35,12 +42,25 @@ public:
 
     bool Snap(const ImageParam& imageParam);
 
+    /**
+    * @brief decode images of a batch in parallel on SnapDecodePool, then push them to every detector at once \n
+    * @param snapMachines camera of every image, nullptr if the camera is not found
+    * @param results FEED_SUCCESS or the reason of every image
+    */
+    static void SnapBatch(const std::vector<SnapMachine*>& snapMachines, const std::vector<ImageParam>& imageParams, std::vector<int>& results);
+
 protected:
     virtual int Init();
     virtual void Uninit();
     
     bool DecodeFrame(const std::vector<unsigned char>& scence, cv::Mat& mat, const std::vector<FaceInfo>& faceInfos, std::vector<cv::Mat>& mats);
 
+    /**
+    * @brief decode one image and make the images to be detected \n
+    * @return FEED_SUCCESS or the reason
+    */
+    int Prepare(const ImageParam& imageParam, std::list<ApiImagePtr>& apiImageIPtrBuffer);
+
 private:
     friend BOOL CALLBACK HCSnapCallback(LONG lCommand, NET_DVR_ALARMER *pAlarmer, char *pAlarmInfo, DWORD dwBufLen, void* pUser);
 
@@ -55,6 +75,44 @@ private:
     SnapMachine& operator=(const SnapMachine&);
 };
 
+/**
+* @brief decoder threads of batched snapshots, started by the first batch and kept till DetectDestroy \n
+* snapshots are small, so starting threads for every batch would cost as much as decoding them;
+* the workers and the calling thread share a batch, every one takes the next image
+*/
+class SnapDecodePool
+{
+public:
+    /**
+    * @brief call task(0 .. taskNumber - 1) on the workers and the calling thread, return when all are done \n
+    * batches of concurrent callers run one after another
+    */
+    static void Run(size_t taskNumber, const std::function<void(size_t)>& task);
+    static void Destroy();
+
+protected:
+    static void Work();
+    static void RunTasks();
+
+protected:
+    static std::mutex _runLocker;
+    static std::mutex _locker;
+    static std::condition_variable _taskCondition;
+    static std::condition_variable _doneCondition;
+    static std::vector<std::thread> _workers;
+    static volatile bool _running;
+
+    static const std::function<void(size_t)>* _task;
+    static size_t _taskNumber;
+    static std::atomic<size_t> _nextTask;
+    static int _busyNumber;    // workers in the current batch
+
+private:
+    SnapDecodePool();
+    SnapDecodePool(const SnapDecodePool&);
+    SnapDecodePool& operator=(const SnapDecodePool&);
+};
+
 class LoginSnapMachine : public SnapMachine
 {
 public:
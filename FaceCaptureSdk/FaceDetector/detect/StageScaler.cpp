@@ -0,0 +1,160 @@
+#include "StageScaler.h"
+#include "ThreadAffinity.h"
+
+#include <algorithm>
+
+#define GLOG_NO_ABBREVIATED_SEVERITIES
+#define GOOGLE_GLOG_DLL_DECL
+#include "glog/logging.h"
+
+static const char* StageName(int stage)
+{
+    static const char* STAGE_NAMES[STAGE_NUMBER] = { "detect", "track", "evaluate", "keypoint", "align", "analyze", "extract" };
+    return stage >= 0 && stage < STAGE_NUMBER ? STAGE_NAMES[stage] : "unknown";
+}
+
+StageScaler::StageScaler(const ScaleParam& scaleParam, int firstStage, int lastStage, StageTimes stageTimes, ScaleStage scaleStage, void* context)
+    : _scaleParam(scaleParam)
+    , _stageTimes(stageTimes), _scaleStage(scaleStage), _context(context)
+    , _scaler(), _scaling(false), _scaleLocker(), _scaleCondition()
+    , _sampleLocker(), _stageSamples()
+{
+    _scaleParam.interval = (std::max)(_scaleParam.interval, 100);
+    _scaleParam.maxThreadCount = (std::max)(_scaleParam.maxThreadCount, 1);
+
+    for (int stage = firstStage; stage <= lastStage; ++stage)
+    {
+        StageSample stageSample;
+        stageSample.stage = stage;
+        _stageSamples.push_back(stageSample);
+    }
+}
+
+StageScaler::~StageScaler()
+{
+    Stop();
+}
+
+void StageScaler::Start()
+{
+    if (!_scaling)
+    {
+        // take current times as the base of the first sample
+        for (size_t idx = 0; idx < _stageSamples.size(); ++idx)
+        {
+            StageSample& stageSample = _stageSamples[idx];
+            int threadCount = 0;
+            _stageTimes(_context, stageSample.stage, threadCount, stageSample.busyMicroseconds, stageSample.totalMicroseconds);
+        }
+
+        _scaling = true;
+        _scaler = std::thread(&StageScaler::Scale, this);
+    }
+}
+
+void StageScaler::Stop()
+{
+    if (_scaling)
+    {
+        _scaling = false;
+        WAKEUP_ALL(_scaleCondition);
+    }
+    WAIT_TO_EXIT(_scaler);
+}
+
+void StageScaler::GetStatistics(std::vector<StageStatistic>& stageStatistics)
+{
+    stageStatistics.clear();
+
+    AUTOLOCK(_sampleLocker);
+    for each (const StageSample& stageSample in _stageSamples)
+    {
+        StageStatistic stageStatistic;
+        stageStatistic.stage = stageSample.stage;
+        long long busyMicroseconds = 0, totalMicroseconds = 0;
+        if (_stageTimes(_context, stageSample.stage, stageStatistic.threadCount, busyMicroseconds, totalMicroseconds))
+        {
+            stageStatistic.utilization = stageSample.utilization;
+            stageStatistics.push_back(stageStatistic);
+        }
+    }
+}
+
+void StageScaler::Scale()
+{
+    ThreadAffinity::Bind(THREAD_SERVICE, -1);
+
+    while (_scaling)
+    {
+        {
+            WAIT_MILLISEC_TILL_COND(_scaleCondition, _scaleLocker, _scaleParam.interval, [this](){ return !_scaling; });
+        }
+
+        if (_scaling)
+        {
+            Sample();
+        }
+    }
+}
+
+void StageScaler::Sample()
+{
+    for (size_t idx = 0; idx < _stageSamples.size(); ++idx)
+    {
+        int stage = 0, threadCount = 0;
+        float utilization = 0.0f;
+        bool scaled = false;
+        {
+            AUTOLOCK(_sampleLocker);
+            StageSample& stageSample = _stageSamples[idx];
+            long long busyMicroseconds = 0, totalMicroseconds = 0;
+            if (!_stageTimes(_context, stageSample.stage, threadCount, busyMicroseconds, totalMicroseconds))
+            {
+                continue;
+            }
+
+            // no work finished in the interval, keep the base till there is
+            long long totalElapsed = totalMicroseconds - stageSample.totalMicroseconds;
+            if (totalElapsed <= 0)
+            {
+                continue;
+            }
+
+            long long busyElapsed = busyMicroseconds - stageSample.busyMicroseconds;
+            stageSample.utilization = (std::min)((std::max)((float)busyElapsed / totalElapsed, 0.0f), 1.0f);
+            stageSample.busyMicroseconds = busyMicroseconds;
+            stageSample.totalMicroseconds = totalMicroseconds;
+
+            stage = stageSample.stage;
+            utilization = stageSample.utilization;
+            scaled = stageSample.scaled;
+            stageSample.scaled = false;
+        }
+
+        if (!_scaleParam.autoscale || scaled || threadCount <= 0)
+        {
+            continue;
+        }
+
+        int scaledThreadCount = threadCount;
+        if (utilization > _scaleParam.highUtilization && threadCount < _scaleParam.maxThreadCount)
+        {
+            scaledThreadCount = threadCount + 1;
+        }
+        else if (utilization < _scaleParam.lowUtilization && threadCount > 1)
+        {
+            scaledThreadCount = threadCount - 1;
+        }
+
+        if (scaledThreadCount != threadCount)
+        {
+            bool result = _scaleStage(_context, stage, scaledThreadCount);
+            LOG(INFO) << "autoscale " << StageName(stage) << " workers " << threadCount << " -> " << scaledThreadCount
+                << ", utilization: " << utilization << (result ? "" : ", failed");
+
+            AUTOLOCK(_sampleLocker);
+            _stageSamples[idx].scaled = true;
+        }
+    }
+}
+
@@ -0,0 +1,82 @@
+
+#ifndef _STAGESCALER_HEADER_H_
+#define _STAGESCALER_HEADER_H_
+
+#include "FaceDetectCore.h"
+#include "FaceCaptureStruct.h"
+
+#include "AutoLock.h"
+
+#include <vector>
+
+/**
+* @brief worker stage sampler and autoscaler \n
+* utilization of a stage is busy time of its workers (time not spent waiting for a batch)
+* divided by their running time since the last sample; when scaleParam.autoscale is set
+* one worker is added to or retired from a stage per sample, a scaled stage is not scaled
+* again in the next sample since its new workers have not run a full interval
+*/
+class StageScaler
+{
+public:
+    /**
+    * @brief get running workers and their cumulative times of one stage \n
+    * times of retired workers should be kept in the sums
+    * @return false if the stage is not enabled
+    */
+    typedef bool(*StageTimes)(void* context, int stage, int& threadCount, long long& busyMicroseconds, long long& totalMicroseconds);
+
+    /**
+    * @brief set running workers of one stage \n
+    * @return false if the workers could not be set
+    */
+    typedef bool(*ScaleStage)(void* context, int stage, int threadCount);
+
+public:
+    StageScaler(const ScaleParam& scaleParam, int firstStage, int lastStage, StageTimes stageTimes, ScaleStage scaleStage, void* context);
+    ~StageScaler();
+
+    void Start();
+    void Stop();
+
+    /**
+    * @brief get utilization of the latest sample and current workers of each enabled stage \n
+    */
+    void GetStatistics(std::vector<StageStatistic>& stageStatistics);
+
+private:
+    struct StageSample
+    {
+        int stage = STAGE_DETECT;
+        long long busyMicroseconds = 0;
+        long long totalMicroseconds = 0;
+        float utilization = 0.0f;
+        bool scaled = false;
+    };
+    typedef std::vector<StageSample> StageSamples;
+
+    void Scale();
+    void Sample();
+
+private:
+    ScaleParam _scaleParam;
+
+    StageTimes _stageTimes;
+    ScaleStage _scaleStage;
+    void* _context;
+
+    std::thread _scaler;
+    volatile bool _scaling;
+    std::mutex _scaleLocker;
+    std::condition_variable _scaleCondition;
+
+    std::mutex _sampleLocker;
+    StageSamples _stageSamples;
+
+private:
+    StageScaler(const StageScaler&);
+    StageScaler& operator=(const StageScaler&);
+};
+
+#endif
+
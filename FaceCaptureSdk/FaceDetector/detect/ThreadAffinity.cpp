@@ -0,0 +1,133 @@
+#include "ThreadAffinity.h"
+
+#include <cstring>
+
+#include <windows.h>
+
+std::mutex ThreadAffinity::_locker;
+AffinityParam ThreadAffinity::_affinityParam;
+int ThreadAffinity::_gpuCount = 0;
+volatile int ThreadAffinity::_generation = 0;
+
+void ThreadAffinity::Configure(const AffinityParam& affinityParam, int gpuCount)
+{
+    AUTOLOCK(_locker);
+    _affinityParam = affinityParam;
+    _gpuCount = gpuCount;
+    ++_generation;
+}
+
+int ThreadAffinity::Generation()
+{
+    return _generation;
+}
+
+int ThreadAffinity::Bind(int role, int deviceIndex)
+{
+    int policy = AFFINITY_NONE;
+    {
+        AUTOLOCK(_locker);
+        switch (role)
+        {
+        case THREAD_DECODER:
+            policy = _affinityParam.decoder;
+            break;
+        case THREAD_ASYNC:
+            policy = _affinityParam.async;
+            break;
+        case THREAD_WORKER:
+            policy = _affinityParam.worker;
+            break;
+        case THREAD_CALLBACK:
+            policy = _affinityParam.callback;
+            break;
+        case THREAD_SERVICE:
+            policy = _affinityParam.service;
+            break;
+        default:
+            break;
+        }
+    }
+
+    int node = -1;
+    if (policy == AFFINITY_DEVICE)
+    {
+        node = DeviceNode(deviceIndex);
+    }
+    else if (policy >= 0 && policy < NodeNumber())
+    {
+        node = policy;
+    }
+    return BindNode(node) ? node : -1;
+}
+
+bool ThreadAffinity::BindNode(int node)
+{
+    if (node < 0)
+    {
+        return true;
+    }
+
+    GROUP_AFFINITY groupAffinity;
+    memset(&groupAffinity, 0, sizeof(groupAffinity));
+    if (!GetNumaNodeProcessorMaskEx((USHORT)node, &groupAffinity) || groupAffinity.Mask == 0)
+    {
+        return false;
+    }
+    return SetThreadGroupAffinity(GetCurrentThread(), &groupAffinity, nullptr) != FALSE;
+}
+
+bool ThreadAffinity::Unbind()
+{
+    DWORD_PTR processMask = 0, systemMask = 0;
+    return GetProcessAffinityMask(GetCurrentProcess(), &processMask, &systemMask)
+        && SetThreadAffinityMask(GetCurrentThread(), processMask) != 0;
+}
+
+int ThreadAffinity::DeviceNode(int deviceIndex)
+{
+    if (deviceIndex < 0)
+    {
+        return -1;
+    }
+
+    int nodeNumber = NodeNumber();
+
+    AUTOLOCK(_locker);
+    if (deviceIndex < (int)_affinityParam.deviceNodes.size())
+    {
+        int node = _affinityParam.deviceNodes[deviceIndex];
+        return node < nodeNumber ? node : -1;
+    }
+
+    // gpus are usually attached to sockets in index order, 0 and 1 to node 0, 2 and 3 to node 1 ...
+    if (_gpuCount > deviceIndex)
+    {
+        return deviceIndex * nodeNumber / _gpuCount;
+    }
+    return deviceIndex % nodeNumber;
+}
+
+int ThreadAffinity::CurrentNode()
+{
+    PROCESSOR_NUMBER processorNumber;
+    GetCurrentProcessorNumberEx(&processorNumber);
+
+    USHORT node = 0;
+    if (!GetNumaProcessorNodeEx(&processorNumber, &node))
+    {
+        return -1;
+    }
+    return node;
+}
+
+int ThreadAffinity::NodeNumber()
+{
+    ULONG highestNode = 0;
+    if (!GetNumaHighestNodeNumber(&highestNode))
+    {
+        return 1;
+    }
+    return (int)highestNode + 1;
+}
+
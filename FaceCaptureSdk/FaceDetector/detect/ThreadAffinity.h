@@ -0,0 +1,60 @@
+
+#ifndef _THREADAFFINITY_HEADER_H_
+#define _THREADAFFINITY_HEADER_H_
+
+#include "FaceDetectCore.h"
+
+#include "AutoLock.h"
+
+/**
+* @brief thread placement by role \n
+* a thread binds itself when it starts, so the policy should be configured before
+* decoders and detectors are created; threads started earlier can compare Generation()
+* and bind again when it changes
+*/
+class ThreadAffinity
+{
+public:
+    /**
+    * @brief set placement policy \n
+    * @param gpuCount gpus spread over numa nodes in order when affinityParam.deviceNodes is not set
+    */
+    static void Configure(const AffinityParam& affinityParam, int gpuCount);
+
+    static int Generation();
+
+    /**
+    * @brief bind current thread by the policy of its role \n
+    * AFFINITY_NONE leaves the affinity untouched, it may be set by the host process
+    * @return numa node bound, -1 if the thread is not bound
+    */
+    static int Bind(int role, int deviceIndex);
+
+    /**
+    * @brief pin current thread to processors of node, node < 0 leaves the affinity untouched \n
+    */
+    static bool BindNode(int node);
+
+    /**
+    * @brief let current thread float on the processors of the process again, after it was bound \n
+    */
+    static bool Unbind();
+
+    static int DeviceNode(int deviceIndex);
+    static int CurrentNode();
+    static int NodeNumber();
+
+private:
+    static std::mutex _locker;
+    static AffinityParam _affinityParam;
+    static int _gpuCount;
+    static volatile int _generation;
+
+private:
+    ThreadAffinity();
+    ThreadAffinity(const ThreadAffinity&);
+    ThreadAffinity& operator=(const ThreadAffinity&);
+};
+
+#endif
+
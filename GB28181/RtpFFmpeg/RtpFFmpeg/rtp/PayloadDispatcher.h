@@ -3,25 +3,10 @@
 #define _PAYLOADDISPATCHER_HEADER_H_
 
 #include "Composer.h"
+#include "RtpHeader.h"
 
 class PayloadDispatcher
 {
-private:
-    struct RTPHeader
-    {
-        uint8_t version : 2;
-        uint8_t padding : 1;
-        uint8_t extension : 1;
-        uint8_t csrccount : 4;
-
-        uint8_t marker : 1;
-        uint8_t payloadtype : 7;
-
-        uint16_t sequencenumber;
-        uint32_t timestamp;
-        uint32_t ssrc;
-    };
-
 public:
     PayloadDispatcher();
     ~PayloadDispatcher();
@@ -31,8 +16,6 @@ public:
 private:
     void Run();
 
-    unsigned char* Parse(RTPHeader* header, unsigned char* data, size_t size, size_t& newsize);
-
 private:
     struct PayLoadHandle
     {
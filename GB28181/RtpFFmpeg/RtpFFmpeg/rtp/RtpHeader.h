@@ -0,0 +1,96 @@
+
+#ifndef _RTPHEADER_HEADER_H_
+#define _RTPHEADER_HEADER_H_
+
+#include <cstddef>
+#include <cstdint>
+
+struct RTPHeader
+{
+    uint8_t version : 2;
+    uint8_t padding : 1;
+    uint8_t extension : 1;
+    uint8_t csrccount : 4;
+
+    uint8_t marker : 1;
+    uint8_t payloadtype : 7;
+
+    uint16_t sequencenumber;
+    uint32_t timestamp;
+    uint32_t ssrc;
+};
+
+/**
+* @brief parse the fixed header, csrc list and extension of a rtp packet (rfc 3550) \n
+* returns the payload inside data and its size in newsize, padding excluded, or nullptr for an invalid packet;
+* it keeps no state, so it is shared by the dispatcher and the benchmarks
+*/
+inline unsigned char* ParseRtpHeader(RTPHeader* header, unsigned char* data, size_t size, size_t& newsize)
+{
+    newsize = size;
+
+    if (size < 12)
+    {
+        //Too short to be a valid RTP header.
+        return nullptr;
+    }
+
+    header->version = data[0] >> 6;
+    if (header->version != 2)
+    {
+        //Currently, the version is 2, if is not 2, unsupported.
+        return nullptr;
+    }
+
+    header->padding = (data[0] >> 5) & 0x01;
+    if (header->padding)
+    {
+        // Padding present.
+        size_t paddingLength = data[newsize - 1];
+        if (paddingLength + 12 > newsize)
+        {
+            return nullptr;
+        }
+        newsize -= paddingLength;
+    }
+
+    header->marker = data[1] >> 7;
+    header->payloadtype = data[1] & 0x7F;
+
+    header->csrccount = data[0] & 0x0f;
+    size_t payloadOffset = 12 + 4 * header->csrccount;
+    if (newsize < payloadOffset)
+    {
+        // Not enough data to fit the basic header and all the CSRC entries.
+        return nullptr;
+    }
+
+    header->extension = (data[0] >> 4) & 0x01;
+    if (header->extension)
+    {
+        // Header extension present.
+        if (newsize < payloadOffset + 4)
+        {
+            // Not enough data to fit the basic header, all CSRC entries and the first 4 bytes of the extension header.
+            return nullptr;
+        }
+
+        const uint8_t *extensionData = (const uint8_t *)&data[payloadOffset];
+        size_t extensionLength = 4 * (extensionData[2] << 8 | extensionData[3]);
+        if (newsize < payloadOffset + 4 + extensionLength)
+        {
+            return nullptr;
+        }
+        payloadOffset += (4 + extensionLength);
+    }
+
+    header->timestamp = data[4] << 24 | data[5] << 16 | data[6] << 8 | data[7];
+    header->ssrc = data[8] << 24 | data[9] << 16 | data[10] << 8 | data[11];
+    header->sequencenumber = data[2] << 8 | data[3];
+
+    newsize -= payloadOffset;
+
+    return data + payloadOffset;
+}
+
+#endif
@@ -92,6 +92,8 @@ bool AsyncContext::FindAsyncDecoder(const std::string& id)
 
 void AsyncContext::RetrieveFrame()
 {
+    BindThread(THREAD_ASYNC, _gpuIndex);
+
     LOG(INFO) << "async context create success";
     while (_retrieving)
     {
@@ -33,12 +33,15 @@
 
 std::vector<FaceCaptureContext::FromParam> FaceCaptureContext::FromParams;
 std::vector<FaceCaptureContext::ToParam> FaceCaptureContext::ToParams;
+bool FaceCaptureContext::PlaceLeastLoaded = false;
+AffinityParam FaceCaptureContext::Affinity;
 
 std::mutex FaceCaptureContext::SnapMachinesLocker;
 std::map<std::string, SnapMachine*> FaceCaptureContext::SnapMachines;
 
 std::mutex FaceCaptureContext::SyncBaseDecodersLocker;
 std::map<std::string, BaseDecoder*> FaceCaptureContext::SyncBaseDecoders;
+std::map<std::string, FaceDetector*> FaceCaptureContext::SyncBaseDecoderDetectors;
 
 std::mutex FaceCaptureContext::AsyncContextsLocker;
 std::map<int, AsyncContext*> FaceCaptureContext::AsyncContexts;
@@ -346,6 +349,18 @@ bool FaceCaptureContext::ReadAnalyze(cJSON* parent, AnalyzeParam& analyzeParam)
         analyzeParam.analyze_age_ethnic = analyze_age_ethnic->type == cJSON_True ? true : false;
     }
 
+    cJSON* cache_size = cJSON_GetObjectItem(parent, "cache_size");
+    if (cache_size && cache_size->type == cJSON_Number)
+    {
+        analyzeParam.cacheSize = cache_size->valueint;
+    }
+
+    cJSON* cache_votes = cJSON_GetObjectItem(parent, "cache_votes");
+    if (cache_votes && cache_votes->type == cJSON_Number)
+    {
+        analyzeParam.cacheVotes = cache_votes->valueint;
+    }
+
     cJSON* buffer_size = cJSON_GetObjectItem(parent, "buffer_size");
     if (buffer_size && buffer_size->type == cJSON_Number)
     {
@@ -408,6 +423,335 @@ bool FaceCaptureContext::ReadExtract(cJSON* parent, ExtractParam& extractParam)
         extractParam.batchSize = batch_size->valueint <= 0 ? 1 : batch_size->valueint;
     }
 
+    cJSON* dedup_threshold = cJSON_GetObjectItem(parent, "dedup_threshold");
+    if (dedup_threshold && dedup_threshold->type == cJSON_Number)
+    {
+        extractParam.dedupThreshold = (float)dedup_threshold->valuedouble;
+    }
+
+    cJSON* dedup_window = cJSON_GetObjectItem(parent, "dedup_window");
+    if (dedup_window && dedup_window->type == cJSON_Number)
+    {
+        extractParam.dedupWindow = dedup_window->valueint;
+    }
+
+    cJSON* dedup_keep_better = cJSON_GetObjectItem(parent, "dedup_keep_better");
+    if (dedup_keep_better)
+    {
+        extractParam.dedupKeepBetter = dedup_keep_better->type == cJSON_True ? true : false;
+    }
+
+    cJSON* feature_encoding = cJSON_GetObjectItem(parent, "feature_encoding");
+    if (feature_encoding && feature_encoding->type == cJSON_String)
+    {
+        std::string encoding(feature_encoding->valuestring);
+        if (encoding == "float16")
+        {
+            extractParam.featureEncoding = FEATURE_ENCODING_FLOAT16;
+        }
+        else if (encoding == "int8")
+        {
+            extractParam.featureEncoding = FEATURE_ENCODING_INT8;
+        }
+        else
+        {
+            extractParam.featureEncoding = FEATURE_ENCODING_RAW;
+        }
+    }
+
+    return true;
+}
+
+bool FaceCaptureContext::ReadArchive(cJSON* parent, ArchiveParam& archiveParam)
+{
+    if (!parent)
+    {
+        return false;
+    }
+
+    cJSON* path = cJSON_GetObjectItem(parent, "path");
+    if (path && path->type == cJSON_String)
+    {
+        archiveParam.path = path->valuestring;
+    }
+
+    cJSON* segment_size = cJSON_GetObjectItem(parent, "segment_size");
+    if (segment_size && segment_size->type == cJSON_Number)
+    {
+        archiveParam.segmentSize = segment_size->valueint <= 0 ? 256 : segment_size->valueint;
+    }
+
+    cJSON* segment_number = cJSON_GetObjectItem(parent, "segment_number");
+    if (segment_number && segment_number->type == cJSON_Number)
+    {
+        archiveParam.segmentNumber = segment_number->valueint;
+    }
+
+    cJSON* buffer_size = cJSON_GetObjectItem(parent, "buffer_size");
+    if (buffer_size && buffer_size->type == cJSON_Number)
+    {
+        archiveParam.bufferSize = buffer_size->valueint;
+    }
+
+    cJSON* jpeg_quality = cJSON_GetObjectItem(parent, "jpeg_quality");
+    if (jpeg_quality && jpeg_quality->type == cJSON_Number)
+    {
+        archiveParam.jpegQuality = jpeg_quality->valueint;
+    }
+
+    cJSON* archive_scence = cJSON_GetObjectItem(parent, "archive_scence");
+    if (archive_scence)
+    {
+        archiveParam.archiveScence = archive_scence->type == cJSON_True ? true : false;
+    }
+
+    return true;
+}
+
+bool FaceCaptureContext::ReadSink(cJSON* parent, SinkParam& sinkParam)
+{
+    if (!parent)
+    {
+        return false;
+    }
+
+    cJSON* path = cJSON_GetObjectItem(parent, "path");
+    if (path && path->type == cJSON_String)
+    {
+        sinkParam.path = path->valuestring;
+    }
+
+    cJSON* buffer_size = cJSON_GetObjectItem(parent, "buffer_size");
+    if (buffer_size && buffer_size->type == cJSON_Number)
+    {
+        sinkParam.bufferSize = buffer_size->valueint;
+    }
+
+    cJSON* batch_size = cJSON_GetObjectItem(parent, "batch_size");
+    if (batch_size && batch_size->type == cJSON_Number)
+    {
+        sinkParam.batchSize = batch_size->valueint;
+    }
+
+    cJSON* batch_timeout = cJSON_GetObjectItem(parent, "batch_timeout");
+    if (batch_timeout && batch_timeout->type == cJSON_Number)
+    {
+        sinkParam.batchTimeout = batch_timeout->valueint;
+    }
+
+    cJSON* sync_write = cJSON_GetObjectItem(parent, "sync_write");
+    if (sync_write)
+    {
+        sinkParam.syncWrite = sync_write->type == cJSON_True ? true : false;
+    }
+
+    cJSON* spill_path = cJSON_GetObjectItem(parent, "spill_path");
+    if (spill_path && spill_path->type == cJSON_String)
+    {
+        sinkParam.spillPath = spill_path->valuestring;
+    }
+
+    cJSON* spill_size = cJSON_GetObjectItem(parent, "spill_size");
+    if (spill_size && spill_size->type == cJSON_Number)
+    {
+        sinkParam.spillSize = spill_size->valueint <= 0 ? 1024 : spill_size->valueint;
+    }
+
+    cJSON* jpeg_quality = cJSON_GetObjectItem(parent, "jpeg_quality");
+    if (jpeg_quality && jpeg_quality->type == cJSON_Number)
+    {
+        sinkParam.jpegQuality = jpeg_quality->valueint;
+    }
+
+    cJSON* sink_scence = cJSON_GetObjectItem(parent, "sink_scence");
+    if (sink_scence)
+    {
+        sinkParam.sinkScence = sink_scence->type == cJSON_True ? true : false;
+    }
+
+    return true;
+}
+
+bool FaceCaptureContext::ReadRing(cJSON* parent, RingParam& ringParam)
+{
+    if (!parent)
+    {
+        return false;
+    }
+
+    cJSON* name = cJSON_GetObjectItem(parent, "name");
+    if (name && name->type == cJSON_String)
+    {
+        ringParam.name = name->valuestring;
+    }
+
+    cJSON* slot_number = cJSON_GetObjectItem(parent, "slot_number");
+    if (slot_number && slot_number->type == cJSON_Number)
+    {
+        ringParam.slotNumber = slot_number->valueint <= 0 ? 128 : slot_number->valueint;
+    }
+
+    cJSON* slot_size = cJSON_GetObjectItem(parent, "slot_size");
+    if (slot_size && slot_size->type == cJSON_Number)
+    {
+        ringParam.slotSize = slot_size->valueint <= 0 ? 512 : slot_size->valueint;
+    }
+
+    cJSON* ring_scence = cJSON_GetObjectItem(parent, "ring_scence");
+    if (ring_scence)
+    {
+        ringParam.ringScence = ring_scence->type == cJSON_True ? true : false;
+    }
+
+    return true;
+}
+
+bool FaceCaptureContext::ReadScale(cJSON* parent, ScaleParam& scaleParam)
+{
+    if (!parent)
+    {
+        return false;
+    }
+
+    cJSON* autoscale = cJSON_GetObjectItem(parent, "autoscale");
+    if (autoscale)
+    {
+        scaleParam.autoscale = autoscale->type == cJSON_True ? true : false;
+    }
+
+    cJSON* interval = cJSON_GetObjectItem(parent, "interval");
+    if (interval && interval->type == cJSON_Number)
+    {
+        scaleParam.interval = interval->valueint <= 0 ? 5000 : interval->valueint;
+    }
+
+    cJSON* high_utilization = cJSON_GetObjectItem(parent, "high_utilization");
+    if (high_utilization && high_utilization->type == cJSON_Number)
+    {
+        scaleParam.highUtilization = (float)high_utilization->valuedouble;
+    }
+
+    cJSON* low_utilization = cJSON_GetObjectItem(parent, "low_utilization");
+    if (low_utilization && low_utilization->type == cJSON_Number)
+    {
+        scaleParam.lowUtilization = (float)low_utilization->valuedouble;
+    }
+
+    cJSON* max_thread_count = cJSON_GetObjectItem(parent, "max_thread_count");
+    if (max_thread_count && max_thread_count->type == cJSON_Number)
+    {
+        scaleParam.maxThreadCount = max_thread_count->valueint <= 0 ? 1 : max_thread_count->valueint;
+    }
+
+    return true;
+}
+
+bool FaceCaptureContext::ReadPlacement(cJSON* parent)
+{
+    if (!parent)
+    {
+        return false;
+    }
+
+    // device: sources go to the detector of decoder device_index
+    // least_loaded: sources go to the least loaded detector, see PlaceFaceDetector
+    cJSON* placement = cJSON_GetObjectItem(parent, "placement");
+    if (placement && placement->type == cJSON_String)
+    {
+        std::string value = placement->valuestring;
+        if (value == "least_loaded")
+        {
+            PlaceLeastLoaded = true;
+        }
+        else if (value == "device")
+        {
+            PlaceLeastLoaded = false;
+        }
+        else
+        {
+            ErrorHandler::ErrorStream << "placement configuration is not valid: " << value;
+            ErrorHandler::FlushLastErrorStream();
+
+            LOG(ERROR) << ErrorHandler::GetLastError();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool ReadAffinityPolicy(cJSON* parent, const char* name, int& policy)
+{
+    cJSON* item = cJSON_GetObjectItem(parent, name);
+    if (!item)
+    {
+        return true;
+    }
+
+    if (item->type == cJSON_Number && item->valueint >= 0)
+    {
+        policy = item->valueint;
+        return true;
+    }
+    else if (item->type == cJSON_String)
+    {
+        std::string value = item->valuestring;
+        if (value == "none")
+        {
+            policy = AFFINITY_NONE;
+            return true;
+        }
+        else if (value == "device")
+        {
+            policy = AFFINITY_DEVICE;
+            return true;
+        }
+    }
+
+    ErrorHandler::ErrorStream << "affinity " << name << " configuration is not valid";
+    ErrorHandler::FlushLastErrorStream();
+
+    LOG(ERROR) << ErrorHandler::GetLastError();
+    return false;
+}
+
+bool FaceCaptureContext::ReadAffinity(cJSON* parent)
+{
+    if (!parent)
+    {
+        return false;
+    }
+
+    // affinity is optional, threads float when it is not set
+    // none: float, device: numa node of the gpu the thread works for, number: numa node
+    cJSON* affinity = cJSON_GetObjectItem(parent, "affinity");
+    if (!affinity)
+    {
+        return true;
+    }
+
+    if (!ReadAffinityPolicy(affinity, "decoder", Affinity.decoder)
+        || !ReadAffinityPolicy(affinity, "async", Affinity.async)
+        || !ReadAffinityPolicy(affinity, "worker", Affinity.worker)
+        || !ReadAffinityPolicy(affinity, "callback", Affinity.callback)
+        || !ReadAffinityPolicy(affinity, "service", Affinity.service))
+    {
+        return false;
+    }
+
+    // numa node of each gpu, gpus are spread over nodes in index order when it is not set
+    cJSON* device_nodes = cJSON_GetObjectItem(affinity, "device_nodes");
+    if (device_nodes && device_nodes->type == cJSON_Array)
+    {
+        Affinity.deviceNodes.clear();
+        int arrSize = cJSON_GetArraySize(device_nodes);
+        for (int idx = 0; idx < arrSize; ++idx)
+        {
+            cJSON* device_node = cJSON_GetArrayItem(device_nodes, idx);
+            Affinity.deviceNodes.push_back(device_node && device_node->type == cJSON_Number ? device_node->valueint : -1);
+        }
+    }
+
     return true;
 }
 
@@ -468,6 +812,12 @@ bool FaceCaptureContext::ReadCaptures(cJSON* parent, const std::string& modelPat
                         fromParam.resultParam.bufferSize = 100;
                     }
 
+                    // archive is optional
+                    ReadArchive(cJSON_GetObjectItem(capture, "archive"), fromParam.resultParam.archiveParam);
+                    ReadSink(cJSON_GetObjectItem(capture, "sink"), fromParam.resultParam.sinkParam);
+                    ReadRing(cJSON_GetObjectItem(capture, "ring"), fromParam.resultParam.ringParam);
+                    ReadScale(cJSON_GetObjectItem(capture, "scale"), fromParam.scaleParam);
+
                     do
                     {
                         cJSON *detect = cJSON_GetObjectItem(capture, "detect");
@@ -626,6 +976,12 @@ bool FaceCaptureContext::ReadExtracts(cJSON* parent, const std::string& modelPat
                         toParam.resultParam.bufferSize = 100;
                     }
 
+                    // archive is optional
+                    ReadArchive(cJSON_GetObjectItem(extract, "archive"), toParam.resultParam.archiveParam);
+                    ReadSink(cJSON_GetObjectItem(extract, "sink"), toParam.resultParam.sinkParam);
+                    ReadRing(cJSON_GetObjectItem(extract, "ring"), toParam.resultParam.ringParam);
+                    ReadScale(cJSON_GetObjectItem(extract, "scale"), toParam.scaleParam);
+
                     do
                     {
                         if (!ReadExtract(extract, toParam.extractParam))
@@ -702,7 +1058,7 @@ bool FaceCaptureContext::ReadConfiguration(const char* path)
             cJSON *model_path = cJSON_GetObjectItem(jroot, "model_path");
             if (model_path && model_path->type == cJSON_String && strlen(model_path->valuestring) > 0)
             {
-                success = ReadCaptures(jroot, model_path->valuestring, path) && ReadExtracts(jroot, model_path->valuestring, path);
+                success = ReadPlacement(jroot) && ReadAffinity(jroot) && ReadCaptures(jroot, model_path->valuestring, path) && ReadExtracts(jroot, model_path->valuestring, path);
             }
             else
             {
@@ -738,7 +1094,7 @@ bool FaceCaptureContext::InitializeFaceExtractor(ToParam& toParam)
 {
     if (toParam.extractParam.threadCount > 0)
     {
-        FaceExtractor* faceExtractor = CreateExtractor(toParam.modelParam, toParam.extractParam, toParam.resultParam);
+        FaceExtractor* faceExtractor = CreateExtractor(toParam.modelParam, toParam.extractParam, toParam.resultParam, toParam.scaleParam);
         if (faceExtractor)
         {
             toParam.extractor = faceExtractor;
@@ -755,6 +1111,11 @@ bool FaceCaptureContext::InitializeFaceExtractor(ToParam& toParam)
     return true;
 }
 
+void FaceCaptureContext::InitializeAffinity()
+{
+    SetAffinity(Affinity);
+}
+
 bool FaceCaptureContext::InitializeFaceExtractors()
 {
     bool success = true;
@@ -802,7 +1163,7 @@ void FaceCaptureContext::UninitializeFaceExtractors()
 bool FaceCaptureContext::InitializeFaceDetector(FromParam& from, FaceExtractor* extractor)
 {
     FaceDetector* faceDetector = CreateDetector(from.modelParam, from.detectParam, from.trackParam, from.evaluateParam,
-        from.keypointParam, from.alignParam, from.analyzeParam, from.resultParam, extractor);
+        from.keypointParam, from.alignParam, from.analyzeParam, from.resultParam, extractor, from.scaleParam);
     if (faceDetector)
     {
         from.detector = faceDetector;
@@ -893,6 +1254,131 @@ FaceDetector* FaceCaptureContext::ChooseFaceDetector(int deviceIndex)
     return nullptr;
 }
 
+FaceDetector* FaceCaptureContext::PlaceFaceDetector(DecoderParam& decoderParam)
+{
+    if (!PlaceLeastLoaded)
+    {
+        return ChooseFaceDetector(decoderParam.device_index);
+    }
+
+    // frames decoded on gpu can only be detected on gpu, the decoder follows the chosen detector to its device
+    bool gpuDecode = decoderParam.device_index >= 0;
+
+    std::vector<FaceDetector*> detectors;
+    std::vector<DetectorLoad> detectorLoads;
+    DetectorLoad maxLoad;
+    for (size_t idx = 0; idx < FromParams.size(); ++idx)
+    {
+        FaceDetector* detector = FromParams[idx].detector;
+        if (detector)
+        {
+            DetectorLoad detectorLoad;
+            GetDetectorLoad(detector, detectorLoad);
+            if (gpuDecode && detectorLoad.deviceIndex < 0)
+            {
+                continue;
+            }
+
+            maxLoad.sourceNumber = (std::max)(maxLoad.sourceNumber, detectorLoad.sourceNumber);
+            maxLoad.queuedNumber = (std::max)(maxLoad.queuedNumber, detectorLoad.queuedNumber);
+            maxLoad.batchMilliseconds = (std::max)(maxLoad.batchMilliseconds, detectorLoad.batchMilliseconds);
+            maxLoad.pixelRate = (std::max)(maxLoad.pixelRate, detectorLoad.pixelRate);
+
+            detectors.push_back(detector);
+            detectorLoads.push_back(detectorLoad);
+        }
+    }
+
+    // each measure is scaled by the largest one of all detectors, so they weigh the same
+    FaceDetector* placed = nullptr;
+    float placedScore = 0.0f;
+    for (size_t idx = 0; idx < detectors.size(); ++idx)
+    {
+        const DetectorLoad& detectorLoad = detectorLoads[idx];
+        float score = 0.0f;
+        score += maxLoad.sourceNumber > 0 ? (float)detectorLoad.sourceNumber / maxLoad.sourceNumber : 0.0f;
+        score += maxLoad.queuedNumber > 0 ? (float)detectorLoad.queuedNumber / maxLoad.queuedNumber : 0.0f;
+        score += maxLoad.batchMilliseconds > 0.0f ? detectorLoad.batchMilliseconds / maxLoad.batchMilliseconds : 0.0f;
+        score += maxLoad.pixelRate > 0.0f ? detectorLoad.pixelRate / maxLoad.pixelRate : 0.0f;
+        score += detectorLoad.bufferUsage;
+        if (!placed || score < placedScore)
+        {
+            placed = detectors[idx];
+            placedScore = score;
+            if (gpuDecode)
+            {
+                decoderParam.device_index = detectorLoad.deviceIndex;
+            }
+        }
+    }
+    return placed;
+}
+
+void FaceCaptureContext::GetDetectorLoads(std::vector<DetectorLoad>& detectorLoads)
+{
+    for (size_t idx = 0; idx < FromParams.size(); ++idx)
+    {
+        if (FromParams[idx].detector)
+        {
+            DetectorLoad detectorLoad;
+            GetDetectorLoad(FromParams[idx].detector, detectorLoad);
+            detectorLoads.push_back(detectorLoad);
+        }
+    }
+}
+
+bool FaceCaptureContext::SetStageThreads(int deviceIndex, int stage, int threadCount)
+{
+    FaceDetector* detector = ChooseFaceDetector(deviceIndex);
+    for each (FromParam from in FromParams)
+    {
+        if (detector && from.detector == detector)
+        {
+            if (stage != STAGE_EXTRACT)
+            {
+                return ScaleStage(detector, stage, threadCount);
+            }
+
+            // extract stage belongs to the extract instance of the capture
+            for each (ToParam to in ToParams)
+            {
+                if (to.name == from.extractName && to.extractor)
+                {
+                    return ScaleStage(to.extractor, stage, threadCount);
+                }
+            }
+        }
+    }
+    return false;
+}
+
+bool FaceCaptureContext::GetStageUtilizations(int deviceIndex, std::vector<StageStatistic>& stageStatistics)
+{
+    stageStatistics.clear();
+
+    FaceDetector* detector = ChooseFaceDetector(deviceIndex);
+    for each (FromParam from in FromParams)
+    {
+        if (detector && from.detector == detector)
+        {
+            GetStageStatistics(detector, stageStatistics);
+
+            for each (ToParam to in ToParams)
+            {
+                if (to.name == from.extractName && to.extractor)
+                {
+                    std::vector<StageStatistic> extractStatistics;
+                    GetStageStatistics(to.extractor, extractStatistics);
+                    stageStatistics.insert(stageStatistics.end(), extractStatistics.begin(), extractStatistics.end());
+                    break;
+                }
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
 void FaceCaptureContext::AddSnapMachine(const std::string& id, SnapMachine* snapMachine)
 {
     std::lock_guard<std::mutex> lg(SnapMachinesLocker);
@@ -916,6 +1402,21 @@ bool FaceCaptureContext::FeedImageMachine(const ImageParam& imageParam)
     return false;
 }
 
+bool FaceCaptureContext::FeedImageMachines(const std::vector<ImageParam>& imageParams, std::vector<int>& results)
+{
+    std::lock_guard<std::mutex> lg(SnapMachinesLocker);
+    std::vector<SnapMachine*> snapMachines(imageParams.size(), nullptr);
+    for (size_t idx = 0; idx < imageParams.size(); ++idx)
+    {
+        std::map<std::string, SnapMachine*>::iterator it = SnapMachines.find(imageParams[idx].sourceId);
+        if (it != SnapMachines.end())
+        {
+            snapMachines[idx] = it->second;
+        }
+    }
+    return FeedSnapMachines(snapMachines, imageParams, results);
+}
+
 bool FaceCaptureContext::DelSnapMachine(const std::string& id)
 {
     std::lock_guard<std::mutex> lg(SnapMachinesLocker);
@@ -941,10 +1442,11 @@ void FaceCaptureContext::UninitializeAllSnapMachines()
     SnapMachines.clear();
 }
 
-void FaceCaptureContext::AddDecoder(const std::string& id, BaseDecoder* baseDecoder)
+void FaceCaptureContext::AddDecoder(const std::string& id, BaseDecoder* baseDecoder, FaceDetector* faceDetector)
 {
     std::lock_guard<std::mutex> lg(SyncBaseDecodersLocker);
     SyncBaseDecoders.insert(std::make_pair(id, baseDecoder));
+    SyncBaseDecoderDetectors[id] = faceDetector;
 }
 
 BaseDecoder* FaceCaptureContext::FindDecoder(const std::string& id)
@@ -958,6 +1460,64 @@ BaseDecoder* FaceCaptureContext::FindDecoder(const std::string& id)
     return nullptr;
 }
 
+FaceDetector* FaceCaptureContext::FindDecoderDetector(const std::string& id)
+{
+    std::lock_guard<std::mutex> lg(SyncBaseDecodersLocker);
+    std::map<std::string, FaceDetector *>::iterator it = SyncBaseDecoderDetectors.find(id);
+    if (SyncBaseDecoderDetectors.end() != it)
+    {
+        return it->second;
+    }
+    return nullptr;
+}
+
+bool FaceCaptureContext::MoveDecoder(const std::string& id, int deviceIndex, int drainTimeout)
+{
+    FaceDetector* target = ChooseFaceDetector(deviceIndex);
+    if (!target)
+    {
+        ErrorHandler::ErrorStream << "can not find face detector instance which work on device[" << deviceIndex << "] for id: " << id;
+        ErrorHandler::FlushLastErrorStream();
+        return false;
+    }
+
+    // hold the decoder during moving, it can not be closed meanwhile
+    std::lock_guard<std::mutex> lg(SyncBaseDecodersLocker);
+    std::map<std::string, BaseDecoder *>::iterator it = SyncBaseDecoders.find(id);
+    if (it == SyncBaseDecoders.end())
+    {
+        ErrorHandler::ErrorStream << "stream not found: " << id;
+        ErrorHandler::FlushLastErrorStream();
+        return false;
+    }
+
+    FaceDetector* source = SyncBaseDecoderDetectors[id];
+    if (source == target)
+    {
+        return true;
+    }
+
+    // frames decoded on gpu can not be detected on another device
+    int decodeDeviceIndex = GetDecoderDeviceIndex(it->second);
+    if (decodeDeviceIndex >= 0 && decodeDeviceIndex != deviceIndex)
+    {
+        ErrorHandler::ErrorStream << "stream decoded on device[" << decodeDeviceIndex << "] can not be moved to device[" << deviceIndex << "]: " << id;
+        ErrorHandler::FlushLastErrorStream();
+        return false;
+    }
+
+    if (!MoveSource(source, target, it->second, drainTimeout))
+    {
+        ErrorHandler::ErrorStream << "stream is not fetched by its face detector: " << id;
+        ErrorHandler::FlushLastErrorStream();
+        return false;
+    }
+    SyncBaseDecoderDetectors[id] = target;
+
+    LOG(INFO) << "stream " << id << " is moved to face detector of device[" << deviceIndex << "]";
+    return true;
+}
+
 bool FaceCaptureContext::DelDecoder(const std::string& id)
 {
     std::lock_guard<std::mutex> lg(SyncBaseDecodersLocker);
@@ -967,6 +1527,7 @@ bool FaceCaptureContext::DelDecoder(const std::string& id)
         // close decoder
         CloseDecoder(it->second);
         SyncBaseDecoders.erase(it);
+        SyncBaseDecoderDetectors.erase(id);
         return true;
     }
     return false;
@@ -977,8 +1538,7 @@ void FaceCaptureContext::UninitializeAllDecoders()
     std::lock_guard<std::mutex> lg(SyncBaseDecodersLocker);
     for (std::map<std::string, BaseDecoder*>::iterator it = SyncBaseDecoders.begin(); it != SyncBaseDecoders.end(); ++it)
     {
-        int deviceIndex = GetDecoderDeviceIndex(it->second);
-        FaceDetector* faceDetector = FaceCaptureContext::ChooseFaceDetector(deviceIndex);
+        FaceDetector* faceDetector = SyncBaseDecoderDetectors[it->first];
         if (faceDetector)
         {
             // delete from face detector
@@ -986,7 +1546,7 @@ void FaceCaptureContext::UninitializeAllDecoders()
         }
         else
         {
-            LOG(WARNING) << "can not find face detector instance which work on device[" << deviceIndex << "]";
+            LOG(WARNING) << "can not find face detector instance of id: " << it->first;
         }
 
         // close decoder
@@ -994,6 +1554,7 @@ void FaceCaptureContext::UninitializeAllDecoders()
     }
 
     SyncBaseDecoders.clear();
+    SyncBaseDecoderDetectors.clear();
 }
 
 void FaceCaptureContext::AddAsyncDecoders(const std::vector<int>& types, const std::vector<std::string>& urls, const std::vector<DecoderParam>& decoderParams, const std::vector<DecodeParam>& decodeParams, const std::vector<FaceParam>& faceParams, const std::vector<std::string>& ids, void(*asyncCallback)(const std::string&, const std::string&))
@@ -1126,8 +1687,7 @@ void FaceCaptureContext::StreamStoppedCallback(const std::string& id, bool async
         BaseDecoder* decoder = FaceCaptureContext::FindDecoder(id);
         if (decoder)
         {
-            int deviceIndex = GetDecoderDeviceIndex(decoder);
-            FaceDetector* faceDetector = FaceCaptureContext::ChooseFaceDetector(deviceIndex);
+            FaceDetector* faceDetector = FaceCaptureContext::FindDecoderDetector(id);
             if (faceDetector)
             {
                 // delete from face detector
@@ -1135,7 +1695,7 @@ void FaceCaptureContext::StreamStoppedCallback(const std::string& id, bool async
             }
             else
             {
-                LOG(WARNING) << "can not find face detector instance which work on device[" << deviceIndex << "] for id: " << id;
+                LOG(WARNING) << "can not find face detector instance of id: " << id;
             }
 
             DelDecoder(id);
@@ -1146,6 +1706,9 @@ void FaceCaptureContext::StreamStoppedCallback(const std::string& id, bool async
 void FaceCaptureContext::ShowConfiguration()
 {
     LOG(INFO) << "======================== face capture configuration ========================";
+    LOG(INFO) << "-- placement          : " << (PlaceLeastLoaded ? "least_loaded" : "device");
+    LOG(INFO) << "-- affinity           : decoder: " << Affinity.decoder << ", async: " << Affinity.async << ", worker: " << Affinity.worker
+        << ", callback: " << Affinity.callback << ", service: " << Affinity.service << " (-2: none, -1: device)";
     for (size_t idx = 0; idx < ToParams.size(); ++idx)
     {
         ModelParam& modelParam = ToParams[idx].modelParam;
@@ -1154,6 +1717,12 @@ void FaceCaptureContext::ShowConfiguration()
         LOG(INFO) << "-- model_path         : " << modelParam.path;
         LOG(INFO) << "-- model_name         : " << modelParam.name;
         LOG(INFO) << "-- result_buffer_size : " << resultParam.bufferSize;
+        LOG(INFO) << "-- archive_path       : " << resultParam.archiveParam.path;
+        LOG(INFO) << "-- archive_segment    : " << resultParam.archiveParam.segmentSize << " MB * " << resultParam.archiveParam.segmentNumber;
+        LOG(INFO) << "-- sink_path          : " << resultParam.sinkParam.path;
+        LOG(INFO) << "-- sink_spill_path    : " << resultParam.sinkParam.spillPath;
+        LOG(INFO) << "-- ring_name          : " << resultParam.ringParam.name << ", slots: " << resultParam.ringParam.slotNumber << " * " << resultParam.ringParam.slotSize << " KB";
+        LOG(INFO) << "-- autoscale          : " << ToParams[idx].scaleParam.autoscale << ", max_thread_count: " << ToParams[idx].scaleParam.maxThreadCount;
 
         ExtractParam& extractParam = ToParams[idx].extractParam;
         LOG(INFO) << "-- device_index       : " << extractParam.deviceIndex;
@@ -1161,6 +1730,10 @@ void FaceCaptureContext::ShowConfiguration()
         LOG(INFO) << "-- buffer_size        : " << extractParam.bufferSize;
         LOG(INFO) << "-- batch_timeout      : " << extractParam.batchTimeout;
         LOG(INFO) << "-- batch_size         : " << extractParam.batchSize;
+        LOG(INFO) << "-- dedup_threshold    : " << extractParam.dedupThreshold;
+        LOG(INFO) << "-- dedup_window       : " << extractParam.dedupWindow;
+        LOG(INFO) << "-- dedup_keep_better  : " << extractParam.dedupKeepBetter;
+        LOG(INFO) << "-- feature_encoding   : " << extractParam.featureEncoding;
     }
     for (size_t idx = 0; idx < FromParams.size(); ++idx)
     {
@@ -1170,6 +1743,12 @@ void FaceCaptureContext::ShowConfiguration()
         LOG(INFO) << "-- model_path         : " << modelParam.path;
         LOG(INFO) << "-- model_name         : " << modelParam.name;
         LOG(INFO) << "-- result_buffer_size : " << resultParam.bufferSize;
+        LOG(INFO) << "-- archive_path       : " << resultParam.archiveParam.path;
+        LOG(INFO) << "-- archive_segment    : " << resultParam.archiveParam.segmentSize << " MB * " << resultParam.archiveParam.segmentNumber;
+        LOG(INFO) << "-- sink_path          : " << resultParam.sinkParam.path;
+        LOG(INFO) << "-- sink_spill_path    : " << resultParam.sinkParam.spillPath;
+        LOG(INFO) << "-- ring_name          : " << resultParam.ringParam.name << ", slots: " << resultParam.ringParam.slotNumber << " * " << resultParam.ringParam.slotSize << " KB";
+        LOG(INFO) << "-- autoscale          : " << FromParams[idx].scaleParam.autoscale << ", max_thread_count: " << FromParams[idx].scaleParam.maxThreadCount;
 
         DetectParam& detectParam = FromParams[idx].detectParam;
         LOG(INFO) << "------------------- detect --------------------";
@@ -1228,6 +1807,9 @@ void FaceCaptureContext::ShowConfiguration()
         LOG(INFO) << "-- analyze_age_gender : " << analyzeParam.analyze_age_gender;
         LOG(INFO) << "-- analyze_age_ethnic : " << analyzeParam.analyze_age_ethnic;
 
+        LOG(INFO) << "-- cache_size         : " << analyzeParam.cacheSize;
+        LOG(INFO) << "-- cache_votes        : " << analyzeParam.cacheVotes;
+
         LOG(INFO) << "-- buffer_size        : " << analyzeParam.bufferSize;
         LOG(INFO) << "-- batch_timeout      : " << analyzeParam.batchTimeout;
         LOG(INFO) << "-- batch_size         : " << analyzeParam.batchSize;
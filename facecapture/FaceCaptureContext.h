@@ -27,6 +27,7 @@ private:
         AlignParam alignParam = {};
         AnalyzeParam analyzeParam = {};
         ResultParam resultParam = {};
+        ScaleParam scaleParam = {};
 
         FaceDetector* detector = nullptr;
     };
@@ -37,6 +38,7 @@ private:
         ModelParam modelParam = {};
         ExtractParam extractParam = {};
         ResultParam resultParam = {};
+        ScaleParam scaleParam = {};
 
         FaceExtractor* extractor = nullptr;
     };
@@ -45,7 +47,14 @@ public:
     static bool ReadConfiguration(const char* path);
     static void ShowConfiguration();
 
+    static void InitializeAffinity();
+
     static FaceDetector* ChooseFaceDetector(int deviceIndex);
+    static FaceDetector* PlaceFaceDetector(DecoderParam& decoderParam);
+    static void GetDetectorLoads(std::vector<DetectorLoad>& detectorLoads);
+
+    static bool SetStageThreads(int deviceIndex, int stage, int threadCount);
+    static bool GetStageUtilizations(int deviceIndex, std::vector<StageStatistic>& stageStatistics);
 
     static bool InitializeFaceExtractor(ToParam& toParam);
     static bool InitializeFaceExtractors();
@@ -58,11 +67,14 @@ public:
     static void AddSnapMachine(const std::string& id, SnapMachine*);
     static bool FindSnapMachine(const std::string& id);
     static bool FeedImageMachine(const ImageParam&);
+    static bool FeedImageMachines(const std::vector<ImageParam>&, std::vector<int>& results);
     static bool DelSnapMachine(const std::string& id);
     static void UninitializeAllSnapMachines();
 
-    static void AddDecoder(const std::string& id, BaseDecoder*);
+    static void AddDecoder(const std::string& id, BaseDecoder*, FaceDetector*);
     static BaseDecoder* FindDecoder(const std::string& id);
+    static FaceDetector* FindDecoderDetector(const std::string& id);
+    static bool MoveDecoder(const std::string& id, int deviceIndex, int drainTimeout);
     static bool DelDecoder(const std::string& id);
     static void UninitializeAllDecoders();
 
@@ -82,7 +94,13 @@ private:
     static bool ReadAligne(cJSON* parent, AlignParam& alignParam);
     static bool ReadAnalyze(cJSON* parent, AnalyzeParam& analyzeParam);
     static bool ReadExtract(cJSON* parent, ExtractParam& extractParam);
+    static bool ReadArchive(cJSON* parent, ArchiveParam& archiveParam);
+    static bool ReadSink(cJSON* parent, SinkParam& sinkParam);
+    static bool ReadRing(cJSON* parent, RingParam& ringParam);
+    static bool ReadScale(cJSON* parent, ScaleParam& scaleParam);
 
+    static bool ReadPlacement(cJSON* parent);
+    static bool ReadAffinity(cJSON* parent);
     static bool ReadCaptures(cJSON* parent, const std::string& modelPath, const std::string& path);
     static bool ReadExtracts(cJSON* parent, const std::string& modelPath, const std::string& path);
 
@@ -90,6 +108,8 @@ private:
     // initialization fields
     static std::vector<FromParam> FromParams;
     static std::vector<ToParam> ToParams;
+    static bool PlaceLeastLoaded;
+    static AffinityParam Affinity;
 
     // operation fields
     static std::mutex SnapMachinesLocker;
@@ -97,6 +117,7 @@ private:
 
     static std::mutex SyncBaseDecodersLocker;
     static std::map<std::string, BaseDecoder*> SyncBaseDecoders;
+    static std::map<std::string, FaceDetector*> SyncBaseDecoderDetectors;
 
     static std::mutex AsyncContextsLocker;
     static std::map<int, AsyncContext*> AsyncContexts;
@@ -112,6 +112,9 @@ FACECAPUTRE_C_API bool FaceCaptureInit(const char* path)
         // show configuration information
         FaceCaptureContext::ShowConfiguration();
 
+        // place threads before decoders and detectors start
+        FaceCaptureContext::InitializeAffinity();
+
         if (!FaceCaptureContext::InitializeFaceExtractors())
         {
             FaceCaptureContext::UninitializeFaceExtractors();
@@ -246,6 +249,16 @@ FACECAPUTRE_C_API bool FeedImageCamera(const ImageParam& imageParam)
     return FaceCaptureContext::FeedImageMachine(imageParam);
 }
 
+FACECAPUTRE_C_API bool FeedImageCameras(const std::vector<ImageParam>& imageParams, std::vector<int>& results)
+{
+    if (!FaceCaptureContext::FeedImageMachines(imageParams, results))
+    {
+        ErrorHandler::SetLastError("some images are not fed, see results");
+        return false;
+    }
+    return true;
+}
+
 FACECAPUTRE_C_API bool CloseImageCamera(const char* id)
 {
     return FaceCaptureContext::DelSnapMachine(id);
@@ -284,16 +297,17 @@ FACECAPUTRE_C_API bool CloseStreamsAsync(const std::vector<std::string>& ids, St
 
 FACECAPUTRE_C_API bool OpenRTSP(const char* url, const DecoderParam& decoderParam, const DecodeParam& decodeParam, const FaceParam& faceParam, const char* id)
 {
-    FaceDetector* faceDetector = FaceCaptureContext::ChooseFaceDetector(decoderParam.device_index);
+    DecoderParam placedParam = decoderParam;
+    FaceDetector* faceDetector = FaceCaptureContext::PlaceFaceDetector(placedParam);
     if (faceDetector)
     {
         if (!FaceCaptureContext::FindDecoder(id))
         {
-            BaseDecoder* baseDecdoer = OpenRTSP(url, decoderParam, decodeParam, id, false, FaceCaptureContext::StreamStoppedCallback);
+            BaseDecoder* baseDecdoer = OpenRTSP(url, placedParam, decodeParam, id, false, FaceCaptureContext::StreamStoppedCallback);
             if (baseDecdoer)
             {
                 AddSource(faceDetector, baseDecdoer, faceParam);
-                FaceCaptureContext::AddDecoder(id, baseDecdoer);
+                FaceCaptureContext::AddDecoder(id, baseDecdoer, faceDetector);
                 return true;
             }
             else
@@ -317,16 +331,17 @@ FACECAPUTRE_C_API bool OpenRTSP(const char* url, const DecoderParam& decoderPara
 
 FACECAPUTRE_C_API bool OpenVideo(const char* path, const DecoderParam& decoderParam, const DecodeParam& decodeParam, const FaceParam& faceParam, const char* id)
 {
-    FaceDetector* faceDetector = FaceCaptureContext::ChooseFaceDetector(decoderParam.device_index);
+    DecoderParam placedParam = decoderParam;
+    FaceDetector* faceDetector = FaceCaptureContext::PlaceFaceDetector(placedParam);
     if (faceDetector)
     {
         if (!FaceCaptureContext::FindDecoder(id))
         {
-            BaseDecoder* baseDecdoer = OpenVideo(path, decoderParam, decodeParam, id, false, FaceCaptureContext::StreamStoppedCallback);
+            BaseDecoder* baseDecdoer = OpenVideo(path, placedParam, decodeParam, id, false, FaceCaptureContext::StreamStoppedCallback);
             if (baseDecdoer)
             {
                 AddSource(faceDetector, baseDecdoer, faceParam);
-                FaceCaptureContext::AddDecoder(id, baseDecdoer);
+                FaceCaptureContext::AddDecoder(id, baseDecdoer, faceDetector);
                 return true;
             }
             else
@@ -350,16 +365,17 @@ FACECAPUTRE_C_API bool OpenVideo(const char* path, const DecoderParam& decoderPa
 
 FACECAPUTRE_C_API bool OpenUSB(const char* path, const DecoderParam& decoderParam, const DecodeParam& decodeParam, const FaceParam& faceParam, const char* id)
 {
-    FaceDetector* faceDetector = FaceCaptureContext::ChooseFaceDetector(decoderParam.device_index);
+    DecoderParam placedParam = decoderParam;
+    FaceDetector* faceDetector = FaceCaptureContext::PlaceFaceDetector(placedParam);
     if (faceDetector)
     {
         if (!FaceCaptureContext::FindDecoder(id))
         {
-            BaseDecoder* baseDecdoer = OpenUSB(path, decoderParam, decodeParam, id, FaceCaptureContext::StreamStoppedCallback);
+            BaseDecoder* baseDecdoer = OpenUSB(path, placedParam, decodeParam, id, FaceCaptureContext::StreamStoppedCallback);
             if (baseDecdoer)
             {
                 AddSource(faceDetector, baseDecdoer, faceParam);
-                FaceCaptureContext::AddDecoder(id, baseDecdoer);
+                FaceCaptureContext::AddDecoder(id, baseDecdoer, faceDetector);
                 return true;
             }
             else
@@ -383,16 +399,17 @@ FACECAPUTRE_C_API bool OpenUSB(const char* path, const DecoderParam& decoderPara
 
 FACECAPUTRE_C_API bool OpenDirectory(const char* path, const DecoderParam& decoderParam, const DecodeParam& decodeParam, const FaceParam& faceParam, const char* id)
 {
-    FaceDetector* faceDetector = FaceCaptureContext::ChooseFaceDetector(decoderParam.device_index);
+    DecoderParam placedParam = decoderParam;
+    FaceDetector* faceDetector = FaceCaptureContext::PlaceFaceDetector(placedParam);
     if (faceDetector)
     {
         if (!FaceCaptureContext::FindDecoder(id))
         {
-            BaseDecoder* baseDecdoer = OpenDirectory(path, decoderParam, decodeParam, id, FaceCaptureContext::StreamStoppedCallback);
+            BaseDecoder* baseDecdoer = OpenDirectory(path, placedParam, decodeParam, id, FaceCaptureContext::StreamStoppedCallback);
             if (baseDecdoer)
             {
                 AddSource(faceDetector, baseDecdoer, faceParam);
-                FaceCaptureContext::AddDecoder(id, baseDecdoer);
+                FaceCaptureContext::AddDecoder(id, baseDecdoer, faceDetector);
                 return true;
             }
             else
@@ -414,13 +431,46 @@ FACECAPUTRE_C_API bool OpenDirectory(const char* path, const DecoderParam& decod
     return false;
 }
 
+FACECAPUTRE_C_API bool OpenWatchFolder(const char* path, const DecoderParam& decoderParam, const DecodeParam& decodeParam, const WatchParam& watchParam, const FaceParam& faceParam, const char* id)
+{
+    DecoderParam placedParam = decoderParam;
+    FaceDetector* faceDetector = FaceCaptureContext::PlaceFaceDetector(placedParam);
+    if (faceDetector)
+    {
+        if (!FaceCaptureContext::FindDecoder(id))
+        {
+            BaseDecoder* baseDecdoer = OpenWatchFolder(path, placedParam, decodeParam, watchParam, id, FaceCaptureContext::StreamStoppedCallback);
+            if (baseDecdoer)
+            {
+                AddSource(faceDetector, baseDecdoer, faceParam);
+                FaceCaptureContext::AddDecoder(id, baseDecdoer, faceDetector);
+                return true;
+            }
+            else
+            {
+                ErrorHandler::SetLastError(GetLastDecodeError());
+            }
+        }
+        else
+        {
+            ErrorHandler::ErrorStream << "Watch folder already created: " << id;
+            ErrorHandler::FlushLastErrorStream();
+        }
+    }
+    else
+    {
+        ErrorHandler::ErrorStream << "can not find face detector instance which work on device[" << decoderParam.device_index << "] for id: " << id;
+        ErrorHandler::FlushLastErrorStream();
+    }
+    return false;
+}
+
 FACECAPUTRE_C_API bool CloseStream(const char* id)
 {
     BaseDecoder* decoder = FaceCaptureContext::FindDecoder(id);
     if (decoder)
     {
-        int deviceIndex = GetDecoderDeviceIndex(decoder);
-        FaceDetector* faceDetector = FaceCaptureContext::ChooseFaceDetector(deviceIndex);
+        FaceDetector* faceDetector = FaceCaptureContext::FindDecoderDetector(id);
         if (faceDetector)
         {
             // delete from face detector
@@ -428,7 +478,7 @@ FACECAPUTRE_C_API bool CloseStream(const char* id)
         }
         else
         {
-            LOG(WARNING) << "can not find face detector instance which work on device[" << deviceIndex << "] for id: " << id;
+            LOG(WARNING) << "can not find face detector instance of id: " << id;
         }
 
         return FaceCaptureContext::DelDecoder(id);
@@ -436,6 +486,27 @@ FACECAPUTRE_C_API bool CloseStream(const char* id)
     return false;
 }
 
+FACECAPUTRE_C_API bool MigrateStream(const char* id, int deviceIndex, int drainTimeout)
+{
+    return FaceCaptureContext::MoveDecoder(id, deviceIndex, drainTimeout);
+}
+
+FACECAPUTRE_C_API bool GetDetectorLoads(std::vector<DetectorLoad>& detectorLoads)
+{
+    FaceCaptureContext::GetDetectorLoads(detectorLoads);
+    return detectorLoads.size() > 0;
+}
+
+FACECAPUTRE_C_API bool SetStageThreads(int deviceIndex, int stage, int threadCount)
+{
+    return FaceCaptureContext::SetStageThreads(deviceIndex, stage, threadCount);
+}
+
+FACECAPUTRE_C_API bool GetStageUtilizations(int deviceIndex, std::vector<StageStatistic>& stageStatistics)
+{
+    return FaceCaptureContext::GetStageUtilizations(deviceIndex, stageStatistics);
+}
+
 FACECAPUTRE_C_API bool GetFaceCapture(std::vector<CaptureResultPtr>& captureResults)
 {
     return FaceCaptureContext::GetCaptureResults(captureResults);
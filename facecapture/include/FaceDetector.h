@@ -20,24 +20,85 @@
 class FaceDetector;
 class FaceExtractor;
 class BaseDecoder;
+class CaptureArchiveReader;
+class CaptureRingReader;
 
 FACEDETECTOR_API bool DetectInit();
 FACEDETECTOR_API void DetectDestroy();
 
 FACEDETECTOR_API const char* GetLastDetectError();
 
+/**
+* @brief place decoder, pipeline and service threads on numa nodes by AffinityParam 
+
+* threads bind themselves when they start, so it should be set before sources and detectors are created
+*/
+FACEDETECTOR_API void SetAffinity(const AffinityParam& affinityParam);
+
+/**
+* @brief bind current thread by the policy of role (THREAD_XXX), for threads started outside the library 
+
+* @return numa node bound, -1 if the thread floats
+*/
+FACEDETECTOR_API int BindThread(int role, int deviceIndex);
+
 FACEDETECTOR_API FaceDetector* CreateDetector(const ModelParam& modelParam, const DetectParam& detectParam, const TrackParam& trackParam,
     const EvaluateParam& evaluateParam, const KeypointParam& keypointParam, const AlignParam& alignParam,
-    const AnalyzeParam& analyzerParam, const ResultParam& resultParam, FaceExtractor*);
+    const AnalyzeParam& analyzerParam, const ResultParam& resultParam, FaceExtractor*, const ScaleParam& scaleParam = ScaleParam());
 FACEDETECTOR_API void DestroyDetector(FaceDetector*);
 
-FACEDETECTOR_API FaceExtractor* CreateExtractor(const ModelParam& modelParam, const ExtractParam& extractParam, const ResultParam& resultParam);
+FACEDETECTOR_API FaceExtractor* CreateExtractor(const ModelParam& modelParam, const ExtractParam& extractParam, const ResultParam& resultParam,
+    const ScaleParam& scaleParam = ScaleParam());
 FACEDETECTOR_API void DestroyExtractor(FaceExtractor*);
 
 FACEDETECTOR_API void AddSource(FaceDetector*, BaseDecoder*, const FaceParam& faceParam);
 FACEDETECTOR_API void DelSource(FaceDetector*, BaseDecoder*);
 
+/**
+* @brief move a running source from one detector to another without dropping its captures \n
+* frames of the source in the pipeline of from are drained first, at most drainTimeout (ms),
+* then tracks and best faces of the source are handed to to
+*/
+FACEDETECTOR_API bool MoveSource(FaceDetector* from, FaceDetector* to, BaseDecoder*, int drainTimeout);
+
+FACEDETECTOR_API void GetDetectorLoad(FaceDetector*, DetectorLoad& detectorLoad);
+
+/**
+* @brief add or retire workers of a stage (STAGE_XXX) while running \n
+* retired workers finish their current batch first, tracks are kept;
+* only stages enabled at creation can be scaled and each keeps one worker at least
+*/
+FACEDETECTOR_API bool ScaleStage(FaceDetector*, int stage, int threadCount);
+FACEDETECTOR_API bool ScaleStage(FaceExtractor*, int stage, int threadCount);
+
+FACEDETECTOR_API void GetStageStatistics(FaceDetector*, std::vector<StageStatistic>& stageStatistics);
+FACEDETECTOR_API void GetStageStatistics(FaceExtractor*, std::vector<StageStatistic>& stageStatistics);
+
 FACEDETECTOR_API bool GetCapture(FaceDetector*, std::vector<std::shared_ptr<CaptureResult>>& captureResults);
 FACEDETECTOR_API bool GetCapture(FaceExtractor*, std::vector<std::shared_ptr<CaptureResult>>& captureResults);
 
+/**
+* @brief read captures archived by ResultParam.archiveParam \n
+* QueryArchive gets captures of sourceId (nullptr or empty for all sources) whose timestamp is in [beginTime, endTime]
+*/
+FACEDETECTOR_API CaptureArchiveReader* OpenArchive(const char* path);
+FACEDETECTOR_API void CloseArchive(CaptureArchiveReader*);
+FACEDETECTOR_API bool QueryArchive(CaptureArchiveReader*, const char* sourceId, long long beginTime, long long endTime, std::vector<std::shared_ptr<CaptureResult>>& captureResults);
+
+/**
+* @brief read captures published to the shared memory ring ResultParam.ringParam.name, from another process as well \n
+* PollRing gets captures published since last poll, at most maxNumber (0 means all);
+* lostNumber counts captures overwritten before they were read, lag is captures published but not read yet
+*/
+FACEDETECTOR_API CaptureRingReader* OpenRing(const char* name);
+FACEDETECTOR_API void CloseRing(CaptureRingReader*);
+FACEDETECTOR_API bool PollRing(CaptureRingReader*, std::vector<std::shared_ptr<CaptureResult>>& captureResults, int maxNumber);
+FACEDETECTOR_API void GetRingStatus(CaptureRingReader*, long long& lostNumber, unsigned int& lag);
+
+/**
+* @brief snapshot of all metrics of the registry: decoder frames, duplicates and read costs per source,
+* items and costs of every stage function, ordered by type and name \n
+*/
+FACEDETECTOR_API void GetMetrics(std::vector<MetricSnapshot>& metricSnapshots);
+
 #endif
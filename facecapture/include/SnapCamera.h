@@ -28,6 +28,7 @@ SNAPMACHINE_API const char* GetSnapMachineId(SnapMachine*);
 SNAPMACHINE_API const int GetSnapMachineDeviceIndex(SnapMachine*);
 
 SNAPMACHINE_API bool FeedSnapMachine(SnapMachine*, const ImageParam& imageParam);
+SNAPMACHINE_API bool FeedSnapMachines(const std::vector<SnapMachine*>& snapMachines, const std::vector<ImageParam>& imageParams, std::vector<int>& results);
 
 SNAPMACHINE_API bool DestroySnapMachine(SnapMachine*);
 
@@ -31,12 +31,19 @@ STREAMDECODER_API const char* GetLastDecodeError();
 STREAMDECODER_API const char* GetDecoderId(BaseDecoder*);
 STREAMDECODER_API const int GetDecoderDeviceIndex(BaseDecoder*);
 
+/**
+* @brief duplicate frames dropped so far and whether the stream is frozen \n
+*
+*/
+STREAMDECODER_API bool IsDecoderFrozen(BaseDecoder*, long long& duplicateNumber);
+
 STREAMDECODER_API bool DecodeFrame(BaseDecoder*);
 
 STREAMDECODER_API BaseDecoder* OpenRTSP(const std::string& url, const DecoderParam&, const DecodeParam& decodeParam, const std::string&, bool async, DecoderStoppedCallback stoppedCb);
 STREAMDECODER_API BaseDecoder* OpenVideo(const std::string& url, const DecoderParam&, const DecodeParam& decodeParam, const std::string&, bool async, DecoderStoppedCallback stoppedCb);
 STREAMDECODER_API BaseDecoder* OpenUSB(const std::string& url, const DecoderParam&, const DecodeParam& decodeParam, const std::string&, DecoderStoppedCallback stoppedCb);
 STREAMDECODER_API BaseDecoder* OpenDirectory(const std::string& url, const DecoderParam&, const DecodeParam& decodeParam, const std::string&, DecoderStoppedCallback stoppedCb);
+STREAMDECODER_API BaseDecoder* OpenWatchFolder(const std::string& url, const DecoderParam&, const DecodeParam& decodeParam, const WatchParam& watchParam, const std::string&, DecoderStoppedCallback stoppedCb);
 
 STREAMDECODER_API bool CloseDecoder(BaseDecoder*);
 
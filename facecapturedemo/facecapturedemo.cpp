@@ -534,7 +534,13 @@ static FaceParam defaultFaceParam;
 
 void ReadFaceParam(cJSON *capture, FaceParam& faceParam)
 {
-    cJSON* jitem = cJSON_GetObjectItem(capture, "scence_image_height");
+    cJSON* jitem = cJSON_GetObjectItem(capture, "priority");
+    if (jitem && jitem->type == cJSON_Number)
+    {
+        faceParam.priority = jitem->valueint;
+    }
+
+    jitem = cJSON_GetObjectItem(capture, "scence_image_height");
     if (jitem && jitem->type == cJSON_Number)
     {
         faceParam.scence_image_height = jitem->valueint;
@@ -564,12 +570,92 @@ void ReadFaceParam(cJSON *capture, FaceParam& faceParam)
         faceParam.detect_interval = jitem->valueint;
     }
 
+    jitem = cJSON_GetObjectItem(capture, "adaptive_detect_interval");
+    if (jitem)
+    {
+        faceParam.adaptive_detect_interval = jitem->type == cJSON_True;
+    }
+
+    jitem = cJSON_GetObjectItem(capture, "min_detect_interval");
+    if (jitem && jitem->type == cJSON_Number)
+    {
+        faceParam.min_detect_interval = jitem->valueint;
+    }
+
+    jitem = cJSON_GetObjectItem(capture, "max_detect_interval");
+    if (jitem && jitem->type == cJSON_Number)
+    {
+        faceParam.max_detect_interval = jitem->valueint;
+    }
+
+    jitem = cJSON_GetObjectItem(capture, "motion_gate");
+    if (jitem)
+    {
+        faceParam.motion_gate = jitem->type == cJSON_True;
+    }
+
+    jitem = cJSON_GetObjectItem(capture, "motion_threshold");
+    if (jitem && jitem->type == cJSON_Number)
+    {
+        faceParam.motion_threshold = jitem->valuedouble;
+    }
+
+    jitem = cJSON_GetObjectItem(capture, "motion_force_interval");
+    if (jitem && jitem->type == cJSON_Number)
+    {
+        faceParam.motion_force_interval = jitem->valueint;
+    }
+
+    jitem = cJSON_GetObjectItem(capture, "cpu_track");
+    if (jitem)
+    {
+        faceParam.cpu_track = jitem->type == cJSON_True;
+    }
+
+    jitem = cJSON_GetObjectItem(capture, "rois");
+    if (jitem && jitem->type == cJSON_Array)
+    {
+        faceParam.rois.clear();
+        int roiSize = cJSON_GetArraySize(jitem);
+        for (int roiIndex = 0; roiIndex < roiSize; ++roiIndex)
+        {
+            cJSON* jroi = cJSON_GetArrayItem(jitem, roiIndex);
+
+            FaceRoi faceRoi;
+            cJSON* jexclude = cJSON_GetObjectItem(jroi, "exclude");
+            faceRoi.exclude = jexclude && jexclude->type == cJSON_True;
+
+            cJSON* jpoints = cJSON_GetObjectItem(jroi, "points");
+            if (jpoints && jpoints->type == cJSON_Array)
+            {
+                int pointSize = cJSON_GetArraySize(jpoints);
+                for (int pointIndex = 0; pointIndex < pointSize; ++pointIndex)
+                {
+                    faceRoi.points.push_back((float)cJSON_GetArrayItem(jpoints, pointIndex)->valuedouble);
+                }
+            }
+            faceParam.rois.push_back(faceRoi);
+        }
+    }
+
     jitem = cJSON_GetObjectItem(capture, "extract_feature");
     if (jitem)
     {
         faceParam.extract_feature = jitem->type == cJSON_True;
     }
 
+    jitem = cJSON_GetObjectItem(capture, "extract_best_only");
+    if (jitem)
+    {
+        faceParam.extract_best_only = jitem->type == cJSON_True;
+    }
+
+    jitem = cJSON_GetObjectItem(capture, "extract_quality_margin");
+    if (jitem && jitem->type == cJSON_Number)
+    {
+        faceParam.extract_quality_margin = jitem->valuedouble;
+    }
+
     jitem = cJSON_GetObjectItem(capture, "analyze_glasses");
     if (jitem)
     {
@@ -665,6 +751,18 @@ void ReadFaceParam(cJSON *capture, FaceParam& faceParam)
     {
         faceParam.brightness = jitem->valuedouble;
     }
+
+    jitem = cJSON_GetObjectItem(capture, "prefilter_clarity");
+    if (jitem && jitem->type == cJSON_Number)
+    {
+        faceParam.prefilter_clarity = jitem->valuedouble;
+    }
+
+    jitem = cJSON_GetObjectItem(capture, "prefilter_brightness");
+    if (jitem && jitem->type == cJSON_Number)
+    {
+        faceParam.prefilter_brightness = jitem->valuedouble;
+    }
 }
 
 void usercallback(const char* id)
@@ -672,6 +770,11 @@ void usercallback(const char* id)
     printf("%s %s exit\n", __FUNCTION__, id);
 }
 
+void frozencallback(const char* id, bool frozen)
+{
+    printf("%s %s %s\n", __FUNCTION__, id, frozen ? "frozen" : "recovered");
+}
+
 void ReadStreams(cJSON *streams, const char* modName, std::vector<std::string>& ids, std::vector<std::string>& urls, std::vector<DecoderParam>& decoderParams, std::vector<DecodeParam>& decodeParams, std::vector<FaceParam>& faceParams, std::vector<char>& syncs)
 {
     if (streams)
@@ -740,8 +843,27 @@ void ReadStreams(cJSON *streams, const char* modName, std::vector<std::string>&
                             continue;
                         }
 
+                        jitem = cJSON_GetObjectItem(json, "decode_threads");
+                        if (jitem && jitem->type == cJSON_Number)
+                        {
+                            decoderParam.decode_threads = jitem->valueint;
+                        }
+
+                        jitem = cJSON_GetObjectItem(json, "ordered");
+                        if (jitem)
+                        {
+                            decoderParam.ordered = jitem->type == cJSON_True ? true : false;
+                        }
+
+                        jitem = cJSON_GetObjectItem(json, "max_short_edge");
+                        if (jitem && jitem->type == cJSON_Number)
+                        {
+                            decoderParam.max_short_edge = jitem->valueint;
+                        }
+
                         DecodeParam decodeParam;
                         decodeParam.ExitCallback = usercallback;
+                        decodeParam.FrozenCallback = frozencallback;
                         jitem = cJSON_GetObjectItem(json, "skip_frame_interval");
                         if (jitem)
                         {
@@ -807,6 +929,18 @@ void ReadStreams(cJSON *streams, const char* modName, std::vector<std::string>&
                             }
                         }
 
+                        jitem = cJSON_GetObjectItem(json, "duplicate_threshold");
+                        if (jitem && jitem->type == cJSON_Number)
+                        {
+                            decodeParam.duplicate_threshold = jitem->valueint;
+                        }
+
+                        jitem = cJSON_GetObjectItem(json, "frozen_duration");
+                        if (jitem && jitem->type == cJSON_Number)
+                        {
+                            decodeParam.frozen_duration = jitem->valueint;
+                        }
+
                         FaceParam faceParam = defaultFaceParam;
                         jitem = cJSON_GetObjectItem(json, "capture");
                         if (jitem && jitem->type == cJSON_Object)
@@ -100,5 +100,64 @@ struct CaptureResult {
 
 typedef std::shared_ptr<CaptureResult> CaptureResultPtr;
 
+/**
+* @brief define live load of a detector \n
+* sources are placed on the least loaded detector by it
+*/
+struct DetectorLoad {
+
+    int deviceIndex  = -1;  // device of detect phase, -1 means cpu
+    int sourceNumber = 0;   // sources fetched by the detector
+    int queuedNumber = 0;   // images and faces waiting in buffers of all phases
+
+    float bufferUsage       = 0.0f; // highest usage of buffers of all phases
+    float batchMilliseconds = 0.0f; // recent detect batch latency (ms)
+    float pixelRate         = 0.0f; // recent pixels fetched from sources (megapixels per second)
+};
+
+/**
+* @brief define worker stages of detector and extractor \n
+* workers of a stage can be added or retired while running
+*/
+enum { STAGE_DETECT, STAGE_TRACK, STAGE_EVALUATE, STAGE_KEYPOINT, STAGE_ALIGN, STAGE_ANALYZE, STAGE_EXTRACT, STAGE_NUMBER };
+
+/**
+* @brief define live statistic of a worker stage \n
+* utilization is busy time of workers divided by their running time in the latest sampling interval
+*/
+struct StageStatistic {
+
+    int stage       = STAGE_DETECT;
+    int threadCount = 0;    // running workers
+
+    float utilization = 0.0f; // [0.0, 1.0]
+};
+
+/**
+* @brief define metric type \n
+*
+*/
+enum { METRIC_COUNTER, METRIC_GAUGE, METRIC_HISTOGRAM };
+
+/**
+* @brief define snapshot of a metric of the registry \n
+* histogram values are microseconds, percentiles are kept within 12.5%
+*/
+struct MetricSnapshot {
+
+    std::string name   = "";
+    std::string labels = "";    // like source="cam1",stage="detect"
+    int type           = METRIC_COUNTER;
+
+    long long value = 0;        // counter or gauge value, recorded number of a histogram
+
+    long long sum = 0;          // histogram only
+    long long max = 0;
+    long long p50 = 0;
+    long long p90 = 0;
+    long long p99 = 0;
+    long long p999 = 0;
+};
+
 #endif
 
@@ -23,12 +23,26 @@
 #ifndef _FACEDETECTOR_STRUCT_HEADER_H_
 #define _FACEDETECTOR_STRUCT_HEADER_H_
 
+#include <vector>
+
+/**
+* @brief define region of interest \n
+* polygon vertexes are relative to frame size, [0.0, 1.0]
+*/
+struct FaceRoi
+{
+    bool exclude = false;      // false: only faces inside the polygon are captured, true: faces inside the polygon are discarded
+    std::vector<float> points; // polygon vertexes: x1, y1, x2, y2, ...
+};
+
 /**
 * @brief define capture rules \n
 *
 */
 struct FaceParam
 {
+    int priority = 0;            // priority class of the source, lower priority source will be shed first when overloaded
+
     int scence_image_height = 0; // 0: keep original resolution, 720: 1280x720, 1080: 1920x1080, other value: will not output scence image
 
     float face_image_range_scale = 1.0f; // 1.0 means same as the face box size; smaller than 1.0 means smaller than face box else larger than face box; smaller or euqal 0.0 means no face image output
@@ -38,6 +52,25 @@ struct FaceParam
 
     int detect_interval = 5;    // frame 
 
+    bool adaptive_detect_interval = false; // adjust detect interval by scene activity between min_detect_interval and max_detect_interval
+    int  min_detect_interval      = 1;     // frame, detect interval when new faces appear
+    int  max_detect_interval      = 25;    // frame, detect interval grows to it step by step when no face is detected
+
+    std::vector<FaceRoi> rois;  // include/exclude regions, detecting is limited to the bounding rectangle of include regions, empty means whole frame
+
+    bool  motion_gate            = false;  // only detect the frames which have motion in motion region (cpu frame difference)
+    float motion_threshold       = 0.005f; // ratio of changed pixels in motion region which indicates motion
+    int   motion_pixel_threshold = 25;     // gray level difference which indicates one pixel changed
+    int   motion_force_interval  = 2000;   // force to detect once in this interval even if no motion (ms), 0 or negative means never
+    float motion_region_x        = 0.0f;   // motion region relative to frame size, [0.0, 1.0]
+    float motion_region_y        = 0.0f;
+    float motion_region_width    = 1.0f;
+    float motion_region_height   = 1.0f;
+
+    bool  cpu_track         = false; // track faces between detections by cpu box tracker (iou association and kalman filter) instead of SDK tracker
+    float cpu_track_iou     = 0.3f;  // minimum iou to associate a detected face with a tracked face
+    int   cpu_track_timeout = 1000;  // tracked face which is not detected again in this duration will be discarded (ms)
+
     int capture_interval     = 0;   // capture interval for each face (ms)
     int capture_frame_number = 3;   // capture frame number in capture interval
 
@@ -61,7 +94,12 @@ struct FaceParam
     float clarity    = -1.0f;          // face clarity (negative means all detected face, 0.10f is recommended)
     float brightness = -1.0f;          // face brightness (negative means all detected face, 0.20f is recommended)
 
+    float prefilter_clarity    = -1.0f; // laplacian variance of the 64 pixels gray face chip scored on cpu before evaluating badness (negative means disabled, 20.0f is recommended)
+    float prefilter_brightness = -1.0f; // mean luminance of the gray face chip scored on cpu before evaluating badness, [0.0, 1.0] (negative means disabled, 0.15f is recommended)
+
     bool extract_feature = true;
+    bool  extract_best_only      = false; // with choose_best_interval, only extract the faces committed by best face finder, the first face of each track is not extracted at once
+    float extract_quality_margin = -1.0f; // only extract the face whose keypoints confidence beats the last extracted face of the same track by this margin, others are captured without feature (negative means disabled)
 };
 
 #endif
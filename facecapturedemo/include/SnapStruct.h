@@ -61,6 +61,12 @@ struct ImageParam
     std::vector<FaceInfo> faceInfos = {};    // face information in the scence image
 };
 
+/**
+* @brief define feeding result of every image in a batch \n
+*
+*/
+enum { FEED_SUCCESS, FEED_NO_CAMERA, FEED_EMPTY_IMAGE, FEED_DECODE_FAILED };
+
 #endif
 
 
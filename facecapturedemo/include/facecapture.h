@@ -51,6 +51,7 @@ FACECAPUTRE_C_API bool CloseSnapCamera(const char* ip, unsigned short port);
 
 FACECAPUTRE_C_API bool OpenImageCamera(int deviceIndex, const char* id, const FaceParam& faceParam);
 FACECAPUTRE_C_API bool FeedImageCamera(const ImageParam& imageParam);
+FACECAPUTRE_C_API bool FeedImageCameras(const std::vector<ImageParam>& imageParams, std::vector<int>& results);
 FACECAPUTRE_C_API bool CloseImageCamera(const char* id);
 
 FACECAPUTRE_C_API bool OpenStreamsAsync(const std::vector<int>& types, const std::vector<std::string>& urls, const std::vector<DecoderParam>& decoderParams, const std::vector<DecodeParam>& decodeParams, const std::vector<FaceParam>& faceParams, const std::vector<std::string>& ids, StreamAsyncCallback callback = nullptr);
@@ -60,9 +61,35 @@ FACECAPUTRE_C_API bool OpenRTSP(const char* url, const DecoderParam& decoderPara
 FACECAPUTRE_C_API bool OpenVideo(const char* path, const DecoderParam& decoderParam, const DecodeParam& decodeParam, const FaceParam& faceParam, const char* id);
 FACECAPUTRE_C_API bool OpenUSB(const char* port, const DecoderParam& decoderParam, const DecodeParam& decodeParam, const FaceParam& faceParam, const char* id);
 FACECAPUTRE_C_API bool OpenDirectory(const char* path, const DecoderParam& decoderParam, const DecodeParam& decodeParam, const FaceParam& faceParam, const char* id);
+FACECAPUTRE_C_API bool OpenWatchFolder(const char* path, const DecoderParam& decoderParam, const DecodeParam& decodeParam, const WatchParam& watchParam, const FaceParam& faceParam, const char* id);
 
 FACECAPUTRE_C_API bool CloseStream(const char* id);
 
+/**
+* @brief move a running stream to the face detector of deviceIndex without dropping its captures \n
+* frames of the stream being detected are drained first, at most drainTimeout (ms),
+* then its tracks and best faces are handed to the new face detector;
+* a stream decoded on gpu can only be moved to the face detector of its decoding device
+*/
+FACECAPUTRE_C_API bool MigrateStream(const char* id, int deviceIndex, int drainTimeout);
+
+/**
+* @brief live loads of all face detectors, streams are placed by them if placement is least_loaded \n
+*/
+FACECAPUTRE_C_API bool GetDetectorLoads(std::vector<DetectorLoad>& detectorLoads);
+
+/**
+* @brief add or retire workers of a stage (STAGE_XXX) of the face detector of deviceIndex while running \n
+* STAGE_EXTRACT scales the extract instance of the face detector; retired workers finish their current batch
+* and no track is lost; only stages enabled in configuration can be scaled and each keeps one worker at least
+*/
+FACECAPUTRE_C_API bool SetStageThreads(int deviceIndex, int stage, int threadCount);
+
+/**
+* @brief running workers and utilization of each enabled stage of the face detector of deviceIndex \n
+*/
+FACECAPUTRE_C_API bool GetStageUtilizations(int deviceIndex, std::vector<StageStatistic>& stageStatistics);
+
 FACECAPUTRE_C_API bool GetFaceCapture(std::vector<CaptureResultPtr>& captureResults);
 
 #endif
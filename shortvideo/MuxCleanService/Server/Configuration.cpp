@@ -7,6 +7,7 @@
 
 Configuration::ActionInfo Configuration::action;
 Configuration::DbInfo Configuration::db;
+Configuration::MetricsInfo Configuration::metrics;
 
 bool Configuration::Load(std::string& err)
 {
@@ -86,6 +87,37 @@ bool Configuration::Load(std::string& err)
                     err = "database(db) configuration not found or invalid";
                 }
 
+                // metrics are optional, the listener is off without them
+                cJSON* metricsinfo = cJSON_GetObjectItem(jroot, "metrics");
+                if (metricsinfo)
+                {
+                    cJSON* port = cJSON_GetObjectItem(metricsinfo, "port");
+                    if (metricsinfo->type == cJSON_Object && port && port->type == cJSON_Number && port->valueint >= 0 && port->valueint <= 65535)
+                    {
+                        metrics.port = port->valueint;
+                    }
+                    else
+                    {
+                        err = "metrics port configuration invalid";
+                        break;
+                    }
+
+                    // loopback unless configured, metrics are served without authentication
+                    cJSON* address = cJSON_GetObjectItem(metricsinfo, "address");
+                    if (address)
+                    {
+                        if (address->type == cJSON_String && address->valuestring && address->valuestring[0])
+                        {
+                            metrics.address = address->valuestring;
+                        }
+                        else
+                        {
+                            err = "metrics address configuration invalid";
+                            break;
+                        }
+                    }
+                }
+
                 Maria maria(db.url);
                 if (!maria.OneHost(action.hostid, action.host, action.root))
                 {
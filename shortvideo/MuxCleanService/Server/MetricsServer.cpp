@@ -0,0 +1,174 @@
+#include "MetricsServer.h"
+
+#include <ws2tcpip.h>
+
+#define GLOG_NO_ABBREVIATED_SEVERITIES
+#define GOOGLE_GLOG_DLL_DECL
+#include "glog/logging.h"
+
+#include "Metrics.h"
+
+#pragma comment(lib, "ws2_32.lib")
+
+SOCKET MetricsServer::_listener = INVALID_SOCKET;
+bool MetricsServer::_serving = false;
+std::thread MetricsServer::_serve;
+
+bool MetricsServer::Startup(const std::string& address, int port, std::string& err)
+{
+    if (port <= 0 || _serving)
+    {
+        return true;
+    }
+
+    WSADATA wsaData;
+    int res = WSAStartup(MAKEWORD(2, 2), &wsaData);
+    if (res != 0)
+    {
+        err = "metrics server can not initialize winsock: " + std::to_string(res);
+        return false;
+    }
+
+    sockaddr_in listenAddress = {};
+    listenAddress.sin_family = AF_INET;
+    listenAddress.sin_port = htons((u_short)port);
+    if (inet_pton(AF_INET, address.c_str(), &listenAddress.sin_addr) != 1)
+    {
+        err = "metrics server address is not an ipv4 address: " + address;
+        WSACleanup();
+        return false;
+    }
+
+    _listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (_listener == INVALID_SOCKET)
+    {
+        err = "metrics server can not create socket: " + std::to_string(WSAGetLastError());
+        WSACleanup();
+        return false;
+    }
+
+    if (bind(_listener, (sockaddr*)&listenAddress, sizeof(listenAddress)) == SOCKET_ERROR || listen(_listener, SOMAXCONN) == SOCKET_ERROR)
+    {
+        err = "metrics server can not listen on " + address + ":" + std::to_string(port) + ": " + std::to_string(WSAGetLastError());
+        closesocket(_listener);
+        _listener = INVALID_SOCKET;
+        WSACleanup();
+        return false;
+    }
+
+    _serving = true;
+    _serve = std::thread(&MetricsServer::Serve);
+
+    LOG(INFO) << "metrics server listening on " << address << ":" << port;
+    return true;
+}
+
+void MetricsServer::Shutdown()
+{
+    if (_serving)
+    {
+        _serving = false;
+        if (_serve.joinable())
+        {
+            _serve.join();
+        }
+
+        closesocket(_listener);
+        _listener = INVALID_SOCKET;
+        WSACleanup();
+    }
+}
+
+void MetricsServer::Serve()
+{
+    while (_serving)
+    {
+        // wake up twice a second to see whether the server is shutting down
+        fd_set readable;
+        FD_ZERO(&readable);
+        FD_SET(_listener, &readable);
+        timeval timeout = { 0, 500000 };
+        int res = select(0, &readable, nullptr, nullptr, &timeout);
+        if (res <= 0)
+        {
+            if (res < 0)
+            {
+                LOG(WARNING) << "metrics server select failed: " << WSAGetLastError();
+                std::this_thread::sleep_for(std::chrono::milliseconds(500));
+            }
+            continue;
+        }
+
+        SOCKET client = accept(_listener, nullptr, nullptr);
+        if (client == INVALID_SOCKET)
+        {
+            continue;
+        }
+
+        // a stalled client must not hold the listener for long
+        DWORD milliseconds = 2000;
+        setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, (const char*)&milliseconds, sizeof(milliseconds));
+        setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, (const char*)&milliseconds, sizeof(milliseconds));
+
+        Respond(client);
+
+        shutdown(client, SD_BOTH);
+        closesocket(client);
+    }
+}
+
+void MetricsServer::Respond(SOCKET client)
+{
+    std::string request;
+    char buffer[1024];
+    while (request.find("\r\n\r\n") == std::string::npos && request.size() < 8192)
+    {
+        int size = recv(client, buffer, sizeof(buffer), 0);
+        if (size <= 0)
+        {
+            return;
+        }
+        request.append(buffer, size);
+    }
+
+    // request line: method path version, query string is ignored
+    std::string::size_type methodEnd = request.find(' ');
+    std::string::size_type pathEnd = methodEnd == std::string::npos ? std::string::npos : request.find_first_of(" ?", methodEnd + 1);
+    std::string method = request.substr(0, methodEnd);
+    std::string path = pathEnd == std::string::npos ? std::string() : request.substr(methodEnd + 1, pathEnd - methodEnd - 1);
+
+    std::string status = "200 OK";
+    std::string body;
+    if (method != "GET")
+    {
+        status = "405 Method Not Allowed";
+        body = "method not allowed\n";
+    }
+    else if (path != "/metrics")
+    {
+        status = "404 Not Found";
+        body = "not found, metrics are served at /metrics\n";
+    }
+    else
+    {
+        body = MetricsRegistry::Expose();
+    }
+
+    std::string response = "HTTP/1.0 " + status + "\r\n"
+        + "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+        + "Content-Length: " + std::to_string(body.size()) + "\r\n"
+        + "Connection: close\r\n\r\n"
+        + body;
+
+    size_t sent = 0;
+    while (sent < response.size())
+    {
+        int size = send(client, response.data() + sent, (int)(response.size() - sent), 0);
+        if (size <= 0)
+        {
+            LOG(WARNING) << "metrics server send failed: " << WSAGetLastError();
+            return;
+        }
+        sent += size;
+    }
+}
@@ -22,6 +22,11 @@ static long long Now()
 RealtimeCleanTask::RealtimeCleanTask(int hostid, const std::string& source)
     : _hostid(hostid), _source(source), _last_clean_timepoint(0)
     , _cleaning(false), _task(), _locker(), _condition()
+    , _clean_latency_metric(MetricsRegistry::Histogram("clean_seconds", MetricsRegistry::SourceLabel(source)))
+    , _removed_files_metric(MetricsRegistry::Counter("clean_removed_files_total", MetricsRegistry::SourceLabel(source)))
+    , _remove_errors_metric(MetricsRegistry::Counter("clean_remove_errors_total", MetricsRegistry::SourceLabel(source)))
+    , _kept_files_metric(MetricsRegistry::Counter("clean_kept_files_total", MetricsRegistry::SourceLabel(source)))
+    , _failed_ranges_metric(MetricsRegistry::Counter("clean_failed_ranges_total", MetricsRegistry::SourceLabel(source)))
 {
     _cleaning = true;
     _task = std::thread(&RealtimeCleanTask::Clean, this);
@@ -107,6 +112,7 @@ bool RealtimeCleanTask::QueryFaceTimepoints(long long beg, long long end, std::v
 
 void RealtimeCleanTask::CleanShortVideos(long long beg, long long end)
 {
+    MetricTimer timer(_clean_latency_metric);
     Maria maria(Configuration::db.url);
 
     std::vector<long long> facetimepoints;
@@ -149,11 +155,13 @@ void RealtimeCleanTask::CleanShortVideos(long long beg, long long end)
                     {
                         if (!FileSystem::RemoveFile(ss.str()))
                         {
+                            _remove_errors_metric->Add();
                             LOG(WARNING) << "[RealtimeCleanTask] delete short video(" << ss.str() << ") failed";
                         }
                         else
                         {
                             maria.DeleteItem(_hostid, _source, item.generatedpoint, item.stoppedpoint);
+                            _removed_files_metric->Add();
                             //LOG(INFO) << "delete short video(" << ss.str() << ") success";
                         }
                     }
@@ -162,18 +170,24 @@ void RealtimeCleanTask::CleanShortVideos(long long beg, long long end)
                         LOG(WARNING) << "[RealtimeCleanTask] short video(" << ss.str() << ") is not accessible or not exist";
                     }
                 }
+                else
+                {
+                    _kept_files_metric->Add();
+                }
             }
         }
         else
         {
             // save failed time point
             maria.ManageFailedItem(_hostid, _source, beg, end, true);
+            _failed_ranges_metric->Add();
         }
     }
     else
     {
         // save failed time point
         maria.ManageFailedItem(_hostid, _source, beg, end, true);
+        _failed_ranges_metric->Add();
     }
 
     // update last clean time point
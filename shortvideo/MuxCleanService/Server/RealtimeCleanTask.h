@@ -7,6 +7,8 @@
 #include <mutex>
 #include <vector>
 
+#include "Metrics.h"
+
 class RealtimeCleanTask
 {
 public:
@@ -29,6 +31,12 @@ private:
     std::mutex _locker;
     std::condition_variable _condition;
 
+    MetricHistogram* _clean_latency_metric;
+    MetricCounter* _removed_files_metric;
+    MetricCounter* _remove_errors_metric;
+    MetricCounter* _kept_files_metric;
+    MetricCounter* _failed_ranges_metric;
+
 private:
     RealtimeCleanTask();
     RealtimeCleanTask(const RealtimeCleanTask&);
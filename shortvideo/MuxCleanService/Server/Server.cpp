@@ -21,6 +21,8 @@
 
 #include "CleanTaskManager.h"
 
+#include "MetricsServer.h"
+
 static void glog_CrashWriter(const char *data, int size)
 {
     LOG(FATAL) << std::string(data, size);
@@ -92,6 +94,11 @@ int main(int argc, char* argv[])
                 throw std::exception(err.c_str());
             }
 
+            if (!MetricsServer::Startup(Configuration::metrics.address, Configuration::metrics.port, err))
+            {
+                LOG(WARNING) << err;
+            }
+
             if (!ProxyManager::Initialize(argc, argv, err))
             {
                 throw std::exception(err.c_str());
@@ -148,6 +155,7 @@ int main(int argc, char* argv[])
         delete manager;
         manager = nullptr;
     }
+    MetricsServer::Shutdown();
 
     LOG(INFO) << "Mux Clean Service stopped: " << desc;
 
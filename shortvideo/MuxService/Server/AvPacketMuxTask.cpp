@@ -26,6 +26,13 @@ AvPacketMuxTask::AvPacketMuxTask(int hostId, const std::string& url, AVFormatCon
     , _packets(), _locker(), _condition()
     , _begin(0), _end(0)
     , _pool(pool)
+    , _queued_metric(MetricsRegistry::Gauge("mux_queued_packets", MetricsRegistry::SourceLabel(url)))
+    , _written_packets_metric(MetricsRegistry::Counter("mux_written_packets_total", MetricsRegistry::SourceLabel(url)))
+    , _written_bytes_metric(MetricsRegistry::Counter("mux_written_bytes_total", MetricsRegistry::SourceLabel(url)))
+    , _write_errors_metric(MetricsRegistry::Counter("mux_write_errors_total", MetricsRegistry::SourceLabel(url)))
+    , _write_latency_metric(MetricsRegistry::Histogram("mux_write_seconds", MetricsRegistry::SourceLabel(url)))
+    , _saved_files_metric(MetricsRegistry::Counter("mux_files_total", MetricsRegistry::SourceLabel(url) + "," + MetricsRegistry::Label("result", "saved")))
+    , _dropped_files_metric(MetricsRegistry::Counter("mux_files_total", MetricsRegistry::SourceLabel(url) + "," + MetricsRegistry::Label("result", "dropped")))
 {
     _timebase.num = 1;
     _timebase.den = frameRate;
@@ -120,6 +127,7 @@ void AvPacketMuxTask::AddPacket(AVPacket* packet, long long frame_index)
 
     std::lock_guard<std::mutex> lg(_locker);
     _packets.push(packet);
+    _queued_metric->Add(1);
     _condition.notify_one();
 }
 
@@ -153,6 +161,7 @@ void AvPacketMuxTask::Mux()
             // fetch packet
             packet = _packets.front();
             _packets.pop();
+            _queued_metric->Add(-1);
 
             // muxing task starting failed, then ignore all packet
             if (!_avformatCxt)
@@ -181,7 +190,7 @@ void AvPacketMuxTask::Mux()
         if (stream_from->codecpar->codec_type == AVMEDIA_TYPE_VIDEO)
         {
             // write the compressed frame to the output format
-            int res = av_interleaved_write_frame(_avformatCxt, packet);
+            int res = WritePacket(packet);
             if (res != 0)
             {
                 char errstr[AV_ERROR_MAX_STRING_SIZE] = { 0 };
@@ -193,7 +202,7 @@ void AvPacketMuxTask::Mux()
         else if (stream_from->codecpar->codec_type == AVMEDIA_TYPE_AUDIO)
         {
             // write the compressed frame to the output format
-            int res = av_interleaved_write_frame(_avformatCxt, packet);
+            int res = WritePacket(packet);
             if (res != 0)
             {
                 char errstr[AV_ERROR_MAX_STRING_SIZE] = { 0 };
@@ -207,6 +216,27 @@ void AvPacketMuxTask::Mux()
     }
 }
 
+int AvPacketMuxTask::WritePacket(AVPacket* packet)
+{
+    // the packet is reset by the muxer
+    int size = packet->size;
+
+    MetricTimer timer(_write_latency_metric);
+    int res = av_interleaved_write_frame(_avformatCxt, packet);
+    timer.Stop();
+
+    if (res == 0)
+    {
+        _written_packets_metric->Add();
+        _written_bytes_metric->Add(size);
+    }
+    else
+    {
+        _write_errors_metric->Add();
+    }
+    return res;
+}
+
 bool AvPacketMuxTask::CreateContext()
 {
     std::string extension = "avi";
@@ -344,6 +374,7 @@ void AvPacketMuxTask::DestroyContext()
         {
             FileSystem::RemoveFile(_absolute);
         }
+        (ending_success ? _saved_files_metric : _dropped_files_metric)->Add();
 
         avformat_free_context(_avformatCxt);
         _avformatCxt = nullptr; 
@@ -30,6 +30,8 @@ extern "C" {
 #include <condition_variable>
 #include <queue>
 
+#include "Metrics.h"
+
 class AvPacketMuxTaskPool;
 class AvPacketMuxTask
 {
@@ -49,6 +51,7 @@ public:
 
 private:
     void Mux();
+    int WritePacket(AVPacket* packet);
 
     bool CreateContext();
     void DestroyContext();
@@ -85,6 +88,14 @@ private:
     long long _end;
 
     AvPacketMuxTaskPool& _pool;
+
+    MetricGauge* _queued_metric;
+    MetricCounter* _written_packets_metric;
+    MetricCounter* _written_bytes_metric;
+    MetricCounter* _write_errors_metric;
+    MetricHistogram* _write_latency_metric;
+    MetricCounter* _saved_files_metric;
+    MetricCounter* _dropped_files_metric;
 };
 
 #endif
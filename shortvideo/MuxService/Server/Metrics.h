@@ -0,0 +1,172 @@
+#ifndef _METRICS_HEADER_H_
+#define _METRICS_HEADER_H_
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+/**
+* @brief monotonic event counter, one relaxed atomic add per update \n
+*
+*/
+class MetricCounter
+{
+public:
+    MetricCounter() : _value(0) {}
+
+    inline void Add(long long value = 1) { _value.fetch_add(value, std::memory_order_relaxed); }
+    inline long long Value() const { return _value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<long long> _value;
+
+private:
+    MetricCounter(const MetricCounter&);
+    MetricCounter& operator=(const MetricCounter&);
+};
+
+/**
+* @brief value that goes up and down, like a queue length \n
+*
+*/
+class MetricGauge
+{
+public:
+    MetricGauge() : _value(0) {}
+
+    inline void Set(long long value) { _value.store(value, std::memory_order_relaxed); }
+    inline void Add(long long value) { _value.fetch_add(value, std::memory_order_relaxed); }
+    inline long long Value() const { return _value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<long long> _value;
+
+private:
+    MetricGauge(const MetricGauge&);
+    MetricGauge& operator=(const MetricGauge&);
+};
+
+// upper bounds of the histogram buckets in microseconds, exposed in seconds from 0.0001 to 10
+static const long long METRIC_BUCKET_BOUNDS[] = {
+    100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, 500000, 1000000, 2500000, 5000000, 10000000
+};
+
+/**
+* @brief latency histogram recorded in microseconds \n
+* the buckets are fixed so prometheus sees the same le labels on every scrape,
+* the last bucket holds the values over 10 seconds
+*/
+class MetricHistogram
+{
+public:
+    enum { BUCKET_NUMBER = sizeof(METRIC_BUCKET_BOUNDS) / sizeof(METRIC_BUCKET_BOUNDS[0]) + 1 };
+
+public:
+    MetricHistogram() : _sum(0)
+    {
+        for (int idx = 0; idx < BUCKET_NUMBER; ++idx)
+        {
+            _buckets[idx].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    inline void Record(long long microseconds)
+    {
+        int idx = 0;
+        while (idx < BUCKET_NUMBER - 1 && microseconds > METRIC_BUCKET_BOUNDS[idx])
+        {
+            idx++;
+        }
+        _buckets[idx].fetch_add(1, std::memory_order_relaxed);
+        _sum.fetch_add(microseconds, std::memory_order_relaxed);
+    }
+
+    inline long long Bucket(int idx) const { return _buckets[idx].load(std::memory_order_relaxed); }
+    inline long long Sum() const { return _sum.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<long long> _buckets[BUCKET_NUMBER];
+    std::atomic<long long> _sum;
+
+private:
+    MetricHistogram(const MetricHistogram&);
+    MetricHistogram& operator=(const MetricHistogram&);
+};
+
+/**
+* @brief records the microseconds from construction to Stop or destruction \n
+*
+*/
+class MetricTimer
+{
+public:
+    explicit MetricTimer(MetricHistogram* histogram) : _histogram(histogram), _start(std::chrono::steady_clock::now()) {}
+    ~MetricTimer() { Stop(); }
+
+    inline void Stop()
+    {
+        if (_histogram)
+        {
+            _histogram->Record(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - _start).count());
+            _histogram = nullptr;
+        }
+    }
+
+private:
+    MetricHistogram* _histogram;
+    std::chrono::steady_clock::time_point _start;
+
+private:
+    MetricTimer(const MetricTimer&);
+    MetricTimer& operator=(const MetricTimer&);
+};
+
+/**
+* @brief named metrics of the service, exposed in prometheus text format \n
+* a metric is identified by name and labels (like source="rtsp://..."), lookup takes a lock,
+* so tasks keep the returned pointers; metrics are never removed
+*/
+class MetricsRegistry
+{
+public:
+    static MetricCounter* Counter(const std::string& name, const std::string& labels = "");
+    static MetricGauge* Gauge(const std::string& name, const std::string& labels = "");
+    static MetricHistogram* Histogram(const std::string& name, const std::string& labels = "");
+
+    /**
+    * @brief one label as name="value", labels are joined with ',' \n
+    */
+    static std::string Label(const std::string& name, const std::string& value);
+
+    /**
+    * @brief source="url" without the user and password of the url, label values are served to every scraper \n
+    */
+    static std::string SourceLabel(const std::string& url);
+
+    /**
+    * @brief all metrics in prometheus text exposition format 0.0.4 \n
+    */
+    static std::string Expose();
+
+private:
+    typedef std::pair<std::string, std::string> MetricKey;
+
+    template<typename Metric>
+    static Metric* Find(std::map<MetricKey, std::shared_ptr<Metric>>& metrics, const std::string& name, const std::string& labels);
+
+private:
+    static std::mutex _locker;
+    static std::map<MetricKey, std::shared_ptr<MetricCounter>> _counters;
+    static std::map<MetricKey, std::shared_ptr<MetricGauge>> _gauges;
+    static std::map<MetricKey, std::shared_ptr<MetricHistogram>> _histograms;
+
+private:
+    MetricsRegistry();
+    MetricsRegistry(const MetricsRegistry&);
+    MetricsRegistry& operator=(const MetricsRegistry&);
+};
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef _METRICSSERVER_HEADER_H_
+#define _METRICSSERVER_HEADER_H_
+
+#include <winsock2.h>
+
+#include <string>
+#include <thread>
+
+/**
+* @brief minimal http listener answering GET /metrics with MetricsRegistry::Expose \n
+* requests are served one by one on its own thread, it is meant for a prometheus scraper only
+*/
+class MetricsServer
+{
+public:
+    /**
+    * @brief listen on port of the ipv4 address, port 0 leaves the listener off \n
+    * metrics are served without authentication, keep it on loopback unless the network is trusted
+    */
+    static bool Startup(const std::string& address, int port, std::string& err);
+    static void Shutdown();
+
+private:
+    static void Serve();
+    static void Respond(SOCKET client);
+
+private:
+    static SOCKET _listener;
+    static bool _serving;
+    static std::thread _serve;
+
+private:
+    MetricsServer();
+    MetricsServer(const MetricsServer&);
+    MetricsServer& operator=(const MetricsServer&);
+};
+
+#endif
@@ -31,6 +31,11 @@ RtspStreamMuxTask::RtspStreamMuxTask(const std::string& rtsp, const std::string&
     , _reading(false), _read()
     , _mfs(), _host_id(-1), _rtsp_ip()
     , _taskpool()
+    , _read_packets_metric(MetricsRegistry::Counter("mux_read_packets_total", MetricsRegistry::SourceLabel(rtsp)))
+    , _read_bytes_metric(MetricsRegistry::Counter("mux_read_bytes_total", MetricsRegistry::SourceLabel(rtsp)))
+    , _read_errors_metric(MetricsRegistry::Counter("mux_read_errors_total", MetricsRegistry::SourceLabel(rtsp)))
+    , _reconnects_metric(MetricsRegistry::Counter("mux_reconnects_total", MetricsRegistry::SourceLabel(rtsp)))
+    , _connected_metric(MetricsRegistry::Gauge("mux_source_connected", MetricsRegistry::SourceLabel(rtsp)))
 {
     _width = _height = 0;
     _frame_rate = 25.0f;
@@ -160,6 +165,7 @@ bool RtspStreamMuxTask::OpenRtsp(std::string& result)
         Maria maria(TaskManager::db.url);
         maria.ActivateSouce(_host_id, _rtsp, Now());
 
+        _connected_metric->Set(1);
         return true;
     }
 
@@ -172,6 +178,7 @@ void RtspStreamMuxTask::CloseRtsp()
     {
         avformat_close_input(&_avformatCxt);
         _avformatCxt = nullptr;
+        _connected_metric->Set(0);
 
         Maria maria(TaskManager::db.url);
         maria.DeactivateSouce(_host_id, _rtsp);
@@ -298,6 +305,7 @@ void RtspStreamMuxTask::Read()
             
             if (_reading)
             {
+                _read_errors_metric->Add();
                 LOG(WARNING) << "read rtsp: " << _rtsp << " failed: (" << res << ")" << errstr;
                 LOG(WARNING) << _rtsp << " is going to restart...";
 
@@ -307,6 +315,7 @@ void RtspStreamMuxTask::Read()
                 std::string err;
                 if (OpenRtsp(err))
                 {
+                    _reconnects_metric->Add();
                     task = StartAvPacketMuxTask();
                     if (task)
                     {
@@ -330,6 +339,9 @@ void RtspStreamMuxTask::Read()
         }
         else
         {
+            _read_packets_metric->Add();
+            _read_bytes_metric->Add(packet->size);
+
             if (!task)
             {
                 AvPacketPool::Free(packet);
@@ -4,6 +4,7 @@
 
 #include "AvPacketMuxTaskPool.h"
 #include "MediaSystem.h"
+#include "Metrics.h"
 
 class RtspStreamMuxTask
 {
@@ -45,6 +46,12 @@ private:
     std::string _rtsp_ip;
 
     AvPacketMuxTaskPool _taskpool;
+
+    MetricCounter* _read_packets_metric;
+    MetricCounter* _read_bytes_metric;
+    MetricCounter* _read_errors_metric;
+    MetricCounter* _reconnects_metric;
+    MetricGauge* _connected_metric;
 };
 
 #endif
@@ -16,6 +16,7 @@
 #include "OperationService.h"
 
 #include "TaskManager.h"
+#include "MetricsServer.h"
 
 #ifdef DUMP_RELEASE
 
@@ -127,6 +128,12 @@ int main(int argc, char* argv[])
                 break;
             }
 
+            // the service runs without metrics if the port is taken
+            if (!MetricsServer::Startup(TaskManager::metrics.address, TaskManager::metrics.port, err))
+            {
+                LOG(WARNING) << err;
+            }
+
             //
             // CtrlCHandler must be created before the communicator or any other threads are started
             //
@@ -159,6 +166,7 @@ int main(int argc, char* argv[])
             }
 
             TaskManager::Shutdown();
+            MetricsServer::Shutdown();
         } while (false);
     }
     catch (const std::exception& ex)
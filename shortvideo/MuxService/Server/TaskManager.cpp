@@ -4,6 +4,7 @@
 
 TaskManager::FileInfo TaskManager::fs;
 TaskManager::DbInfo TaskManager::db;
+TaskManager::MetricsInfo TaskManager::metrics;
 
 std::mutex TaskManager::_locker;
 std::map<std::string, RtspStreamMuxTask*> TaskManager::_tasks;
@@ -151,6 +152,37 @@ bool TaskManager::Startup(std::string& err)
                     err = "database(db) configuration not found or invalid";
                 }
 
+                // metrics are optional, the listener is off without them
+                cJSON* metricsinfo = cJSON_GetObjectItem(jroot, "metrics");
+                if (metricsinfo)
+                {
+                    cJSON* port = cJSON_GetObjectItem(metricsinfo, "port");
+                    if (metricsinfo->type == cJSON_Object && port && port->type == cJSON_Number && port->valueint >= 0 && port->valueint <= 65535)
+                    {
+                        metrics.port = port->valueint;
+                    }
+                    else
+                    {
+                        err = "metrics port configuration invalid";
+                        break;
+                    }
+
+                    // loopback unless configured, metrics are served without authentication
+                    cJSON* address = cJSON_GetObjectItem(metricsinfo, "address");
+                    if (address)
+                    {
+                        if (address->type == cJSON_String && address->valuestring && address->valuestring[0])
+                        {
+                            metrics.address = address->valuestring;
+                        }
+                        else
+                        {
+                            err = "metrics address configuration invalid";
+                            break;
+                        }
+                    }
+                }
+
                 cJSON* rtsp = cJSON_GetObjectItem(jroot, "rtsp");
                 if (rtsp && rtsp->type == cJSON_Array)
                 {
@@ -36,6 +36,13 @@ public:
 
     static DbInfo db;
 
+    struct MetricsInfo
+    {
+        std::string address = "127.0.0.1";
+        int port = 0;
+    };
+    static MetricsInfo metrics;
+
 private:
     static std::mutex _locker;
     static std::map<std::string, RtspStreamMuxTask*> _tasks;
@@ -4,6 +4,7 @@
 
 PusherManager::MediaInfo PusherManager::md;
 PusherManager::DbInfo PusherManager::db;
+PusherManager::MetricsInfo PusherManager::metrics;
 
 std::mutex PusherManager::_locker;
 std::queue<RtmpPusher*> PusherManager::_free_pushers;
@@ -95,6 +96,37 @@ bool PusherManager::Startup(std::string& err)
                 else
                 {
                     err = "database(db) configuration not found or invalid";
+                    break;
+                }
+
+                cJSON* metricsinfo = cJSON_GetObjectItem(jroot, "metrics");
+                if (metricsinfo)
+                {
+                    cJSON* port = cJSON_GetObjectItem(metricsinfo, "port");
+                    if (metricsinfo->type == cJSON_Object && port && port->type == cJSON_Number && port->valueint >= 0 && port->valueint <= 65535)
+                    {
+                        metrics.port = port->valueint;
+                    }
+                    else
+                    {
+                        err = "metrics port configuration invalid";
+                        break;
+                    }
+
+                    // loopback unless configured, metrics are served without authentication
+                    cJSON* address = cJSON_GetObjectItem(metricsinfo, "address");
+                    if (address)
+                    {
+                        if (address->type == cJSON_String && address->valuestring && address->valuestring[0])
+                        {
+                            metrics.address = address->valuestring;
+                        }
+                        else
+                        {
+                            err = "metrics address configuration invalid";
+                            break;
+                        }
+                    }
                 }
             } while (false);
 
@@ -30,6 +30,13 @@ public:
 
     static DbInfo db;
 
+    struct MetricsInfo
+    {
+        std::string address = "127.0.0.1";
+        int port = 0;
+    };
+    static MetricsInfo metrics;
+
 private:
     static RtmpPusher* Alloc();
     static void Free(RtmpPusher* pusher);
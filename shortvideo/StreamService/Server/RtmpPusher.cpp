@@ -14,6 +14,14 @@ RtmpPusher::RtmpPusher(const std::string& rtmp)
     , _input_ctx(nullptr), _vedio_stream_index(-1), _live_ctx(nullptr)
     , _pushing(false), _push()
     , _url(), _locker(), _condition()
+    , _started_metric(MetricsRegistry::Counter("stream_pushes_total", MetricsRegistry::Label("result", "started")))
+    , _failed_metric(MetricsRegistry::Counter("stream_pushes_total", MetricsRegistry::Label("result", "failed")))
+    , _active_metric(MetricsRegistry::Gauge("stream_active_pushers"))
+    , _pushed_packets_metric(MetricsRegistry::Counter("stream_pushed_packets_total"))
+    , _pushed_bytes_metric(MetricsRegistry::Counter("stream_pushed_bytes_total"))
+    , _write_errors_metric(MetricsRegistry::Counter("stream_write_errors_total"))
+    , _write_latency_metric(MetricsRegistry::Histogram("stream_write_seconds"))
+    , _lag_metric(MetricsRegistry::Histogram("stream_lag_seconds"))
 {
     _pushing = true;
     _push = std::thread(&RtmpPusher::Stream, this);
@@ -39,10 +47,12 @@ bool RtmpPusher::Push(const std::string& url, std::string& live)
         _url = url;
         if (CreateRtmpContext(live))
         {
+            _started_metric->Add();
             std::lock_guard<std::mutex> lg(_locker);
             _condition.notify_one();
             return true;
         }
+        _failed_metric->Add();
         return false;
     }
     live = "can not found stream service";
@@ -62,6 +72,7 @@ void RtmpPusher::Stream()
             }
         }
 
+        _active_metric->Add(1);
         int frame_index = 0;
 
         AVPacket pkt;
@@ -97,6 +108,12 @@ void RtmpPusher::Stream()
                 if (pts_time > now_time)
                 {
                     av_usleep(pts_time - now_time);
+                    _lag_metric->Record(0);
+                }
+                else
+                {
+                    // behind the timeline of the file, the live stream is stalling
+                    _lag_metric->Record(now_time - pts_time);
                 }
             }
 
@@ -113,9 +130,18 @@ void RtmpPusher::Stream()
                 frame_index++;
             }
 
+            int size = pkt.size;
+            MetricTimer timer(_write_latency_metric);
             ret = av_interleaved_write_frame(_live_ctx, &pkt);
-            if (ret < 0)
+            timer.Stop();
+            if (ret >= 0)
+            {
+                _pushed_packets_metric->Add();
+                _pushed_bytes_metric->Add(size);
+            }
+            else
             {
+                _write_errors_metric->Add();
                 char errstr[AV_ERROR_MAX_STRING_SIZE] = { 0 };
                 av_make_error_string(errstr, AV_ERROR_MAX_STRING_SIZE, ret);
                 LOG(ERROR) << "push one live frame for file: " << _url << " failed: " << "(" << ret << ")" << errstr;
@@ -125,6 +151,7 @@ void RtmpPusher::Stream()
         }
 
         DestroyRtmpContext();
+        _active_metric->Add(-1);
 
         PusherManager::Free(this);
     }
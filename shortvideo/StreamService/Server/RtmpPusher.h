@@ -30,6 +30,8 @@ extern "C" {
 #include <condition_variable>
 #include <queue>
 
+#include "Metrics.h"
+
 class RtmpPusher
 {
 public:
@@ -58,6 +60,15 @@ private:
     std::mutex _locker;
     std::condition_variable _condition;
 
+    MetricCounter* _started_metric;
+    MetricCounter* _failed_metric;
+    MetricGauge* _active_metric;
+    MetricCounter* _pushed_packets_metric;
+    MetricCounter* _pushed_bytes_metric;
+    MetricCounter* _write_errors_metric;
+    MetricHistogram* _write_latency_metric;
+    MetricHistogram* _lag_metric;
+
 private:
     RtmpPusher(const RtmpPusher&);
     RtmpPusher& operator=(const RtmpPusher&);
@@ -16,6 +16,7 @@
 #include "OperationService.h"
 
 #include "PusherManager.h"
+#include "MetricsServer.h"
 
 static void glog_CrashWriter(const char *data, int size)
 {
@@ -85,6 +86,11 @@ int main(int argc, char* argv[])
             return -1;
         }
 
+        if (!MetricsServer::Startup(PusherManager::metrics.address, PusherManager::metrics.port, err))
+        {
+            LOG(WARNING) << err;
+        }
+
         //
         // CtrlCHandler must be created before the communicator or any other threads are started
         //
@@ -117,6 +123,7 @@ int main(int argc, char* argv[])
         }
 
         PusherManager::Shutdown();
+        MetricsServer::Shutdown();
     }
     catch (const std::exception& ex)
     {